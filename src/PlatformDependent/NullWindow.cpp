@@ -0,0 +1,27 @@
+/*********************************************************\
+File:       NullWindow.cpp
+Purpose:    An offscreen window, for running without a
+            display
+\*********************************************************/
+#include "NullWindow.h"
+#include "Memory.h"
+
+CNullWindow::CNullWindow()
+{
+}
+
+CNullWindow::~CNullWindow()
+{
+}
+
+uint CNullWindow::CreateMainWindow( uint nWidth, uint nHeight )
+{
+    m_pSystemWindow = NULL;
+    m_nWidth = nWidth;
+    m_nHeight = nHeight;
+    return 0;
+}
+
+void CNullWindow::ProcessMessages( void )
+{
+}
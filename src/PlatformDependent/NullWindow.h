@@ -0,0 +1,36 @@
+/*********************************************************\
+File:       NullWindow.h
+Purpose:    An offscreen window, for running without a
+            display
+\*********************************************************/
+#ifndef _NULLWINDOW_H_
+#define _NULLWINDOW_H_
+#include "Common.h"
+#include "Window.h"
+
+class CNullWindow : public CWindow
+{
+public:
+    // CNullWindow constructor
+    CNullWindow();
+
+    // CNullWindow destructor
+    ~CNullWindow();
+    /***************************************\
+    | class methods                         |
+    \***************************************/    
+    //-----------------------------------------------------------------------------
+    //  CreateMainWindow
+    //  Only records the size. There's no system window
+    //-----------------------------------------------------------------------------
+    uint CreateMainWindow( uint nWidth, uint nHeight );
+
+    //-----------------------------------------------------------------------------
+    //  ProcessMessages
+    //  Processes system messages. There aren't any
+    //-----------------------------------------------------------------------------
+    void ProcessMessages( void );
+};
+
+
+#endif // #ifndef _NULLWINDOW_H_
@@ -54,6 +54,7 @@ CD3DGraphics::~CD3DGraphics()
 //-----------------------------------------------------------------------------
 uint CD3DGraphics::Initialize( CWindow* pWindow )
 {
+    MEMORY_CATEGORY( eMemoryCategoryGfx );
     uint nResult = 0;
 
     //////////////////////////////////////////
@@ -309,9 +310,7 @@ void CD3DGraphics::Render( CObject** ppObjects, uint nNumObjects )
     // Perform rendering
 
     // Update and set the view matrix
-    XMMATRIX mView = m_pCurrView->GetViewMatrix();
-    XMMATRIX mProj = m_pCurrView->GetProjMatrix();
-    SetViewProj( &mView, &mProj );
+    SetViewProj( &m_pCurrView->GetViewMatrix(), &m_pCurrView->GetProjMatrix() );
 
     // Render objects
     for( uint i = 0; i < nNumObjects; ++i )
@@ -343,6 +342,8 @@ void CD3DGraphics::Present( void )
 //-----------------------------------------------------------------------------
 CMesh* CD3DGraphics::CreateMesh( const wchar_t* szFilename )
 {
+    MEMORY_CATEGORY( eMemoryCategoryAssets );
+
     //static unsigned int nCount = 0;
     //sprintf( szNewfile, "%d.mesh", nCount );
     //FILE* pFile = fopen( szNewfile, "wb" );
@@ -513,6 +514,8 @@ CMesh* CD3DGraphics::CreateMesh( const wchar_t* szFilename )
 CMesh* CD3DGraphics::CreateMesh( void* vertices, uint nVertexStride, uint nNumVertices,
                                  void* indices, uint nIndexFormat, uint nNumIndices )
 {
+    MEMORY_CATEGORY( eMemoryCategoryAssets );
+
     D3D11_BUFFER_DESC       bufferDesc  = { 0 };
     D3D11_SUBRESOURCE_DATA  initData    = { 0 };
     HRESULT                 hr          = S_OK;
@@ -520,8 +523,8 @@ CMesh* CD3DGraphics::CreateMesh( void* vertices, uint nVertexStride, uint nNumVe
     // Define the input layout
     D3D11_INPUT_ELEMENT_DESC layout[] =
     {
-        { "POSITION", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 0,  D3D11_INPUT_PER_VERTEX_DATA, 0 },
-        { "COLOR",    0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 16, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_FLOAT, 0, 0,  D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "COLOR",    0, DXGI_FORMAT_R8G8B8A8_UNORM,     0, 8,  D3D11_INPUT_PER_VERTEX_DATA, 0 },
 	};
 	UINT numElements = ARRAYSIZE( layout );
     
@@ -631,6 +634,8 @@ CMesh* CD3DGraphics::CreateMesh( void* vertices, uint nVertexStride, uint nNumVe
 //-----------------------------------------------------------------------------
 CMaterial* CD3DGraphics::CreateMaterial( const wchar_t* szFilename, const char* szEntryPoint, const char* szProfile )
 {    
+    MEMORY_CATEGORY( eMemoryCategoryAssets );
+
     ID3DBlob*   pShaderBlob = NULL;
     ID3DBlob*   pErrorBlob = NULL;
     uint        nCompileFlags = 0;
@@ -687,10 +692,10 @@ CMaterial* CD3DGraphics::CreateMaterial( const wchar_t* szFilename, const char*
 //-----------------------------------------------------------------------------
 void CD3DGraphics::SetViewProj( const void* pView, const void* pProj )
 {
-    XMMATRIX mMatrices[2] = 
+    RMatrix4x4 mMatrices[2] = 
     { 
-        XMMatrixTranspose( *((XMMATRIX*)pView) ), 
-        XMMatrixTranspose( *((XMMATRIX*)pProj) )
+        Transpose( *((const RMatrix4x4*)pView) ), 
+        Transpose( *((const RMatrix4x4*)pProj) )
     };
 
     m_pContext->UpdateSubresource( m_pViewProjCB, 0, NULL, mMatrices, 0, 0 );
@@ -9,6 +9,11 @@ Modified by:    Kyle Weicht
 #include "memory.h"
 #include <D3D11.h>
 
+#pragma push_macro( "new" )
+#undef new
+DEFINE_POOL_ALLOCATED( CD3DMaterial, 256, eMemoryCategoryAssets )
+#pragma pop_macro( "new" )
+
 // CD3DMaterial constructor
 CD3DMaterial::CD3DMaterial()
     : m_pDeviceContext( NULL )
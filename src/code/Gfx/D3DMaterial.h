@@ -12,6 +12,7 @@ Modified by:    Kyle Weicht
 #include "Material.h"
 #include "types.h"
 #include "memory.h"
+#include "PoolAllocator.h"
 
 struct ID3D11PixelShader;
 struct ID3D11DeviceContext;
@@ -19,6 +20,10 @@ class CD3DGraphics;
 
 class CD3DMaterial : public CMaterial
 {
+#pragma push_macro( "new" )
+#undef new
+    DECLARE_POOL_ALLOCATED( CD3DMaterial )
+#pragma pop_macro( "new" )
     friend class CD3DGraphics;
 public:
     // CD3DMaterial constructor
@@ -8,8 +8,11 @@ Modified by:    Kyle Weicht
 #include "D3DMesh.h"
 #include <D3D11.h>
 #include "memory.h"
-#include <xnamath.h>
-#include <xmmintrin.h>
+
+#pragma push_macro( "new" )
+#undef new
+DEFINE_POOL_ALLOCATED( CD3DMesh, 256, eMemoryCategoryAssets )
+#pragma pop_macro( "new" )
 
 // CD3DMesh constructor
 CD3DMesh::CD3DMesh()
@@ -43,9 +46,9 @@ void CD3DMesh::DrawMesh( void )
     m_pDeviceContext->VSSetShader( m_pVertexShader, NULL, 0 );
 
     // Set constant buffer
-    XMMATRIX mWorld = XMMatrixRotationQuaternion( m_vOrientation );
-    mWorld = mWorld * XMMatrixTranslationFromVector( m_vPosition );
-    mWorld = XMMatrixTranspose( mWorld );
+    RMatrix4x4 mWorld = RMatrix4x4RotationQuaternion( m_vOrientation );
+    mWorld.r[3] = RVecSet( m_vPosition.x, m_vPosition.y, m_vPosition.z, 1.0f );
+    mWorld.Transpose();
     m_pDeviceContext->UpdateSubresource( m_pWorldMatrixCB, 0, NULL, &mWorld, 0, 0 );
     m_pDeviceContext->VSSetConstantBuffers( 1, 1, &m_pWorldMatrixCB );
 
@@ -10,6 +10,7 @@ Modified by:    Kyle Weicht
 #define _D3DMESH_H_
 #include "Common.h"
 #include "Mesh.h"
+#include "PoolAllocator.h"
 
 struct ID3D11InputLayout;
 struct ID3D11Buffer;
@@ -19,6 +20,10 @@ class CD3DGraphics;
 
 class CD3DMesh : public CMesh
 {
+#pragma push_macro( "new" )
+#undef new
+    DECLARE_POOL_ALLOCATED( CD3DMesh )
+#pragma pop_macro( "new" )
     friend class CD3DGraphics;
 public:
     // CD3DMesh constructor
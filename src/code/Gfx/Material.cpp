@@ -6,11 +6,13 @@ Modified:       3/22/2011 6:50:33 PM
 Modified by:    Kyle Weicht
 \*********************************************************/
 #include "Material.h"
-#include "memory.h"
+#include "Memory.h"
 
 // CMaterial constructor
 CMaterial::CMaterial()
 {
+    // Materials own GPU shaders, so free them between frames
+    SetDeferDestruction( true );
 }
 
 // CMaterial destructor
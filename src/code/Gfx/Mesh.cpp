@@ -13,6 +13,8 @@ CMesh::CMesh()
     , m_nIndexCount( 0 )
     , m_nIndexSize( 0 )
 {
+    // Meshes own GPU buffers, so free them between frames
+    SetDeferDestruction( true );
 }
 
 // CMesh destructor
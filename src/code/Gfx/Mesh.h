@@ -11,8 +11,7 @@ Modified by:    Kyle Weicht
 #include "Common.h"
 #include "IRefCounted.h"
 #include "Types.h"
-#include <Windows.h>
-#include <xnamath.h>
+#include "RiotMath.h"
 
 
 /********************* File Format ***********************\
@@ -49,8 +48,8 @@ protected:
     /***************************************\
     | class members                         |
     \***************************************/
-    XMVECTOR    m_vPosition;
-    XMVECTOR    m_vOrientation;
+    RVector4    m_vPosition;
+    RQuaternion m_vOrientation;
     uint        m_nVertexSize;
     uint        m_nIndexCount;
     uint        m_nIndexSize;
@@ -0,0 +1,257 @@
+/*********************************************************\
+File:       NullGraphics.cpp
+Purpose:    A graphics device that draws nothing
+\*********************************************************/
+#include "NullGraphics.h"
+#include "NullMesh.h"
+#include "NullMaterial.h"
+#include "Window.h"
+#include "View.h"
+#include "Scene/Object.h"
+#include "Memory.h"
+#include "TraceCapture.h"
+#include <string.h>
+
+//////////////////////////////////////////
+// The cube CD3DGraphics::CreateMesh builds
+struct NullCubeVertex
+{
+    float   pPos[3];
+    float   pColor[4];
+};
+
+static const NullCubeVertex gs_pCubeVertices[] =
+{
+    { { -1.0f,  1.0f, -1.0f }, { 0.0f, 0.0f, 1.0f, 1.0f } },
+    { {  1.0f,  1.0f, -1.0f }, { 0.0f, 1.0f, 0.0f, 1.0f } },
+    { {  1.0f,  1.0f,  1.0f }, { 0.0f, 1.0f, 1.0f, 1.0f } },
+    { { -1.0f,  1.0f,  1.0f }, { 1.0f, 0.0f, 0.0f, 1.0f } },
+    { { -1.0f, -1.0f, -1.0f }, { 1.0f, 0.0f, 1.0f, 1.0f } },
+    { {  1.0f, -1.0f, -1.0f }, { 1.0f, 1.0f, 0.0f, 1.0f } },
+    { {  1.0f, -1.0f,  1.0f }, { 1.0f, 1.0f, 1.0f, 1.0f } },
+    { { -1.0f, -1.0f,  1.0f }, { 0.0f, 0.0f, 0.0f, 1.0f } },
+};
+
+static const uint16 gs_pCubeIndices[] =
+{
+    3,1,0,
+    2,1,3,
+
+    0,5,4,
+    1,5,0,
+
+    3,4,7,
+    0,4,3,
+
+    1,6,5,
+    2,6,1,
+
+    2,7,6,
+    3,7,2,
+
+    6,4,5,
+    7,4,6,
+};
+
+// CNullGraphics constructor
+CNullGraphics::CNullGraphics()
+    : m_pBoundMaterial( NULL )
+    , m_pBoundMesh( NULL )
+{
+    memset( &m_FrameStats, 0, sizeof( m_FrameStats ) );
+    memset( &m_LastFrameStats, 0, sizeof( m_LastFrameStats ) );
+    memset( &m_TotalStats, 0, sizeof( m_TotalStats ) );
+}
+
+// CNullGraphics destructor
+CNullGraphics::~CNullGraphics()
+{
+}
+/***************************************\
+| class methods                         |
+\***************************************/
+
+//-----------------------------------------------------------------------------
+//  Initialize
+//  Creates the device, then creates any other needed buffers, etc.
+//-----------------------------------------------------------------------------
+uint CNullGraphics::Initialize( CWindow* pWindow )
+{
+    uint nResult = CreateDevice( pWindow );
+    m_pViewProjCB[0].Identity();
+    m_pViewProjCB[1].Identity();
+    m_WorldCB.Identity();
+    return nResult;
+}
+
+//-----------------------------------------------------------------------------
+//  CreateDevice
+//  Creates the device, reading info from the window
+//-----------------------------------------------------------------------------
+uint CNullGraphics::CreateDevice( CWindow* pWindow )
+{
+    m_pWindow = pWindow;
+    CreateBuffers( pWindow->GetWidth(), pWindow->GetHeight() );
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+//  ReleaseBuffers
+//  Releases all buffers to prepare for a resize
+//-----------------------------------------------------------------------------
+void CNullGraphics::ReleaseBuffers( void )
+{
+}
+
+//-----------------------------------------------------------------------------
+//  CreateBuffers
+//  Creates all buffers required for rendering. There's no back buffer to
+//  write to, so there's nothing to create
+//-----------------------------------------------------------------------------
+void CNullGraphics::CreateBuffers( uint, uint )
+{
+}
+
+//-----------------------------------------------------------------------------
+//  PrepareRender
+//  Clears the screen to prepare for rendering
+//-----------------------------------------------------------------------------
+void CNullGraphics::PrepareRender( void )
+{
+    // Nothing is known to be bound at the start of a frame, so the first
+    // draw always counts its binds, the same as the D3D device's would be
+    m_pBoundMaterial = NULL;
+    m_pBoundMesh = NULL;
+}
+
+//-----------------------------------------------------------------------------
+//  Render
+//  Renders everything, the same way CD3DGraphics::Render does
+//-----------------------------------------------------------------------------
+void CNullGraphics::Render( CObject** ppObjects, uint nNumObjects )
+{
+    SetViewProj( &m_pCurrView->GetViewMatrix(), &m_pCurrView->GetProjMatrix() );
+
+    for( uint i = 0; i < nNumObjects; ++i )
+    {
+        CMaterial* pMaterial = ppObjects[i]->GetMaterial();
+        CMesh*     pMesh = ppObjects[i]->GetMesh();
+        if( pMesh && pMaterial )
+        {
+            pMaterial->ApplyMaterial();
+            pMesh->DrawMesh();
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//  Present
+//  Presents the frame, which here only closes off the frame's stats
+//-----------------------------------------------------------------------------
+void CNullGraphics::Present( void )
+{
+    m_TotalStats.nDraws += m_FrameStats.nDraws;
+    m_TotalStats.nTriangles += m_FrameStats.nTriangles;
+    m_TotalStats.nStateChanges += m_FrameStats.nStateChanges;
+    m_TotalStats.nBytesUploaded += m_FrameStats.nBytesUploaded;
+    m_LastFrameStats = m_FrameStats;
+    memset( &m_FrameStats, 0, sizeof( m_FrameStats ) );
+
+    TraceCounter( "Draws", (double)m_LastFrameStats.nDraws );
+    TraceCounter( "State changes", (double)m_LastFrameStats.nStateChanges );
+    TraceCounter( "Uploaded KB", (double)m_LastFrameStats.nBytesUploaded / 1024.0 );
+}
+
+//-----------------------------------------------------------------------------
+//  SetViewProj
+//  Sets the view projection constant buffer
+//-----------------------------------------------------------------------------
+void CNullGraphics::SetViewProj( const void* pView, const void* pProj )
+{
+    m_pViewProjCB[0] = Transpose( *( (const RMatrix4x4*)pView ) );
+    m_pViewProjCB[1] = Transpose( *( (const RMatrix4x4*)pProj ) );
+    m_FrameStats.nBytesUploaded += sizeof( m_pViewProjCB );
+}
+
+//-----------------------------------------------------------------------------
+//  CreateMesh
+//  Creates a mesh from the file. Like CD3DGraphics, this is always the cube
+//-----------------------------------------------------------------------------
+CMesh* CNullGraphics::CreateMesh( const wchar_t* )
+{
+    return CreateMesh( (void*)gs_pCubeVertices, sizeof( NullCubeVertex ), sizeof( gs_pCubeVertices ) / sizeof( gs_pCubeVertices[0] ),
+                       (void*)gs_pCubeIndices, 16, sizeof( gs_pCubeIndices ) / sizeof( gs_pCubeIndices[0] ) );
+}
+
+//-----------------------------------------------------------------------------
+//  CreateMesh
+//  Creates a mesh from memory
+//-----------------------------------------------------------------------------
+CMesh* CNullGraphics::CreateMesh( void* vertices, uint nVertexStride, uint nNumVertices,
+                                  void* indices, uint nIndexFormat, uint nNumIndices )
+{
+    MEMORY_CATEGORY( eMemoryCategoryAssets );
+
+    uint nVertexBytes = nVertexStride * nNumVertices;
+    uint nIndexBytes = ( nIndexFormat / 8 ) * nNumIndices;
+
+    CNullMesh* pMesh = new CNullMesh();
+    pMesh->m_pGraphics = this;
+    pMesh->m_pVertices = new byte[ nVertexBytes ];
+    pMesh->m_pIndices = new byte[ nIndexBytes ];
+    memcpy( pMesh->m_pVertices, vertices, nVertexBytes );
+    memcpy( pMesh->m_pIndices, indices, nIndexBytes );
+    pMesh->m_nVertexCount = nNumVertices;
+    pMesh->m_nVertexSize = nVertexStride;
+    pMesh->m_nIndexSize = nIndexFormat;
+    pMesh->m_nIndexCount = nNumIndices;
+
+    m_FrameStats.nBytesUploaded += nVertexBytes + nIndexBytes;
+    return pMesh;
+}
+
+//-----------------------------------------------------------------------------
+//  CreateMaterial
+//  Creates a material. There's no shader compiler, so the file isn't read
+//-----------------------------------------------------------------------------
+CMaterial* CNullGraphics::CreateMaterial( const wchar_t*, const char*, const char* )
+{
+    MEMORY_CATEGORY( eMemoryCategoryAssets );
+
+    CNullMaterial* pMaterial = new CNullMaterial();
+    pMaterial->m_pGraphics = this;
+    return pMaterial;
+}
+
+//-----------------------------------------------------------------------------
+//  ApplyMaterial
+//  A real device would set the pixel shader
+//-----------------------------------------------------------------------------
+void CNullGraphics::ApplyMaterial( const CNullMaterial* pMaterial )
+{
+    if( pMaterial != m_pBoundMaterial )
+    {
+        m_pBoundMaterial = pMaterial;
+        ++m_FrameStats.nStateChanges;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//  DrawMesh
+//  A real device would update the world matrix constant buffer, bind the
+//  mesh's shader and buffers if they weren't already, and draw
+//-----------------------------------------------------------------------------
+void CNullGraphics::DrawMesh( const CNullMesh* pMesh, const RMatrix4x4& mWorld )
+{
+    m_WorldCB = mWorld;
+    m_FrameStats.nBytesUploaded += sizeof( m_WorldCB );
+
+    if( pMesh != m_pBoundMesh )
+    {
+        m_pBoundMesh = pMesh;
+        ++m_FrameStats.nStateChanges;
+    }
+
+    ++m_FrameStats.nDraws;
+    m_FrameStats.nTriangles += pMesh->m_nIndexCount / 3;
+}
@@ -0,0 +1,146 @@
+/*********************************************************\
+File:       NullGraphics.h
+Purpose:    A graphics device that draws nothing. It keeps
+            CPU copies of everything it's given and counts
+            the work a real device would have done, so the
+            rest of the engine can run without a GPU
+\*********************************************************/
+#ifndef _NULLGRAPHICS_H_
+#define _NULLGRAPHICS_H_
+#include "Common.h"
+#include "Graphics.h"
+#include "RiotMath.h"
+
+class CNullMesh;
+class CNullMaterial;
+
+//-----------------------------------------------------------------------------
+//  NullGraphicsStats
+//  State changes are the binds a real device would have needed: a
+//  material or mesh that isn't the one already bound. Uploads are buffer
+//  creation and constant buffer updates
+//-----------------------------------------------------------------------------
+struct NullGraphicsStats
+{
+    uint64  nDraws;
+    uint64  nTriangles;
+    uint64  nStateChanges;
+    uint64  nBytesUploaded;
+};
+
+class CNullGraphics : public CGraphics
+{
+    friend class CNullMesh;
+    friend class CNullMaterial;
+public:
+    // CNullGraphics constructor
+    CNullGraphics();
+
+    // CNullGraphics destructor
+    ~CNullGraphics();
+    /***************************************\
+    | class methods                         |
+    \***************************************/
+
+    //-----------------------------------------------------------------------------
+    //  Initialize
+    //  Creates the device, then creates any other needed buffers, etc.
+    //-----------------------------------------------------------------------------
+    uint Initialize( CWindow* pWindow );
+
+    //-----------------------------------------------------------------------------
+    //  CreateDevice
+    //  Creates the device, reading info from the window
+    //-----------------------------------------------------------------------------
+    uint CreateDevice( CWindow* pWindow );
+
+    //-----------------------------------------------------------------------------
+    //  ReleaseBuffers
+    //  Releases all buffers to prepare for a resize
+    //-----------------------------------------------------------------------------
+    void ReleaseBuffers( void );
+
+    //-----------------------------------------------------------------------------
+    //  CreateBuffers
+    //  Creates all buffers required for rendering
+    //-----------------------------------------------------------------------------
+    void CreateBuffers( uint nWidth, uint nHeight );
+
+    //-----------------------------------------------------------------------------
+    //  PrepareRender
+    //  Clears the screen to prepare for rendering
+    //-----------------------------------------------------------------------------
+    void PrepareRender( void );
+
+    //-----------------------------------------------------------------------------
+    //  Render
+    //  Renders everything
+    //-----------------------------------------------------------------------------
+    void Render( CObject** ppObjects, uint nNumObjects );
+
+    //-----------------------------------------------------------------------------
+    //  Present
+    //  Presents the frame, which here only closes off the frame's stats
+    //-----------------------------------------------------------------------------
+    void Present( void );
+
+    //-----------------------------------------------------------------------------
+    //  SetViewProj
+    //  Sets the view projection constant buffer
+    //-----------------------------------------------------------------------------
+    void SetViewProj( const void* pView, const void* pProj );
+
+    //-----------------------------------------------------------------------------
+    //  GetFrameStats/GetTotalStats
+    //  The last presented frame's work, and everything since Initialize
+    //-----------------------------------------------------------------------------
+    const NullGraphicsStats& GetFrameStats( void ) const { return m_LastFrameStats; }
+    const NullGraphicsStats& GetTotalStats( void ) const { return m_TotalStats; }
+
+public:
+    /***************************************\
+    | object creation                       |
+    \***************************************/
+
+    //-----------------------------------------------------------------------------
+    //  CreateMesh
+    //  Creates a mesh from the file. Like CD3DGraphics, this is always the cube
+    //-----------------------------------------------------------------------------
+    CMesh* CreateMesh( const wchar_t* szFilename );
+
+    //-----------------------------------------------------------------------------
+    //  CreateMesh
+    //  Creates a mesh from memory
+    //-----------------------------------------------------------------------------
+    CMesh* CreateMesh( void* vertices, uint nVertexStride, uint nNumVertices,
+                       void* indices, uint nIndexFormat, uint nNumIndices );
+
+    //-----------------------------------------------------------------------------
+    //  CreateMaterial
+    //  Creates a material. There's no shader compiler, so the file isn't read
+    //-----------------------------------------------------------------------------
+    CMaterial* CreateMaterial( const wchar_t* szFilename, const char* szEntryPoint, const char* szProfile );
+
+private:
+    // Called by the meshes and materials in place of the device
+    void ApplyMaterial( const CNullMaterial* pMaterial );
+    void DrawMesh( const CNullMesh* pMesh, const RMatrix4x4& mWorld );
+
+private:
+    /***************************************\
+    | class members                         |
+    \***************************************/
+    // The constant buffers, as they'd be uploaded
+    RMatrix4x4              m_pViewProjCB[2];
+    RMatrix4x4              m_WorldCB;
+
+    const CNullMaterial*    m_pBoundMaterial;
+    const CNullMesh*        m_pBoundMesh;
+
+    NullGraphicsStats       m_FrameStats;
+    NullGraphicsStats       m_LastFrameStats;
+    NullGraphicsStats       m_TotalStats;
+};
+
+
+#endif // #ifndef _NULLGRAPHICS_H_
@@ -0,0 +1,32 @@
+/*********************************************************\
+File:       NullMaterial.cpp
+Purpose:    A material for CNullGraphics
+\*********************************************************/
+#include "NullMaterial.h"
+#include "NullGraphics.h"
+#include "Memory.h"
+
+#pragma push_macro( "new" )
+#undef new
+DEFINE_POOL_ALLOCATED( CNullMaterial, 256, eMemoryCategoryAssets )
+#pragma pop_macro( "new" )
+
+// CNullMaterial constructor
+CNullMaterial::CNullMaterial()
+    : m_pGraphics( NULL )
+{
+}
+
+// CNullMaterial destructor
+CNullMaterial::~CNullMaterial()
+{
+}
+
+//-----------------------------------------------------------------------------
+//  ApplyMaterial
+//  Applies the material to the pipeline
+//-----------------------------------------------------------------------------
+void CNullMaterial::ApplyMaterial( void )
+{
+    m_pGraphics->ApplyMaterial( this );
+}
@@ -0,0 +1,44 @@
+/*********************************************************\
+File:       NullMaterial.h
+Purpose:    A material for CNullGraphics
+\*********************************************************/
+#ifndef _NULLMATERIAL_H_
+#define _NULLMATERIAL_H_
+#include "Common.h"
+#include "Material.h"
+#include "PoolAllocator.h"
+
+class CNullGraphics;
+
+class CNullMaterial : public CMaterial
+{
+#pragma push_macro( "new" )
+#undef new
+    DECLARE_POOL_ALLOCATED( CNullMaterial )
+#pragma pop_macro( "new" )
+    friend class CNullGraphics;
+public:
+    // CNullMaterial constructor
+    CNullMaterial();
+
+    // CNullMaterial destructor
+    ~CNullMaterial();
+    /***************************************\
+    | class methods                         |
+    \***************************************/
+
+    //-----------------------------------------------------------------------------
+    //  ApplyMaterial
+    //  Applies the material to the pipeline
+    //-----------------------------------------------------------------------------
+    void ApplyMaterial( void );
+
+private:
+    /***************************************\
+    | class members                         |
+    \***************************************/
+    CNullGraphics*  m_pGraphics;
+};
+
+
+#endif // #ifndef _NULLMATERIAL_H_
@@ -0,0 +1,41 @@
+/*********************************************************\
+File:       NullMesh.cpp
+Purpose:    A mesh for CNullGraphics
+\*********************************************************/
+#include "NullMesh.h"
+#include "NullGraphics.h"
+#include "Memory.h"
+
+#pragma push_macro( "new" )
+#undef new
+DEFINE_POOL_ALLOCATED( CNullMesh, 256, eMemoryCategoryAssets )
+#pragma pop_macro( "new" )
+
+// CNullMesh constructor
+CNullMesh::CNullMesh()
+    : m_pGraphics( NULL )
+    , m_pVertices( NULL )
+    , m_pIndices( NULL )
+    , m_nVertexCount( 0 )
+{
+}
+
+// CNullMesh destructor
+CNullMesh::~CNullMesh()
+{
+    SAFE_DELETE_ARRAY( m_pVertices );
+    SAFE_DELETE_ARRAY( m_pIndices );
+}
+
+//-----------------------------------------------------------------------------
+//  DrawMesh
+//  Builds the world matrix, and hands it to the device to count
+//-----------------------------------------------------------------------------
+void CNullMesh::DrawMesh( void )
+{
+    // The same world matrix CD3DMesh uploads
+    RMatrix4x4 mWorld = RMatrix4x4RotationQuaternion( m_vOrientation );
+    mWorld.r[3] = RVecSet( m_vPosition.x, m_vPosition.y, m_vPosition.z, 1.0f );
+    mWorld.Transpose();
+    m_pGraphics->DrawMesh( this, mWorld );
+}
@@ -0,0 +1,48 @@
+/*********************************************************\
+File:       NullMesh.h
+Purpose:    A mesh for CNullGraphics, with its vertex and
+            index buffers kept in system memory
+\*********************************************************/
+#ifndef _NULLMESH_H_
+#define _NULLMESH_H_
+#include "Common.h"
+#include "Mesh.h"
+#include "PoolAllocator.h"
+
+class CNullGraphics;
+
+class CNullMesh : public CMesh
+{
+#pragma push_macro( "new" )
+#undef new
+    DECLARE_POOL_ALLOCATED( CNullMesh )
+#pragma pop_macro( "new" )
+    friend class CNullGraphics;
+public:
+    // CNullMesh constructor
+    CNullMesh();
+
+    // CNullMesh destructor
+    ~CNullMesh();
+    /***************************************\
+    | class methods                         |
+    \***************************************/
+
+    //-----------------------------------------------------------------------------
+    //  DrawMesh
+    //  Builds the world matrix, and hands it to the device to count
+    //-----------------------------------------------------------------------------
+    void DrawMesh( void );
+
+private:
+    /***************************************\
+    | class members                         |
+    \***************************************/
+    CNullGraphics*  m_pGraphics;
+    byte*           m_pVertices;
+    byte*           m_pIndices;
+    uint            m_nVertexCount;
+};
+
+
+#endif // #ifndef _NULLMESH_H_
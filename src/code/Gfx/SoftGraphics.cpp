@@ -0,0 +1,1423 @@
+/*********************************************************\
+File:       SoftGraphics.cpp
+Purpose:    A software rasterizer
+\*********************************************************/
+#include "SoftGraphics.h"
+#include "SoftMesh.h"
+#include "SoftMaterial.h"
+#include "Window.h"
+#include "View.h"
+#include "Scene/Object.h"
+#include "MathStream.h"
+#include "PackedVector.h"
+#include "Memory.h"
+#include "Atomic.h"
+#include "Timer.h"
+#include "Profiler.h"
+#include "TraceCapture.h"
+#include <stdlib.h> // For getenv
+#include <string.h>
+
+#if defined( OS_WINDOWS )
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h> // For sysconf
+#endif // #if defined( OS_WINDOWS )
+#define new DEBUG_NEW
+
+/**********************************************************\
+|**********************************************************|
+| The pipeline
+|
+| Vertex    The frame's vertices are split into chunks.
+|           Each is transformed by its draw's world view
+|           projection with the stream kernels, then
+|           projected to the screen and given an outcode
+|           saying which clip planes it's outside of
+| Bin       The frame's triangles are split into a run
+|           per bin. Triangles outside the screen or
+|           facing away are dropped, ones crossing the
+|           near or far plane or the guard band are
+|           clipped, and the rest are set up for
+|           rasterizing and listed in every tile their
+|           bounds touch
+| Raster    Each tile is cleared, then every triangle
+|           listed for it is rasterized, 4 pixels at a
+|           time, and depth tested. A tile belongs to one
+|           thread, so nothing is locked
+|
+| Screen positions are fixed point, in 1/16ths of a
+| pixel from the middle of the screen. The guard band
+| keeps them within 4000 pixels, so an edge function
+| steps by less than 2^21 a pixel, and changes by less
+| than 2^28 across a tile
+|**********************************************************|
+\**********************************************************/
+static const uint   gs_nSoftTileShift       = 6;
+static const uint   gs_nSoftTileSize        = 1 << gs_nSoftTileShift;
+static const uint   gs_nSoftVertexChunk     = 4096;
+static const uint   gs_nMaxSoftThreads      = 64;
+static const uint   gs_nMaxSoftBufferSize   = 4096;
+static const float  gs_fSoftGuardBand       = 4000.0f;  // Pixels from the middle of the screen
+
+// The same clear color as CD3DGraphics, { 0.25, 0.25, 0.75, 1 }
+static const uint32 gs_nSoftClearColor      = 0xFFBF4040;
+
+// Outcodes, one bit for each clip plane a vertex is outside of
+enum
+{
+    eSoftClipLeft   = 0x01,
+    eSoftClipRight  = 0x02,
+    eSoftClipTop    = 0x04,
+    eSoftClipBottom = 0x08,
+    eSoftClipNear   = 0x10,
+    eSoftClipFar    = 0x20,
+    eNUMSOFTCLIPPLANES = 6
+};
+
+//-----------------------------------------------------------------------------
+//  SoftDraw
+//  A mesh drawn this frame, and where its vertices and triangles are in the
+//  frame's
+//-----------------------------------------------------------------------------
+struct SoftDraw
+{
+    RMatrix4x4          mWorldViewProj;
+    const CSoftMesh*    pMesh;
+    uint                nFirstVertex;
+    uint                nFirstTriangle;
+    uint                nNumTriangles;
+};
+
+//-----------------------------------------------------------------------------
+//  SoftTriangle
+//  A triangle set up for rasterizing. An edge function is
+//  A * x + B * y + C at pixel (x, y), and is positive inside the triangle.
+//  The planes are a * x + b * y + c, and hold the depth, 1 / w, and the
+//  color over w, so the color can be interpolated with perspective
+//-----------------------------------------------------------------------------
+struct SoftTriangle
+{
+    sint64  pEdgeC[3];
+    sint32  pEdgeA[3];
+    sint32  pEdgeB[3];
+    sint32  nMinX, nMinY;       // The pixels it could cover, inclusive
+    sint32  nMaxX, nMaxY;
+    float   pDepth[3];
+    float   pRecipW[3];
+    float   pColor[4][3];
+};
+
+//-----------------------------------------------------------------------------
+//  SoftBin/SoftTileBin
+//  A bin's set up triangles, and which of them touch a tile. Their arrays
+//  only ever grow, so after the first few frames nothing is allocated
+//-----------------------------------------------------------------------------
+struct SoftBin
+{
+    SoftTriangle*   pTriangles;
+    uint            nNumTriangles;
+    uint            nMaxTriangles;
+    uint            nNumTileTriangles;
+};
+
+struct SoftTileBin
+{
+    uint*           pTriangles;
+    uint            nNumTriangles;
+    uint            nMaxTriangles;
+};
+
+//-----------------------------------------------------------------------------
+//  SoftScreenVertex/SoftClipVertex
+//  A vertex ready for setup, and one in clip space, for clipping
+//-----------------------------------------------------------------------------
+struct SoftScreenVertex
+{
+    sint32  nX, nY;
+    float   fDepth;
+    float   fRecipW;
+    float   pColor[4];
+};
+
+struct SoftClipVertex
+{
+    float   pPosition[4];
+    float   pColor[4];
+};
+
+//-----------------------------------------------------------------------------
+//  GrowArray
+//  Makes room for nNeeded elements, keeping the first nCount. Called from
+//  the workers mid-frame, but only until the arrays are big enough
+//-----------------------------------------------------------------------------
+template< class T >
+static void GrowArray( T** ppArray, uint* pnMax, uint nCount, uint nNeeded )
+{
+    if( nNeeded <= *pnMax )
+    {
+        return;
+    }
+
+    ALLOW_FRAME_ALLOCATIONS();
+    MEMORY_CATEGORY( eMemoryCategoryGfx );
+    uint nMax = *pnMax ? *pnMax * 2 : 64;
+    while( nMax < nNeeded )
+    {
+        nMax *= 2;
+    }
+    T* pArray = new T[ nMax ];
+    if( nCount > 0 )
+    {
+        memcpy( pArray, *ppArray, sizeof( T ) * nCount );
+    }
+    SAFE_DELETE_ARRAY( *ppArray );
+    *ppArray = pArray;
+    *pnMax = nMax;
+}
+
+//-----------------------------------------------------------------------------
+//  FindDraw
+//  The last draw starting at or before nItem, going by pnFirst. That's the
+//  one nItem is in, as empty draws start where the next one does
+//-----------------------------------------------------------------------------
+static uint FindDraw( const SoftDraw* pDraws, uint nNumDraws, uint SoftDraw::* pnFirst, uint nItem )
+{
+    uint nLow = 0;
+    uint nHigh = nNumDraws;
+    while( nHigh - nLow > 1 )
+    {
+        uint nMiddle = ( nLow + nHigh ) / 2;
+        if( pDraws[nMiddle].*pnFirst <= nItem )
+            nLow = nMiddle;
+        else
+            nHigh = nMiddle;
+    }
+    return nLow;
+}
+
+/**********************************************************\
+|**********************************************************|
+| Vertex stage
+|**********************************************************|
+\**********************************************************/
+
+//-----------------------------------------------------------------------------
+//  ProjectToScreen
+//  Divides by w, and scales to fixed point screen positions. fScaleX and
+//  fScaleY are 8 times the width and height, flipping y so it goes down.
+//  The screen position and depth are only good when the outcode is 0
+//-----------------------------------------------------------------------------
+static void ScalarProjectToScreen( const float* pX, const float* pY, const float* pZ, const float* pW,
+                                   float fScaleX, float fScaleY, float fGuardX, float fGuardY,
+                                   sint32* pScreenX, sint32* pScreenY, float* pDepth, float* pRecipW,
+                                   uint8* pOutcodes, uint nCount )
+{
+    for( uint i = 0; i < nCount; ++i )
+    {
+        float fX = pX[i], fY = pY[i], fZ = pZ[i], fW = pW[i];
+        uint nOutcode = 0;
+        nOutcode |= ( fX < -fGuardX * fW ) ? eSoftClipLeft : 0;
+        nOutcode |= ( fX >  fGuardX * fW ) ? eSoftClipRight : 0;
+        nOutcode |= ( fY >  fGuardY * fW ) ? eSoftClipTop : 0;
+        nOutcode |= ( fY < -fGuardY * fW ) ? eSoftClipBottom : 0;
+        nOutcode |= ( fZ < 0.0f ) ? eSoftClipNear : 0;
+        nOutcode |= ( fZ > fW ) ? eSoftClipFar : 0;
+        pOutcodes[i] = (uint8)nOutcode;
+        if( nOutcode == 0 )
+        {
+            float fRecipW = 1.0f / fW;
+            pScreenX[i] = (sint32)floorf( fX * fRecipW * fScaleX + 0.5f );
+            pScreenY[i] = (sint32)floorf( fY * fRecipW * fScaleY + 0.5f );
+            pDepth[i] = fZ * fRecipW;
+            pRecipW[i] = fRecipW;
+        }
+    }
+}
+
+#if defined( RIOT_SSE )
+static void SSEProjectToScreen( const float* pX, const float* pY, const float* pZ, const float* pW,
+                                float fScaleX, float fScaleY, float fGuardX, float fGuardY,
+                                sint32* pScreenX, sint32* pScreenY, float* pDepth, float* pRecipW,
+                                uint8* pOutcodes, uint nCount )
+{
+    __m128 vOne = _mm_set1_ps( 1.0f );
+    __m128 vZero = _mm_setzero_ps();
+    __m128 vScaleX = _mm_set1_ps( fScaleX ), vScaleY = _mm_set1_ps( fScaleY );
+    __m128 vGuardX = _mm_set1_ps( fGuardX ), vGuardY = _mm_set1_ps( fGuardY );
+    __m128 vSignBit = _mm_set1_ps( -0.0f );
+
+    uint nVectorCount = nCount & ~3;
+    for( uint i = 0; i < nVectorCount; i += 4 )
+    {
+        __m128 vX = _mm_loadu_ps( pX + i ), vY = _mm_loadu_ps( pY + i );
+        __m128 vZ = _mm_loadu_ps( pZ + i ), vW = _mm_loadu_ps( pW + i );
+
+        // Outcodes. Everything outside has been divided by
+        // nonsense, but the outcode says not to use it
+        __m128 vLimitX = _mm_mul_ps( vW, vGuardX ), vLimitY = _mm_mul_ps( vW, vGuardY );
+        __m128 vNegLimitX = _mm_xor_ps( vLimitX, vSignBit ), vNegLimitY = _mm_xor_ps( vLimitY, vSignBit );
+        __m128i vOutcode = _mm_and_si128( _mm_castps_si128( _mm_cmplt_ps( vX, vNegLimitX ) ), _mm_set1_epi32( eSoftClipLeft ) );
+        vOutcode = _mm_or_si128( vOutcode, _mm_and_si128( _mm_castps_si128( _mm_cmpgt_ps( vX, vLimitX ) ), _mm_set1_epi32( eSoftClipRight ) ) );
+        vOutcode = _mm_or_si128( vOutcode, _mm_and_si128( _mm_castps_si128( _mm_cmpgt_ps( vY, vLimitY ) ), _mm_set1_epi32( eSoftClipTop ) ) );
+        vOutcode = _mm_or_si128( vOutcode, _mm_and_si128( _mm_castps_si128( _mm_cmplt_ps( vY, vNegLimitY ) ), _mm_set1_epi32( eSoftClipBottom ) ) );
+        vOutcode = _mm_or_si128( vOutcode, _mm_and_si128( _mm_castps_si128( _mm_cmplt_ps( vZ, vZero ) ), _mm_set1_epi32( eSoftClipNear ) ) );
+        vOutcode = _mm_or_si128( vOutcode, _mm_and_si128( _mm_castps_si128( _mm_cmpgt_ps( vZ, vW ) ), _mm_set1_epi32( eSoftClipFar ) ) );
+        vOutcode = _mm_packs_epi32( vOutcode, vOutcode );
+        vOutcode = _mm_packus_epi16( vOutcode, vOutcode );
+        *(uint32*)( pOutcodes + i ) = (uint32)_mm_cvtsi128_si32( vOutcode );
+
+        __m128 vRecipW = _mm_div_ps( vOne, vW );
+        _mm_storeu_si128( (__m128i*)( pScreenX + i ), _mm_cvtps_epi32( _mm_mul_ps( _mm_mul_ps( vX, vRecipW ), vScaleX ) ) );
+        _mm_storeu_si128( (__m128i*)( pScreenY + i ), _mm_cvtps_epi32( _mm_mul_ps( _mm_mul_ps( vY, vRecipW ), vScaleY ) ) );
+        _mm_storeu_ps( pDepth + i, _mm_mul_ps( vZ, vRecipW ) );
+        _mm_storeu_ps( pRecipW + i, vRecipW );
+    }
+    ScalarProjectToScreen( pX + nVectorCount, pY + nVectorCount, pZ + nVectorCount, pW + nVectorCount,
+                           fScaleX, fScaleY, fGuardX, fGuardY,
+                           pScreenX + nVectorCount, pScreenY + nVectorCount, pDepth + nVectorCount, pRecipW + nVectorCount,
+                           pOutcodes + nVectorCount, nCount - nVectorCount );
+}
+#endif // #if defined( RIOT_SSE )
+
+/**********************************************************\
+|**********************************************************|
+| Bin stage
+|**********************************************************|
+\**********************************************************/
+
+//-----------------------------------------------------------------------------
+//  ClipPolygon
+//  Clips a convex polygon against one plane, returning how many vertices
+//  are left. Every plane keeps the side where its distance is positive
+//-----------------------------------------------------------------------------
+static float ClipDistance( const SoftClipVertex& V, uint nPlane, float fGuardX, float fGuardY )
+{
+    const float* p = V.pPosition;
+    switch( nPlane )
+    {
+    case 0:     return p[0] + fGuardX * p[3];
+    case 1:     return fGuardX * p[3] - p[0];
+    case 2:     return fGuardY * p[3] - p[1];
+    case 3:     return p[1] + fGuardY * p[3];
+    case 4:     return p[2];
+    default:    return p[3] - p[2];
+    }
+}
+
+static uint ClipPolygon( const SoftClipVertex* pIn, uint nNumIn, SoftClipVertex* pOut, uint nPlane, float fGuardX, float fGuardY )
+{
+    uint nNumOut = 0;
+    const SoftClipVertex* pPrev = &pIn[ nNumIn - 1 ];
+    float fPrevDistance = ClipDistance( *pPrev, nPlane, fGuardX, fGuardY );
+    for( uint i = 0; i < nNumIn; ++i )
+    {
+        const SoftClipVertex* pCurr = &pIn[i];
+        float fDistance = ClipDistance( *pCurr, nPlane, fGuardX, fGuardY );
+        if( ( fPrevDistance >= 0.0f ) != ( fDistance >= 0.0f ) )
+        {   // The edge crosses the plane
+            float fT = fPrevDistance / ( fPrevDistance - fDistance );
+            SoftClipVertex& Out = pOut[ nNumOut++ ];
+            for( uint j = 0; j < 4; ++j )
+            {
+                Out.pPosition[j] = pPrev->pPosition[j] + ( pCurr->pPosition[j] - pPrev->pPosition[j] ) * fT;
+                Out.pColor[j] = pPrev->pColor[j] + ( pCurr->pColor[j] - pPrev->pColor[j] ) * fT;
+            }
+        }
+        if( fDistance >= 0.0f )
+        {
+            pOut[ nNumOut++ ] = *pCurr;
+        }
+        pPrev = pCurr;
+        fPrevDistance = fDistance;
+    }
+    return nNumOut;
+}
+
+//-----------------------------------------------------------------------------
+//  UnpackColor
+//  R8G8B8A8 to floats
+//-----------------------------------------------------------------------------
+static void UnpackColor( uint32 nColor, float* pColor )
+{
+    static const float fScale = 1.0f / 255.0f;
+    pColor[0] = (float)( nColor & 0xFF ) * fScale;
+    pColor[1] = (float)( ( nColor >> 8 ) & 0xFF ) * fScale;
+    pColor[2] = (float)( ( nColor >> 16 ) & 0xFF ) * fScale;
+    pColor[3] = (float)( nColor >> 24 ) * fScale;
+}
+
+//-----------------------------------------------------------------------------
+//  SetupPlane
+//  The plane through the three values at the three vertices. fU and fV
+//  are the vertices' positions in pixels, relative to the first
+//-----------------------------------------------------------------------------
+static void SetupPlane( float fValue0, float fValue1, float fValue2,
+                        float fU0, float fV0, float fU1, float fV1, float fU2, float fV2,
+                        float fRecipDet, float* pPlane )
+{
+    float fDelta1 = fValue1 - fValue0;
+    float fDelta2 = fValue2 - fValue0;
+    pPlane[0] = ( fDelta1 * fV2 - fDelta2 * fV1 ) * fRecipDet;
+    pPlane[1] = ( fDelta2 * fU1 - fDelta1 * fU2 ) * fRecipDet;
+    pPlane[2] = fValue0 - pPlane[0] * fU0 - pPlane[1] * fV0;
+}
+
+//-----------------------------------------------------------------------------
+//  SetupTriangle
+//  Sets up a triangle for rasterizing. Returns false if it faces away or
+//  doesn't cover any pixel centers. Like D3D's defaults, triangles that
+//  are clockwise on screen face forward, and pixel centers exactly on an
+//  edge are only drawn if it's a top or left edge
+//-----------------------------------------------------------------------------
+static bool SetupTriangle( const SoftScreenVertex& V0, const SoftScreenVertex& V1, const SoftScreenVertex& V2,
+                           uint nWidth, uint nHeight, SoftTriangle* pTriangle )
+{
+    sint64 nArea = (sint64)( V1.nX - V0.nX ) * ( V2.nY - V0.nY ) - (sint64)( V2.nX - V0.nX ) * ( V1.nY - V0.nY );
+    if( nArea <= 0 )
+    {
+        return false;
+    }
+
+    // The pixels whose centers are within the bounds. Pixel x's center is
+    // at 16 * x + 8 - 8 * nWidth
+    sint32 nOffsetX = (sint32)nWidth * 8 - 8;
+    sint32 nOffsetY = (sint32)nHeight * 8 - 8;
+    sint32 nLeft = V0.nX < V1.nX ? ( V0.nX < V2.nX ? V0.nX : V2.nX ) : ( V1.nX < V2.nX ? V1.nX : V2.nX );
+    sint32 nRight = V0.nX > V1.nX ? ( V0.nX > V2.nX ? V0.nX : V2.nX ) : ( V1.nX > V2.nX ? V1.nX : V2.nX );
+    sint32 nTop = V0.nY < V1.nY ? ( V0.nY < V2.nY ? V0.nY : V2.nY ) : ( V1.nY < V2.nY ? V1.nY : V2.nY );
+    sint32 nBottom = V0.nY > V1.nY ? ( V0.nY > V2.nY ? V0.nY : V2.nY ) : ( V1.nY > V2.nY ? V1.nY : V2.nY );
+    pTriangle->nMinX = ( nLeft + nOffsetX + 15 ) >> 4;
+    pTriangle->nMinY = ( nTop + nOffsetY + 15 ) >> 4;
+    pTriangle->nMaxX = ( nRight + nOffsetX ) >> 4;
+    pTriangle->nMaxY = ( nBottom + nOffsetY ) >> 4;
+    pTriangle->nMinX = pTriangle->nMinX > 0 ? pTriangle->nMinX : 0;
+    pTriangle->nMinY = pTriangle->nMinY > 0 ? pTriangle->nMinY : 0;
+    pTriangle->nMaxX = pTriangle->nMaxX < (sint32)nWidth - 1 ? pTriangle->nMaxX : (sint32)nWidth - 1;
+    pTriangle->nMaxY = pTriangle->nMaxY < (sint32)nHeight - 1 ? pTriangle->nMaxY : (sint32)nHeight - 1;
+    if( pTriangle->nMinX > pTriangle->nMaxX || pTriangle->nMinY > pTriangle->nMaxY )
+    {
+        return false;
+    }
+
+    // Edge functions, moved so they're in whole pixels from the corner of
+    // the screen. Going clockwise a left edge goes up, and a top edge
+    // goes right
+    const SoftScreenVertex* pVertices[3] = { &V0, &V1, &V2 };
+    for( uint nEdge = 0; nEdge < 3; ++nEdge )
+    {
+        const SoftScreenVertex& A = *pVertices[ nEdge ];
+        const SoftScreenVertex& B = *pVertices[ nEdge == 2 ? 0 : nEdge + 1 ];
+        sint32 nA = A.nY - B.nY;
+        sint32 nB = B.nX - A.nX;
+        sint64 nC = -( (sint64)nA * A.nX + (sint64)nB * A.nY );
+        nC -= (sint64)nA * nOffsetX + (sint64)nB * nOffsetY;
+        bool bTopLeft = nA > 0 || ( nA == 0 && nB > 0 );
+        pTriangle->pEdgeA[ nEdge ] = nA * 16;
+        pTriangle->pEdgeB[ nEdge ] = nB * 16;
+        pTriangle->pEdgeC[ nEdge ] = bTopLeft ? nC : nC - 1;
+    }
+
+    // Planes over the pixels, relative to the first vertex
+    float fU1 = (float)( V1.nX - V0.nX ) * ( 1.0f / 16.0f ), fV1 = (float)( V1.nY - V0.nY ) * ( 1.0f / 16.0f );
+    float fU2 = (float)( V2.nX - V0.nX ) * ( 1.0f / 16.0f ), fV2 = (float)( V2.nY - V0.nY ) * ( 1.0f / 16.0f );
+    float fU0 = (float)( V0.nX + nOffsetX ) * ( 1.0f / 16.0f ), fV0 = (float)( V0.nY + nOffsetY ) * ( 1.0f / 16.0f );
+    float fRecipDet = 256.0f / (float)nArea;
+    SetupPlane( V0.fDepth, V1.fDepth, V2.fDepth, fU0, fV0, fU1, fV1, fU2, fV2, fRecipDet, pTriangle->pDepth );
+    SetupPlane( V0.fRecipW, V1.fRecipW, V2.fRecipW, fU0, fV0, fU1, fV1, fU2, fV2, fRecipDet, pTriangle->pRecipW );
+    for( uint i = 0; i < 4; ++i )
+    {
+        SetupPlane( V0.pColor[i] * V0.fRecipW, V1.pColor[i] * V1.fRecipW, V2.pColor[i] * V2.fRecipW,
+                    fU0, fV0, fU1, fV1, fU2, fV2, fRecipDet, pTriangle->pColor[i] );
+    }
+    return true;
+}
+
+/**********************************************************\
+|**********************************************************|
+| Raster stage
+|**********************************************************|
+\**********************************************************/
+
+//-----------------------------------------------------------------------------
+//  ClampEdge
+//  An edge function's value at the corner of the area being rasterized.
+//  Anything past 2^30 can't change sign within a tile, so it's clamped to
+//  fit the 32 bit steps
+//-----------------------------------------------------------------------------
+static sint32 ClampEdge( const SoftTriangle& Triangle, uint nEdge, sint32 nX, sint32 nY )
+{
+    static const sint64 nLimit = (sint64)1 << 30;
+    sint64 nValue = (sint64)Triangle.pEdgeA[nEdge] * nX + (sint64)Triangle.pEdgeB[nEdge] * nY + Triangle.pEdgeC[nEdge];
+    nValue = nValue > nLimit ? nLimit : nValue;
+    nValue = nValue < -nLimit ? -nLimit : nValue;
+    return (sint32)nValue;
+}
+
+//-----------------------------------------------------------------------------
+//  RasterizeTriangle
+//  Draws the part of a triangle within the tile from (nTileX, nTileY).
+//  Pixels are done in groups of 4 starting on a multiple of 4, which can
+//  run past the screen's right edge into the padding, but never past the
+//  tile's
+//-----------------------------------------------------------------------------
+static void RasterizeTriangle( const SoftTriangle& Triangle, sint32 nTileX, sint32 nTileY,
+                               uint32* pColorBuffer, float* pDepthBuffer, uint nPitch )
+{
+    sint32 nMinX = Triangle.nMinX > nTileX ? Triangle.nMinX : nTileX;
+    sint32 nMinY = Triangle.nMinY > nTileY ? Triangle.nMinY : nTileY;
+    sint32 nMaxX = Triangle.nMaxX < nTileX + (sint32)gs_nSoftTileSize - 1 ? Triangle.nMaxX : nTileX + (sint32)gs_nSoftTileSize - 1;
+    sint32 nMaxY = Triangle.nMaxY < nTileY + (sint32)gs_nSoftTileSize - 1 ? Triangle.nMaxY : nTileY + (sint32)gs_nSoftTileSize - 1;
+    if( nMinX > nMaxX || nMinY > nMaxY )
+    {
+        return;
+    }
+    nMinX &= ~3;
+
+    sint32 pEdgeRow[3];
+    for( uint nEdge = 0; nEdge < 3; ++nEdge )
+    {
+        pEdgeRow[nEdge] = ClampEdge( Triangle, nEdge, nMinX, nMinY );
+    }
+
+#if defined( RIOT_SSE )
+    __m128i pRowE[3], pStepE[3];
+    for( uint nEdge = 0; nEdge < 3; ++nEdge )
+    {
+        sint32 nA = Triangle.pEdgeA[nEdge];
+        pRowE[nEdge] = _mm_add_epi32( _mm_set1_epi32( pEdgeRow[nEdge] ), _mm_set_epi32( nA * 3, nA * 2, nA, 0 ) );
+        pStepE[nEdge] = _mm_set1_epi32( nA * 4 );
+    }
+    __m128 vLanes = _mm_set_ps( 3.0f, 2.0f, 1.0f, 0.0f );
+    __m128 vOne = _mm_set1_ps( 1.0f );
+    __m128 vZero = _mm_setzero_ps();
+    __m128 v255 = _mm_set1_ps( 255.0f );
+    __m128 vDepthA = _mm_set1_ps( Triangle.pDepth[0] );
+    __m128 vRecipWA = _mm_set1_ps( Triangle.pRecipW[0] );
+    __m128 pColorA[4];
+    for( uint i = 0; i < 4; ++i )
+    {
+        pColorA[i] = _mm_set1_ps( Triangle.pColor[i][0] );
+    }
+
+    for( sint32 nY = nMinY; nY <= nMaxY; ++nY )
+    {
+        // Each plane's b * y + c is the same across the row
+        float fY = (float)nY;
+        __m128 vDepthRow = _mm_set1_ps( Triangle.pDepth[1] * fY + Triangle.pDepth[2] );
+        __m128 vRecipWRow = _mm_set1_ps( Triangle.pRecipW[1] * fY + Triangle.pRecipW[2] );
+        __m128i vE0 = pRowE[0], vE1 = pRowE[1], vE2 = pRowE[2];
+        uint32* pColorRow = pColorBuffer + nY * nPitch;
+        float* pDepthRow = pDepthBuffer + nY * nPitch;
+
+        for( sint32 nX = nMinX; nX <= nMaxX; nX += 4 )
+        {
+            __m128i vOutside = _mm_srai_epi32( _mm_or_si128( _mm_or_si128( vE0, vE1 ), vE2 ), 31 );
+            vE0 = _mm_add_epi32( vE0, pStepE[0] );
+            vE1 = _mm_add_epi32( vE1, pStepE[1] );
+            vE2 = _mm_add_epi32( vE2, pStepE[2] );
+            if( _mm_movemask_epi8( vOutside ) == 0xFFFF )
+            {
+                continue;
+            }
+
+            __m128 vX = _mm_add_ps( _mm_set1_ps( (float)nX ), vLanes );
+            __m128 vDepth = _mm_add_ps( _mm_mul_ps( vDepthA, vX ), vDepthRow );
+            __m128 vOldDepth = _mm_loadu_ps( pDepthRow + nX );
+            __m128 vPass = _mm_andnot_ps( _mm_castsi128_ps( vOutside ), _mm_cmplt_ps( vDepth, vOldDepth ) );
+            if( _mm_movemask_ps( vPass ) == 0 )
+            {
+                continue;
+            }
+            _mm_storeu_ps( pDepthRow + nX, _mm_or_ps( _mm_and_ps( vPass, vDepth ), _mm_andnot_ps( vPass, vOldDepth ) ) );
+
+            // Color over w, back to color
+            __m128 vW = _mm_div_ps( vOne, _mm_add_ps( _mm_mul_ps( vRecipWA, vX ), vRecipWRow ) );
+            __m128i vColor = _mm_setzero_si128();
+            for( uint i = 0; i < 4; ++i )
+            {
+                __m128 vChannel = _mm_add_ps( _mm_mul_ps( pColorA[i], vX ), _mm_set1_ps( Triangle.pColor[i][1] * fY + Triangle.pColor[i][2] ) );
+                vChannel = _mm_mul_ps( _mm_min_ps( _mm_max_ps( _mm_mul_ps( vChannel, vW ), vZero ), vOne ), v255 );
+                vColor = _mm_or_si128( vColor, _mm_slli_epi32( _mm_cvtps_epi32( vChannel ), i * 8 ) );
+            }
+            __m128i vOldColor = _mm_loadu_si128( (const __m128i*)( pColorRow + nX ) );
+            __m128i vPassMask = _mm_castps_si128( vPass );
+            _mm_storeu_si128( (__m128i*)( pColorRow + nX ), _mm_or_si128( _mm_and_si128( vPassMask, vColor ), _mm_andnot_si128( vPassMask, vOldColor ) ) );
+        }
+
+        for( uint nEdge = 0; nEdge < 3; ++nEdge )
+        {
+            pRowE[nEdge] = _mm_add_epi32( pRowE[nEdge], _mm_set1_epi32( Triangle.pEdgeB[nEdge] ) );
+        }
+    }
+#else
+    for( sint32 nY = nMinY; nY <= nMaxY; ++nY )
+    {
+        float fY = (float)nY;
+        sint32 nE0 = pEdgeRow[0], nE1 = pEdgeRow[1], nE2 = pEdgeRow[2];
+        uint32* pColorRow = pColorBuffer + nY * nPitch;
+        float* pDepthRow = pDepthBuffer + nY * nPitch;
+
+        for( sint32 nX = nMinX; nX < nMaxX + 4 - ( ( nMaxX - nMinX ) & 3 ); ++nX )
+        {
+            bool bInside = ( nE0 | nE1 | nE2 ) >= 0;
+            nE0 += Triangle.pEdgeA[0];
+            nE1 += Triangle.pEdgeA[1];
+            nE2 += Triangle.pEdgeA[2];
+            if( !bInside )
+            {
+                continue;
+            }
+
+            float fX = (float)nX;
+            float fDepth = Triangle.pDepth[0] * fX + Triangle.pDepth[1] * fY + Triangle.pDepth[2];
+            if( !( fDepth < pDepthRow[nX] ) )
+            {
+                continue;
+            }
+            pDepthRow[nX] = fDepth;
+
+            float fW = 1.0f / ( Triangle.pRecipW[0] * fX + Triangle.pRecipW[1] * fY + Triangle.pRecipW[2] );
+            uint32 nColor = 0;
+            for( uint i = 0; i < 4; ++i )
+            {
+                float fChannel = ( Triangle.pColor[i][0] * fX + Triangle.pColor[i][1] * fY + Triangle.pColor[i][2] ) * fW;
+                fChannel = fChannel < 0.0f ? 0.0f : ( fChannel > 1.0f ? 1.0f : fChannel );
+                nColor |= (uint32)( fChannel * 255.0f + 0.5f ) << ( i * 8 );
+            }
+            pColorRow[nX] = nColor;
+        }
+
+        pEdgeRow[0] += Triangle.pEdgeB[0];
+        pEdgeRow[1] += Triangle.pEdgeB[1];
+        pEdgeRow[2] += Triangle.pEdgeB[2];
+    }
+#endif // #if defined( RIOT_SSE )
+}
+
+/**********************************************************\
+|**********************************************************|
+| Threads
+|**********************************************************|
+\**********************************************************/
+
+//-----------------------------------------------------------------------------
+//  SoftSemaphore
+//-----------------------------------------------------------------------------
+struct SoftSemaphore
+{
+#if defined( OS_WINDOWS )
+    HANDLE          hSemaphore;
+#else
+    pthread_mutex_t Mutex;
+    pthread_cond_t  Condition;
+    uint            nCount;
+#endif // #if defined( OS_WINDOWS )
+};
+
+static SoftSemaphore* NewSemaphore( void )
+{
+    SoftSemaphore* pSemaphore = new SoftSemaphore;
+#if defined( OS_WINDOWS )
+    pSemaphore->hSemaphore = ::CreateSemaphoreA( NULL, 0, gs_nMaxSoftThreads, NULL );
+#else
+    pthread_mutex_init( &pSemaphore->Mutex, NULL );
+    pthread_cond_init( &pSemaphore->Condition, NULL );
+    pSemaphore->nCount = 0;
+#endif // #if defined( OS_WINDOWS )
+    return pSemaphore;
+}
+
+static void DeleteSemaphore( SoftSemaphore* pSemaphore )
+{
+#if defined( OS_WINDOWS )
+    CloseHandle( pSemaphore->hSemaphore );
+#else
+    pthread_cond_destroy( &pSemaphore->Condition );
+    pthread_mutex_destroy( &pSemaphore->Mutex );
+#endif // #if defined( OS_WINDOWS )
+    delete pSemaphore;
+}
+
+static void SignalSemaphore( SoftSemaphore* pSemaphore, uint nCount )
+{
+#if defined( OS_WINDOWS )
+    ReleaseSemaphore( pSemaphore->hSemaphore, nCount, NULL );
+#else
+    pthread_mutex_lock( &pSemaphore->Mutex );
+    pSemaphore->nCount += nCount;
+    pthread_cond_broadcast( &pSemaphore->Condition );
+    pthread_mutex_unlock( &pSemaphore->Mutex );
+#endif // #if defined( OS_WINDOWS )
+}
+
+static void WaitSemaphore( SoftSemaphore* pSemaphore )
+{
+#if defined( OS_WINDOWS )
+    WaitForSingleObject( pSemaphore->hSemaphore, INFINITE );
+#else
+    pthread_mutex_lock( &pSemaphore->Mutex );
+    while( pSemaphore->nCount == 0 )
+    {
+        pthread_cond_wait( &pSemaphore->Condition, &pSemaphore->Mutex );
+    }
+    --pSemaphore->nCount;
+    pthread_mutex_unlock( &pSemaphore->Mutex );
+#endif // #if defined( OS_WINDOWS )
+}
+
+//-----------------------------------------------------------------------------
+//  SoftWorker
+//  The workers' entry point, which just hands over to WorkerMain
+//-----------------------------------------------------------------------------
+struct SoftWorker
+{
+#if defined( OS_WINDOWS )
+    static DWORD WINAPI ThreadMain( LPVOID pParam )
+    {
+        CSoftGraphics::WorkerMain( (CSoftGraphics*)pParam );
+        return 0;
+    }
+#else
+    static void* ThreadMain( void* pParam )
+    {
+        CSoftGraphics::WorkerMain( (CSoftGraphics*)pParam );
+        return NULL;
+    }
+#endif // #if defined( OS_WINDOWS )
+};
+
+//-----------------------------------------------------------------------------
+//  GetNumCores
+//-----------------------------------------------------------------------------
+static uint GetNumCores( void )
+{
+#if defined( OS_WINDOWS )
+    SYSTEM_INFO SystemInfo;
+    GetSystemInfo( &SystemInfo );
+    return (uint)SystemInfo.dwNumberOfProcessors;
+#else
+    long nCores = sysconf( _SC_NPROCESSORS_ONLN );
+    return nCores > 0 ? (uint)nCores : 1;
+#endif // #if defined( OS_WINDOWS )
+}
+
+/**********************************************************\
+|**********************************************************|
+| CSoftGraphics
+|**********************************************************|
+\**********************************************************/
+
+//////////////////////////////////////////
+// The cube CD3DGraphics::CreateMesh builds
+struct SoftCubeVertex
+{
+    float   pPos[3];
+    float   pColor[4];
+};
+
+static const SoftCubeVertex gs_pCubeVertices[] =
+{
+    { { -1.0f,  1.0f, -1.0f }, { 0.0f, 0.0f, 1.0f, 1.0f } },
+    { {  1.0f,  1.0f, -1.0f }, { 0.0f, 1.0f, 0.0f, 1.0f } },
+    { {  1.0f,  1.0f,  1.0f }, { 0.0f, 1.0f, 1.0f, 1.0f } },
+    { { -1.0f,  1.0f,  1.0f }, { 1.0f, 0.0f, 0.0f, 1.0f } },
+    { { -1.0f, -1.0f, -1.0f }, { 1.0f, 0.0f, 1.0f, 1.0f } },
+    { {  1.0f, -1.0f, -1.0f }, { 1.0f, 1.0f, 0.0f, 1.0f } },
+    { {  1.0f, -1.0f,  1.0f }, { 1.0f, 1.0f, 1.0f, 1.0f } },
+    { { -1.0f, -1.0f,  1.0f }, { 0.0f, 0.0f, 0.0f, 1.0f } },
+};
+
+static const uint16 gs_pCubeIndices[] =
+{
+    3,1,0,
+    2,1,3,
+
+    0,5,4,
+    1,5,0,
+
+    3,4,7,
+    0,4,3,
+
+    1,6,5,
+    2,6,1,
+
+    2,7,6,
+    3,7,2,
+
+    6,4,5,
+    7,4,6,
+};
+
+//////////////////////////////////////////
+// The terrain's vertex, as CD3DGraphics's
+// input layout reads it
+struct SoftTerrainVertex
+{
+    RHalf4      vPos;
+    RUNorm8x4   vColor;
+};
+
+// CSoftGraphics constructor
+CSoftGraphics::CSoftGraphics()
+    : m_pDraws( NULL )
+    , m_nNumDraws( 0 )
+    , m_nMaxDraws( 0 )
+    , m_nNumVertices( 0 )
+    , m_nNumTriangles( 0 )
+    , m_pClipX( NULL )
+    , m_pClipY( NULL )
+    , m_pClipZ( NULL )
+    , m_pClipW( NULL )
+    , m_pDepth( NULL )
+    , m_pRecipW( NULL )
+    , m_pScreenX( NULL )
+    , m_pScreenY( NULL )
+    , m_pOutcodes( NULL )
+    , m_nMaxVertices( 0 )
+    , m_pBins( NULL )
+    , m_pTileBins( NULL )
+    , m_nNumBins( 0 )
+    , m_pColorBuffer( NULL )
+    , m_pDepthBuffer( NULL )
+    , m_nWidth( 0 )
+    , m_nHeight( 0 )
+    , m_nPitch( 0 )
+    , m_nTilesX( 0 )
+    , m_nNumTiles( 0 )
+    , m_fGuardBandX( 1.0f )
+    , m_fGuardBandY( 1.0f )
+    , m_ppThreads( NULL )
+    , m_nNumWorkers( 0 )
+    , m_pStartSemaphore( NULL )
+    , m_pDoneSemaphore( NULL )
+    , m_pfnJob( NULL )
+    , m_nJobItems( 0 )
+    , m_nNextJobItem( 0 )
+    , m_nQuit( 0 )
+{
+    m_mViewProj.Identity();
+    memset( &m_FrameStats, 0, sizeof( m_FrameStats ) );
+    memset( &m_LastFrameStats, 0, sizeof( m_LastFrameStats ) );
+}
+
+// CSoftGraphics destructor
+CSoftGraphics::~CSoftGraphics()
+{
+    // Stop the workers
+    if( m_nNumWorkers > 0 )
+    {
+        AtomicStoreRelease( &m_nQuit, 1 );
+        SignalSemaphore( m_pStartSemaphore, m_nNumWorkers );
+        for( uint i = 0; i < m_nNumWorkers; ++i )
+        {
+#if defined( OS_WINDOWS )
+            WaitForSingleObject( (HANDLE)m_ppThreads[i], INFINITE );
+            CloseHandle( (HANDLE)m_ppThreads[i] );
+#else
+            pthread_join( *(pthread_t*)m_ppThreads[i], NULL );
+            delete (pthread_t*)m_ppThreads[i];
+#endif // #if defined( OS_WINDOWS )
+        }
+    }
+    SAFE_DELETE_ARRAY( m_ppThreads );
+    if( m_pStartSemaphore )
+    {
+        DeleteSemaphore( m_pStartSemaphore );
+        DeleteSemaphore( m_pDoneSemaphore );
+    }
+
+    ReleaseBuffers();
+    for( uint i = 0; i < m_nNumBins; ++i )
+    {
+        SAFE_DELETE_ARRAY( m_pBins[i].pTriangles );
+    }
+    SAFE_DELETE_ARRAY( m_pBins );
+    SAFE_DELETE_ARRAY( m_pDraws );
+    SAFE_DELETE_ARRAY( m_pClipX );
+    SAFE_DELETE_ARRAY( m_pClipY );
+    SAFE_DELETE_ARRAY( m_pClipZ );
+    SAFE_DELETE_ARRAY( m_pClipW );
+    SAFE_DELETE_ARRAY( m_pDepth );
+    SAFE_DELETE_ARRAY( m_pRecipW );
+    SAFE_DELETE_ARRAY( m_pScreenX );
+    SAFE_DELETE_ARRAY( m_pScreenY );
+    SAFE_DELETE_ARRAY( m_pOutcodes );
+}
+/***************************************\
+| class methods                         |
+\***************************************/
+
+//-----------------------------------------------------------------------------
+//  Initialize
+//  Creates the device, then creates any other needed buffers, etc.
+//-----------------------------------------------------------------------------
+uint CSoftGraphics::Initialize( CWindow* pWindow )
+{
+    return CreateDevice( pWindow );
+}
+
+//-----------------------------------------------------------------------------
+//  CreateDevice
+//  Starts a worker thread for every core but this one
+//-----------------------------------------------------------------------------
+uint CSoftGraphics::CreateDevice( CWindow* pWindow )
+{
+    MEMORY_CATEGORY( eMemoryCategoryGfx );
+    m_pWindow = pWindow;
+
+    uint nNumThreads = GetNumCores();
+    const char* szThreads = getenv( "RIOT_SOFT_THREADS" );
+    if( szThreads && strtoul( szThreads, NULL, 10 ) > 0 )
+    {
+        nNumThreads = (uint)strtoul( szThreads, NULL, 10 );
+    }
+    nNumThreads = nNumThreads < gs_nMaxSoftThreads ? nNumThreads : gs_nMaxSoftThreads;
+
+    // Two bins a thread, so a thread that gets the expensive part of the
+    // screen doesn't hold everyone else up for long
+    m_nNumBins = nNumThreads * 2;
+    m_pBins = new SoftBin[ m_nNumBins ];
+    memset( m_pBins, 0, sizeof( SoftBin ) * m_nNumBins );
+
+    m_pStartSemaphore = NewSemaphore();
+    m_pDoneSemaphore = NewSemaphore();
+    m_nNumWorkers = nNumThreads - 1;
+    m_ppThreads = new void*[ m_nNumWorkers + 1 ];
+    for( uint i = 0; i < m_nNumWorkers; ++i )
+    {
+#if defined( OS_WINDOWS )
+        m_ppThreads[i] = (void*)::CreateThread( NULL, 0, SoftWorker::ThreadMain, this, 0, NULL );
+#else
+        pthread_t* pThread = new pthread_t;
+        pthread_create( pThread, NULL, SoftWorker::ThreadMain, this );
+        m_ppThreads[i] = pThread;
+#endif // #if defined( OS_WINDOWS )
+    }
+
+    CreateBuffers( pWindow->GetWidth(), pWindow->GetHeight() );
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+//  ReleaseBuffers
+//  Releases all buffers to prepare for a resize
+//-----------------------------------------------------------------------------
+void CSoftGraphics::ReleaseBuffers( void )
+{
+    if( m_pTileBins )
+    {
+        for( uint i = 0; i < m_nNumBins * m_nNumTiles; ++i )
+        {
+            SAFE_DELETE_ARRAY( m_pTileBins[i].pTriangles );
+        }
+    }
+    SAFE_DELETE_ARRAY( m_pTileBins );
+    SAFE_DELETE_ARRAY( m_pColorBuffer );
+    SAFE_DELETE_ARRAY( m_pDepthBuffer );
+    m_nNumTiles = 0;
+}
+
+//-----------------------------------------------------------------------------
+//  CreateBuffers
+//  Creates the framebuffer and the tile bins. Rows are padded to a whole
+//  number of tiles
+//-----------------------------------------------------------------------------
+void CSoftGraphics::CreateBuffers( uint nWidth, uint nHeight )
+{
+    MEMORY_CATEGORY( eMemoryCategoryGfx );
+
+    m_nWidth = nWidth < gs_nMaxSoftBufferSize ? nWidth : gs_nMaxSoftBufferSize;
+    m_nHeight = nHeight < gs_nMaxSoftBufferSize ? nHeight : gs_nMaxSoftBufferSize;
+    m_nTilesX = ( m_nWidth + gs_nSoftTileSize - 1 ) >> gs_nSoftTileShift;
+    m_nNumTiles = m_nTilesX * ( ( m_nHeight + gs_nSoftTileSize - 1 ) >> gs_nSoftTileShift );
+    m_nPitch = m_nTilesX * gs_nSoftTileSize;
+    m_fGuardBandX = gs_fSoftGuardBand / ( m_nWidth * 0.5f );
+    m_fGuardBandY = gs_fSoftGuardBand / ( m_nHeight * 0.5f );
+
+    m_pColorBuffer = new uint32[ m_nPitch * m_nHeight ];
+    m_pDepthBuffer = new float[ m_nPitch * m_nHeight ];
+    m_pTileBins = new SoftTileBin[ m_nNumBins * m_nNumTiles ];
+    memset( m_pTileBins, 0, sizeof( SoftTileBin ) * m_nNumBins * m_nNumTiles );
+    for( uint i = 0; i < m_nPitch * m_nHeight; ++i )
+    {
+        m_pColorBuffer[i] = gs_nSoftClearColor;
+        m_pDepthBuffer[i] = 1.0f;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//  PrepareRender
+//  Starts a new frame
+//-----------------------------------------------------------------------------
+void CSoftGraphics::PrepareRender( void )
+{
+    m_nNumDraws = 0;
+    m_nNumVertices = 0;
+    m_nNumTriangles = 0;
+}
+
+//-----------------------------------------------------------------------------
+//  Render
+//  Renders everything, then runs the pipeline
+//-----------------------------------------------------------------------------
+void CSoftGraphics::Render( CObject** ppObjects, uint nNumObjects )
+{
+    SetViewProj( &m_pCurrView->GetViewMatrix(), &m_pCurrView->GetProjMatrix() );
+
+    for( uint i = 0; i < nNumObjects; ++i )
+    {
+        CMaterial* pMaterial = ppObjects[i]->GetMaterial();
+        CMesh*     pMesh = ppObjects[i]->GetMesh();
+        if( pMesh && pMaterial )
+        {
+            pMaterial->ApplyMaterial();
+            pMesh->DrawMesh();
+        }
+    }
+
+    // Make room for the transformed vertices
+    if( m_nNumVertices > m_nMaxVertices )
+    {
+        uint nMaxVertices = m_nMaxVertices;
+        GrowArray( &m_pClipX, &nMaxVertices, 0, m_nNumVertices );
+        nMaxVertices = m_nMaxVertices;
+        GrowArray( &m_pClipY, &nMaxVertices, 0, m_nNumVertices );
+        nMaxVertices = m_nMaxVertices;
+        GrowArray( &m_pClipZ, &nMaxVertices, 0, m_nNumVertices );
+        nMaxVertices = m_nMaxVertices;
+        GrowArray( &m_pClipW, &nMaxVertices, 0, m_nNumVertices );
+        nMaxVertices = m_nMaxVertices;
+        GrowArray( &m_pDepth, &nMaxVertices, 0, m_nNumVertices );
+        nMaxVertices = m_nMaxVertices;
+        GrowArray( &m_pRecipW, &nMaxVertices, 0, m_nNumVertices );
+        nMaxVertices = m_nMaxVertices;
+        GrowArray( &m_pScreenX, &nMaxVertices, 0, m_nNumVertices );
+        nMaxVertices = m_nMaxVertices;
+        GrowArray( &m_pScreenY, &nMaxVertices, 0, m_nNumVertices );
+        nMaxVertices = m_nMaxVertices;
+        GrowArray( &m_pOutcodes, &nMaxVertices, 0, m_nNumVertices );
+        m_nMaxVertices = nMaxVertices;
+    }
+
+    double fMsPerTick = 1000.0 / GetOSTicksPerSecond();
+    uint64 nStart = GetOSTicks();
+    {
+        PROFILE_SCOPE( "Soft vertex stage" );
+        RunJob( &CSoftGraphics::TransformVertices, ( m_nNumVertices + gs_nSoftVertexChunk - 1 ) / gs_nSoftVertexChunk );
+    }
+    uint64 nVertexEnd = GetOSTicks();
+    {
+        PROFILE_SCOPE( "Soft bin stage" );
+        RunJob( &CSoftGraphics::BinTriangles, m_nNumBins );
+    }
+    uint64 nBinEnd = GetOSTicks();
+    {
+        PROFILE_SCOPE( "Soft raster stage" );
+        RunJob( &CSoftGraphics::RasterizeTile, m_nNumTiles );
+    }
+    uint64 nRasterEnd = GetOSTicks();
+
+    m_FrameStats.fVertexMs += (float)( ( nVertexEnd - nStart ) * fMsPerTick );
+    m_FrameStats.fBinMs += (float)( ( nBinEnd - nVertexEnd ) * fMsPerTick );
+    m_FrameStats.fRasterMs += (float)( ( nRasterEnd - nBinEnd ) * fMsPerTick );
+    m_FrameStats.nDraws += m_nNumDraws;
+    m_FrameStats.nVertices += m_nNumVertices;
+    m_FrameStats.nTriangles += m_nNumTriangles;
+    for( uint i = 0; i < m_nNumBins; ++i )
+    {
+        m_FrameStats.nTrianglesDrawn += m_pBins[i].nNumTriangles;
+        m_FrameStats.nTileTriangles += m_pBins[i].nNumTileTriangles;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//  Present
+//  Presents the frame, which here only closes off the frame's stats
+//-----------------------------------------------------------------------------
+void CSoftGraphics::Present( void )
+{
+    m_LastFrameStats = m_FrameStats;
+    memset( &m_FrameStats, 0, sizeof( m_FrameStats ) );
+
+    TraceCounter( "Soft vertex ms", m_LastFrameStats.fVertexMs );
+    TraceCounter( "Soft bin ms", m_LastFrameStats.fBinMs );
+    TraceCounter( "Soft raster ms", m_LastFrameStats.fRasterMs );
+    TraceCounter( "Triangles drawn", (double)m_LastFrameStats.nTrianglesDrawn );
+}
+
+//-----------------------------------------------------------------------------
+//  SetViewProj
+//  Sets the view projection constant buffer
+//-----------------------------------------------------------------------------
+void CSoftGraphics::SetViewProj( const void* pView, const void* pProj )
+{
+    m_mViewProj = *( (const RMatrix4x4*)pView ) * *( (const RMatrix4x4*)pProj );
+}
+
+//-----------------------------------------------------------------------------
+//  CreateMesh
+//  Creates a mesh from the file. Like CD3DGraphics, this is always the cube
+//-----------------------------------------------------------------------------
+CMesh* CSoftGraphics::CreateMesh( const wchar_t* )
+{
+    uint nNumVertices = sizeof( gs_pCubeVertices ) / sizeof( gs_pCubeVertices[0] );
+    CSoftMesh* pMesh = NewMesh( nNumVertices, gs_pCubeIndices, 16, sizeof( gs_pCubeIndices ) / sizeof( gs_pCubeIndices[0] ) );
+    for( uint i = 0; i < nNumVertices; ++i )
+    {
+        const SoftCubeVertex& Vertex = gs_pCubeVertices[i];
+        pMesh->m_Positions.Set( i, RVector3( Vertex.pPos ) );
+        pMesh->m_pColors[i] = RUNorm8x4( RVector4( Vertex.pColor[0], Vertex.pColor[1], Vertex.pColor[2], Vertex.pColor[3] ) ).v;
+    }
+    pMesh->m_nVertexSize = sizeof( SoftCubeVertex );
+    return pMesh;
+}
+
+//-----------------------------------------------------------------------------
+//  CreateMesh
+//  Creates a mesh from memory. The half positions are pulled out a
+//  component at a time, and converted straight into the stream
+//-----------------------------------------------------------------------------
+CMesh* CSoftGraphics::CreateMesh( void* vertices, uint nVertexStride, uint nNumVertices,
+                                  void* indices, uint nIndexFormat, uint nNumIndices )
+{
+    MEMORY_CATEGORY( eMemoryCategoryAssets );
+
+    CSoftMesh* pMesh = NewMesh( nNumVertices, indices, nIndexFormat, nNumIndices );
+    const byte* pVertices = (const byte*)vertices;
+    RHalf* pHalfs = new RHalf[ nNumVertices ];
+    float* pComponents[3] = { pMesh->m_Positions.x, pMesh->m_Positions.y, pMesh->m_Positions.z };
+    for( uint nComponent = 0; nComponent < 3; ++nComponent )
+    {
+        for( uint i = 0; i < nNumVertices; ++i )
+        {
+            const SoftTerrainVertex* pVertex = (const SoftTerrainVertex*)( pVertices + i * nVertexStride );
+            pHalfs[i] = ( &pVertex->vPos.x )[ nComponent ];
+        }
+        StreamHalfsToFloats( pHalfs, pComponents[ nComponent ], nNumVertices );
+    }
+    SAFE_DELETE_ARRAY( pHalfs );
+
+    for( uint i = 0; i < nNumVertices; ++i )
+    {
+        const SoftTerrainVertex* pVertex = (const SoftTerrainVertex*)( pVertices + i * nVertexStride );
+        pMesh->m_pColors[i] = pVertex->vColor.v;
+    }
+    pMesh->m_nVertexSize = nVertexStride;
+    return pMesh;
+}
+
+//-----------------------------------------------------------------------------
+//  NewMesh
+//  Creates a mesh with room for the vertices, and copies the indices in
+//-----------------------------------------------------------------------------
+CSoftMesh* CSoftGraphics::NewMesh( uint nNumVertices, const void* pIndices, uint nIndexFormat, uint nNumIndices )
+{
+    MEMORY_CATEGORY( eMemoryCategoryAssets );
+
+    CSoftMesh* pMesh = new CSoftMesh();
+    pMesh->m_pGraphics = this;
+    pMesh->m_Positions.Resize( nNumVertices );
+    pMesh->m_pColors = new uint32[ nNumVertices ];
+    pMesh->m_pIndices = new uint32[ nNumIndices ];
+    for( uint i = 0; i < nNumIndices; ++i )
+    {
+        pMesh->m_pIndices[i] = nIndexFormat == 16 ? ( (const uint16*)pIndices )[i] : ( (const uint32*)pIndices )[i];
+    }
+    pMesh->m_nVertexCount = nNumVertices;
+    pMesh->m_nIndexSize = nIndexFormat;
+    pMesh->m_nIndexCount = nNumIndices;
+    return pMesh;
+}
+
+//-----------------------------------------------------------------------------
+//  CreateMaterial
+//  Creates a material
+//-----------------------------------------------------------------------------
+CMaterial* CSoftGraphics::CreateMaterial( const wchar_t*, const char*, const char* )
+{
+    MEMORY_CATEGORY( eMemoryCategoryAssets );
+    return new CSoftMaterial();
+}
+
+//-----------------------------------------------------------------------------
+//  DrawMesh
+//  Adds the mesh to the frame's draws
+//-----------------------------------------------------------------------------
+void CSoftGraphics::DrawMesh( const CSoftMesh* pMesh, const RMatrix4x4& mWorld )
+{
+    GrowArray( &m_pDraws, &m_nMaxDraws, m_nNumDraws, m_nNumDraws + 1 );
+
+    SoftDraw& Draw = m_pDraws[ m_nNumDraws++ ];
+    Draw.mWorldViewProj = mWorld * m_mViewProj;
+    Draw.pMesh = pMesh;
+    Draw.nFirstVertex = m_nNumVertices;
+    Draw.nFirstTriangle = m_nNumTriangles;
+    Draw.nNumTriangles = pMesh->m_nIndexCount / 3;
+    m_nNumVertices += pMesh->m_nVertexCount;
+    m_nNumTriangles += Draw.nNumTriangles;
+}
+
+//-----------------------------------------------------------------------------
+//  RunJob
+//  Wakes the workers, helps them, then waits for them to finish
+//-----------------------------------------------------------------------------
+void CSoftGraphics::RunJob( SoftJob pfnJob, uint nNumItems )
+{
+    m_pfnJob = pfnJob;
+    m_nJobItems = nNumItems;
+    AtomicStoreRelease( &m_nNextJobItem, 0 );
+
+    SignalSemaphore( m_pStartSemaphore, m_nNumWorkers );
+    RunJobItems();
+    for( uint i = 0; i < m_nNumWorkers; ++i )
+    {
+        WaitSemaphore( m_pDoneSemaphore );
+    }
+}
+
+//-----------------------------------------------------------------------------
+//  RunJobItems
+//  Takes items off the job until there aren't any left
+//-----------------------------------------------------------------------------
+void CSoftGraphics::RunJobItems( void )
+{
+    for( ;; )
+    {
+        uint nItem = (uint)( AtomicIncrement( &m_nNextJobItem ) - 1 );
+        if( nItem >= m_nJobItems )
+        {
+            break;
+        }
+        ( this->*m_pfnJob )( nItem );
+    }
+}
+
+//-----------------------------------------------------------------------------
+//  WorkerMain
+//  Runs every job until the device is destroyed
+//-----------------------------------------------------------------------------
+void CSoftGraphics::WorkerMain( CSoftGraphics* pGraphics )
+{
+    ProfilerSetThreadName( "Soft raster" );
+    for( ;; )
+    {
+        WaitSemaphore( pGraphics->m_pStartSemaphore );
+        if( AtomicLoadAcquire( &pGraphics->m_nQuit ) )
+        {
+            break;
+        }
+        pGraphics->RunJobItems();
+        SignalSemaphore( pGraphics->m_pDoneSemaphore, 1 );
+    }
+}
+
+//-----------------------------------------------------------------------------
+//  TransformVertices
+//  The vertex stage, for one chunk of the frame's vertices. This is what
+//  StandardVertexShader.hlsl and Terrain.hlsl do, and the divide by w
+//-----------------------------------------------------------------------------
+void CSoftGraphics::TransformVertices( uint nChunk )
+{
+    PROFILE_SCOPE( "Soft vertices" );
+
+    uint nFirst = nChunk * gs_nSoftVertexChunk;
+    uint nEnd = nFirst + gs_nSoftVertexChunk < m_nNumVertices ? nFirst + gs_nSoftVertexChunk : m_nNumVertices;
+    uint nVertex = nFirst;
+    for( uint nDraw = FindDraw( m_pDraws, m_nNumDraws, &SoftDraw::nFirstVertex, nFirst ); nVertex < nEnd; ++nDraw )
+    {
+        const SoftDraw& Draw = m_pDraws[ nDraw ];
+        uint nDrawEnd = Draw.nFirstVertex + Draw.pMesh->m_nVertexCount;
+        nDrawEnd = nDrawEnd < nEnd ? nDrawEnd : nEnd;
+        if( nDrawEnd <= nVertex )
+        {
+            continue;
+        }
+
+        const RVec3Stream& Positions = Draw.pMesh->m_Positions;
+        uint nLocal = nVertex - Draw.nFirstVertex;
+        StreamProjectPoints( Draw.mWorldViewProj, Positions.x + nLocal, Positions.y + nLocal, Positions.z + nLocal,
+                             m_pClipX + nVertex, m_pClipY + nVertex, m_pClipZ + nVertex, m_pClipW + nVertex, nDrawEnd - nVertex );
+        nVertex = nDrawEnd;
+    }
+
+#if defined( RIOT_SSE )
+    SSEProjectToScreen(
+#else
+    ScalarProjectToScreen(
+#endif // #if defined( RIOT_SSE )
+        m_pClipX + nFirst, m_pClipY + nFirst, m_pClipZ + nFirst, m_pClipW + nFirst,
+        m_nWidth * 8.0f, m_nHeight * -8.0f, m_fGuardBandX, m_fGuardBandY,
+        m_pScreenX + nFirst, m_pScreenY + nFirst, m_pDepth + nFirst, m_pRecipW + nFirst,
+        m_pOutcodes + nFirst, nEnd - nFirst );
+}
+
+//-----------------------------------------------------------------------------
+//  BinTriangles
+//  The bin stage, for one bin's run of the frame's triangles
+//-----------------------------------------------------------------------------
+void CSoftGraphics::BinTriangles( uint nBin )
+{
+    PROFILE_SCOPE( "Soft bin" );
+
+    SoftBin& Bin = m_pBins[ nBin ];
+    SoftTileBin* pTileBins = m_pTileBins + nBin * m_nNumTiles;
+    Bin.nNumTriangles = 0;
+    Bin.nNumTileTriangles = 0;
+    for( uint i = 0; i < m_nNumTiles; ++i )
+    {
+        pTileBins[i].nNumTriangles = 0;
+    }
+
+    uint nFirst = (uint)( (uint64)m_nNumTriangles * nBin / m_nNumBins );
+    uint nEnd = (uint)( (uint64)m_nNumTriangles * ( nBin + 1 ) / m_nNumBins );
+    if( nFirst == nEnd )
+    {
+        return;
+    }
+
+    // Room for every triangle. Clipping can make more, but rarely
+    GrowArray( &Bin.pTriangles, &Bin.nMaxTriangles, 0, nEnd - nFirst );
+
+    SoftScreenVertex pScreen[ 3 + eNUMSOFTCLIPPLANES ];
+    SoftClipVertex pClip[2][ 3 + eNUMSOFTCLIPPLANES ];
+    uint nTriangle = nFirst;
+    for( uint nDraw = FindDraw( m_pDraws, m_nNumDraws, &SoftDraw::nFirstTriangle, nFirst ); nTriangle < nEnd; ++nDraw )
+    {
+        const SoftDraw& Draw = m_pDraws[ nDraw ];
+        uint nDrawEnd = Draw.nFirstTriangle + Draw.nNumTriangles;
+        nDrawEnd = nDrawEnd < nEnd ? nDrawEnd : nEnd;
+        const uint32* pColors = Draw.pMesh->m_pColors;
+
+        for( ; nTriangle < nDrawEnd; ++nTriangle )
+        {
+            const uint32* pIndices = Draw.pMesh->m_pIndices + ( nTriangle - Draw.nFirstTriangle ) * 3;
+            uint pVertices[3] = { pIndices[0] + Draw.nFirstVertex, pIndices[1] + Draw.nFirstVertex, pIndices[2] + Draw.nFirstVertex };
+            uint nOutcodeAnd = m_pOutcodes[ pVertices[0] ] & m_pOutcodes[ pVertices[1] ] & m_pOutcodes[ pVertices[2] ];
+            uint nOutcodeOr = m_pOutcodes[ pVertices[0] ] | m_pOutcodes[ pVertices[1] ] | m_pOutcodes[ pVertices[2] ];
+            if( nOutcodeAnd != 0 )
+            {   // Entirely outside one of the planes
+                continue;
+            }
+
+            uint nNumScreen = 0;
+            if( nOutcodeOr == 0 )
+            {
+                for( uint i = 0; i < 3; ++i )
+                {
+                    uint nVertex = pVertices[i];
+                    pScreen[i].nX = m_pScreenX[ nVertex ];
+                    pScreen[i].nY = m_pScreenY[ nVertex ];
+                    pScreen[i].fDepth = m_pDepth[ nVertex ];
+                    pScreen[i].fRecipW = m_pRecipW[ nVertex ];
+                    UnpackColor( pColors[ nVertex - Draw.nFirstVertex ], pScreen[i].pColor );
+                }
+                nNumScreen = 3;
+            }
+            else
+            {
+                // Clip against the planes it crosses, then project
+                // what's left
+                uint nNumClip = 3;
+                for( uint i = 0; i < 3; ++i )
+                {
+                    uint nVertex = pVertices[i];
+                    pClip[0][i].pPosition[0] = m_pClipX[ nVertex ];
+                    pClip[0][i].pPosition[1] = m_pClipY[ nVertex ];
+                    pClip[0][i].pPosition[2] = m_pClipZ[ nVertex ];
+                    pClip[0][i].pPosition[3] = m_pClipW[ nVertex ];
+                    UnpackColor( pColors[ nVertex - Draw.nFirstVertex ], pClip[0][i].pColor );
+                }
+                uint nIn = 0;
+                for( uint nPlane = 0; nPlane < eNUMSOFTCLIPPLANES && nNumClip >= 3; ++nPlane )
+                {
+                    if( nOutcodeOr & ( 1 << nPlane ) )
+                    {
+                        nNumClip = ClipPolygon( pClip[ nIn ], nNumClip, pClip[ nIn ^ 1 ], nPlane, m_fGuardBandX, m_fGuardBandY );
+                        nIn ^= 1;
+                    }
+                }
+                if( nNumClip < 3 )
+                {
+                    continue;
+                }
+
+                for( uint i = 0; i < nNumClip; ++i )
+                {
+                    const SoftClipVertex& Clip = pClip[ nIn ][i];
+                    float fRecipW = 1.0f / Clip.pPosition[3];
+                    pScreen[i].nX = (sint32)floorf( Clip.pPosition[0] * fRecipW * m_nWidth * 8.0f + 0.5f );
+                    pScreen[i].nY = (sint32)floorf( Clip.pPosition[1] * fRecipW * m_nHeight * -8.0f + 0.5f );
+                    pScreen[i].fDepth = Clip.pPosition[2] * fRecipW;
+                    pScreen[i].fRecipW = fRecipW;
+                    memcpy( pScreen[i].pColor, Clip.pColor, sizeof( Clip.pColor ) );
+                }
+                nNumScreen = nNumClip;
+            }
+
+            // Set up and bin the triangle, or the fan clipping left
+            for( uint i = 2; i < nNumScreen; ++i )
+            {
+                GrowArray( &Bin.pTriangles, &Bin.nMaxTriangles, Bin.nNumTriangles, Bin.nNumTriangles + 1 );
+                SoftTriangle* pTriangle = &Bin.pTriangles[ Bin.nNumTriangles ];
+                if( !SetupTriangle( pScreen[0], pScreen[i - 1], pScreen[i], m_nWidth, m_nHeight, pTriangle ) )
+                {
+                    continue;
+                }
+
+                uint nTileMinX = (uint)pTriangle->nMinX >> gs_nSoftTileShift;
+                uint nTileMaxX = (uint)pTriangle->nMaxX >> gs_nSoftTileShift;
+                uint nTileMinY = (uint)pTriangle->nMinY >> gs_nSoftTileShift;
+                uint nTileMaxY = (uint)pTriangle->nMaxY >> gs_nSoftTileShift;
+                for( uint nTileY = nTileMinY; nTileY <= nTileMaxY; ++nTileY )
+                {
+                    for( uint nTileX = nTileMinX; nTileX <= nTileMaxX; ++nTileX )
+                    {
+                        SoftTileBin& TileBin = pTileBins[ nTileY * m_nTilesX + nTileX ];
+                        GrowArray( &TileBin.pTriangles, &TileBin.nMaxTriangles, TileBin.nNumTriangles, TileBin.nNumTriangles + 1 );
+                        TileBin.pTriangles[ TileBin.nNumTriangles++ ] = Bin.nNumTriangles;
+                    }
+                }
+                Bin.nNumTileTriangles += ( nTileMaxX - nTileMinX + 1 ) * ( nTileMaxY - nTileMinY + 1 );
+                ++Bin.nNumTriangles;
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//  RasterizeTile
+//  The raster stage, for one tile. Every bin's triangles for the tile are
+//  drawn, in order
+//-----------------------------------------------------------------------------
+void CSoftGraphics::RasterizeTile( uint nTile )
+{
+    PROFILE_SCOPE( "Soft raster" );
+
+    sint32 nTileX = (sint32)( ( nTile % m_nTilesX ) << gs_nSoftTileShift );
+    sint32 nTileY = (sint32)( ( nTile / m_nTilesX ) << gs_nSoftTileShift );
+    uint nRows = m_nHeight - nTileY < gs_nSoftTileSize ? m_nHeight - nTileY : gs_nSoftTileSize;
+
+    // Clear
+    for( uint nRow = 0; nRow < nRows; ++nRow )
+    {
+        uint32* pColor = m_pColorBuffer + ( nTileY + nRow ) * m_nPitch + nTileX;
+        float* pDepth = m_pDepthBuffer + ( nTileY + nRow ) * m_nPitch + nTileX;
+        for( uint i = 0; i < gs_nSoftTileSize; ++i )
+        {
+            pColor[i] = gs_nSoftClearColor;
+            pDepth[i] = 1.0f;
+        }
+    }
+
+    for( uint nBin = 0; nBin < m_nNumBins; ++nBin )
+    {
+        const SoftTriangle* pTriangles = m_pBins[ nBin ].pTriangles;
+        const SoftTileBin& TileBin = m_pTileBins[ nBin * m_nNumTiles + nTile ];
+        for( uint i = 0; i < TileBin.nNumTriangles; ++i )
+        {
+            RasterizeTriangle( pTriangles[ TileBin.pTriangles[i] ], nTileX, nTileY, m_pColorBuffer, m_pDepthBuffer, m_nPitch );
+        }
+    }
+}
@@ -0,0 +1,223 @@
+/*********************************************************\
+File:       SoftGraphics.h
+Purpose:    A software rasterizer. Vertices are transformed
+            with the stream kernels, triangles are binned
+            into screen tiles, and the tiles are rasterized
+            and depth tested in parallel on every core, into
+            a framebuffer in memory
+\*********************************************************/
+#ifndef _SOFTGRAPHICS_H_
+#define _SOFTGRAPHICS_H_
+#include "Common.h"
+#include "Graphics.h"
+#include "RiotMath.h"
+
+class CSoftMesh;
+class CSoftMaterial;
+struct SoftDraw;
+struct SoftBin;
+struct SoftTileBin;
+struct SoftSemaphore;
+
+//-----------------------------------------------------------------------------
+//  SoftGraphicsStats
+//  One frame of work, and how long each stage of the pipeline took. The
+//  stages run one after the other, each spread over every thread
+//-----------------------------------------------------------------------------
+struct SoftGraphicsStats
+{
+    float   fVertexMs;          // Transforming and projecting the vertices
+    float   fBinMs;             // Clipping, culling, setup and binning
+    float   fRasterMs;          // Clearing, rasterizing and depth testing the tiles
+    uint    nDraws;
+    uint    nVertices;
+    uint    nTriangles;         // Submitted
+    uint    nTrianglesDrawn;    // Left after clipping and culling
+    uint    nTileTriangles;     // Triangles rasterized, once per tile they touch
+};
+
+class CSoftGraphics : public CGraphics
+{
+    friend class CSoftMesh;
+    friend class CSoftMaterial;
+    friend struct SoftWorker;
+public:
+    // CSoftGraphics constructor
+    CSoftGraphics();
+
+    // CSoftGraphics destructor
+    ~CSoftGraphics();
+    /***************************************\
+    | class methods                         |
+    \***************************************/
+
+    //-----------------------------------------------------------------------------
+    //  Initialize
+    //  Creates the device, then creates any other needed buffers, etc.
+    //-----------------------------------------------------------------------------
+    uint Initialize( CWindow* pWindow );
+
+    //-----------------------------------------------------------------------------
+    //  CreateDevice
+    //  Starts a worker thread for every core but this one. RIOT_SOFT_THREADS
+    //  sets the total number of threads instead
+    //-----------------------------------------------------------------------------
+    uint CreateDevice( CWindow* pWindow );
+
+    //-----------------------------------------------------------------------------
+    //  ReleaseBuffers
+    //  Releases all buffers to prepare for a resize
+    //-----------------------------------------------------------------------------
+    void ReleaseBuffers( void );
+
+    //-----------------------------------------------------------------------------
+    //  CreateBuffers
+    //  Creates the framebuffer and the tile bins. It can be up to 4096
+    //  pixels on a side
+    //-----------------------------------------------------------------------------
+    void CreateBuffers( uint nWidth, uint nHeight );
+
+    //-----------------------------------------------------------------------------
+    //  PrepareRender
+    //  Starts a new frame. The tiles are cleared as they're rasterized
+    //-----------------------------------------------------------------------------
+    void PrepareRender( void );
+
+    //-----------------------------------------------------------------------------
+    //  Render
+    //  Renders everything. The draws are collected, then run through the
+    //  whole pipeline before this returns
+    //-----------------------------------------------------------------------------
+    void Render( CObject** ppObjects, uint nNumObjects );
+
+    //-----------------------------------------------------------------------------
+    //  Present
+    //  Presents the frame, which here only closes off the frame's stats
+    //-----------------------------------------------------------------------------
+    void Present( void );
+
+    //-----------------------------------------------------------------------------
+    //  SetViewProj
+    //  Sets the view projection constant buffer
+    //-----------------------------------------------------------------------------
+    void SetViewProj( const void* pView, const void* pProj );
+
+    //-----------------------------------------------------------------------------
+    //  Accessors
+    //  The framebuffer is R8G8B8A8, with GetPitch pixels between rows
+    //-----------------------------------------------------------------------------
+    const SoftGraphicsStats& GetFrameStats( void ) const { return m_LastFrameStats; }
+    const uint32* GetFramebuffer( void ) const { return m_pColorBuffer; }
+    uint GetWidth( void ) const { return m_nWidth; }
+    uint GetHeight( void ) const { return m_nHeight; }
+    uint GetPitch( void ) const { return m_nPitch; }
+    uint GetNumThreads( void ) const { return m_nNumWorkers + 1; }
+
+public:
+    /***************************************\
+    | object creation                       |
+    \***************************************/
+
+    //-----------------------------------------------------------------------------
+    //  CreateMesh
+    //  Creates a mesh from the file. Like CD3DGraphics, this is always the cube
+    //-----------------------------------------------------------------------------
+    CMesh* CreateMesh( const wchar_t* szFilename );
+
+    //-----------------------------------------------------------------------------
+    //  CreateMesh
+    //  Creates a mesh from memory. Like CD3DGraphics, the vertices are
+    //  expected to be terrain vertices
+    //-----------------------------------------------------------------------------
+    CMesh* CreateMesh( void* vertices, uint nVertexStride, uint nNumVertices,
+                       void* indices, uint nIndexFormat, uint nNumIndices );
+
+    //-----------------------------------------------------------------------------
+    //  CreateMaterial
+    //  Creates a material. Both shaders only pass the vertex color through,
+    //  so the file isn't read
+    //-----------------------------------------------------------------------------
+    CMaterial* CreateMaterial( const wchar_t* szFilename, const char* szEntryPoint, const char* szProfile );
+
+private:
+    // Called by the meshes in place of the device
+    void DrawMesh( const CSoftMesh* pMesh, const RMatrix4x4& mWorld );
+
+    // Creates a mesh with room for the vertices, and copies the indices in
+    CSoftMesh* NewMesh( uint nNumVertices, const void* pIndices, uint nIndexFormat, uint nNumIndices );
+
+    //-----------------------------------------------------------------------------
+    //  Jobs
+    //  RunJob calls pfnJob once for every item from 0 to nNumItems, spread
+    //  over the workers and this thread, and returns when they're all done
+    //-----------------------------------------------------------------------------
+    typedef void (CSoftGraphics::*SoftJob)( uint nItem );
+    void RunJob( SoftJob pfnJob, uint nNumItems );
+    void RunJobItems( void );
+    static void WorkerMain( CSoftGraphics* pGraphics );
+
+    // The pipeline stages
+    void TransformVertices( uint nChunk );
+    void BinTriangles( uint nBin );
+    void RasterizeTile( uint nTile );
+
+private:
+    /***************************************\
+    | class members                         |
+    \***************************************/
+    RMatrix4x4          m_mViewProj;
+
+    // This frame's draws
+    SoftDraw*           m_pDraws;
+    uint                m_nNumDraws;
+    uint                m_nMaxDraws;
+    uint                m_nNumVertices;
+    uint                m_nNumTriangles;
+
+    // The transformed vertices, for every draw in the frame. The screen
+    // positions are in 1/16ths of a pixel from the middle of the screen
+    float*              m_pClipX;
+    float*              m_pClipY;
+    float*              m_pClipZ;
+    float*              m_pClipW;
+    float*              m_pDepth;
+    float*              m_pRecipW;
+    sint32*             m_pScreenX;
+    sint32*             m_pScreenY;
+    uint8*              m_pOutcodes;
+    uint                m_nMaxVertices;
+
+    // Each bin sets up a contiguous run of the frame's triangles, and
+    // lists which of them touch each tile. The tiles go through the bins
+    // in order, so triangles are drawn in the order they were submitted
+    SoftBin*            m_pBins;
+    SoftTileBin*        m_pTileBins;    // m_nNumBins rows of m_nNumTiles
+    uint                m_nNumBins;
+
+    // The framebuffer
+    uint32*             m_pColorBuffer;
+    float*              m_pDepthBuffer;
+    uint                m_nWidth;
+    uint                m_nHeight;
+    uint                m_nPitch;
+    uint                m_nTilesX;
+    uint                m_nNumTiles;
+    float               m_fGuardBandX;  // How far past the edges, in w, the rasterizer can go
+    float               m_fGuardBandY;
+
+    // The workers, and the job they're running
+    void**              m_ppThreads;
+    uint                m_nNumWorkers;
+    SoftSemaphore*      m_pStartSemaphore;
+    SoftSemaphore*      m_pDoneSemaphore;
+    SoftJob             m_pfnJob;
+    uint                m_nJobItems;
+    volatile sint32     m_nNextJobItem;
+    volatile sint32     m_nQuit;
+
+    SoftGraphicsStats   m_FrameStats;
+    SoftGraphicsStats   m_LastFrameStats;
+};
+
+
+#endif // #ifndef _SOFTGRAPHICS_H_
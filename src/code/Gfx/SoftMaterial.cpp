@@ -0,0 +1,29 @@
+/*********************************************************\
+File:       SoftMaterial.cpp
+Purpose:    A material for CSoftGraphics
+\*********************************************************/
+#include "SoftMaterial.h"
+#include "Memory.h"
+
+#pragma push_macro( "new" )
+#undef new
+DEFINE_POOL_ALLOCATED( CSoftMaterial, 256, eMemoryCategoryAssets )
+#pragma pop_macro( "new" )
+
+// CSoftMaterial constructor
+CSoftMaterial::CSoftMaterial()
+{
+}
+
+// CSoftMaterial destructor
+CSoftMaterial::~CSoftMaterial()
+{
+}
+
+//-----------------------------------------------------------------------------
+//  ApplyMaterial
+//  Applies the material to the pipeline
+//-----------------------------------------------------------------------------
+void CSoftMaterial::ApplyMaterial( void )
+{
+}
@@ -0,0 +1,36 @@
+/*********************************************************\
+File:       SoftMaterial.h
+Purpose:    A material for CSoftGraphics
+\*********************************************************/
+#ifndef _SOFTMATERIAL_H_
+#define _SOFTMATERIAL_H_
+#include "Common.h"
+#include "Material.h"
+#include "PoolAllocator.h"
+
+class CSoftMaterial : public CMaterial
+{
+#pragma push_macro( "new" )
+#undef new
+    DECLARE_POOL_ALLOCATED( CSoftMaterial )
+#pragma pop_macro( "new" )
+public:
+    // CSoftMaterial constructor
+    CSoftMaterial();
+
+    // CSoftMaterial destructor
+    ~CSoftMaterial();
+    /***************************************\
+    | class methods                         |
+    \***************************************/
+
+    //-----------------------------------------------------------------------------
+    //  ApplyMaterial
+    //  Applies the material to the pipeline. The only pixel shader there is
+    //  outputs the vertex color, so there's nothing to apply
+    //-----------------------------------------------------------------------------
+    void ApplyMaterial( void );
+};
+
+
+#endif // #ifndef _SOFTMATERIAL_H_
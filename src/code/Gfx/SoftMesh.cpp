@@ -0,0 +1,41 @@
+/*********************************************************\
+File:       SoftMesh.cpp
+Purpose:    A mesh for CSoftGraphics
+\*********************************************************/
+#include "SoftMesh.h"
+#include "SoftGraphics.h"
+#include "Memory.h"
+
+#pragma push_macro( "new" )
+#undef new
+DEFINE_POOL_ALLOCATED( CSoftMesh, 256, eMemoryCategoryAssets )
+#pragma pop_macro( "new" )
+
+// CSoftMesh constructor
+CSoftMesh::CSoftMesh()
+    : m_pGraphics( NULL )
+    , m_pColors( NULL )
+    , m_pIndices( NULL )
+    , m_nVertexCount( 0 )
+{
+}
+
+// CSoftMesh destructor
+CSoftMesh::~CSoftMesh()
+{
+    SAFE_DELETE_ARRAY( m_pColors );
+    SAFE_DELETE_ARRAY( m_pIndices );
+}
+
+//-----------------------------------------------------------------------------
+//  DrawMesh
+//  Builds the world matrix, and adds the mesh to the device's draws
+//-----------------------------------------------------------------------------
+void CSoftMesh::DrawMesh( void )
+{
+    // The same world matrix CD3DMesh uploads, before it's transposed for
+    // the shader
+    RMatrix4x4 mWorld = RMatrix4x4RotationQuaternion( m_vOrientation );
+    mWorld.r[3] = RVecSet( m_vPosition.x, m_vPosition.y, m_vPosition.z, 1.0f );
+    m_pGraphics->DrawMesh( this, mWorld );
+}
@@ -0,0 +1,50 @@
+/*********************************************************\
+File:       SoftMesh.h
+Purpose:    A mesh for CSoftGraphics. The positions are
+            kept as a stream, ready for the vertex stage
+\*********************************************************/
+#ifndef _SOFTMESH_H_
+#define _SOFTMESH_H_
+#include "Common.h"
+#include "Mesh.h"
+#include "MathStream.h"
+#include "PoolAllocator.h"
+
+class CSoftGraphics;
+
+class CSoftMesh : public CMesh
+{
+#pragma push_macro( "new" )
+#undef new
+    DECLARE_POOL_ALLOCATED( CSoftMesh )
+#pragma pop_macro( "new" )
+    friend class CSoftGraphics;
+public:
+    // CSoftMesh constructor
+    CSoftMesh();
+
+    // CSoftMesh destructor
+    ~CSoftMesh();
+    /***************************************\
+    | class methods                         |
+    \***************************************/
+
+    //-----------------------------------------------------------------------------
+    //  DrawMesh
+    //  Builds the world matrix, and adds the mesh to the device's draws
+    //-----------------------------------------------------------------------------
+    void DrawMesh( void );
+
+private:
+    /***************************************\
+    | class members                         |
+    \***************************************/
+    CSoftGraphics*  m_pGraphics;
+    RVec3Stream     m_Positions;
+    uint32*         m_pColors;      // R8G8B8A8
+    uint32*         m_pIndices;     // 16 bit indices are widened
+    uint            m_nVertexCount;
+};
+
+
+#endif // #ifndef _SOFTMESH_H_
@@ -6,15 +6,15 @@ Modified:       3/23/2011 6:43:54 PM
 Modified by:    Kyle Weicht
 \*********************************************************/
 #include "View.h"
-#include "memory.h"
+#include "Memory.h"
 
 // CView constructor
 CView::CView()
 {
     SetPerspective( 60.0f, 1024.0f/768.0f, 0.1f, 10000.0f );
-    m_vPosition = XMVectorSet( 0.0f, 40.0f, -5.0f, 0.0f );
-    m_vLook = XMVectorSet( 0.0f, 0.0f, 1.0f, 0.0f );
-    m_vUp = XMVectorSet( 0.0f, 1.0f, 0.0f, 0.0f );
+    m_vPosition = RVector4( 0.0f, 40.0f, -5.0f, 0.0f );
+    m_vLook = RVector4( 0.0f, 0.0f, 1.0f, 0.0f );
+    m_vUp = RVector4( 0.0f, 1.0f, 0.0f, 0.0f );
 }
 
 // CView destructor
@@ -47,14 +47,25 @@ void CView::TranslateZ( float fTrans )
 //-----------------------------------------------------------------------------
 void CView::RotateX( float fRad )
 {
-    XMMATRIX rot = XMMatrixRotationAxis( m_vRight, fRad );
-    m_vLook = XMVector4Transform( m_vLook, rot );
+    RMatrix4x4 rot = RMatrix4x4RotationAxisEst( m_vRight, fRad );
+    m_vLook = m_vLook * rot;
 }
 
 void CView::RotateY( float fRad )
 {
-    XMMATRIX rot = XMMatrixRotationY( fRad );
-    m_vLook = XMVector4Transform( m_vLook, rot );
+    RMatrix4x4 rot = RMatrix4x4RotationAxisEst( RVector4( 0.0f, 1.0f, 0.0f, 0.0f ), fRad );
+    m_vLook = m_vLook * rot;
+}
+
+
+//-----------------------------------------------------------------------------
+//  LookAt
+//  Points the camera at vTarget, keeping it upright
+//-----------------------------------------------------------------------------
+void CView::LookAt( const RVector4& vTarget )
+{
+    m_vLook = vTarget - m_vPosition;
+    m_vLook.w = 0.0f;
 }
 
 
@@ -65,27 +76,10 @@ void CView::RotateY( float fRad )
 //-----------------------------------------------------------------------------
 void CView::Update( float fDeltaTime )
 {
-    XMVECTOR vX, vY, vZ;
-
-    m_vLook = vZ = XMVector4Normalize( m_vLook );
-    m_vRight = vX = XMVector4Normalize( XMVector3Cross( m_vUp, vZ ) );
-    vY = XMVector3Cross( vZ, vX );
-    
-    m_mViewMatrix._11 = XMVectorGetX(vX); m_mViewMatrix._12 = XMVectorGetY(vX); m_mViewMatrix._13 = XMVectorGetZ(vX); m_mViewMatrix._14 = -XMVectorGetX( XMVector3Dot(vX, m_vPosition) );
-    m_mViewMatrix._21 = XMVectorGetX(vY); m_mViewMatrix._22 = XMVectorGetY(vY); m_mViewMatrix._23 = XMVectorGetZ(vY); m_mViewMatrix._24 = -XMVectorGetX( XMVector3Dot(vY, m_vPosition) );
-    m_mViewMatrix._31 = XMVectorGetX(vZ); m_mViewMatrix._32 = XMVectorGetY(vZ); m_mViewMatrix._33 = XMVectorGetZ(vZ); m_mViewMatrix._34 = -XMVectorGetX( XMVector3Dot(vZ, m_vPosition) );
-    m_mViewMatrix._41 = 0.0f;             m_mViewMatrix._42 = 0.0f;             m_mViewMatrix._43 = 0.0f;             m_mViewMatrix._44 = 1.0f;
-
-    //m_mViewMatrix = XMMatrixIdentity();
-    //m_mViewMatrix.r[0] = vX;
-    //m_mViewMatrix.r[1] = vY;
-    //m_mViewMatrix.r[2] = vY;
-    //
-    //m_mViewMatrix._14 = -XMVectorGetX( XMVector3Dot( vX, m_vPosition ) );
-    //m_mViewMatrix._24 = -XMVectorGetX( XMVector3Dot( vY, m_vPosition ) );
-    //m_mViewMatrix._34 = -XMVectorGetX( XMVector3Dot( vZ, m_vPosition ) );
-
-    m_mViewMatrix = XMMatrixTranspose( m_mViewMatrix );
+    m_vLook.Normalize();
+    m_vRight = Normalize( CrossProduct( m_vUp, m_vLook ) );
+
+    m_mViewMatrix = RMatrix4x4LookToLH( m_vPosition, m_vLook, m_vUp );
 }
 
 //-----------------------------------------------------------------------------
@@ -94,8 +88,7 @@ void CView::Update( float fDeltaTime )
 //-----------------------------------------------------------------------------
 void CView::SetPerspective( float fFoV, float fAspectRatio, float fNear, float fFar )
 {
-    fFoV = (fFoV/180.0f) * XM_PI;
-    m_mProjMatrix = XMMatrixPerspectiveFovLH( fFoV, fAspectRatio, fNear, fFar );
+    m_mProjMatrix = RMatrix4x4PerspectiveFovLH( DegToRad( fFoV ), fAspectRatio, fNear, fFar );
 }
 
 
@@ -103,12 +96,21 @@ void CView::SetPerspective( float fFoV, float fAspectRatio, float fNear, float f
 //  GetView/ProjMatrix
 //  Returns the view/proj matrix
 //-----------------------------------------------------------------------------
-const XMMATRIX& CView::GetViewMatrix( void )
+const RMatrix4x4& CView::GetViewMatrix( void )
 {
     return m_mViewMatrix;
 }
 
-const XMMATRIX& CView::GetProjMatrix( void )
+const RMatrix4x4& CView::GetProjMatrix( void )
 {
     return m_mProjMatrix;
 }
+
+//-----------------------------------------------------------------------------
+//  GetFrustum
+//  Returns the world space frustum, as of the last Update
+//-----------------------------------------------------------------------------
+RFrustum CView::GetFrustum( void )
+{
+    return RFrustumFromMatrix( m_mViewMatrix * m_mProjMatrix );
+}
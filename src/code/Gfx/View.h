@@ -10,10 +10,10 @@ Modified by:    Kyle Weicht
 #ifndef _VIEW_H_
 #define _VIEW_H_
 #include "Common.h"
-#include "Scene\Object.h"
+#include "Scene/Object.h"
 #include "Types.h"
-#include <Windows.h>
-#include <xnamath.h>
+#include "RiotMath.h"
+#include "BoundingVolume.h"
 
 class CView : public CObject
 {
@@ -45,6 +45,12 @@ public:
     //-----------------------------------------------------------------------------
     void RotateX( float fRad );
     void RotateY( float fRad );
+
+    //-----------------------------------------------------------------------------
+    //  LookAt
+    //  Points the camera at vTarget, keeping it upright
+    //-----------------------------------------------------------------------------
+    void LookAt( const RVector4& vTarget );
     
     //-----------------------------------------------------------------------------
     //  Update
@@ -63,19 +69,25 @@ public:
     //  GetView/ProjMatrix
     //  Returns the view/proj matrix
     //-----------------------------------------------------------------------------
-    const XMMATRIX& GetViewMatrix( void );
-    const XMMATRIX& GetProjMatrix( void );
+    const RMatrix4x4& GetViewMatrix( void );
+    const RMatrix4x4& GetProjMatrix( void );
+
+    //-----------------------------------------------------------------------------
+    //  GetFrustum
+    //  Returns the world space frustum, as of the last Update
+    //-----------------------------------------------------------------------------
+    RFrustum GetFrustum( void );
 
 private:
     /***************************************\
     | class members                         |
     \***************************************/
-    XMVECTOR    m_vUp;
-    XMVECTOR    m_vLook;
-    XMVECTOR    m_vRight;
+    RVector4    m_vUp;
+    RVector4    m_vLook;
+    RVector4    m_vRight;
 
-    XMMATRIX    m_mViewMatrix;
-    XMMATRIX    m_mProjMatrix;
+    RMatrix4x4  m_mViewMatrix;
+    RMatrix4x4  m_mProjMatrix;
 };
 
 
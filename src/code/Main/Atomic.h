@@ -0,0 +1,224 @@
+/*********************************************************\
+File:       Atomic.h
+Purpose:    Atomic operations and a light-weight spin lock
+\*********************************************************/
+#ifndef _ATOMIC_H_
+#define _ATOMIC_H_
+#include "Types.h"
+
+#if defined( _MSC_VER )
+#include <intrin.h>
+#include <emmintrin.h> // For _mm_pause
+#endif // #if defined( _MSC_VER )
+
+//-----------------------------------------------------------------------------
+//  Atomic operations
+//  All of them return the new value, except the exchanges which return the
+//  previous value. The acquire load and release store are for handing data
+//  from one thread to another without a lock
+//-----------------------------------------------------------------------------
+#if defined( _MSC_VER )
+
+__forceinline sint32 AtomicIncrement( volatile sint32* pValue )
+{
+    return _InterlockedIncrement( (volatile long*)pValue );
+}
+
+__forceinline sint32 AtomicDecrement( volatile sint32* pValue )
+{
+    return _InterlockedDecrement( (volatile long*)pValue );
+}
+
+__forceinline sint32 AtomicAdd( volatile sint32* pValue, sint32 nAdd )
+{
+    return _InterlockedExchangeAdd( (volatile long*)pValue, nAdd ) + nAdd;
+}
+
+__forceinline sint32 AtomicExchange( volatile sint32* pValue, sint32 nNew )
+{
+    return _InterlockedExchange( (volatile long*)pValue, nNew );
+}
+
+__forceinline sint32 AtomicCompareExchange( volatile sint32* pValue, sint32 nNew, sint32 nComparand )
+{
+    return _InterlockedCompareExchange( (volatile long*)pValue, nNew, nComparand );
+}
+
+__forceinline sint64 AtomicCompareExchange64( volatile sint64* pValue, sint64 nNew, sint64 nComparand )
+{
+    return _InterlockedCompareExchange64( pValue, nNew, nComparand );
+}
+
+__forceinline sint64 AtomicAdd64( volatile sint64* pValue, sint64 nAdd )
+{
+#if defined( _M_X64 )
+    return _InterlockedExchangeAdd64( pValue, nAdd ) + nAdd;
+#else
+    sint64 nOld;
+    do
+    {
+        nOld = *pValue;
+    } while( _InterlockedCompareExchange64( pValue, nOld + nAdd, nOld ) != nOld );
+    return nOld + nAdd;
+#endif // #if defined( _M_X64 )
+}
+
+__forceinline void* AtomicCompareExchangePointer( void* volatile* ppValue, void* pNew, void* pComparand )
+{
+#if defined( _M_X64 )
+    return _InterlockedCompareExchangePointer( ppValue, pNew, pComparand );
+#else
+    return (void*)_InterlockedCompareExchange( (volatile long*)ppValue, (long)pNew, (long)pComparand );
+#endif // #if defined( _M_X64 )
+}
+
+__forceinline sint32 AtomicLoadAcquire( volatile sint32* pValue )
+{
+    // x86 never reorders loads with later loads, just keep the compiler honest
+    sint32 nValue = *pValue;
+    _ReadWriteBarrier();
+    return nValue;
+}
+
+__forceinline void AtomicStoreRelease( volatile sint32* pValue, sint32 nNew )
+{
+    _ReadWriteBarrier();
+    *pValue = nNew;
+}
+
+__forceinline void CPUPause( void )
+{
+    _mm_pause();
+}
+
+#else // #if defined( _MSC_VER )
+
+__forceinline sint32 AtomicIncrement( volatile sint32* pValue )
+{
+    return __sync_add_and_fetch( pValue, 1 );
+}
+
+__forceinline sint32 AtomicDecrement( volatile sint32* pValue )
+{
+    return __sync_sub_and_fetch( pValue, 1 );
+}
+
+__forceinline sint32 AtomicAdd( volatile sint32* pValue, sint32 nAdd )
+{
+    return __sync_add_and_fetch( pValue, nAdd );
+}
+
+__forceinline sint32 AtomicExchange( volatile sint32* pValue, sint32 nNew )
+{
+    __sync_synchronize();
+    return __sync_lock_test_and_set( pValue, nNew );
+}
+
+__forceinline sint32 AtomicCompareExchange( volatile sint32* pValue, sint32 nNew, sint32 nComparand )
+{
+    return __sync_val_compare_and_swap( pValue, nComparand, nNew );
+}
+
+__forceinline sint64 AtomicCompareExchange64( volatile sint64* pValue, sint64 nNew, sint64 nComparand )
+{
+    return __sync_val_compare_and_swap( pValue, nComparand, nNew );
+}
+
+__forceinline sint64 AtomicAdd64( volatile sint64* pValue, sint64 nAdd )
+{
+    return __sync_add_and_fetch( pValue, nAdd );
+}
+
+__forceinline void* AtomicCompareExchangePointer( void* volatile* ppValue, void* pNew, void* pComparand )
+{
+    return __sync_val_compare_and_swap( ppValue, pComparand, pNew );
+}
+
+__forceinline sint32 AtomicLoadAcquire( volatile sint32* pValue )
+{
+    return __atomic_load_n( pValue, __ATOMIC_ACQUIRE );
+}
+
+__forceinline void AtomicStoreRelease( volatile sint32* pValue, sint32 nNew )
+{
+    __atomic_store_n( pValue, nNew, __ATOMIC_RELEASE );
+}
+
+__forceinline void CPUPause( void )
+{
+#if defined( __i386__ ) || defined( __x86_64__ )
+    __builtin_ia32_pause();
+#endif
+}
+
+#endif // #if defined( _MSC_VER )
+
+//-----------------------------------------------------------------------------
+//  AtomicMax64
+//  Raises *pValue to nValue if nValue is larger
+//-----------------------------------------------------------------------------
+__forceinline void AtomicMax64( volatile sint64* pValue, sint64 nValue )
+{
+    sint64 nOld = *pValue;
+    while( nValue > nOld )
+    {
+        sint64 nPrev = AtomicCompareExchange64( pValue, nValue, nOld );
+        if( nPrev == nOld )
+            break;
+        nOld = nPrev;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//  CSpinLock
+//  Busy-waiting lock for very short critical sections. A zero-initialized
+//  CSpinLock is unlocked, so it is safe to use from static initializers
+//-----------------------------------------------------------------------------
+class CSpinLock
+{
+public:
+    CSpinLock() : m_nLock( 0 ) { }
+
+    __forceinline void Lock( void )
+    {
+        while( AtomicCompareExchange( &m_nLock, 1, 0 ) != 0 )
+        {
+            while( m_nLock != 0 )
+            {
+                CPUPause();
+            }
+        }
+    }
+
+    __forceinline bool TryLock( void )
+    {
+        return AtomicCompareExchange( &m_nLock, 1, 0 ) == 0;
+    }
+
+    __forceinline void Unlock( void )
+    {
+        AtomicExchange( &m_nLock, 0 );
+    }
+
+private:
+    volatile sint32 m_nLock;
+};
+
+//-----------------------------------------------------------------------------
+//  CScopedSpinLock
+//  Holds a CSpinLock for the lifetime of the object
+//-----------------------------------------------------------------------------
+class CScopedSpinLock
+{
+public:
+    CScopedSpinLock( CSpinLock& lock ) : m_Lock( lock ) { m_Lock.Lock(); }
+    ~CScopedSpinLock() { m_Lock.Unlock(); }
+
+private:
+    CScopedSpinLock( const CScopedSpinLock& );
+    CScopedSpinLock& operator=( const CScopedSpinLock& );
+
+    CSpinLock& m_Lock;
+};
+
+#endif // #ifndef _ATOMIC_H_
@@ -0,0 +1,300 @@
+/*********************************************************\
+File:       Benchmark.cpp
+Purpose:    Records a benchmark run frame by frame, and
+            writes the results out for comparing runs
+\*********************************************************/
+#include "Benchmark.h"
+#include "FrameStats.h"
+#include "Profiler.h"
+#include "Memory.h"
+#include "MathStream.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+//-----------------------------------------------------------------------------
+//  Phases
+//  The frame, and every profile scope in the top two levels of the
+//  profile. Like the frame statistics, everything here comes from malloc,
+//  so the benchmark doesn't show up in its own allocation counts
+//-----------------------------------------------------------------------------
+static const uint   gs_nMaxBenchmarkPhases  = 24;
+static const uint   gs_nMaxBenchmarkDepth   = 2;
+
+struct BenchmarkPhase
+{
+    const char*         szName;
+    CFrameTimeHistogram histogram;
+};
+
+static BenchmarkSettings    g_Settings;
+static bool                 g_bBenchmarkRunning = false;
+static float                g_fLoadMs = 0.0f;
+static uint                 g_nFramesSeen = 0;          // Including the warm-up
+static uint                 g_nFramesRecorded = 0;
+static uint                 g_nMaxFrames = 0;
+static BenchmarkFrame*      g_pFrames = NULL;
+static float*               g_pPhaseMs = NULL;          // gs_nMaxBenchmarkPhases a frame
+static BenchmarkPhase*      g_pPhases[gs_nMaxBenchmarkPhases];
+static uint                 g_nNumPhases = 0;
+static sint64               g_nPeakBytesLive = 0;
+
+static uint FindPhase( const char* szName )
+{
+    for( uint nPhase = 0; nPhase < g_nNumPhases; ++nPhase )
+    {
+        if( strcmp( g_pPhases[nPhase]->szName, szName ) == 0 )
+            return nPhase;
+    }
+    if( g_nNumPhases == gs_nMaxBenchmarkPhases )
+        return gs_nMaxBenchmarkPhases;
+
+    // The histograms are too big to construct on the stack, so construct
+    // them in place
+    BenchmarkPhase* pPhase = (BenchmarkPhase*)malloc( sizeof( BenchmarkPhase ) );
+    pPhase->szName = szName;
+    pPhase->histogram.Clear();
+    g_pPhases[ g_nNumPhases ] = pPhase;
+    return g_nNumPhases++;
+}
+
+bool BenchmarkIsRunning( void )
+{
+    return g_bBenchmarkRunning;
+}
+
+void BenchmarkBegin( const BenchmarkSettings& settings, float fLoadMs )
+{
+    g_Settings = settings;
+    g_fLoadMs = fLoadMs;
+    g_nFramesSeen = 0;
+    g_nFramesRecorded = 0;
+    g_nMaxFrames = settings.nNumFrames;
+    g_pFrames = (BenchmarkFrame*)calloc( g_nMaxFrames, sizeof( BenchmarkFrame ) );
+    g_pPhaseMs = (float*)calloc( g_nMaxFrames * gs_nMaxBenchmarkPhases, sizeof( float ) );
+    g_nPeakBytesLive = 0;
+    g_bBenchmarkRunning = true;
+
+    // The frame always comes first
+    FindPhase( "Frame" );
+}
+
+bool BenchmarkRecordFrame( const BenchmarkFrame& frame )
+{
+    if( !g_bBenchmarkRunning || g_nFramesRecorded == g_nMaxFrames )
+        return false;
+    if( g_nFramesSeen++ < g_Settings.nWarmupFrames )
+        return true;
+
+    uint nFrame = g_nFramesRecorded++;
+    g_pFrames[nFrame] = frame;
+
+    // A scope can be hit from more than one place, so its time is summed
+    // over the frame before it's recorded
+    float* pPhaseMs = g_pPhaseMs + nFrame * gs_nMaxBenchmarkPhases;
+    bool pRan[gs_nMaxBenchmarkPhases] = { false };
+    pPhaseMs[0] = frame.fFrameMs;
+    pRan[0] = true;
+
+    uint nNumNodes = 0;
+    const ProfileNode* pNodes = ProfilerGetFrame( &nNumNodes );
+    for( uint nNode = 0; nNode < nNumNodes; ++nNode )
+    {
+        if( pNodes[nNode].nDepth == 0 || pNodes[nNode].nDepth > gs_nMaxBenchmarkDepth )
+            continue;
+
+        uint nPhase = FindPhase( pNodes[nNode].szName );
+        if( nPhase == gs_nMaxBenchmarkPhases )
+            continue;
+        pPhaseMs[nPhase] += pNodes[nNode].fMilliseconds;
+        pRan[nPhase] = true;
+    }
+
+    for( uint nPhase = 0; nPhase < g_nNumPhases; ++nPhase )
+    {
+        if( pRan[nPhase] )
+        {
+            float fMs = pPhaseMs[nPhase];
+            g_pPhases[nPhase]->histogram.Add( fMs > 0.0f ? (uint)( fMs * 1000.0f + 0.5f ) : 0 );
+        }
+    }
+
+    MemoryStats memoryStats;
+    GetMemoryStats( &memoryStats );
+    g_nPeakBytesLive = memoryStats.nBytesLive > g_nPeakBytesLive ? memoryStats.nBytesLive : g_nPeakBytesLive;
+
+    return g_nFramesRecorded < g_nMaxFrames;
+}
+
+//-----------------------------------------------------------------------------
+//  OpenResults
+//-----------------------------------------------------------------------------
+static FILE* OpenResults( const char* szFilename )
+{
+    FILE* pFile = NULL;
+#if defined( _MSC_VER )
+    if( fopen_s( &pFile, szFilename, "w" ) != 0 )
+        return NULL;
+#else
+    pFile = fopen( szFilename, "w" );
+#endif // #if defined( _MSC_VER )
+    return pFile;
+}
+
+//-----------------------------------------------------------------------------
+//  WriteCSV
+//  A row per recorded frame, with every phase's time and the counters
+//-----------------------------------------------------------------------------
+static void WriteCSV( FILE* pFile )
+{
+    fprintf( pFile, "frame" );
+    for( uint nPhase = 0; nPhase < g_nNumPhases; ++nPhase )
+    {
+        fprintf( pFile, ",%s ms", g_pPhases[nPhase]->szName );
+    }
+    fprintf( pFile, ",allocations,bytes_allocated,draws,triangles,triangles_drawn,state_changes\n" );
+
+    for( uint nFrame = 0; nFrame < g_nFramesRecorded; ++nFrame )
+    {
+        const BenchmarkFrame& frame = g_pFrames[nFrame];
+        const float* pPhaseMs = g_pPhaseMs + nFrame * gs_nMaxBenchmarkPhases;
+        fprintf( pFile, "%u", g_Settings.nWarmupFrames + nFrame );
+        for( uint nPhase = 0; nPhase < g_nNumPhases; ++nPhase )
+        {
+            fprintf( pFile, ",%.4f", pPhaseMs[nPhase] );
+        }
+        fprintf( pFile, ",%llu,%llu,%llu,%llu,%llu,%llu\n",
+                 (unsigned long long)frame.nAllocations,
+                 (unsigned long long)frame.nBytesAllocated,
+                 (unsigned long long)frame.nDraws,
+                 (unsigned long long)frame.nTriangles,
+                 (unsigned long long)frame.nTrianglesDrawn,
+                 (unsigned long long)frame.nStateChanges );
+    }
+}
+
+//-----------------------------------------------------------------------------
+//  WriteJSON
+//  The settings, then the summaries. The names are all string literals
+//  from the code, so nothing needs escaping
+//-----------------------------------------------------------------------------
+static void WriteCounter( FILE* pFile, const char* szName, uint64 BenchmarkFrame::* pnCounter, bool bLast )
+{
+    uint64 nTotal = 0;
+    uint64 nMax = 0;
+    for( uint nFrame = 0; nFrame < g_nFramesRecorded; ++nFrame )
+    {
+        uint64 nValue = g_pFrames[nFrame].*pnCounter;
+        nTotal += nValue;
+        nMax = nValue > nMax ? nValue : nMax;
+    }
+    fprintf( pFile, "        \"%s\": { \"total\": %llu, \"avg\": %.2f, \"max\": %llu }%s\n",
+             szName, (unsigned long long)nTotal,
+             g_nFramesRecorded ? (double)nTotal / g_nFramesRecorded : 0.0,
+             (unsigned long long)nMax, bLast ? "" : "," );
+}
+
+static void WriteJSON( FILE* pFile )
+{
+#if defined( OS_WINDOWS )
+    const char* szPlatform = "windows";
+#elif defined( OS_OSX )
+    const char* szPlatform = "osx";
+#else
+    const char* szPlatform = "linux";
+#endif // #if defined( OS_WINDOWS )
+#if defined( _DEBUG )
+    const char* szBuild = "debug";
+#else
+    const char* szBuild = "release";
+#endif // #if defined( _DEBUG )
+
+    fprintf( pFile, "{\n" );
+    fprintf( pFile, "    \"platform\": \"%s\",\n", szPlatform );
+    fprintf( pFile, "    \"build\": \"%s\",\n", szBuild );
+    fprintf( pFile, "    \"math_isa\": \"%s\",\n", MathGetISAName( MathGetISA() ) );
+    fprintf( pFile, "    \"backend\": \"%s\",\n", g_Settings.szBackend );
+    fprintf( pFile, "    \"objects\": %u,\n", g_Settings.nNumObjects );
+    fprintf( pFile, "    \"frames\": %u,\n", g_nFramesRecorded );
+    fprintf( pFile, "    \"warmup_frames\": %u,\n", g_Settings.nWarmupFrames );
+    fprintf( pFile, "    \"seed\": %u,\n", g_Settings.nSeed );
+    fprintf( pFile, "    \"load_ms\": %.3f,\n", g_fLoadMs );
+
+    fprintf( pFile, "    \"phases\": [\n" );
+    for( uint nPhase = 0; nPhase < g_nNumPhases; ++nPhase )
+    {
+        const CFrameTimeHistogram& histogram = g_pPhases[nPhase]->histogram;
+        fprintf( pFile, "        { \"name\": \"%s\", \"frames\": %u, \"min_ms\": %.3f, \"avg_ms\": %.3f, "
+                        "\"p50_ms\": %.3f, \"p95_ms\": %.3f, \"p99_ms\": %.3f, \"max_ms\": %.3f }%s\n",
+                 g_pPhases[nPhase]->szName, histogram.GetCount(),
+                 histogram.GetMin(), histogram.GetAverage(),
+                 histogram.GetPercentile( 50.0f ), histogram.GetPercentile( 95.0f ),
+                 histogram.GetPercentile( 99.0f ), histogram.GetMax(),
+                 nPhase + 1 < g_nNumPhases ? "," : "" );
+    }
+    fprintf( pFile, "    ],\n" );
+
+    fprintf( pFile, "    \"counters\": {\n" );
+    WriteCounter( pFile, "allocations", &BenchmarkFrame::nAllocations, false );
+    WriteCounter( pFile, "bytes_allocated", &BenchmarkFrame::nBytesAllocated, false );
+    WriteCounter( pFile, "draws", &BenchmarkFrame::nDraws, false );
+    WriteCounter( pFile, "triangles", &BenchmarkFrame::nTriangles, false );
+    WriteCounter( pFile, "triangles_drawn", &BenchmarkFrame::nTrianglesDrawn, false );
+    WriteCounter( pFile, "state_changes", &BenchmarkFrame::nStateChanges, true );
+    fprintf( pFile, "    },\n" );
+
+    fprintf( pFile, "    \"memory\": {\n" );
+    fprintf( pFile, "        \"peak_live_kb\": %lld,\n", (long long)( g_nPeakBytesLive / 1024 ) );
+    fprintf( pFile, "        \"categories\": [\n" );
+    for( uint nCategory = 0; nCategory < eNUMMEMORYCATEGORIES; ++nCategory )
+    {
+        MemoryCategoryStats stats;
+        GetMemoryCategoryStats( (eMemoryCategory)nCategory, &stats );
+        fprintf( pFile, "            { \"name\": \"%s\", \"live_kb\": %lld, \"peak_kb\": %lld, \"allocations_live\": %lld }%s\n",
+                 GetMemoryCategoryName( (eMemoryCategory)nCategory ),
+                 (long long)( stats.nBytesLive / 1024 ),
+                 (long long)( stats.nPeakBytesLive / 1024 ),
+                 (long long)stats.nAllocationsLive,
+                 nCategory + 1 < eNUMMEMORYCATEGORIES ? "," : "" );
+    }
+    fprintf( pFile, "        ]\n" );
+    fprintf( pFile, "    }\n" );
+    fprintf( pFile, "}\n" );
+}
+
+bool BenchmarkEnd( void )
+{
+    if( !g_bBenchmarkRunning )
+        return true;
+    g_bBenchmarkRunning = false;
+
+    const char* szFilename = g_Settings.szFilename;
+    size_t nLength = strlen( szFilename );
+    bool bCSV = nLength >= 4 && strcmp( szFilename + nLength - 4, ".csv" ) == 0;
+
+    FILE* pFile = OpenResults( szFilename );
+    if( pFile )
+    {
+        if( bCSV )
+            WriteCSV( pFile );
+        else
+            WriteJSON( pFile );
+        fclose( pFile );
+    }
+
+    const CFrameTimeHistogram& frameHistogram = g_pPhases[0]->histogram;
+    printf( "Benchmark: %u objects, %u frames, avg %.3f ms, p99 %.3f ms, max %.3f ms\n",
+            g_Settings.nNumObjects, g_nFramesRecorded,
+            frameHistogram.GetAverage(), frameHistogram.GetPercentile( 99.0f ), frameHistogram.GetMax() );
+
+    for( uint nPhase = 0; nPhase < g_nNumPhases; ++nPhase )
+    {
+        free( g_pPhases[nPhase] );
+    }
+    g_nNumPhases = 0;
+    free( g_pFrames );
+    free( g_pPhaseMs );
+    g_pFrames = NULL;
+    g_pPhaseMs = NULL;
+    return pFile != NULL;
+}
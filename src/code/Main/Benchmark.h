@@ -0,0 +1,69 @@
+/*********************************************************\
+File:       Benchmark.h
+Purpose:    Records a benchmark run frame by frame, and
+            writes the results out for comparing runs
+\*********************************************************/
+#ifndef _BENCHMARK_H_
+#define _BENCHMARK_H_
+#include "Types.h"
+
+//-----------------------------------------------------------------------------
+//  BenchmarkSettings
+//  How the run was set up. The strings have to outlive the benchmark
+//-----------------------------------------------------------------------------
+struct BenchmarkSettings
+{
+    const char* szFilename;         // .csv for a row per frame, JSON otherwise
+    const char* szBackend;
+    uint        nNumObjects;
+    uint        nNumFrames;         // Recorded, at least 1
+    uint        nWarmupFrames;      // Run first, and left out of the results
+    uint        nSeed;
+};
+
+//-----------------------------------------------------------------------------
+//  BenchmarkFrame
+//  What the engine measured over one frame. The draw counts are whatever
+//  the graphics backend keeps, 0 if it doesn't
+//-----------------------------------------------------------------------------
+struct BenchmarkFrame
+{
+    float   fFrameMs;
+    uint64  nAllocations;
+    uint64  nBytesAllocated;
+    uint64  nDraws;
+    uint64  nTriangles;             // Submitted
+    uint64  nTrianglesDrawn;        // Left after culling and clipping
+    uint64  nStateChanges;
+};
+
+//-----------------------------------------------------------------------------
+//  BenchmarkBegin
+//  Starts recording. Everything for the recorded frames is allocated here,
+//  so recording doesn't allocate during frames. fLoadMs is how long it
+//  took to start up and build the scene
+//-----------------------------------------------------------------------------
+void BenchmarkBegin( const BenchmarkSettings& settings, float fLoadMs );
+
+//-----------------------------------------------------------------------------
+//  BenchmarkRecordFrame
+//  Records a frame, along with the time of each profile scope in the top
+//  two levels of last frame's profile. Call it after MemoryEndFrame, so
+//  the memory counters cover the whole frame. Returns false once every
+//  frame has been recorded
+//-----------------------------------------------------------------------------
+bool BenchmarkRecordFrame( const BenchmarkFrame& frame );
+
+//-----------------------------------------------------------------------------
+//  BenchmarkEnd
+//  Writes the results, and prints a summary. Returns false if the file
+//  couldn't be written
+//-----------------------------------------------------------------------------
+bool BenchmarkEnd( void );
+
+//-----------------------------------------------------------------------------
+//  BenchmarkIsRunning
+//-----------------------------------------------------------------------------
+bool BenchmarkIsRunning( void );
+
+#endif // #ifndef _BENCHMARK_H_
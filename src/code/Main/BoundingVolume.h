@@ -0,0 +1,198 @@
+/*********************************************************\
+File:       BoundingVolume.h
+Purpose:    Planes, bounding volumes and the view frustum,
+            and the tests between them
+\*********************************************************/
+#ifndef _BOUNDINGVOLUME_H_
+#define _BOUNDINGVOLUME_H_
+#include "Types.h"
+#include "RiotMath.h"
+
+//-----------------------------------------------------------------------------
+//  RPlane
+//  Every point p on the plane has a*p.x + b*p.y + c*p.z + d = 0. Points
+//  on the side the normal points to are in front, with a positive distance
+//-----------------------------------------------------------------------------
+class ALIGN( 16 ) RPlane
+{
+public:
+    /***************************************\
+    | class members
+    \***************************************/
+    union
+    {
+        struct { float a, b, c, d; };
+        float f[4];
+        RVectorReg v;
+    };
+
+public:
+    // RPlane constructors
+    RPlane(  ) { }
+    RPlane( float A, float B, float C, float D );
+    explicit RPlane( RVectorReg V );
+
+    /***************************************\
+    | class methods
+    \***************************************/
+    // Scales the plane so the normal is unit length. Distance is only in
+    // world units once it's normalized
+    void Normalize( void );
+    float Distance( const RVector4& vPoint ) const;
+    RVector4 GetNormal( void ) const;
+};
+
+RPlane RPlaneFromPointNormal( const RVector4& vPoint, const RVector4& vNormal );
+// Facing the side A, B, C wind clockwise from, the same as D3D's front faces
+RPlane RPlaneFromPoints( const RVector4& A, const RVector4& B, const RVector4& C );
+
+//-----------------------------------------------------------------------------
+//  RAABB
+//  Axis aligned box. The w of both corners is 0
+//-----------------------------------------------------------------------------
+class ALIGN( 16 ) RAABB
+{
+public:
+    /***************************************\
+    | class members
+    \***************************************/
+    RVector4    vMin;
+    RVector4    vMax;
+
+public:
+    // RAABB constructors
+    RAABB(  ) { }
+    RAABB( const RVector4& Min, const RVector4& Max );
+
+    /***************************************\
+    | class methods
+    \***************************************/
+    RVector4 GetCenter( void ) const;
+    RVector4 GetExtents( void ) const;  // Half the size
+    void AddPoint( const RVector4& vPoint );
+    void Merge( const RAABB& Box );
+    bool Contains( const RVector4& vPoint ) const;
+};
+
+RAABB RAABBFromCenterExtents( const RVector4& vCenter, const RVector4& vExtents );
+RAABB Merge( const RAABB& A, const RAABB& B );
+// The box around the transformed box
+RAABB Transform( const RAABB& Box, const RMatrix4x4& M );
+
+//-----------------------------------------------------------------------------
+//  RSphere
+//-----------------------------------------------------------------------------
+class ALIGN( 16 ) RSphere
+{
+public:
+    /***************************************\
+    | class members
+    \***************************************/
+    RVector4    vCenter;
+    float       fRadius;
+
+public:
+    // RSphere constructors
+    RSphere(  ) { }
+    RSphere( const RVector4& Center, float Radius );
+
+    /***************************************\
+    | class methods
+    \***************************************/
+    bool Contains( const RVector4& vPoint ) const;
+};
+
+// Scales the radius by the longest of M's first three rows. That's the
+// largest scale when M scales before it rotates, like a world matrix
+RSphere Transform( const RSphere& Sphere, const RMatrix4x4& M );
+
+//-----------------------------------------------------------------------------
+//  ROBB
+//  Oriented box: a box of half size vExtents, rotated by qOrientation
+//  about its center
+//-----------------------------------------------------------------------------
+class ALIGN( 16 ) ROBB
+{
+public:
+    /***************************************\
+    | class members
+    \***************************************/
+    RVector4    vCenter;
+    RVector4    vExtents;
+    RQuaternion qOrientation;
+
+public:
+    // ROBB constructors
+    ROBB(  ) { }
+    ROBB( const RVector4& Center, const RVector4& Extents, const RQuaternion& Orientation );
+
+    /***************************************\
+    | class methods
+    \***************************************/
+    // The box's local x, y and z axes in world space
+    void GetAxes( RVector4* pAxes ) const;
+    bool Contains( const RVector4& vPoint ) const;
+};
+
+//-----------------------------------------------------------------------------
+//  RFrustum
+//  Six planes, all facing in, so anything in front of all of them is in
+//  the frustum
+//-----------------------------------------------------------------------------
+enum eFrustumPlane
+{
+    eFrustumLeft,
+    eFrustumRight,
+    eFrustumBottom,
+    eFrustumTop,
+    eFrustumNear,
+    eFrustumFar,
+
+    eNUMFRUSTUMPLANES
+};
+
+class ALIGN( 16 ) RFrustum
+{
+public:
+    /***************************************\
+    | class members
+    \***************************************/
+    RPlane  Planes[eNUMFRUSTUMPLANES];
+};
+
+//-----------------------------------------------------------------------------
+//  RFrustumFromMatrix
+//  Pulls the planes out of a view * projection matrix, with 0 to 1 depth.
+//  A projection matrix alone gives the frustum in view space
+//-----------------------------------------------------------------------------
+RFrustum RFrustumFromMatrix( const RMatrix4x4& mViewProj );
+
+//-----------------------------------------------------------------------------
+//  Intersect
+//  True if the volumes touch or overlap. The frustum tests are
+//  conservative: a volume just outside a corner of the frustum can still
+//  pass, but nothing inside is ever rejected
+//-----------------------------------------------------------------------------
+bool Intersect( const RAABB& A, const RAABB& B );
+bool Intersect( const RSphere& A, const RSphere& B );
+bool Intersect( const RSphere& Sphere, const RAABB& Box );
+bool Intersect( const ROBB& A, const ROBB& B );
+bool Intersect( const RFrustum& Frustum, const RSphere& Sphere );
+bool Intersect( const RFrustum& Frustum, const RAABB& Box );
+bool Intersect( const RFrustum& Frustum, const ROBB& Box );
+
+//-----------------------------------------------------------------------------
+//  IntersectRay
+//  True if the ray hits the volume, and *pT is how far along vDirection
+//  it enters, or 0 if vOrigin is already inside. vDirection needn't be
+//  normalized
+//-----------------------------------------------------------------------------
+bool IntersectRay( const RAABB& Box, const RVector4& vOrigin, const RVector4& vDirection, float* pT );
+bool IntersectRay( const RSphere& Sphere, const RVector4& vOrigin, const RVector4& vDirection, float* pT );
+
+//-----------------------------------------------------------------------------
+//  Everything's inlined
+//-----------------------------------------------------------------------------
+#include "BoundingVolume.inl"
+
+#endif // #ifndef _BOUNDINGVOLUME_H_
@@ -0,0 +1,404 @@
+/*********************************************************\
+File:      BoundingVolume.inl
+Purpose:   Inline definitions for BoundingVolume.h
+\*********************************************************/
+
+// |A|, one lane at a time
+__forceinline RVectorReg RVecAbs( RVectorReg A )
+{
+    return RVecMax( A, RVecSub( RVecSplat( 0.0f ), A ) );
+}
+
+// (x, y, z, 1), so a dot product with a plane is the distance to it
+__forceinline RVectorReg RVecPoint( const RVector4& V )
+{
+    return RVecSet( V.x, V.y, V.z, 1.0f );
+}
+
+/**********************************************************\
+|**********************************************************|
+| class RPlane
+|**********************************************************|
+\**********************************************************/
+_inline RPlane::RPlane(float A, float B, float C, float D) : v( RVecSet( A, B, C, D ) )
+{
+}
+
+_inline RPlane::RPlane(RVectorReg V) : v( V )
+{
+}
+
+_inline void RPlane::Normalize(void)
+{
+    float fRecip = 1 / sqrtf( a*a + b*b + c*c );
+    v = RVecMul( v, RVecSplat( fRecip ) );
+}
+
+_inline float RPlane::Distance(const RVector4& vPoint) const
+{
+    return RVecGetX( RVecDot( v, RVecPoint( vPoint ) ) );
+}
+
+_inline RVector4 RPlane::GetNormal(void) const
+{
+    return RVector4( a, b, c, 0.0f );
+}
+
+// Non-member functions
+_inline RPlane RPlaneFromPointNormal(const RVector4& vPoint, const RVector4& vNormal)
+{
+    RVector4 vUnit = Normalize( RVector4( vNormal.x, vNormal.y, vNormal.z, 0.0f ) );
+    return RPlane( vUnit.x, vUnit.y, vUnit.z, -vUnit.DotProduct( RVector4( vPoint.x, vPoint.y, vPoint.z, 0.0f ) ) );
+}
+
+_inline RPlane RPlaneFromPoints(const RVector4& A, const RVector4& B, const RVector4& C)
+{
+    return RPlaneFromPointNormal( A, CrossProduct( B - A, C - A ) );
+}
+
+
+/**********************************************************\
+|**********************************************************|
+| class RAABB
+|**********************************************************|
+\**********************************************************/
+_inline RAABB::RAABB(const RVector4& Min, const RVector4& Max)
+    : vMin( Min.x, Min.y, Min.z, 0.0f )
+    , vMax( Max.x, Max.y, Max.z, 0.0f )
+{
+}
+
+_inline RVector4 RAABB::GetCenter(void) const
+{
+    return RVector4( RVecMul( RVecAdd( vMin.v, vMax.v ), RVecSplat( 0.5f ) ) );
+}
+
+_inline RVector4 RAABB::GetExtents(void) const
+{
+    return RVector4( RVecMul( RVecSub( vMax.v, vMin.v ), RVecSplat( 0.5f ) ) );
+}
+
+_inline void RAABB::AddPoint(const RVector4& vPoint)
+{
+    RVectorReg vPoint3 = RVecSet( vPoint.x, vPoint.y, vPoint.z, 0.0f );
+    vMin.v = RVecMin( vMin.v, vPoint3 );
+    vMax.v = RVecMax( vMax.v, vPoint3 );
+}
+
+_inline void RAABB::Merge(const RAABB& Box)
+{
+    vMin.v = RVecMin( vMin.v, Box.vMin.v );
+    vMax.v = RVecMax( vMax.v, Box.vMax.v );
+}
+
+_inline bool RAABB::Contains(const RVector4& vPoint) const
+{
+    return RVecAllLessEqual3( vMin.v, vPoint.v ) && RVecAllLessEqual3( vPoint.v, vMax.v );
+}
+
+// Non-member functions
+_inline RAABB RAABBFromCenterExtents(const RVector4& vCenter, const RVector4& vExtents)
+{
+    return RAABB( vCenter - vExtents, vCenter + vExtents );
+}
+
+_inline RAABB Merge(const RAABB& A, const RAABB& B)
+{
+    RAABB Box( A );
+    Box.Merge( B );
+    return Box;
+}
+
+//-----------------------------------------------------------------------------
+//  Transform
+//  Each new extent is the old ones projected onto that axis of M, which
+//  is exact for the box, if not for whatever the box was bounding
+//-----------------------------------------------------------------------------
+_inline RAABB Transform(const RAABB& Box, const RMatrix4x4& M)
+{
+    RVector4 vCenter = RVector4( RVecPoint( Box.GetCenter() ) ) * M;
+    RVector4 vExtents = Box.GetExtents();
+
+    RVectorReg vNewExtents = RVecMul( RVecSplatX( vExtents.v ), RVecAbs( M.r[0] ) );
+    vNewExtents = RVecAdd( vNewExtents, RVecMul( RVecSplatY( vExtents.v ), RVecAbs( M.r[1] ) ) );
+    vNewExtents = RVecAdd( vNewExtents, RVecMul( RVecSplatZ( vExtents.v ), RVecAbs( M.r[2] ) ) );
+
+    return RAABBFromCenterExtents( vCenter, RVector4( vNewExtents ) );
+}
+
+
+/**********************************************************\
+|**********************************************************|
+| class RSphere
+|**********************************************************|
+\**********************************************************/
+_inline RSphere::RSphere(const RVector4& Center, float Radius)
+    : vCenter( Center.x, Center.y, Center.z, 0.0f )
+    , fRadius( Radius )
+{
+}
+
+_inline bool RSphere::Contains(const RVector4& vPoint) const
+{
+    RVector4 vOffset( vPoint.x - vCenter.x, vPoint.y - vCenter.y, vPoint.z - vCenter.z, 0.0f );
+    return vOffset.MagnitudeSquared() <= fRadius * fRadius;
+}
+
+// Non-member functions
+_inline RSphere Transform(const RSphere& Sphere, const RMatrix4x4& M)
+{
+    RVector4 vCenter = RVector4( RVecPoint( Sphere.vCenter ) ) * M;
+
+    float fScaleSq = RVector4( M._11, M._12, M._13, 0.0f ).MagnitudeSquared();
+    float fRowSq = RVector4( M._21, M._22, M._23, 0.0f ).MagnitudeSquared();
+    fScaleSq = fRowSq > fScaleSq ? fRowSq : fScaleSq;
+    fRowSq = RVector4( M._31, M._32, M._33, 0.0f ).MagnitudeSquared();
+    fScaleSq = fRowSq > fScaleSq ? fRowSq : fScaleSq;
+
+    return RSphere( vCenter, Sphere.fRadius * sqrtf( fScaleSq ) );
+}
+
+
+/**********************************************************\
+|**********************************************************|
+| class ROBB
+|**********************************************************|
+\**********************************************************/
+_inline ROBB::ROBB(const RVector4& Center, const RVector4& Extents, const RQuaternion& Orientation)
+    : vCenter( Center.x, Center.y, Center.z, 0.0f )
+    , vExtents( Extents.x, Extents.y, Extents.z, 0.0f )
+    , qOrientation( Orientation )
+{
+}
+
+_inline void ROBB::GetAxes(RVector4* pAxes) const
+{
+    RMatrix4x4 mRotation = RMatrix4x4RotationQuaternion( qOrientation );
+    pAxes[0] = RVector4( mRotation.r[0] );
+    pAxes[1] = RVector4( mRotation.r[1] );
+    pAxes[2] = RVector4( mRotation.r[2] );
+}
+
+_inline bool ROBB::Contains(const RVector4& vPoint) const
+{
+    RVector4 pAxes[3];
+    GetAxes( pAxes );
+    RVector4 vOffset( vPoint.x - vCenter.x, vPoint.y - vCenter.y, vPoint.z - vCenter.z, 0.0f );
+    for( uint i = 0; i < 3; ++i )
+    {
+        if( fabsf( vOffset.DotProduct( pAxes[i] ) ) > vExtents.f[i] )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/**********************************************************\
+|**********************************************************|
+| class RFrustum
+|**********************************************************|
+\**********************************************************/
+//-----------------------------------------------------------------------------
+//  RFrustumFromMatrix
+//  A point is in the frustum if its clip space position has -w <= x <= w,
+//  -w <= y <= w and 0 <= z <= w. Each of those is a dot product of the
+//  point with columns of the matrix, so each plane is a sum of columns
+//-----------------------------------------------------------------------------
+_inline RFrustum RFrustumFromMatrix(const RMatrix4x4& mViewProj)
+{
+    RMatrix4x4 mColumns = Transpose( mViewProj );
+
+    RFrustum Frustum;
+    Frustum.Planes[eFrustumLeft]   = RPlane( RVecAdd( mColumns.r[3], mColumns.r[0] ) );
+    Frustum.Planes[eFrustumRight]  = RPlane( RVecSub( mColumns.r[3], mColumns.r[0] ) );
+    Frustum.Planes[eFrustumBottom] = RPlane( RVecAdd( mColumns.r[3], mColumns.r[1] ) );
+    Frustum.Planes[eFrustumTop]    = RPlane( RVecSub( mColumns.r[3], mColumns.r[1] ) );
+    Frustum.Planes[eFrustumNear]   = RPlane( mColumns.r[2] );
+    Frustum.Planes[eFrustumFar]    = RPlane( RVecSub( mColumns.r[3], mColumns.r[2] ) );
+    for( uint i = 0; i < eNUMFRUSTUMPLANES; ++i )
+    {
+        Frustum.Planes[i].Normalize();
+    }
+    return Frustum;
+}
+
+
+/**********************************************************\
+|**********************************************************|
+| Intersection tests
+|**********************************************************|
+\**********************************************************/
+_inline bool Intersect(const RAABB& A, const RAABB& B)
+{
+    return RVecAllLessEqual3( A.vMin.v, B.vMax.v ) && RVecAllLessEqual3( B.vMin.v, A.vMax.v );
+}
+
+_inline bool Intersect(const RSphere& A, const RSphere& B)
+{
+    float fRadii = A.fRadius + B.fRadius;
+    RVector4 vOffset( A.vCenter.x - B.vCenter.x, A.vCenter.y - B.vCenter.y, A.vCenter.z - B.vCenter.z, 0.0f );
+    return vOffset.MagnitudeSquared() <= fRadii * fRadii;
+}
+
+// The closest point in the box to the center is in the sphere
+_inline bool Intersect(const RSphere& Sphere, const RAABB& Box)
+{
+    RVectorReg vCenter = RVecSet( Sphere.vCenter.x, Sphere.vCenter.y, Sphere.vCenter.z, 0.0f );
+    RVectorReg vClosest = RVecMin( RVecMax( vCenter, Box.vMin.v ), Box.vMax.v );
+    RVectorReg vOffset = RVecSub( vCenter, vClosest );
+    return RVecGetX( RVecDot( vOffset, vOffset ) ) <= Sphere.fRadius * Sphere.fRadius;
+}
+
+//-----------------------------------------------------------------------------
+//  Intersect
+//  Separating axis test of two oriented boxes: they're apart if there's an
+//  axis their projections don't overlap on. Only 15 axes need checking:
+//  the 3 of each box, and the 9 cross products of one box's with the other's
+//-----------------------------------------------------------------------------
+_inline bool Intersect(const ROBB& A, const ROBB& B)
+{
+    RVector4 pAxesA[3], pAxesB[3];
+    A.GetAxes( pAxesA );
+    B.GetAxes( pAxesB );
+
+    // B's axes in A's space. The epsilon stops nearly parallel edges, whose
+    // cross product is almost zero, from separating anything
+    float R[3][3], AbsR[3][3];
+    for( uint i = 0; i < 3; ++i )
+    {
+        for( uint j = 0; j < 3; ++j )
+        {
+            R[i][j] = pAxesA[i].DotProduct( pAxesB[j] );
+            AbsR[i][j] = fabsf( R[i][j] ) + gs_fEpsilon;
+        }
+    }
+
+    RVector4 vOffset( B.vCenter.x - A.vCenter.x, B.vCenter.y - A.vCenter.y, B.vCenter.z - A.vCenter.z, 0.0f );
+    float T[3] = { vOffset.DotProduct( pAxesA[0] ), vOffset.DotProduct( pAxesA[1] ), vOffset.DotProduct( pAxesA[2] ) };
+    const float* pEA = A.vExtents.f;
+    const float* pEB = B.vExtents.f;
+
+    for( uint i = 0; i < 3; ++i )
+    {
+        float fRadiusB = pEB[0] * AbsR[i][0] + pEB[1] * AbsR[i][1] + pEB[2] * AbsR[i][2];
+        if( fabsf( T[i] ) > pEA[i] + fRadiusB )
+            return false;
+    }
+
+    for( uint j = 0; j < 3; ++j )
+    {
+        float fRadiusA = pEA[0] * AbsR[0][j] + pEA[1] * AbsR[1][j] + pEA[2] * AbsR[2][j];
+        if( fabsf( T[0] * R[0][j] + T[1] * R[1][j] + T[2] * R[2][j] ) > fRadiusA + pEB[j] )
+            return false;
+    }
+
+    for( uint i = 0; i < 3; ++i )
+    {
+        uint i1 = ( i + 1 ) % 3, i2 = ( i + 2 ) % 3;
+        for( uint j = 0; j < 3; ++j )
+        {
+            uint j1 = ( j + 1 ) % 3, j2 = ( j + 2 ) % 3;
+            float fRadiusA = pEA[i1] * AbsR[i2][j] + pEA[i2] * AbsR[i1][j];
+            float fRadiusB = pEB[j1] * AbsR[i][j2] + pEB[j2] * AbsR[i][j1];
+            if( fabsf( T[i2] * R[i1][j] - T[i1] * R[i2][j] ) > fRadiusA + fRadiusB )
+                return false;
+        }
+    }
+
+    return true;
+}
+
+_inline bool Intersect(const RFrustum& Frustum, const RSphere& Sphere)
+{
+    RVectorReg vCenter = RVecPoint( Sphere.vCenter );
+    for( uint i = 0; i < eNUMFRUSTUMPLANES; ++i )
+    {
+        if( RVecGetX( RVecDot( Frustum.Planes[i].v, vCenter ) ) < -Sphere.fRadius )
+            return false;
+    }
+    return true;
+}
+
+// The box's extents projected onto each plane normal give its "radius"
+// in that direction. The extents' w is 0, so the plane's d drops out
+_inline bool Intersect(const RFrustum& Frustum, const RAABB& Box)
+{
+    RVectorReg vCenter = RVecPoint( Box.GetCenter() );
+    RVectorReg vExtents = Box.GetExtents().v;
+    for( uint i = 0; i < eNUMFRUSTUMPLANES; ++i )
+    {
+        RVectorReg vDistance = RVecDot( Frustum.Planes[i].v, vCenter );
+        RVectorReg vRadius = RVecDot( RVecAbs( Frustum.Planes[i].v ), vExtents );
+        if( RVecGetX( RVecAdd( vDistance, vRadius ) ) < 0.0f )
+            return false;
+    }
+    return true;
+}
+
+_inline bool Intersect(const RFrustum& Frustum, const ROBB& Box)
+{
+    RVector4 pAxes[3];
+    Box.GetAxes( pAxes );
+    RVectorReg vCenter = RVecPoint( Box.vCenter );
+    for( uint i = 0; i < eNUMFRUSTUMPLANES; ++i )
+    {
+        const RPlane& Plane = Frustum.Planes[i];
+        float fRadius = Box.vExtents.x * fabsf( RVecGetX( RVecDot( Plane.v, pAxes[0].v ) ) )
+                      + Box.vExtents.y * fabsf( RVecGetX( RVecDot( Plane.v, pAxes[1].v ) ) )
+                      + Box.vExtents.z * fabsf( RVecGetX( RVecDot( Plane.v, pAxes[2].v ) ) );
+        if( RVecGetX( RVecDot( Plane.v, vCenter ) ) < -fRadius )
+            return false;
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//  IntersectRay
+//  The slab test: where the ray crosses each pair of planes, done for all
+//  three axes at once. It hits if it enters every slab before it leaves
+//  any of them. A zero direction component divides to infinity, which
+//  still gives the right answer unless the origin is exactly on that face
+//-----------------------------------------------------------------------------
+_inline bool IntersectRay(const RAABB& Box, const RVector4& vOrigin, const RVector4& vDirection, float* pT)
+{
+    RVectorReg vOrigin3 = RVecSet( vOrigin.x, vOrigin.y, vOrigin.z, 0.0f );
+    RVectorReg vInvDirection = RVecSet( 1 / vDirection.x, 1 / vDirection.y, 1 / vDirection.z, 0.0f );
+    RVectorReg vT1 = RVecMul( RVecSub( Box.vMin.v, vOrigin3 ), vInvDirection );
+    RVectorReg vT2 = RVecMul( RVecSub( Box.vMax.v, vOrigin3 ), vInvDirection );
+    RVector4 vEnter( RVecMin( vT1, vT2 ) );
+    RVector4 vExit( RVecMax( vT1, vT2 ) );
+
+    float fEnter = vEnter.x > vEnter.y ? vEnter.x : vEnter.y;
+    fEnter = vEnter.z > fEnter ? vEnter.z : fEnter;
+    float fExit = vExit.x < vExit.y ? vExit.x : vExit.y;
+    fExit = vExit.z < fExit ? vExit.z : fExit;
+
+    if( fExit < 0.0f || fEnter > fExit )
+        return false;
+
+    *pT = fEnter > 0.0f ? fEnter : 0.0f;
+    return true;
+}
+
+_inline bool IntersectRay(const RSphere& Sphere, const RVector4& vOrigin, const RVector4& vDirection, float* pT)
+{
+    RVector4 vOffset( vOrigin.x - Sphere.vCenter.x, vOrigin.y - Sphere.vCenter.y, vOrigin.z - Sphere.vCenter.z, 0.0f );
+    RVector4 vDirection3( vDirection.x, vDirection.y, vDirection.z, 0.0f );
+    float fA = vDirection3.MagnitudeSquared();
+    float fB = vOffset.DotProduct( vDirection3 );
+    float fC = vOffset.MagnitudeSquared() - Sphere.fRadius * Sphere.fRadius;
+
+    // Outside and pointing away
+    if( fC > 0.0f && fB > 0.0f )
+        return false;
+
+    float fDiscriminant = fB * fB - fA * fC;
+    if( fDiscriminant < 0.0f )
+        return false;
+
+    float fT = ( -fB - sqrtf( fDiscriminant ) ) / fA;
+    *pT = fT > 0.0f ? fT : 0.0f;
+    return true;
+}
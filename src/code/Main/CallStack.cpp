@@ -0,0 +1,104 @@
+/*********************************************************\
+File:       CallStack.cpp
+Purpose:    Call stack capture and symbolization
+\*********************************************************/
+#include "CallStack.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#if defined( OS_WINDOWS )
+#include <Windows.h>
+#include <DbgHelp.h>
+#pragma comment( lib, "dbghelp.lib" )
+#else
+#include <execinfo.h>
+#include <dlfcn.h>
+#include <cxxabi.h>
+#endif // #if defined( OS_WINDOWS )
+
+static const uint gs_nMaxCaptureDepth = 64;
+
+//-----------------------------------------------------------------------------
+//  InitializeCallStacks
+//  Loads whatever the platform needs to walk and name stacks
+//-----------------------------------------------------------------------------
+void InitializeCallStacks( void )
+{
+#if defined( OS_WINDOWS )
+    static bool bSymbolsInitialized = false;
+    if( !bSymbolsInitialized )
+    {
+        SymSetOptions( SYMOPT_UNDNAME | SYMOPT_DEFERRED_LOADS );
+        SymInitialize( GetCurrentProcess(), NULL, TRUE );
+        bSymbolsInitialized = true;
+    }
+#else
+    // The first backtrace loads the unwinder, get that out of the way
+    void* pFrame;
+    backtrace( &pFrame, 1 );
+#endif // #if defined( OS_WINDOWS )
+}
+
+//-----------------------------------------------------------------------------
+//  CaptureCallStack
+//  Fills ppFrames with up to nMaxDepth return addresses, innermost first,
+//  leaving out the caller's nSkipFrames innermost frames. This function's
+//  own frame is always left out
+//-----------------------------------------------------------------------------
+uint CaptureCallStack( void** ppFrames, uint nMaxDepth, uint nSkipFrames )
+{
+    ++nSkipFrames;
+#if defined( OS_WINDOWS )
+    return CaptureStackBackTrace( nSkipFrames, nMaxDepth, ppFrames, NULL );
+#else
+    void* pAllFrames[gs_nMaxCaptureDepth];
+    uint nCapture = nMaxDepth + nSkipFrames;
+    if( nCapture > gs_nMaxCaptureDepth )
+    {
+        nCapture = gs_nMaxCaptureDepth;
+    }
+    int nDepth = backtrace( pAllFrames, (int)nCapture );
+    if( nDepth <= (int)nSkipFrames )
+        return 0;
+    nDepth -= nSkipFrames;
+    memcpy( ppFrames, pAllFrames + nSkipFrames, sizeof( void* ) * nDepth );
+    return (uint)nDepth;
+#endif // #if defined( OS_WINDOWS )
+}
+
+//-----------------------------------------------------------------------------
+//  GetCallStackFrameName
+//  Symbolizes one frame, or prints its address if there's no symbol
+//-----------------------------------------------------------------------------
+void GetCallStackFrameName( void* pFrame, char* szName, size_t nLength )
+{
+#if defined( OS_WINDOWS )
+    char pSymbolBuffer[ sizeof( SYMBOL_INFO ) + 256 ];
+    SYMBOL_INFO* pSymbol = (SYMBOL_INFO*)pSymbolBuffer;
+    pSymbol->SizeOfStruct = sizeof( SYMBOL_INFO );
+    pSymbol->MaxNameLen = 255;
+    DWORD64 nDisplacement = 0;
+    if( SymFromAddr( GetCurrentProcess(), (DWORD64)pFrame, &nDisplacement, pSymbol ) )
+    {
+        _snprintf_s( szName, nLength, _TRUNCATE, "%s", pSymbol->Name );
+    }
+    else
+    {
+        _snprintf_s( szName, nLength, _TRUNCATE, "%p", pFrame );
+    }
+#else
+    Dl_info info;
+    if( dladdr( pFrame, &info ) && info.dli_sname )
+    {
+        int nStatus = 0;
+        char* szDemangled = abi::__cxa_demangle( info.dli_sname, NULL, NULL, &nStatus );
+        snprintf( szName, nLength, "%s", nStatus == 0 ? szDemangled : info.dli_sname );
+        free( szDemangled );
+    }
+    else
+    {
+        snprintf( szName, nLength, "%p", pFrame );
+    }
+#endif // #if defined( OS_WINDOWS )
+}
@@ -0,0 +1,31 @@
+/*********************************************************\
+File:       CallStack.h
+Purpose:    Call stack capture and symbolization
+\*********************************************************/
+#ifndef _CALLSTACK_H_
+#define _CALLSTACK_H_
+#include "Types.h"
+#include <stddef.h> // For size_t
+
+//-----------------------------------------------------------------------------
+//  InitializeCallStacks
+//  Loads whatever the platform needs to walk and name stacks. Capturing a
+//  stack from inside the allocator can't afford to do that the first time,
+//  so call this before turning on anything that does
+//-----------------------------------------------------------------------------
+void InitializeCallStacks( void );
+
+//-----------------------------------------------------------------------------
+//  CaptureCallStack
+//  Fills ppFrames with up to nMaxDepth return addresses, innermost first,
+//  leaving out the caller's nSkipFrames innermost frames. Returns the depth
+//-----------------------------------------------------------------------------
+uint CaptureCallStack( void** ppFrames, uint nMaxDepth, uint nSkipFrames );
+
+//-----------------------------------------------------------------------------
+//  GetCallStackFrameName
+//  Symbolizes one frame, or prints its address if there's no symbol
+//-----------------------------------------------------------------------------
+void GetCallStackFrameName( void* pFrame, char* szName, size_t nLength );
+
+#endif // #ifndef _CALLSTACK_H_
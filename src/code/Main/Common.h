@@ -13,12 +13,14 @@ Modified by:    Kyle Weicht
 #include "Types.h"
 
 // Standard headers
+#include <stdio.h>
+#include <string.h>
 #ifdef OS_WINDOWS
 #include <crtdbg.h> // Include this to avoid errors when overloading new/delete
 #endif
 
 // Memory
-#include "memory.h"
+#include "Memory.h"
 
 // Use overridden new/delete
 #define new DEBUG_NEW
@@ -0,0 +1,177 @@
+/*********************************************************\
+File:       FrameAllocator.cpp
+Purpose:    Double-buffered linear allocator for per-frame
+            scratch memory
+\*********************************************************/
+#include "Types.h"
+#include <stdlib.h>
+#include <string.h>
+#include "Memory.h"
+
+//-----------------------------------------------------------------------------
+//  Frame arenas
+//  Two arenas are used, one for the current frame and one for the previous
+//  frame. Whatever was allocated during frame N is released when frame N+1
+//  ends, so data handed from the end of one frame to the start of the next
+//  (eg, UI strings) stays valid.
+//  If an arena runs out during a frame, overflow chunks are chained on and
+//  the arena is resized to fit everything the next time it's reset, so the
+//  steady state is a single block with no mallocs.
+//  Arena memory comes straight from malloc so it doesn't show up in the
+//  allocation tracker
+//-----------------------------------------------------------------------------
+struct FrameArenaChunk
+{
+    FrameArenaChunk*    pNext;
+    size_t              nCapacity;
+    size_t              nOffset;
+};
+
+struct FrameArena
+{
+    byte*               pBase;
+    size_t              nCapacity;
+    size_t              nOffset;
+    FrameArenaChunk*    pOverflow;
+    size_t              nOverflowSize;
+};
+
+static const size_t gs_nDefaultFrameArenaSize = 1024 * 1024;
+
+static FrameArena   g_pFrameArenas[2];
+static uint         g_nCurrentFrameArena = 0;
+
+//-----------------------------------------------------------------------------
+//  AlignUp
+//-----------------------------------------------------------------------------
+static _inline nativeuint AlignUp( nativeuint nValue, uint nAlignment )
+{
+    return ( nValue + ( nAlignment - 1 ) ) & ~( (nativeuint)nAlignment - 1 );
+}
+
+//-----------------------------------------------------------------------------
+//  FrameAllocOverflow
+//  Slow path, for when the arena's main block is full (or doesn't exist yet)
+//-----------------------------------------------------------------------------
+static void* FrameAllocOverflow( FrameArena* pArena, size_t nSize, uint nAlignment )
+{
+    // First allocation ever, just create the main block
+    if( pArena->pBase == NULL )
+    {
+        pArena->nCapacity = gs_nDefaultFrameArenaSize;
+        pArena->pBase = (byte*)malloc( pArena->nCapacity );
+        pArena->nOffset = 0;
+        if( nSize + nAlignment <= pArena->nCapacity )
+        {
+            return FrameAlloc( nSize, nAlignment );
+        }
+    }
+
+    // Try the current overflow chunk...
+    FrameArenaChunk* pChunk = pArena->pOverflow;
+    if( pChunk )
+    {
+        byte* pChunkData = (byte*)( pChunk + 1 );
+        nativeuint nAligned = AlignUp( (nativeuint)pChunkData + pChunk->nOffset, nAlignment );
+        size_t nEnd = ( nAligned - (nativeuint)pChunkData ) + nSize;
+        if( nEnd <= pChunk->nCapacity )
+        {
+            pArena->nOverflowSize += nEnd - pChunk->nOffset;
+            pChunk->nOffset = nEnd;
+            return (void*)nAligned;
+        }
+    }
+
+    // ...otherwise chain on a new one
+    size_t nCapacity = pArena->nCapacity;
+    if( nCapacity < nSize + nAlignment )
+    {
+        nCapacity = nSize + nAlignment;
+    }
+    pChunk = (FrameArenaChunk*)malloc( sizeof( FrameArenaChunk ) + nCapacity );
+    pChunk->pNext = pArena->pOverflow;
+    pChunk->nCapacity = nCapacity;
+    pChunk->nOffset = 0;
+    pArena->pOverflow = pChunk;
+
+    byte* pChunkData = (byte*)( pChunk + 1 );
+    nativeuint nAligned = AlignUp( (nativeuint)pChunkData, nAlignment );
+    pChunk->nOffset = ( nAligned - (nativeuint)pChunkData ) + nSize;
+    pArena->nOverflowSize += pChunk->nOffset;
+    return (void*)nAligned;
+}
+
+//-----------------------------------------------------------------------------
+//  ResetArena
+//  Releases everything in the arena, growing it if it overflowed
+//-----------------------------------------------------------------------------
+static void ResetArena( FrameArena* pArena )
+{
+    if( pArena->pOverflow )
+    {
+        FrameArenaChunk* pChunk = pArena->pOverflow;
+        while( pChunk )
+        {
+            FrameArenaChunk* pNext = pChunk->pNext;
+            free( pChunk );
+            pChunk = pNext;
+        }
+        pArena->pOverflow = NULL;
+
+        // Grow so the whole frame fits next time, with some headroom
+        size_t nNeeded = pArena->nOffset + pArena->nOverflowSize;
+        size_t nCapacity = pArena->nCapacity;
+        while( nCapacity < nNeeded + ( nNeeded >> 2 ) )
+        {
+            nCapacity *= 2;
+        }
+        free( pArena->pBase );
+        pArena->pBase = (byte*)malloc( nCapacity );
+        pArena->nCapacity = nCapacity;
+        pArena->nOverflowSize = 0;
+    }
+
+    pArena->nOffset = 0;
+}
+
+//-----------------------------------------------------------------------------
+//  FrameAlloc
+//  Returns nSize bytes of scratch memory, valid until the end of next frame
+//-----------------------------------------------------------------------------
+void* __cdecl FrameAlloc( size_t nSize, uint nAlignment )
+{
+    FrameArena* pArena = &g_pFrameArenas[ g_nCurrentFrameArena ];
+
+    nativeuint nBase = (nativeuint)pArena->pBase;
+    nativeuint nAligned = AlignUp( nBase + pArena->nOffset, nAlignment );
+    size_t nEnd = ( nAligned - nBase ) + nSize;
+    if( pArena->pBase != NULL && pArena->pOverflow == NULL && nEnd <= pArena->nCapacity )
+    {
+        pArena->nOffset = nEnd;
+        return (void*)nAligned;
+    }
+
+    return FrameAllocOverflow( pArena, nSize, nAlignment );
+}
+
+//-----------------------------------------------------------------------------
+//  FrameStrDup
+//  Copies a string into frame memory
+//-----------------------------------------------------------------------------
+char* __cdecl FrameStrDup( const char* szString )
+{
+    size_t nLength = strlen( szString ) + 1;
+    char* szCopy = (char*)FrameAlloc( nLength, 1 );
+    memcpy( szCopy, szString, nLength );
+    return szCopy;
+}
+
+//-----------------------------------------------------------------------------
+//  FrameAllocatorEndFrame
+//  Called by MemoryEndFrame. Flips the arenas
+//-----------------------------------------------------------------------------
+void FrameAllocatorEndFrame( void )
+{
+    g_nCurrentFrameArena ^= 1;
+    ResetArena( &g_pFrameArenas[ g_nCurrentFrameArena ] );
+}
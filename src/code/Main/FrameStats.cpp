@@ -0,0 +1,282 @@
+/*********************************************************\
+File:       FrameStats.cpp
+Purpose:    Frame time statistics, with percentiles over
+            a rolling window and the whole run
+\*********************************************************/
+#include "FrameStats.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#if defined( _MSC_VER )
+#include <intrin.h> // For _BitScanReverse
+#endif // #if defined( _MSC_VER )
+
+static __forceinline uint HighestBit( uint nValue )
+{
+#if defined( _MSC_VER )
+    unsigned long nIndex;
+    _BitScanReverse( &nIndex, nValue );
+    return (uint)nIndex;
+#else
+    return 31 - (uint)__builtin_clz( nValue );
+#endif // #if defined( _MSC_VER )
+}
+
+// CFrameTimeHistogram constructor
+CFrameTimeHistogram::CFrameTimeHistogram()
+{
+    Clear();
+}
+
+//-----------------------------------------------------------------------------
+//  ValueToBucket/BucketToValue
+//  Buckets below ms_nLinearBuckets hold one value each. Past that, the top
+//  ms_nSubBucketBits + 1 bits of the value pick the bucket within its power
+//  of two
+//-----------------------------------------------------------------------------
+uint CFrameTimeHistogram::ValueToBucket( uint nMicroseconds )
+{
+    if( nMicroseconds < ms_nLinearBuckets )
+        return nMicroseconds;
+
+    uint nBit = HighestBit( nMicroseconds );
+    if( nBit > ms_nMaxBit )
+        return ms_nNumBuckets - 1;
+
+    uint nShift = nBit - ms_nSubBucketBits;
+    return ms_nLinearBuckets
+         + ( nBit - ms_nSubBucketBits - 1 ) * ( 1 << ms_nSubBucketBits )
+         + ( nMicroseconds >> nShift ) - ( 1 << ms_nSubBucketBits );
+}
+
+uint CFrameTimeHistogram::BucketToValue( uint nBucket )
+{
+    if( nBucket < ms_nLinearBuckets )
+        return nBucket;
+
+    uint nOctave = ( nBucket - ms_nLinearBuckets ) >> ms_nSubBucketBits;
+    uint nSubBucket = ( nBucket - ms_nLinearBuckets ) & ( ( 1 << ms_nSubBucketBits ) - 1 );
+    uint nShift = nOctave + 1;
+    uint nLow = ( ( 1 << ms_nSubBucketBits ) + nSubBucket ) << nShift;
+    return nLow + ( ( 1 << nShift ) >> 1 );
+}
+
+//-----------------------------------------------------------------------------
+//  Add/Remove
+//  Records a time, or takes back one that was recorded before
+//-----------------------------------------------------------------------------
+void CFrameTimeHistogram::Add( uint nMicroseconds )
+{
+    ++m_pBuckets[ ValueToBucket( nMicroseconds ) ];
+    ++m_nCount;
+    m_nTotal += nMicroseconds;
+}
+
+void CFrameTimeHistogram::Remove( uint nMicroseconds )
+{
+    --m_pBuckets[ ValueToBucket( nMicroseconds ) ];
+    --m_nCount;
+    m_nTotal -= nMicroseconds;
+}
+
+void CFrameTimeHistogram::Clear( void )
+{
+    memset( m_pBuckets, 0, sizeof( m_pBuckets ) );
+    m_nCount = 0;
+    m_nTotal = 0;
+}
+
+//-----------------------------------------------------------------------------
+//  GetPercentile
+//  Returns the time fPercentile (0-100) of the recorded times are at or
+//  under, in milliseconds
+//-----------------------------------------------------------------------------
+float CFrameTimeHistogram::GetPercentile( float fPercentile ) const
+{
+    if( m_nCount == 0 )
+        return 0.0f;
+
+    // The rank of the value we want, 1 based
+    uint nRank = (uint)( fPercentile * 0.01f * m_nCount + 0.5f );
+    if( nRank < 1 )
+    {
+        nRank = 1;
+    }
+    if( nRank > m_nCount )
+    {
+        nRank = m_nCount;
+    }
+
+    uint nSeen = 0;
+    for( uint nBucket = 0; nBucket < ms_nNumBuckets; ++nBucket )
+    {
+        nSeen += m_pBuckets[nBucket];
+        if( nSeen >= nRank )
+            return GetBucketMilliseconds( nBucket );
+    }
+    return GetBucketMilliseconds( ms_nNumBuckets - 1 );
+}
+
+float CFrameTimeHistogram::GetAverage( void ) const
+{
+    return m_nCount ? (float)( (double)m_nTotal / m_nCount * 0.001 ) : 0.0f;
+}
+
+float CFrameTimeHistogram::GetMin( void ) const
+{
+    return GetPercentile( 0.0f );
+}
+
+float CFrameTimeHistogram::GetMax( void ) const
+{
+    return GetPercentile( 100.0f );
+}
+
+//-----------------------------------------------------------------------------
+//  Series
+//  Each series remembers its last nWindowFrames times in a ring, so the
+//  oldest one can be taken back out of the window histogram. Everything's
+//  malloc'd, so none of it counts as a heap allocation during a frame
+//-----------------------------------------------------------------------------
+struct FrameStatSeries
+{
+    const char*         szName;
+    CFrameTimeHistogram window;
+    CFrameTimeHistogram wholeRun;
+    uint*               pRing;
+    uint                nRingPos;
+};
+
+static const uint   gs_nDefaultWindowFrames = 300;
+
+static FrameStatSeries* g_pSeries[gs_nMaxFrameStatSeries];
+static uint             g_nNumSeries = 0;
+static uint             g_nWindowFrames = gs_nDefaultWindowFrames;
+
+void FrameStatsSetWindow( uint nWindowFrames )
+{
+    g_nWindowFrames = nWindowFrames ? nWindowFrames : 1;
+    for( uint nSeries = 0; nSeries < g_nNumSeries; ++nSeries )
+    {
+        FrameStatSeries* pSeries = g_pSeries[nSeries];
+        free( pSeries->pRing );
+        pSeries->pRing = (uint*)malloc( sizeof( uint ) * g_nWindowFrames );
+        pSeries->nRingPos = 0;
+        pSeries->window.Clear();
+    }
+}
+
+static FrameStatSeries* FindSeries( const char* szName )
+{
+    for( uint nSeries = 0; nSeries < g_nNumSeries; ++nSeries )
+    {
+        if( strcmp( g_pSeries[nSeries]->szName, szName ) == 0 )
+            return g_pSeries[nSeries];
+    }
+    if( g_nNumSeries == gs_nMaxFrameStatSeries )
+        return NULL;
+
+    // The histograms are too big to construct on the stack, so construct
+    // them in place
+    FrameStatSeries* pSeries = (FrameStatSeries*)malloc( sizeof( FrameStatSeries ) );
+    // TODO: Handle out of memory error ( pSeries == 0 )
+    pSeries->szName = szName;
+    pSeries->window.Clear();
+    pSeries->wholeRun.Clear();
+    pSeries->pRing = (uint*)malloc( sizeof( uint ) * g_nWindowFrames );
+    pSeries->nRingPos = 0;
+    g_pSeries[ g_nNumSeries++ ] = pSeries;
+    return pSeries;
+}
+
+void FrameStatsRecord( const char* szName, float fMilliseconds )
+{
+    FrameStatSeries* pSeries = FindSeries( szName );
+    if( pSeries == NULL )
+        return;
+
+    uint nMicroseconds = fMilliseconds > 0.0f ? (uint)( fMilliseconds * 1000.0f + 0.5f ) : 0;
+    uint nSlot = pSeries->nRingPos % g_nWindowFrames;
+    if( pSeries->nRingPos >= g_nWindowFrames )
+    {
+        pSeries->window.Remove( pSeries->pRing[nSlot] );
+    }
+    pSeries->pRing[nSlot] = nMicroseconds;
+    ++pSeries->nRingPos;
+
+    pSeries->window.Add( nMicroseconds );
+    pSeries->wholeRun.Add( nMicroseconds );
+}
+
+static void Summarize( const char* szName, const CFrameTimeHistogram& histogram, FrameTimeSummary* pSummary )
+{
+    pSummary->szName = szName;
+    pSummary->nFrames = histogram.GetCount();
+    pSummary->fMin = histogram.GetMin();
+    pSummary->fAverage = histogram.GetAverage();
+    pSummary->fP50 = histogram.GetPercentile( 50.0f );
+    pSummary->fP95 = histogram.GetPercentile( 95.0f );
+    pSummary->fP99 = histogram.GetPercentile( 99.0f );
+    pSummary->fMax = histogram.GetMax();
+}
+
+uint FrameStatsGetSummaries( FrameTimeSummary* pSummaries, uint nMaxSummaries, bool bWholeRun )
+{
+    uint nNumSummaries = g_nNumSeries < nMaxSummaries ? g_nNumSeries : nMaxSummaries;
+    for( uint nSeries = 0; nSeries < nNumSummaries; ++nSeries )
+    {
+        const FrameStatSeries* pSeries = g_pSeries[nSeries];
+        Summarize( pSeries->szName, bWholeRun ? pSeries->wholeRun : pSeries->window, &pSummaries[nSeries] );
+    }
+    return nNumSummaries;
+}
+
+//-----------------------------------------------------------------------------
+//  FrameStatsWriteCSV
+//  Writes the whole-run summaries, then every series' histogram
+//-----------------------------------------------------------------------------
+bool FrameStatsWriteCSV( const char* szFilename )
+{
+    FILE* pFile = NULL;
+#if defined( _MSC_VER )
+    if( fopen_s( &pFile, szFilename, "w" ) != 0 )
+        return false;
+#else
+    pFile = fopen( szFilename, "w" );
+#endif // #if defined( _MSC_VER )
+    if( pFile == NULL )
+        return false;
+
+    fprintf( pFile, "series,frames,min_ms,avg_ms,p50_ms,p95_ms,p99_ms,max_ms\n" );
+    for( uint nSeries = 0; nSeries < g_nNumSeries; ++nSeries )
+    {
+        FrameTimeSummary summary;
+        Summarize( g_pSeries[nSeries]->szName, g_pSeries[nSeries]->wholeRun, &summary );
+        fprintf( pFile, "%s,%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+                 summary.szName, summary.nFrames, summary.fMin, summary.fAverage,
+                 summary.fP50, summary.fP95, summary.fP99, summary.fMax );
+    }
+
+    // Every non-empty bucket, with the percentile it reaches
+    fprintf( pFile, "\nseries,bucket_ms,frames,cumulative_percent\n" );
+    for( uint nSeries = 0; nSeries < g_nNumSeries; ++nSeries )
+    {
+        const CFrameTimeHistogram& histogram = g_pSeries[nSeries]->wholeRun;
+        uint nSeen = 0;
+        for( uint nBucket = 0; nBucket < CFrameTimeHistogram::ms_nNumBuckets; ++nBucket )
+        {
+            uint nFrames = histogram.GetBucketCount( nBucket );
+            if( nFrames == 0 )
+                continue;
+
+            nSeen += nFrames;
+            fprintf( pFile, "%s,%.3f,%u,%.2f\n", g_pSeries[nSeries]->szName,
+                     CFrameTimeHistogram::GetBucketMilliseconds( nBucket ), nFrames,
+                     100.0f * nSeen / histogram.GetCount() );
+        }
+    }
+
+    fclose( pFile );
+    return true;
+}
@@ -0,0 +1,121 @@
+/*********************************************************\
+File:       FrameStats.h
+Purpose:    Frame time statistics, with percentiles over
+            a rolling window and the whole run
+\*********************************************************/
+#ifndef _FRAMESTATS_H_
+#define _FRAMESTATS_H_
+#include "Types.h"
+
+//-----------------------------------------------------------------------------
+//  CFrameTimeHistogram
+//  Fixed-size log-linear histogram of times, HDR histogram style. Times are
+//  recorded in microseconds: below 128us every value has its own bucket,
+//  above that every power of two is split into 64 buckets, so a percentile
+//  is never more than about 1.6% off. Anything over 64 seconds goes into
+//  the last bucket
+//-----------------------------------------------------------------------------
+class CFrameTimeHistogram
+{
+public:
+    // CFrameTimeHistogram constructor
+    CFrameTimeHistogram();
+    /***************************************\
+    | class methods                         |
+    \***************************************/
+
+    //-----------------------------------------------------------------------------
+    //  Add/Remove
+    //  Records a time, or takes back one that was recorded before
+    //-----------------------------------------------------------------------------
+    void Add( uint nMicroseconds );
+    void Remove( uint nMicroseconds );
+    void Clear( void );
+
+    //-----------------------------------------------------------------------------
+    //  GetPercentile
+    //  Returns the time fPercentile (0-100) of the recorded times are at or
+    //  under, in milliseconds
+    //-----------------------------------------------------------------------------
+    float GetPercentile( float fPercentile ) const;
+
+    //-----------------------------------------------------------------------------
+    //  Accessors
+    //-----------------------------------------------------------------------------
+    uint  GetCount( void ) const { return m_nCount; }
+    float GetAverage( void ) const;     // Exact, in milliseconds
+    float GetMin( void ) const;         // To the bucket, in milliseconds
+    float GetMax( void ) const;
+
+    //-----------------------------------------------------------------------------
+    //  GetBucketCount/GetBucketMilliseconds
+    //  For walking the raw histogram
+    //-----------------------------------------------------------------------------
+    uint GetBucketCount( uint nBucket ) const { return m_pBuckets[nBucket]; }
+    static float GetBucketMilliseconds( uint nBucket ) { return BucketToValue( nBucket ) * 0.001f; }
+
+    static const uint   ms_nSubBucketBits = 6;
+    static const uint   ms_nLinearBuckets = 2 << ms_nSubBucketBits;  // 128
+    static const uint   ms_nMaxBit = 25;
+    static const uint   ms_nNumBuckets = ms_nLinearBuckets + ( ms_nMaxBit - ms_nSubBucketBits ) * ( 1 << ms_nSubBucketBits );
+
+private:
+    static uint ValueToBucket( uint nMicroseconds );
+    static uint BucketToValue( uint nBucket );  // The middle of the bucket
+
+    /***************************************\
+    | class members                         |
+    \***************************************/
+    uint    m_pBuckets[ms_nNumBuckets];
+    uint    m_nCount;
+    uint64  m_nTotal;
+};
+
+//-----------------------------------------------------------------------------
+//  Frame statistics
+//  FrameStatsRecord is called once a frame for every series: the whole
+//  frame, plus each subsystem. Every series keeps a histogram of the last
+//  nWindowFrames frames and one of the whole run. Main thread only
+//-----------------------------------------------------------------------------
+struct FrameTimeSummary
+{
+    const char* szName;
+    uint        nFrames;
+    float       fMin;       // Milliseconds
+    float       fAverage;
+    float       fP50;
+    float       fP95;
+    float       fP99;
+    float       fMax;
+};
+
+static const uint gs_nMaxFrameStatSeries = 16;
+
+//-----------------------------------------------------------------------------
+//  FrameStatsSetWindow
+//  Sets how many frames the rolling statistics cover. Clears the window
+//-----------------------------------------------------------------------------
+void FrameStatsSetWindow( uint nWindowFrames );
+
+//-----------------------------------------------------------------------------
+//  FrameStatsRecord
+//  Records this frame's time for a series, creating it if it's new.
+//  szName has to outlive the statistics
+//-----------------------------------------------------------------------------
+void FrameStatsRecord( const char* szName, float fMilliseconds );
+
+//-----------------------------------------------------------------------------
+//  FrameStatsGetSummaries
+//  Fills pSummaries with every series, over the window or the whole run.
+//  Returns how many there are
+//-----------------------------------------------------------------------------
+uint FrameStatsGetSummaries( FrameTimeSummary* pSummaries, uint nMaxSummaries, bool bWholeRun );
+
+//-----------------------------------------------------------------------------
+//  FrameStatsWriteCSV
+//  Writes the whole-run summaries, then every series' histogram. Returns
+//  false if the file couldn't be written
+//-----------------------------------------------------------------------------
+bool FrameStatsWriteCSV( const char* szFilename );
+
+#endif // #ifndef _FRAMESTATS_H_
@@ -0,0 +1,446 @@
+/*********************************************************\
+File:       HeapProfiler.cpp
+Purpose:    Sampling heap profiler. Captures the call stack
+            of roughly one allocation every N bytes
+\*********************************************************/
+#include "HeapProfiler.h"
+#include "Atomic.h"
+#include "CallStack.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+//-----------------------------------------------------------------------------
+//  Sample storage
+//  Stacks are interned in a table that only grows, and every live sample
+//  points at one. Live samples are kept in an open-addressed table keyed by
+//  address, like the debug tracker. Every free has to ask whether its block
+//  was sampled, so a small counting filter is checked first, without the
+//  lock: it can only be non-zero for addresses that might be in the table.
+//  All of the tables are allocated with malloc so they stay out of the
+//  profile
+//-----------------------------------------------------------------------------
+static const uint gs_nMaxStackDepth     = 32;
+static const uint gs_nSkipFrames        = 2;    // HeapProfilerSampleAlloc and operator new
+static const uint gs_nFilterBits        = 16;
+static const uint gs_nMinTableBits      = 8;
+
+struct HeapStack
+{
+    void*   pFrames[gs_nMaxStackDepth];
+    uint    nDepth;
+    uint    nHash;
+    sint64  nLiveSamples;
+    sint64  nLiveSampledBytes;  // Sum of the sampled blocks' sizes
+    double  fLiveBytes;         // Scaled up to estimate every block
+    double  fLiveCount;
+};
+
+struct HeapSample
+{
+    nativeuint  nAddress;       // 0 means the slot is empty
+    uint        nStack;
+    size_t      nSize;
+    double      fWeight;        // How many blocks this sample stands for
+};
+
+volatile bool   g_bHeapProfilerEnabled = false;
+volatile sint32 g_nHeapProfilerLiveSamples = 0;
+
+static CSpinLock    g_HeapProfilerLock;
+static double       g_fSampleInterval = 512.0 * 1024.0;
+
+static HeapStack*   g_pStacks = NULL;
+static uint         g_nNumStacks = 0;
+static uint         g_nStackCapacity = 0;
+static uint*        g_pStackIndex = NULL;   // Open addressed, stack number + 1
+static uint         g_nStackIndexBits = 0;
+
+static HeapSample*  g_pSamples = NULL;
+static uint         g_nSampleBits = 0;
+
+static volatile uint16 g_pSampleFilter[1 << gs_nFilterBits];
+
+static THREAD_LOCAL sint64  gs_nBytesUntilSample = 0;
+static THREAD_LOCAL uint64  gs_nRandomState = 0;
+static THREAD_LOCAL bool    gs_bInHeapProfiler = false;
+
+//-----------------------------------------------------------------------------
+//  Hashing
+//-----------------------------------------------------------------------------
+static _inline uint HashAddress( nativeuint nAddress )
+{
+    return (uint)( ( (uint64)nAddress * 0x9E3779B97F4A7C15ULL ) >> 32 );
+}
+
+static uint HashStack( void* const* pFrames, uint nDepth )
+{
+    uint64 nHash = 14695981039346656037ULL;
+    for( uint i = 0; i < nDepth; ++i )
+    {
+        nHash = ( nHash ^ (uint64)(nativeuint)pFrames[i] ) * 1099511628211ULL;
+    }
+    return (uint)( nHash ^ ( nHash >> 32 ) );
+}
+
+//-----------------------------------------------------------------------------
+//  NextSampleGap
+//  Exponentially distributed, so allocations are sampled as a Poisson
+//  process over the bytes allocated
+//-----------------------------------------------------------------------------
+static sint64 NextSampleGap( void )
+{
+    if( gs_nRandomState == 0 )
+    {
+        gs_nRandomState = (uint64)(nativeuint)&gs_nRandomState ^ 0x2545F4914F6CDD1DULL;
+    }
+    // xorshift64*
+    gs_nRandomState ^= gs_nRandomState >> 12;
+    gs_nRandomState ^= gs_nRandomState << 25;
+    gs_nRandomState ^= gs_nRandomState >> 27;
+    uint64 nRandom = gs_nRandomState * 0x2545F4914F6CDD1DULL;
+
+    // Uniform in (0, 1]
+    double fUniform = ( (double)( nRandom >> 11 ) + 1.0 ) * ( 1.0 / 9007199254740992.0 );
+    return (sint64)( -log( fUniform ) * g_fSampleInterval ) + 1;
+}
+
+//-----------------------------------------------------------------------------
+//  FindOrAddStack
+//  Returns the number of the stack, adding it if it's new. Called with the
+//  lock held
+//-----------------------------------------------------------------------------
+static uint FindOrAddStack( void* const* pFrames, uint nDepth )
+{
+    uint nHash = HashStack( pFrames, nDepth );
+
+    // Grow the index past 50% full
+    if( ( g_nNumStacks + 1 ) * 2 > ( 1u << g_nStackIndexBits ) )
+    {
+        uint nNewBits = g_nStackIndexBits ? g_nStackIndexBits + 1 : gs_nMinTableBits;
+        uint nNewMask = ( 1 << nNewBits ) - 1;
+        uint* pNewIndex = (uint*)calloc( (size_t)1 << nNewBits, sizeof( uint ) );
+        for( uint i = 0; i < g_nNumStacks; ++i )
+        {
+            uint nSlot = g_pStacks[i].nHash & nNewMask;
+            while( pNewIndex[nSlot] != 0 )
+            {
+                nSlot = ( nSlot + 1 ) & nNewMask;
+            }
+            pNewIndex[nSlot] = i + 1;
+        }
+        free( g_pStackIndex );
+        g_pStackIndex = pNewIndex;
+        g_nStackIndexBits = nNewBits;
+    }
+
+    uint nMask = ( 1 << g_nStackIndexBits ) - 1;
+    uint nSlot = nHash & nMask;
+    while( g_pStackIndex[nSlot] != 0 )
+    {
+        HeapStack* pStack = &g_pStacks[ g_pStackIndex[nSlot] - 1 ];
+        if( pStack->nHash == nHash && pStack->nDepth == nDepth &&
+            memcmp( pStack->pFrames, pFrames, sizeof( void* ) * nDepth ) == 0 )
+        {
+            return g_pStackIndex[nSlot] - 1;
+        }
+        nSlot = ( nSlot + 1 ) & nMask;
+    }
+
+    if( g_nNumStacks == g_nStackCapacity )
+    {
+        g_nStackCapacity = g_nStackCapacity ? g_nStackCapacity * 2 : 256;
+        g_pStacks = (HeapStack*)realloc( g_pStacks, sizeof( HeapStack ) * g_nStackCapacity );
+    }
+
+    uint nStack = g_nNumStacks++;
+    HeapStack* pStack = &g_pStacks[nStack];
+    memset( pStack, 0, sizeof( HeapStack ) );
+    memcpy( pStack->pFrames, pFrames, sizeof( void* ) * nDepth );
+    pStack->nDepth = nDepth;
+    pStack->nHash = nHash;
+    g_pStackIndex[nSlot] = nStack + 1;
+    return nStack;
+}
+
+//-----------------------------------------------------------------------------
+//  AddSample
+//  Called with the lock held
+//-----------------------------------------------------------------------------
+static void AddSample( nativeuint nAddress, uint nStack, size_t nSize, double fWeight )
+{
+    uint nLiveSamples = (uint)g_nHeapProfilerLiveSamples;
+    if( ( nLiveSamples + 1 ) * 2 > ( 1u << g_nSampleBits ) )
+    {
+        uint nOldCapacity = g_nSampleBits ? ( 1 << g_nSampleBits ) : 0;
+        HeapSample* pOldSamples = g_pSamples;
+        uint nNewBits = g_nSampleBits ? g_nSampleBits + 1 : gs_nMinTableBits;
+        uint nNewMask = ( 1 << nNewBits ) - 1;
+        g_pSamples = (HeapSample*)calloc( (size_t)1 << nNewBits, sizeof( HeapSample ) );
+        for( uint i = 0; i < nOldCapacity; ++i )
+        {
+            if( pOldSamples[i].nAddress == 0 )
+                continue;
+            uint nSlot = HashAddress( pOldSamples[i].nAddress ) & nNewMask;
+            while( g_pSamples[nSlot].nAddress != 0 )
+            {
+                nSlot = ( nSlot + 1 ) & nNewMask;
+            }
+            g_pSamples[nSlot] = pOldSamples[i];
+        }
+        free( pOldSamples );
+        g_nSampleBits = nNewBits;
+    }
+
+    uint nMask = ( 1 << g_nSampleBits ) - 1;
+    uint nSlot = HashAddress( nAddress ) & nMask;
+    while( g_pSamples[nSlot].nAddress != 0 )
+    {
+        nSlot = ( nSlot + 1 ) & nMask;
+    }
+    HeapSample& sample = g_pSamples[nSlot];
+    sample.nAddress = nAddress;
+    sample.nStack = nStack;
+    sample.nSize = nSize;
+    sample.fWeight = fWeight;
+
+    HeapStack* pStack = &g_pStacks[nStack];
+    pStack->nLiveSamples += 1;
+    pStack->nLiveSampledBytes += nSize;
+    pStack->fLiveBytes += fWeight * nSize;
+    pStack->fLiveCount += fWeight;
+
+    ++g_pSampleFilter[ HashAddress( nAddress ) >> ( 32 - gs_nFilterBits ) ];
+    AtomicIncrement( &g_nHeapProfilerLiveSamples );
+}
+
+//-----------------------------------------------------------------------------
+//  RemoveSample
+//  Called with the lock held. Returns false if the address wasn't sampled
+//-----------------------------------------------------------------------------
+static bool RemoveSample( nativeuint nAddress )
+{
+    if( g_pSamples == NULL )
+        return false;
+
+    uint nMask = ( 1 << g_nSampleBits ) - 1;
+    uint nSlot = HashAddress( nAddress ) & nMask;
+    while( g_pSamples[nSlot].nAddress != nAddress )
+    {
+        if( g_pSamples[nSlot].nAddress == 0 )
+            return false;
+        nSlot = ( nSlot + 1 ) & nMask;
+    }
+
+    HeapSample& sample = g_pSamples[nSlot];
+    HeapStack* pStack = &g_pStacks[sample.nStack];
+    pStack->nLiveSamples -= 1;
+    pStack->nLiveSampledBytes -= sample.nSize;
+    pStack->fLiveBytes -= sample.fWeight * sample.nSize;
+    pStack->fLiveCount -= sample.fWeight;
+
+    // Backward-shift deletion, same as the tracker
+    uint nHole = nSlot;
+    uint nNext = ( nHole + 1 ) & nMask;
+    while( g_pSamples[nNext].nAddress != 0 )
+    {
+        uint nHome = HashAddress( g_pSamples[nNext].nAddress ) & nMask;
+        if( ( ( nNext - nHome ) & nMask ) >= ( ( nNext - nHole ) & nMask ) )
+        {
+            g_pSamples[nHole] = g_pSamples[nNext];
+            nHole = nNext;
+        }
+        nNext = ( nNext + 1 ) & nMask;
+    }
+    g_pSamples[nHole].nAddress = 0;
+
+    --g_pSampleFilter[ HashAddress( nAddress ) >> ( 32 - gs_nFilterBits ) ];
+    AtomicDecrement( &g_nHeapProfilerLiveSamples );
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//  HeapProfilerSampleAlloc
+//  Counts down the bytes until the next sample on this thread
+//-----------------------------------------------------------------------------
+void HeapProfilerSampleAlloc( void* pData, size_t nSize )
+{
+    gs_nBytesUntilSample -= (sint64)nSize;
+    if( gs_nBytesUntilSample > 0 || pData == NULL || gs_bInHeapProfiler )
+        return;
+
+    gs_bInHeapProfiler = true;
+    gs_nBytesUntilSample = NextSampleGap();
+
+    // The chance a block of nSize bytes gets sampled is 1 - e^(-nSize/interval),
+    // so each sample stands for 1/that many blocks
+    double fProbability = 1.0 - exp( -(double)nSize / g_fSampleInterval );
+    double fWeight = fProbability > 0.0 ? 1.0 / fProbability : 1.0;
+
+    void* pFrames[gs_nMaxStackDepth];
+    uint nDepth = CaptureCallStack( pFrames, gs_nMaxStackDepth, gs_nSkipFrames );
+
+    g_HeapProfilerLock.Lock();
+    uint nStack = FindOrAddStack( pFrames, nDepth );
+    AddSample( (nativeuint)pData, nStack, nSize, fWeight );
+    g_HeapProfilerLock.Unlock();
+
+    gs_bInHeapProfiler = false;
+}
+
+//-----------------------------------------------------------------------------
+//  HeapProfilerSampleFree
+//  Drops the sample for pData, if there is one
+//-----------------------------------------------------------------------------
+void HeapProfilerSampleFree( void* pData )
+{
+    nativeuint nAddress = (nativeuint)pData;
+    if( nAddress == 0 || g_pSampleFilter[ HashAddress( nAddress ) >> ( 32 - gs_nFilterBits ) ] == 0 )
+        return;
+
+    g_HeapProfilerLock.Lock();
+    RemoveSample( nAddress );
+    g_HeapProfilerLock.Unlock();
+}
+
+//-----------------------------------------------------------------------------
+//  HeapProfilerEnable/HeapProfilerDisable
+//  Starts and stops sampling
+//-----------------------------------------------------------------------------
+void HeapProfilerEnable( uint64 nSampleInterval )
+{
+    g_fSampleInterval = (double)( nSampleInterval ? nSampleInterval : 1 );
+    InitializeCallStacks();
+    g_bHeapProfilerEnabled = true;
+}
+
+void HeapProfilerDisable( void )
+{
+    g_bHeapProfilerEnabled = false;
+}
+
+bool HeapProfilerIsEnabled( void )
+{
+    return g_bHeapProfilerEnabled;
+}
+
+//-----------------------------------------------------------------------------
+//  WriteCollapsed/WritePprof
+//  pStacks is a copy of the stack table
+//-----------------------------------------------------------------------------
+static void WriteCollapsed( FILE* pFile, const HeapStack* pStacks, uint nNumStacks )
+{
+    char szName[ 256 ];
+    for( uint i = 0; i < nNumStacks; ++i )
+    {
+        const HeapStack& stack = pStacks[i];
+        if( stack.nLiveSamples <= 0 )
+            continue;
+
+        // Outermost frame first
+        for( uint nFrame = stack.nDepth; nFrame > 0; --nFrame )
+        {
+            GetCallStackFrameName( stack.pFrames[nFrame - 1], szName, sizeof( szName ) );
+            // ';' separates frames, make sure no name contains one
+            for( char* pChar = szName; *pChar; ++pChar )
+            {
+                if( *pChar == ';' )
+                    *pChar = ':';
+            }
+            fprintf( pFile, nFrame == stack.nDepth ? "%s" : ";%s", szName );
+        }
+        fprintf( pFile, " %llu\n", (unsigned long long)( stack.fLiveBytes + 0.5 ) );
+    }
+}
+
+static void WritePprof( FILE* pFile, const HeapStack* pStacks, uint nNumStacks )
+{
+    // pprof does its own unsampling for heap_v2, so the raw sampled
+    // numbers are written
+    sint64 nTotalSamples = 0;
+    sint64 nTotalBytes = 0;
+    for( uint i = 0; i < nNumStacks; ++i )
+    {
+        nTotalSamples += pStacks[i].nLiveSamples;
+        nTotalBytes += pStacks[i].nLiveSampledBytes;
+    }
+
+    fprintf( pFile, "heap profile: %lld: %lld [%lld: %lld] @ heap_v2/%llu\n",
+             (long long)nTotalSamples, (long long)nTotalBytes,
+             (long long)nTotalSamples, (long long)nTotalBytes,
+             (unsigned long long)g_fSampleInterval );
+
+    for( uint i = 0; i < nNumStacks; ++i )
+    {
+        const HeapStack& stack = pStacks[i];
+        if( stack.nLiveSamples <= 0 )
+            continue;
+
+        fprintf( pFile, "%lld: %lld [%lld: %lld] @",
+                 (long long)stack.nLiveSamples, (long long)stack.nLiveSampledBytes,
+                 (long long)stack.nLiveSamples, (long long)stack.nLiveSampledBytes );
+        for( uint nFrame = 0; nFrame < stack.nDepth; ++nFrame )
+        {
+            fprintf( pFile, " %p", stack.pFrames[nFrame] );
+        }
+        fprintf( pFile, "\n" );
+    }
+
+#if defined( OS_LINUX )
+    // Lets pprof map the addresses back to binaries
+    FILE* pMaps = fopen( "/proc/self/maps", "r" );
+    if( pMaps )
+    {
+        fprintf( pFile, "\nMAPPED_LIBRARIES:\n" );
+        char szLine[ 512 ];
+        while( fgets( szLine, sizeof( szLine ), pMaps ) )
+        {
+            fputs( szLine, pFile );
+        }
+        fclose( pMaps );
+    }
+#endif // #if defined( OS_LINUX )
+}
+
+//-----------------------------------------------------------------------------
+//  HeapProfilerWrite
+//  Writes the live sampled bytes, by stack
+//-----------------------------------------------------------------------------
+bool HeapProfilerWrite( const char* szFilename, eHeapProfileFormat nFormat )
+{
+    // Copy the stacks so nothing is symbolized with the lock held, and
+    // don't sample anything this thread allocates in the meantime
+    bool bWasInHeapProfiler = gs_bInHeapProfiler;
+    gs_bInHeapProfiler = true;
+
+    g_HeapProfilerLock.Lock();
+    uint nNumStacks = g_nNumStacks;
+    HeapStack* pStacks = (HeapStack*)malloc( sizeof( HeapStack ) * ( nNumStacks ? nNumStacks : 1 ) );
+    memcpy( pStacks, g_pStacks, sizeof( HeapStack ) * nNumStacks );
+    g_HeapProfilerLock.Unlock();
+
+    FILE* pFile = NULL;
+#if defined( _MSC_VER )
+    fopen_s( &pFile, szFilename, "w" );
+#else
+    pFile = fopen( szFilename, "w" );
+#endif // #if defined( _MSC_VER )
+
+    if( pFile )
+    {
+        if( nFormat == eHeapProfilePprof )
+        {
+            WritePprof( pFile, pStacks, nNumStacks );
+        }
+        else
+        {
+            WriteCollapsed( pFile, pStacks, nNumStacks );
+        }
+        fclose( pFile );
+    }
+
+    free( pStacks );
+    gs_bInHeapProfiler = bWasInHeapProfiler;
+    return pFile != NULL;
+}
@@ -0,0 +1,71 @@
+/*********************************************************\
+File:       HeapProfiler.h
+Purpose:    Sampling heap profiler. Captures the call stack
+            of roughly one allocation every N bytes
+\*********************************************************/
+#ifndef _HEAPPROFILER_H_
+#define _HEAPPROFILER_H_
+#include "Types.h"
+#include <stddef.h> // For size_t
+
+//-----------------------------------------------------------------------------
+//  The profiler is off until HeapProfilerEnable is called. While it's on,
+//  the gaps between sampled allocations are random with a mean of
+//  nSampleInterval bytes, so every byte has the same chance of being
+//  sampled no matter how it was allocated. Samples are aggregated by call
+//  stack and scaled back up when they're written, so the output estimates
+//  the real live bytes per stack.
+//  Off, the profiler costs a branch per allocation and free
+//-----------------------------------------------------------------------------
+enum eHeapProfileFormat
+{
+    eHeapProfileCollapsed,  // "main;Riot::Run;CGraphics::CreateMesh 123456", for flamegraph.pl/speedscope
+    eHeapProfilePprof,      // Legacy text heap profile, for pprof
+
+    eNUMHEAPPROFILEFORMATS
+};
+
+//-----------------------------------------------------------------------------
+//  HeapProfilerEnable/HeapProfilerDisable
+//  Starts and stops sampling. Samples taken so far are kept until the
+//  sampled blocks are freed, so a profile written after disabling still
+//  shows them
+//-----------------------------------------------------------------------------
+void HeapProfilerEnable( uint64 nSampleInterval = 512 * 1024 );
+void HeapProfilerDisable( void );
+bool HeapProfilerIsEnabled( void );
+
+//-----------------------------------------------------------------------------
+//  HeapProfilerWrite
+//  Writes the live sampled bytes, by stack. Returns false if the file
+//  couldn't be written
+//-----------------------------------------------------------------------------
+bool HeapProfilerWrite( const char* szFilename, eHeapProfileFormat nFormat );
+
+//-----------------------------------------------------------------------------
+//  Allocator hooks
+//  Called by the global operator new/delete for every block
+//-----------------------------------------------------------------------------
+extern volatile bool    g_bHeapProfilerEnabled;
+extern volatile sint32  g_nHeapProfilerLiveSamples;
+
+void HeapProfilerSampleAlloc( void* pData, size_t nSize );
+void HeapProfilerSampleFree( void* pData );
+
+__forceinline void HeapProfilerOnAlloc( void* pData, size_t nSize )
+{
+    if( g_bHeapProfilerEnabled )
+    {
+        HeapProfilerSampleAlloc( pData, nSize );
+    }
+}
+
+__forceinline void HeapProfilerOnFree( void* pData )
+{
+    if( g_nHeapProfilerLiveSamples != 0 )
+    {
+        HeapProfilerSampleFree( pData );
+    }
+}
+
+#endif // #ifndef _HEAPPROFILER_H_
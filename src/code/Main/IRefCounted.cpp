@@ -0,0 +1,69 @@
+/*********************************************************\
+File:       IRefCounted.cpp
+Purpose:    The deferred release queue
+\*********************************************************/
+#include "IRefCounted.h"
+
+//-----------------------------------------------------------------------------
+//  The queue is an intrusive lock-free stack. Any thread can push, and
+//  ProcessDeferredReleases takes the whole thing at once, so there's no
+//  ABA problem to worry about
+//-----------------------------------------------------------------------------
+static IRefCounted* volatile    gs_pDeferredHead = NULL;
+static volatile bool            gs_bDeferredReleasesEnabled = true;
+
+//-----------------------------------------------------------------------------
+//  DeferDestruction
+//  Adds the object to the deferred release queue, or deletes it right
+//  away if deferred releases are turned off
+//-----------------------------------------------------------------------------
+void IRefCounted::DeferDestruction( void )
+{
+    if( !gs_bDeferredReleasesEnabled )
+    {
+        delete this;
+        return;
+    }
+
+    IRefCounted* pHead;
+    do
+    {
+        pHead = gs_pDeferredHead;
+        m_pNextDeferred = pHead;
+    } while( AtomicCompareExchangePointer( (void* volatile*)&gs_pDeferredHead, this, pHead ) != pHead );
+}
+
+//-----------------------------------------------------------------------------
+//  ProcessDeferredReleases
+//  Deletes everything in the deferred release queue, including anything
+//  their destructors release. Call from one thread at a time
+//-----------------------------------------------------------------------------
+void ProcessDeferredReleases( void )
+{
+    while( gs_pDeferredHead )
+    {
+        // Take the whole list
+        IRefCounted* pObject;
+        do
+        {
+            pObject = gs_pDeferredHead;
+        } while( AtomicCompareExchangePointer( (void* volatile*)&gs_pDeferredHead, NULL, pObject ) != pObject );
+
+        while( pObject )
+        {
+            IRefCounted* pNext = pObject->m_pNextDeferred;
+            delete pObject;
+            pObject = pNext;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//  SetDeferredReleasesEnabled
+//  When disabled, deferred objects are deleted by their last Release like
+//  any other. Turned off at shutdown, once nothing will process the queue
+//-----------------------------------------------------------------------------
+void SetDeferredReleasesEnabled( bool bEnabled )
+{
+    gs_bDeferredReleasesEnabled = bEnabled;
+}
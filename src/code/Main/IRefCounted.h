@@ -6,27 +6,146 @@ Purpose:    Ref counting interface
 #define _IREFCOUNTED_H_
 #include "Common.h"
 #include "Types.h"
+#include "Atomic.h"
 
+//-----------------------------------------------------------------------------
+//  IRefCounted
+//  The count is atomic, so references can be added and released from any
+//  thread. Objects that opt in with SetDeferDestruction aren't deleted by
+//  the last Release, they're queued up and deleted together by
+//  ProcessDeferredReleases, which the engine calls at the end of the frame.
+//  That keeps expensive destructors (freeing GPU resources) out of the
+//  middle of the frame and on the thread that owns them
+//-----------------------------------------------------------------------------
 class IRefCounted
 {
 public:
     IRefCounted()
         : m_nRefCount(1)
+        , m_bDeferDestruction(false)
+        , m_pNextDeferred(NULL)
     { }
     virtual ~IRefCounted() { }
 
-    _inline void AddRef( void ) { ++m_nRefCount; }
+    _inline void AddRef( void ) { AtomicIncrement( &m_nRefCount ); }
     _inline void Release( void ) 
     { 
-        --m_nRefCount; 
-        if( m_nRefCount == 0 ) 
+        if( AtomicDecrement( &m_nRefCount ) == 0 ) 
         { 
-            delete this; 
+            if( m_bDeferDestruction )
+            {
+                DeferDestruction();
+            }
+            else
+            {
+                delete this; 
+            }
         } 
     }
 
+    _inline sint32 GetRefCount( void ) const { return m_nRefCount; }
+
+protected:
+    //-----------------------------------------------------------------------------
+    //  SetDeferDestruction
+    //  Makes the last Release queue the object instead of deleting it
+    //-----------------------------------------------------------------------------
+    _inline void SetDeferDestruction( bool bDefer ) { m_bDeferDestruction = bDefer; }
+
+private:
+    //-----------------------------------------------------------------------------
+    //  DeferDestruction
+    //  Adds the object to the deferred release queue, or deletes it right
+    //  away if deferred releases are turned off
+    //-----------------------------------------------------------------------------
+    void DeferDestruction( void );
+
+    friend void ProcessDeferredReleases( void );
+
+    volatile sint32 m_nRefCount;
+    bool            m_bDeferDestruction;
+    IRefCounted*    m_pNextDeferred;
+};
+
+//-----------------------------------------------------------------------------
+//  ProcessDeferredReleases
+//  Deletes everything in the deferred release queue, including anything
+//  their destructors release. Call from one thread at a time
+//-----------------------------------------------------------------------------
+void ProcessDeferredReleases( void );
+
+//-----------------------------------------------------------------------------
+//  SetDeferredReleasesEnabled
+//  When disabled, deferred objects are deleted by their last Release like
+//  any other. Turned off at shutdown, once nothing will process the queue
+//-----------------------------------------------------------------------------
+void SetDeferredReleasesEnabled( bool bEnabled );
+
+//-----------------------------------------------------------------------------
+//  RefPtr
+//  Intrusive smart pointer, holds one reference to a ref counted object.
+//  Assigning a raw pointer adds a reference, use AdoptRef for pointers
+//  that already come with one (anything straight out of new or Create*)
+//-----------------------------------------------------------------------------
+template< class T >
+class RefPtr
+{
+public:
+    RefPtr() : m_pObject( NULL ) { }
+    RefPtr( T* pObject ) : m_pObject( pObject ) { if( m_pObject ) m_pObject->AddRef(); }
+    RefPtr( const RefPtr& ref ) : m_pObject( ref.m_pObject ) { if( m_pObject ) m_pObject->AddRef(); }
+    ~RefPtr() { if( m_pObject ) m_pObject->Release(); }
+
+    RefPtr& operator=( T* pObject )
+    {
+        // AddRef first, in case it's the same object
+        if( pObject ) 
+            pObject->AddRef();
+        T* pOld = m_pObject;
+        m_pObject = pObject;
+        if( pOld ) 
+            pOld->Release();
+        return *this;
+    }
+    RefPtr& operator=( const RefPtr& ref ) { return *this = ref.m_pObject; }
+
+    //-----------------------------------------------------------------------------
+    //  Attach/Detach
+    //  Takes over a reference without adding one, or gives up the held
+    //  reference without releasing it
+    //-----------------------------------------------------------------------------
+    void Attach( T* pObject )
+    {
+        T* pOld = m_pObject;
+        m_pObject = pObject;
+        if( pOld ) 
+            pOld->Release();
+    }
+    T* Detach( void )
+    {
+        T* pObject = m_pObject;
+        m_pObject = NULL;
+        return pObject;
+    }
+
+    //-----------------------------------------------------------------------------
+    //  Accessors
+    //-----------------------------------------------------------------------------
+    T* Get( void ) const { return m_pObject; }
+    T* operator->( void ) const { return m_pObject; }
+    T& operator*( void ) const { return *m_pObject; }
+    operator T*( void ) const { return m_pObject; }
+
 private:
-    uint m_nRefCount;
+    T*  m_pObject;
 };
 
+template< class T >
+_inline RefPtr<T> AdoptRef( T* pObject )
+{
+    RefPtr<T> ref;
+    ref.Attach( pObject );
+    return ref;
+}
+
 #endif // #ifndef _IREFCOUNTED_H_
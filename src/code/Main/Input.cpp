@@ -5,27 +5,239 @@ Purpose:    Definition of the input system
 #include "Input.h"
 #include "Common.h"
 
+static const char   gs_pInputRecordingMagic[4] = { 'R', 'I', 'N', 'P' };
+static const uint32 gs_nInputRecordingVersion = 1;
+static const uint8  gs_nAllKeysChanged = 255;
+
+//-----------------------------------------------------------------------------
+//  OpenRecording
+//-----------------------------------------------------------------------------
+static FILE* OpenRecording( const char* szFilename, const char* szMode )
+{
+    FILE* pFile = NULL;
+#if defined( _MSC_VER )
+    if( fopen_s( &pFile, szFilename, szMode ) != 0 )
+        return NULL;
+#else
+    pFile = fopen( szFilename, szMode );
+#endif // #if defined( _MSC_VER )
+    return pFile;
+}
+
 RiotInput::RiotInput( )
+    : m_fFrameTime( 0.0f )
+    , m_pRecordFile( NULL )
+    , m_pReplayFile( NULL )
+    , m_fReplayFrameTime( 0.0f )
+    , m_bReplaying( false )
+    , m_bReplayFinished( false )
 {
     for( int i = 0; i < 256; ++i )
     {
         m_pKeys[i] = 0;
+        m_pReplayKeys[i] = 0;
     }
 }
 
 RiotInput::~RiotInput( )
 {
+    if( m_pRecordFile )
+    {
+        fclose( m_pRecordFile );
+    }
+    if( m_pReplayFile )
+    {
+        fclose( m_pReplayFile );
+    }
+}
+
+//-----------------------------------------------------------------------------
+//  StartRecording
+//  Records every frame from the next PollInput on
+//-----------------------------------------------------------------------------
+bool RiotInput::StartRecording( const char* szFilename, float fTickTime )
+{
+    FILE* pFile = OpenRecording( szFilename, "wb" );
+    if( pFile == NULL )
+        return false;
+
+    InputRecordingHeader header;
+    memcpy( header.pMagic, gs_pInputRecordingMagic, sizeof( header.pMagic ) );
+    header.nVersion = gs_nInputRecordingVersion;
+    header.fTickTime = fTickTime;
+    header.nReserved = 0;
+    if( fwrite( &header, sizeof( header ), 1, pFile ) != 1 )
+    {
+        fclose( pFile );
+        return false;
+    }
+
+    if( m_pRecordFile )
+    {
+        fclose( m_pRecordFile );
+    }
+    m_pRecordFile = pFile;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//  StartReplay
+//  Plays back a recording in place of the keyboard. The first frame is
+//  read straight away
+//-----------------------------------------------------------------------------
+bool RiotInput::StartReplay( const char* szFilename, float fTickTime )
+{
+    FILE* pFile = OpenRecording( szFilename, "rb" );
+    if( pFile == NULL )
+        return false;
+
+    InputRecordingHeader header;
+    if( fread( &header, sizeof( header ), 1, pFile ) != 1
+        || memcmp( header.pMagic, gs_pInputRecordingMagic, sizeof( header.pMagic ) ) != 0
+        || header.nVersion != gs_nInputRecordingVersion )
+    {
+        fclose( pFile );
+        return false;
+    }
+    if( header.fTickTime != fTickTime )
+    {
+        printf( "%s was recorded with a %.2f Hz tick, so it won't replay exactly at %.2f Hz\n",
+                szFilename, 1.0f / header.fTickTime, 1.0f / fTickTime );
+    }
+
+    if( m_pReplayFile )
+    {
+        fclose( m_pReplayFile );
+    }
+    m_pReplayFile = pFile;
+    m_bReplayFinished = false;
+    // Recordings start with every key up
+    memset( m_pReplayKeys, 0, sizeof( m_pReplayKeys ) );
+    ReadReplayFrame();
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//  RecordFrame
+//  Only the keys that changed since last frame are written, which is
+//  usually none of them
+//-----------------------------------------------------------------------------
+void RiotInput::RecordFrame( const uint8* pKeys, float fFrameTime )
+{
+    uint8 pChanges[256];
+    uint nNumChanges = 0;
+    for( int i = 0; i < 256; ++i )
+    {
+        bool bDown = ( pKeys[i] & 0x80 ) != 0;
+        if( bDown != ( m_pKeys[i] != 0x00 ) )
+        {
+            pChanges[ nNumChanges++ ] = (uint8)i;
+        }
+    }
+
+    fwrite( &fFrameTime, sizeof( fFrameTime ), 1, m_pRecordFile );
+    if( nNumChanges < gs_nAllKeysChanged )
+    {
+        uint8 nCount = (uint8)nNumChanges;
+        fwrite( &nCount, sizeof( nCount ), 1, m_pRecordFile );
+        fwrite( pChanges, sizeof( uint8 ), nNumChanges, m_pRecordFile );
+    }
+    else
+    {
+        uint8 pBits[32] = { 0 };
+        for( int i = 0; i < 256; ++i )
+        {
+            if( pKeys[i] & 0x80 )
+            {
+                pBits[ i >> 3 ] |= (uint8)( 1 << ( i & 7 ) );
+            }
+        }
+        fwrite( &gs_nAllKeysChanged, sizeof( gs_nAllKeysChanged ), 1, m_pRecordFile );
+        fwrite( pBits, sizeof( pBits ), 1, m_pRecordFile );
+    }
+}
+
+//-----------------------------------------------------------------------------
+//  ReadReplayFrame
+//  Rebuilds the keyboard state RecordFrame was given for the next frame.
+//  Once the recording runs out, the replay's finished
+//-----------------------------------------------------------------------------
+void RiotInput::ReadReplayFrame( void )
+{
+    float fFrameTime = 0.0f;
+    uint8 nNumChanges = 0;
+    bool bRead = fread( &fFrameTime, sizeof( fFrameTime ), 1, m_pReplayFile ) == 1
+              && fread( &nNumChanges, sizeof( nNumChanges ), 1, m_pReplayFile ) == 1;
+    if( bRead && nNumChanges == gs_nAllKeysChanged )
+    {
+        uint8 pBits[32];
+        bRead = fread( pBits, sizeof( pBits ), 1, m_pReplayFile ) == 1;
+        for( int i = 0; bRead && i < 256; ++i )
+        {
+            m_pReplayKeys[i] = ( pBits[ i >> 3 ] & ( 1 << ( i & 7 ) ) ) ? 0x80 : 0x00;
+        }
+    }
+    else if( bRead )
+    {
+        uint8 pChanges[256];
+        bRead = fread( pChanges, sizeof( uint8 ), nNumChanges, m_pReplayFile ) == nNumChanges;
+        for( uint i = 0; bRead && i < nNumChanges; ++i )
+        {
+            m_pReplayKeys[ pChanges[i] ] ^= 0x80;
+        }
+    }
+
+    if( bRead )
+    {
+        m_fReplayFrameTime = fFrameTime;
+    }
+    else
+    {
+        fclose( m_pReplayFile );
+        m_pReplayFile = NULL;
+        m_bReplayFinished = true;
+    }
 }
 
 //-----------------------------------------------------------------------------
 //  PollInput
-//  Gets the current state of the IO devices
+//  Gets the current state of the IO devices, or the next frame of the
+//  replay
 //-----------------------------------------------------------------------------
-void RiotInput::PollInput( void )
+void RiotInput::PollInput( float fFrameTime )
 {
     uint8 pKeys[256];
+    m_fFrameTime = fFrameTime;
+    m_bReplaying = false;
 
-    GetKeyboardState( pKeys );
+    if( m_pReplayFile )
+    {
+        memcpy( pKeys, m_pReplayKeys, sizeof( pKeys ) );
+        m_fFrameTime = m_fReplayFrameTime;
+        m_bReplaying = true;
+        ReadReplayFrame();
+    }
+    else if( m_bReplayFinished )
+    {   // The replay's over, let go of everything. There's no frame to
+        // simulate, so there's nothing to record either
+        memset( m_pKeys, 0, sizeof( m_pKeys ) );
+        m_fFrameTime = 0.0f;
+        return;
+    }
+    else
+    {
+#if defined( OS_WINDOWS )
+        GetKeyboardState( pKeys );
+#else
+        // No keyboard to read without a window system
+        memset( pKeys, 0, sizeof( pKeys ) );
+#endif // #if defined( OS_WINDOWS )
+    }
+
+    if( m_pRecordFile )
+    {
+        RecordFrame( pKeys, m_fFrameTime );
+    }
 
     for( int i = 0; i < 256; ++i )
     {
@@ -60,7 +272,7 @@ bool RiotInput::IsKeyDown( uint8 nKey )
 }
 
 bool RiotInput::IsKeyUp( uint8 nKey )
-{    
+{
     if( m_pKeys[nKey] == 0x00 )
         return true;
 
@@ -69,12 +281,25 @@ bool RiotInput::IsKeyUp( uint8 nKey )
 
 //-----------------------------------------------------------------------------
 //  WasKeyPressed
-//  Returns if the key was just pressed and isn't held down
+//  Returns if the key was down last frame too, so it keeps firing every
+//  frame the key is held
 //-----------------------------------------------------------------------------
 bool RiotInput::WasKeyPressed( uint8 nKey )
 {
     if( m_pKeys[nKey] == 0x81 )
         return true;
-    
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+//  WasKeyJustPressed
+//  Returns if the key went down this frame
+//-----------------------------------------------------------------------------
+bool RiotInput::WasKeyJustPressed( uint8 nKey )
+{
+    if( m_pKeys[nKey] == 0x80 )
+        return true;
+
     return false;
 }
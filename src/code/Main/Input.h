@@ -11,8 +11,38 @@ Purpose:    User IO system
 
 #if defined( WIN32 ) || defined( WIN64 )
 #include <Windows.h>
+#else
+// The virtual key codes the engine uses, for platforms without <Windows.h>
+#define VK_CONTROL  0x11
+#define VK_ESCAPE   0x1B
+#define VK_LEFT     0x25
+#define VK_UP       0x26
+#define VK_RIGHT    0x27
+#define VK_DOWN     0x28
+#define VK_F1       0x70
+#define VK_F2       0x71
+#define VK_F3       0x72
+#define VK_F4       0x73
+#define VK_F5       0x74
 #endif // #if defined( WIN32 ) || defined( WIN64 )
 
+//-----------------------------------------------------------------------------
+//  Input recordings
+//  A recording is every frame's keyboard state and frame time, so a replay
+//  sees exactly what the recorded run saw. After the header, each frame is
+//      float   fFrameTime
+//      uint8   nNumChanges     Keys that went up or down, 255 for all 256
+//      uint8   pKeys[]         The keys that changed, or a bit per key
+//                              (32 bytes) if nNumChanges is 255
+//-----------------------------------------------------------------------------
+struct InputRecordingHeader
+{
+    char    pMagic[4];          // "RINP"
+    uint32  nVersion;
+    float   fTickTime;          // Replays need the same tick to match
+    uint32  nReserved;
+};
+
 class RiotInput : public IRefCounted
 {
 //---------------------------------------------------------------------------------
@@ -23,9 +53,39 @@ public:
     
     //-----------------------------------------------------------------------------
     //  PollInput
-    //  Gets the current state of the IO devices
+    //  Gets the current state of the IO devices, or the next frame of the
+    //  replay. fFrameTime is the time the frame is for, which is recorded
+    //  along with the keys
+    //-----------------------------------------------------------------------------
+    void PollInput( float fFrameTime );
+
+    //-----------------------------------------------------------------------------
+    //  GetFrameTime
+    //  The time this frame should simulate. That's what was passed to
+    //  PollInput, unless a replay is playing back its own. 0 once a replay
+    //  has finished
     //-----------------------------------------------------------------------------
-    void PollInput( void );
+    float GetFrameTime( void ) const { return m_fFrameTime; }
+
+    //-----------------------------------------------------------------------------
+    //  StartRecording/StartReplay
+    //  Records every frame from the next PollInput on, or plays back a
+    //  recording in place of the keyboard. fTickTime is the simulation
+    //  tick, which a replay warns about if it doesn't match. Return false
+    //  if the file couldn't be opened or isn't a recording
+    //-----------------------------------------------------------------------------
+    bool StartRecording( const char* szFilename, float fTickTime );
+    bool StartReplay( const char* szFilename, float fTickTime );
+
+    //-----------------------------------------------------------------------------
+    //  IsReplaying/IsReplayFinished
+    //  IsReplaying is if this frame came from a replay. The replay reads a
+    //  frame ahead, so IsReplayFinished is already true on its last frame
+    //  (or straight after StartReplay, if it's empty). Polling past the end
+    //  leaves the keys up and the frame time at 0
+    //-----------------------------------------------------------------------------
+    bool IsReplaying( void ) const { return m_bReplaying; }
+    bool IsReplayFinished( void ) const { return m_bReplayFinished; }
 
     //-----------------------------------------------------------------------------
     //  IsKeyDown
@@ -36,15 +96,34 @@ public:
 
     //-----------------------------------------------------------------------------
     //  WasKeyPressed
-    //  Returns if the key was just pressed and isn't held down
+    //  Returns if the key was down last frame too, so it keeps firing every
+    //  frame the key is held
     //-----------------------------------------------------------------------------
     bool WasKeyPressed( uint8 nKey );
+
+    //-----------------------------------------------------------------------------
+    //  WasKeyJustPressed
+    //  Returns if the key went down this frame. Fires once per press, which
+    //  is what toggles want
+    //-----------------------------------------------------------------------------
+    bool WasKeyJustPressed( uint8 nKey );
 private:
+    // Writes a frame of the recording, or reads the replay's next frame
+    // into m_pReplayKeys. Keys are in the same form as GetKeyboardState's
+    void RecordFrame( const uint8* pKeys, float fFrameTime );
+    void ReadReplayFrame( void );
 
 //---------------------------------------------------------------------------------
 //  Members
 private:
     uint8   m_pKeys[256];
+    float   m_fFrameTime;
+    FILE*   m_pRecordFile;
+    FILE*   m_pReplayFile;      // Open while there's a frame in m_pReplayKeys
+    uint8   m_pReplayKeys[256];
+    float   m_fReplayFrameTime;
+    bool    m_bReplaying;
+    bool    m_bReplayFinished;
 };
 
 
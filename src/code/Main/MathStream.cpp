@@ -0,0 +1,780 @@
+/*********************************************************\
+File:       MathStream.cpp
+Purpose:    Structure of arrays vectors, the scalar and
+            SSE stream kernels, and picking between them
+\*********************************************************/
+#include "Common.h"
+#include "MathStream.h"
+#include "MathStreamKernels.h"
+#include "PackedVector.h"
+#include "Memory.h"
+#include <string.h>
+#include <float.h> // For FLT_MAX
+
+#if defined( RIOT_X86 )
+#if defined( _MSC_VER )
+#include <intrin.h> // For __cpuid, _xgetbv
+#else
+#include <cpuid.h>
+#endif // #if defined( _MSC_VER )
+#endif // #if defined( RIOT_X86 )
+
+#define new DEBUG_NEW
+
+/**********************************************************\
+|**********************************************************|
+| class RVec3Stream
+|**********************************************************|
+\**********************************************************/
+// RVec3Stream constructors
+RVec3Stream::RVec3Stream()
+    : x( NULL )
+    , y( NULL )
+    , z( NULL )
+    , m_nCount( 0 )
+    , m_nCapacity( 0 )
+{
+}
+
+RVec3Stream::RVec3Stream( uint nCount )
+    : x( NULL )
+    , y( NULL )
+    , z( NULL )
+    , m_nCount( 0 )
+    , m_nCapacity( 0 )
+{
+    Resize( nCount );
+}
+
+// RVec3Stream destructor
+RVec3Stream::~RVec3Stream()
+{
+    if( x )
+    {
+        AlignedFree( x );
+    }
+    x = y = z = NULL;
+}
+
+//-----------------------------------------------------------------------------
+//  Resize
+//  Sets the number of vectors. Growing past the capacity reallocates,
+//  and keeps the vectors that were there
+//-----------------------------------------------------------------------------
+void RVec3Stream::Resize( uint nCount )
+{
+    if( nCount > m_nCapacity )
+    {
+        // All three arrays share one cache aligned block
+        uint nCapacity = ( nCount + 7 ) & ~7;
+        float* pBlock = CACHE_ALIGNED_ARRAY( float, nCapacity * 3 );
+        // TODO: Handle out of memory error ( pBlock == 0 )
+        if( x )
+        {
+            memcpy( pBlock,                 x, sizeof( float ) * m_nCount );
+            memcpy( pBlock + nCapacity,     y, sizeof( float ) * m_nCount );
+            memcpy( pBlock + nCapacity * 2, z, sizeof( float ) * m_nCount );
+            AlignedFree( x );
+        }
+        x = pBlock;
+        y = pBlock + nCapacity;
+        z = pBlock + nCapacity * 2;
+        m_nCapacity = nCapacity;
+    }
+    m_nCount = nCount;
+}
+
+
+/**********************************************************\
+|**********************************************************|
+| Scalar kernels
+|**********************************************************|
+\**********************************************************/
+static void ScalarTransformPoints( const float* pMatrix, const float* pInX, const float* pInY, const float* pInZ,
+                                   float* pOutX, float* pOutY, float* pOutZ, uint nCount )
+{
+    const float* m = pMatrix;
+    for( uint i = 0; i < nCount; ++i )
+    {
+        float fX = pInX[i], fY = pInY[i], fZ = pInZ[i];
+        pOutX[i] = fX * m[0] + fY * m[4] + fZ * m[8]  + m[12];
+        pOutY[i] = fX * m[1] + fY * m[5] + fZ * m[9]  + m[13];
+        pOutZ[i] = fX * m[2] + fY * m[6] + fZ * m[10] + m[14];
+    }
+}
+
+static void ScalarProjectPoints( const float* pMatrix, const float* pInX, const float* pInY, const float* pInZ,
+                                 float* pOutX, float* pOutY, float* pOutZ, float* pOutW, uint nCount )
+{
+    const float* m = pMatrix;
+    for( uint i = 0; i < nCount; ++i )
+    {
+        float fX = pInX[i], fY = pInY[i], fZ = pInZ[i];
+        pOutX[i] = fX * m[0] + fY * m[4] + fZ * m[8]  + m[12];
+        pOutY[i] = fX * m[1] + fY * m[5] + fZ * m[9]  + m[13];
+        pOutZ[i] = fX * m[2] + fY * m[6] + fZ * m[10] + m[14];
+        pOutW[i] = fX * m[3] + fY * m[7] + fZ * m[11] + m[15];
+    }
+}
+
+static void ScalarDotProducts( const float* pAX, const float* pAY, const float* pAZ,
+                               const float* pBX, const float* pBY, const float* pBZ, float* pOut, uint nCount )
+{
+    for( uint i = 0; i < nCount; ++i )
+    {
+        pOut[i] = pAX[i] * pBX[i] + pAY[i] * pBY[i] + pAZ[i] * pBZ[i];
+    }
+}
+
+static void ScalarNormalize( float* pX, float* pY, float* pZ, uint nCount )
+{
+    for( uint i = 0; i < nCount; ++i )
+    {
+        float fRecip = 1 / sqrtf( pX[i] * pX[i] + pY[i] * pY[i] + pZ[i] * pZ[i] );
+        pX[i] *= fRecip;
+        pY[i] *= fRecip;
+        pZ[i] *= fRecip;
+    }
+}
+
+static void ScalarMinMax( const float* pX, const float* pY, const float* pZ, uint nCount, float* pMin, float* pMax )
+{
+    for( uint i = 0; i < nCount; ++i )
+    {
+        pMin[0] = pX[i] < pMin[0] ? pX[i] : pMin[0];
+        pMin[1] = pY[i] < pMin[1] ? pY[i] : pMin[1];
+        pMin[2] = pZ[i] < pMin[2] ? pZ[i] : pMin[2];
+        pMax[0] = pX[i] > pMax[0] ? pX[i] : pMax[0];
+        pMax[1] = pY[i] > pMax[1] ? pY[i] : pMax[1];
+        pMax[2] = pZ[i] > pMax[2] ? pZ[i] : pMax[2];
+    }
+}
+
+static void ScalarMultiplyMatrices( const float* pA, const float* pB, float* pOut, uint nCount )
+{
+    for( uint n = 0; n < nCount; ++n, pA += 16, pB += 16, pOut += 16 )
+    {
+        float pResult[16];
+        for( uint i = 0; i < 4; ++i )
+        {
+            for( uint j = 0; j < 4; ++j )
+            {
+                pResult[i*4 + j] = pA[i*4 + 0] * pB[0*4 + j] + pA[i*4 + 1] * pB[1*4 + j]
+                                 + pA[i*4 + 2] * pB[2*4 + j] + pA[i*4 + 3] * pB[3*4 + j];
+            }
+        }
+        memcpy( pOut, pResult, sizeof( pResult ) );
+    }
+}
+
+static uint ScalarCullSpheres( const float* pPlanes, const float* pX, const float* pY, const float* pZ,
+                               const float* pRadius, uint nCount, uint8* pVisible )
+{
+    uint nVisible = 0;
+    for( uint i = 0; i < nCount; ++i )
+    {
+        uint8 nInside = 1;
+        for( const float* pPlane = pPlanes; pPlane < pPlanes + 24; pPlane += 4 )
+        {
+            float fDistance = pX[i] * pPlane[0] + pY[i] * pPlane[1] + pZ[i] * pPlane[2] + pPlane[3];
+            nInside &= ( fDistance >= -pRadius[i] );
+        }
+        pVisible[i] = nInside;
+        nVisible += nInside;
+    }
+    return nVisible;
+}
+
+static uint ScalarOverlapAABBs( const float* pBox, const float* pMinX, const float* pMinY, const float* pMinZ,
+                                const float* pMaxX, const float* pMaxY, const float* pMaxZ, uint nCount, uint8* pOverlap )
+{
+    uint nOverlapping = 0;
+    for( uint i = 0; i < nCount; ++i )
+    {
+        uint8 nOverlaps = pMinX[i] <= pBox[3] && pBox[0] <= pMaxX[i]
+                       && pMinY[i] <= pBox[4] && pBox[1] <= pMaxY[i]
+                       && pMinZ[i] <= pBox[5] && pBox[2] <= pMaxZ[i];
+        pOverlap[i] = nOverlaps;
+        nOverlapping += nOverlaps;
+    }
+    return nOverlapping;
+}
+
+// The same slab test as IntersectRay, with the entry clamped to 0 first
+static uint ScalarIntersectRayAABBs( const float* pRay, const float* pMinX, const float* pMinY, const float* pMinZ,
+                                     const float* pMaxX, const float* pMaxY, const float* pMaxZ, uint nCount, float* pT )
+{
+    uint nHits = 0;
+    for( uint i = 0; i < nCount; ++i )
+    {
+        const float* pMins[3] = { pMinX + i, pMinY + i, pMinZ + i };
+        const float* pMaxs[3] = { pMaxX + i, pMaxY + i, pMaxZ + i };
+        float fEnter = 0.0f;
+        float fExit = FLT_MAX;
+        for( uint nAxis = 0; nAxis < 3; ++nAxis )
+        {
+            float fT1 = ( *pMins[nAxis] - pRay[nAxis] ) * pRay[nAxis + 3];
+            float fT2 = ( *pMaxs[nAxis] - pRay[nAxis] ) * pRay[nAxis + 3];
+            float fNear = fT1 < fT2 ? fT1 : fT2;
+            float fFar = fT1 < fT2 ? fT2 : fT1;
+            fEnter = fNear > fEnter ? fNear : fEnter;
+            fExit = fFar < fExit ? fFar : fExit;
+        }
+        bool bHit = fEnter <= fExit;
+        pT[i] = bHit ? fEnter : -1.0f;
+        nHits += bHit;
+    }
+    return nHits;
+}
+
+static void ScalarFloatsToHalfs( const float* pIn, uint16* pOut, uint nCount )
+{
+    for( uint i = 0; i < nCount; ++i )
+    {
+        pOut[i] = FloatToHalf( pIn[i] );
+    }
+}
+
+static void ScalarHalfsToFloats( const uint16* pIn, float* pOut, uint nCount )
+{
+    for( uint i = 0; i < nCount; ++i )
+    {
+        pOut[i] = HalfToFloat( pIn[i] );
+    }
+}
+
+const MathStreamKernels g_ScalarKernels =
+{
+    ScalarTransformPoints,
+    ScalarProjectPoints,
+    ScalarDotProducts,
+    ScalarNormalize,
+    ScalarMinMax,
+    ScalarMultiplyMatrices,
+    ScalarCullSpheres,
+    ScalarOverlapAABBs,
+    ScalarIntersectRayAABBs,
+    ScalarFloatsToHalfs,
+    ScalarHalfsToFloats,
+};
+
+
+/**********************************************************\
+|**********************************************************|
+| SSE kernels
+| 4 at a time. The streams are 32 byte aligned, but the
+| leftovers of a vector kernel may start anywhere, so
+| loads are unaligned
+|**********************************************************|
+\**********************************************************/
+#if defined( RIOT_SSE )
+
+static void SSETransformPoints( const float* pMatrix, const float* pInX, const float* pInY, const float* pInZ,
+                                float* pOutX, float* pOutY, float* pOutZ, uint nCount )
+{
+    __m128 v11 = _mm_set1_ps( pMatrix[0] ), v12 = _mm_set1_ps( pMatrix[1] ), v13 = _mm_set1_ps( pMatrix[2] );
+    __m128 v21 = _mm_set1_ps( pMatrix[4] ), v22 = _mm_set1_ps( pMatrix[5] ), v23 = _mm_set1_ps( pMatrix[6] );
+    __m128 v31 = _mm_set1_ps( pMatrix[8] ), v32 = _mm_set1_ps( pMatrix[9] ), v33 = _mm_set1_ps( pMatrix[10] );
+    __m128 v41 = _mm_set1_ps( pMatrix[12] ), v42 = _mm_set1_ps( pMatrix[13] ), v43 = _mm_set1_ps( pMatrix[14] );
+
+    uint nVectorCount = nCount & ~3;
+    for( uint i = 0; i < nVectorCount; i += 4 )
+    {
+        __m128 vX = _mm_loadu_ps( pInX + i ), vY = _mm_loadu_ps( pInY + i ), vZ = _mm_loadu_ps( pInZ + i );
+        __m128 vOutX = _mm_add_ps( _mm_add_ps( _mm_mul_ps( vX, v11 ), _mm_mul_ps( vY, v21 ) ), _mm_add_ps( _mm_mul_ps( vZ, v31 ), v41 ) );
+        __m128 vOutY = _mm_add_ps( _mm_add_ps( _mm_mul_ps( vX, v12 ), _mm_mul_ps( vY, v22 ) ), _mm_add_ps( _mm_mul_ps( vZ, v32 ), v42 ) );
+        __m128 vOutZ = _mm_add_ps( _mm_add_ps( _mm_mul_ps( vX, v13 ), _mm_mul_ps( vY, v23 ) ), _mm_add_ps( _mm_mul_ps( vZ, v33 ), v43 ) );
+        _mm_storeu_ps( pOutX + i, vOutX );
+        _mm_storeu_ps( pOutY + i, vOutY );
+        _mm_storeu_ps( pOutZ + i, vOutZ );
+    }
+    ScalarTransformPoints( pMatrix, pInX + nVectorCount, pInY + nVectorCount, pInZ + nVectorCount,
+                           pOutX + nVectorCount, pOutY + nVectorCount, pOutZ + nVectorCount, nCount - nVectorCount );
+}
+
+static void SSEProjectPoints( const float* pMatrix, const float* pInX, const float* pInY, const float* pInZ,
+                              float* pOutX, float* pOutY, float* pOutZ, float* pOutW, uint nCount )
+{
+    __m128 v11 = _mm_set1_ps( pMatrix[0] ),  v12 = _mm_set1_ps( pMatrix[1] ),  v13 = _mm_set1_ps( pMatrix[2] ),  v14 = _mm_set1_ps( pMatrix[3] );
+    __m128 v21 = _mm_set1_ps( pMatrix[4] ),  v22 = _mm_set1_ps( pMatrix[5] ),  v23 = _mm_set1_ps( pMatrix[6] ),  v24 = _mm_set1_ps( pMatrix[7] );
+    __m128 v31 = _mm_set1_ps( pMatrix[8] ),  v32 = _mm_set1_ps( pMatrix[9] ),  v33 = _mm_set1_ps( pMatrix[10] ), v34 = _mm_set1_ps( pMatrix[11] );
+    __m128 v41 = _mm_set1_ps( pMatrix[12] ), v42 = _mm_set1_ps( pMatrix[13] ), v43 = _mm_set1_ps( pMatrix[14] ), v44 = _mm_set1_ps( pMatrix[15] );
+
+    uint nVectorCount = nCount & ~3;
+    for( uint i = 0; i < nVectorCount; i += 4 )
+    {
+        __m128 vX = _mm_loadu_ps( pInX + i ), vY = _mm_loadu_ps( pInY + i ), vZ = _mm_loadu_ps( pInZ + i );
+        __m128 vOutX = _mm_add_ps( _mm_add_ps( _mm_mul_ps( vX, v11 ), _mm_mul_ps( vY, v21 ) ), _mm_add_ps( _mm_mul_ps( vZ, v31 ), v41 ) );
+        __m128 vOutY = _mm_add_ps( _mm_add_ps( _mm_mul_ps( vX, v12 ), _mm_mul_ps( vY, v22 ) ), _mm_add_ps( _mm_mul_ps( vZ, v32 ), v42 ) );
+        __m128 vOutZ = _mm_add_ps( _mm_add_ps( _mm_mul_ps( vX, v13 ), _mm_mul_ps( vY, v23 ) ), _mm_add_ps( _mm_mul_ps( vZ, v33 ), v43 ) );
+        __m128 vOutW = _mm_add_ps( _mm_add_ps( _mm_mul_ps( vX, v14 ), _mm_mul_ps( vY, v24 ) ), _mm_add_ps( _mm_mul_ps( vZ, v34 ), v44 ) );
+        _mm_storeu_ps( pOutX + i, vOutX );
+        _mm_storeu_ps( pOutY + i, vOutY );
+        _mm_storeu_ps( pOutZ + i, vOutZ );
+        _mm_storeu_ps( pOutW + i, vOutW );
+    }
+    ScalarProjectPoints( pMatrix, pInX + nVectorCount, pInY + nVectorCount, pInZ + nVectorCount,
+                         pOutX + nVectorCount, pOutY + nVectorCount, pOutZ + nVectorCount, pOutW + nVectorCount, nCount - nVectorCount );
+}
+
+static void SSEDotProducts( const float* pAX, const float* pAY, const float* pAZ,
+                            const float* pBX, const float* pBY, const float* pBZ, float* pOut, uint nCount )
+{
+    uint nVectorCount = nCount & ~3;
+    for( uint i = 0; i < nVectorCount; i += 4 )
+    {
+        __m128 vDot = _mm_mul_ps( _mm_loadu_ps( pAX + i ), _mm_loadu_ps( pBX + i ) );
+        vDot = _mm_add_ps( vDot, _mm_mul_ps( _mm_loadu_ps( pAY + i ), _mm_loadu_ps( pBY + i ) ) );
+        vDot = _mm_add_ps( vDot, _mm_mul_ps( _mm_loadu_ps( pAZ + i ), _mm_loadu_ps( pBZ + i ) ) );
+        _mm_storeu_ps( pOut + i, vDot );
+    }
+    ScalarDotProducts( pAX + nVectorCount, pAY + nVectorCount, pAZ + nVectorCount,
+                       pBX + nVectorCount, pBY + nVectorCount, pBZ + nVectorCount, pOut + nVectorCount, nCount - nVectorCount );
+}
+
+static void SSENormalize( float* pX, float* pY, float* pZ, uint nCount )
+{
+    __m128 vOne = _mm_set1_ps( 1.0f );
+    uint nVectorCount = nCount & ~3;
+    for( uint i = 0; i < nVectorCount; i += 4 )
+    {
+        __m128 vX = _mm_loadu_ps( pX + i ), vY = _mm_loadu_ps( pY + i ), vZ = _mm_loadu_ps( pZ + i );
+        __m128 vLengthSq = _mm_add_ps( _mm_add_ps( _mm_mul_ps( vX, vX ), _mm_mul_ps( vY, vY ) ), _mm_mul_ps( vZ, vZ ) );
+        __m128 vRecip = _mm_div_ps( vOne, _mm_sqrt_ps( vLengthSq ) );
+        _mm_storeu_ps( pX + i, _mm_mul_ps( vX, vRecip ) );
+        _mm_storeu_ps( pY + i, _mm_mul_ps( vY, vRecip ) );
+        _mm_storeu_ps( pZ + i, _mm_mul_ps( vZ, vRecip ) );
+    }
+    ScalarNormalize( pX + nVectorCount, pY + nVectorCount, pZ + nVectorCount, nCount - nVectorCount );
+}
+
+static float HorizontalMin( __m128 v )
+{
+    v = _mm_min_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+    v = _mm_min_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+    return _mm_cvtss_f32( v );
+}
+
+static float HorizontalMax( __m128 v )
+{
+    v = _mm_max_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+    v = _mm_max_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+    return _mm_cvtss_f32( v );
+}
+
+static void SSEMinMax( const float* pX, const float* pY, const float* pZ, uint nCount, float* pMin, float* pMax )
+{
+    __m128 vMinX = _mm_set1_ps( pMin[0] ), vMinY = _mm_set1_ps( pMin[1] ), vMinZ = _mm_set1_ps( pMin[2] );
+    __m128 vMaxX = _mm_set1_ps( pMax[0] ), vMaxY = _mm_set1_ps( pMax[1] ), vMaxZ = _mm_set1_ps( pMax[2] );
+
+    uint nVectorCount = nCount & ~3;
+    for( uint i = 0; i < nVectorCount; i += 4 )
+    {
+        __m128 vX = _mm_loadu_ps( pX + i ), vY = _mm_loadu_ps( pY + i ), vZ = _mm_loadu_ps( pZ + i );
+        vMinX = _mm_min_ps( vMinX, vX ); vMaxX = _mm_max_ps( vMaxX, vX );
+        vMinY = _mm_min_ps( vMinY, vY ); vMaxY = _mm_max_ps( vMaxY, vY );
+        vMinZ = _mm_min_ps( vMinZ, vZ ); vMaxZ = _mm_max_ps( vMaxZ, vZ );
+    }
+    pMin[0] = HorizontalMin( vMinX ); pMin[1] = HorizontalMin( vMinY ); pMin[2] = HorizontalMin( vMinZ );
+    pMax[0] = HorizontalMax( vMaxX ); pMax[1] = HorizontalMax( vMaxY ); pMax[2] = HorizontalMax( vMaxZ );
+    ScalarMinMax( pX + nVectorCount, pY + nVectorCount, pZ + nVectorCount, nCount - nVectorCount, pMin, pMax );
+}
+
+static void SSEMultiplyMatrices( const float* pA, const float* pB, float* pOut, uint nCount )
+{
+    for( uint n = 0; n < nCount; ++n, pA += 16, pB += 16, pOut += 16 )
+    {
+        __m128 vB0 = _mm_loadu_ps( pB ), vB1 = _mm_loadu_ps( pB + 4 ), vB2 = _mm_loadu_ps( pB + 8 ), vB3 = _mm_loadu_ps( pB + 12 );
+        // Loaded up front, so pOut can be pA
+        __m128 pRows[4] = { _mm_loadu_ps( pA ), _mm_loadu_ps( pA + 4 ), _mm_loadu_ps( pA + 8 ), _mm_loadu_ps( pA + 12 ) };
+        for( uint i = 0; i < 4; ++i )
+        {
+            __m128 vRow = pRows[i];
+            __m128 vResult = _mm_mul_ps( _mm_shuffle_ps( vRow, vRow, _MM_SHUFFLE( 0, 0, 0, 0 ) ), vB0 );
+            vResult = _mm_add_ps( vResult, _mm_mul_ps( _mm_shuffle_ps( vRow, vRow, _MM_SHUFFLE( 1, 1, 1, 1 ) ), vB1 ) );
+            vResult = _mm_add_ps( vResult, _mm_mul_ps( _mm_shuffle_ps( vRow, vRow, _MM_SHUFFLE( 2, 2, 2, 2 ) ), vB2 ) );
+            vResult = _mm_add_ps( vResult, _mm_mul_ps( _mm_shuffle_ps( vRow, vRow, _MM_SHUFFLE( 3, 3, 3, 3 ) ), vB3 ) );
+            _mm_storeu_ps( pOut + i*4, vResult );
+        }
+    }
+}
+
+// How many lanes of a movemask are set
+static uint CountMask( uint nMask )
+{
+    return ( nMask & 1 ) + ( ( nMask >> 1 ) & 1 ) + ( ( nMask >> 2 ) & 1 ) + ( nMask >> 3 );
+}
+
+// One byte per lane of a movemask
+static uint StoreMask( uint nMask, uint8* pOut )
+{
+    pOut[0] = nMask & 1;
+    pOut[1] = ( nMask >> 1 ) & 1;
+    pOut[2] = ( nMask >> 2 ) & 1;
+    pOut[3] = ( nMask >> 3 ) & 1;
+    return CountMask( nMask );
+}
+
+static uint SSECullSpheres( const float* pPlanes, const float* pX, const float* pY, const float* pZ,
+                            const float* pRadius, uint nCount, uint8* pVisible )
+{
+    uint nVisible = 0;
+    uint nVectorCount = nCount & ~3;
+    for( uint i = 0; i < nVectorCount; i += 4 )
+    {
+        __m128 vX = _mm_loadu_ps( pX + i ), vY = _mm_loadu_ps( pY + i ), vZ = _mm_loadu_ps( pZ + i );
+        __m128 vNegRadius = _mm_sub_ps( _mm_setzero_ps(), _mm_loadu_ps( pRadius + i ) );
+        __m128 vInside = _mm_castsi128_ps( _mm_set1_epi32( -1 ) );
+        for( const float* pPlane = pPlanes; pPlane < pPlanes + 24; pPlane += 4 )
+        {
+            __m128 vDistance = _mm_add_ps( _mm_mul_ps( vX, _mm_set1_ps( pPlane[0] ) ), _mm_set1_ps( pPlane[3] ) );
+            vDistance = _mm_add_ps( vDistance, _mm_mul_ps( vY, _mm_set1_ps( pPlane[1] ) ) );
+            vDistance = _mm_add_ps( vDistance, _mm_mul_ps( vZ, _mm_set1_ps( pPlane[2] ) ) );
+            vInside = _mm_and_ps( vInside, _mm_cmpge_ps( vDistance, vNegRadius ) );
+        }
+        nVisible += StoreMask( _mm_movemask_ps( vInside ), pVisible + i );
+    }
+    return nVisible + ScalarCullSpheres( pPlanes, pX + nVectorCount, pY + nVectorCount, pZ + nVectorCount,
+                                         pRadius + nVectorCount, nCount - nVectorCount, pVisible + nVectorCount );
+}
+
+static uint SSEOverlapAABBs( const float* pBox, const float* pMinX, const float* pMinY, const float* pMinZ,
+                             const float* pMaxX, const float* pMaxY, const float* pMaxZ, uint nCount, uint8* pOverlap )
+{
+    __m128 vBoxMinX = _mm_set1_ps( pBox[0] ), vBoxMinY = _mm_set1_ps( pBox[1] ), vBoxMinZ = _mm_set1_ps( pBox[2] );
+    __m128 vBoxMaxX = _mm_set1_ps( pBox[3] ), vBoxMaxY = _mm_set1_ps( pBox[4] ), vBoxMaxZ = _mm_set1_ps( pBox[5] );
+
+    uint nOverlapping = 0;
+    uint nVectorCount = nCount & ~3;
+    for( uint i = 0; i < nVectorCount; i += 4 )
+    {
+        __m128 vOverlap = _mm_and_ps( _mm_cmple_ps( _mm_loadu_ps( pMinX + i ), vBoxMaxX ), _mm_cmple_ps( vBoxMinX, _mm_loadu_ps( pMaxX + i ) ) );
+        vOverlap = _mm_and_ps( vOverlap, _mm_and_ps( _mm_cmple_ps( _mm_loadu_ps( pMinY + i ), vBoxMaxY ), _mm_cmple_ps( vBoxMinY, _mm_loadu_ps( pMaxY + i ) ) ) );
+        vOverlap = _mm_and_ps( vOverlap, _mm_and_ps( _mm_cmple_ps( _mm_loadu_ps( pMinZ + i ), vBoxMaxZ ), _mm_cmple_ps( vBoxMinZ, _mm_loadu_ps( pMaxZ + i ) ) ) );
+        nOverlapping += StoreMask( _mm_movemask_ps( vOverlap ), pOverlap + i );
+    }
+    return nOverlapping + ScalarOverlapAABBs( pBox, pMinX + nVectorCount, pMinY + nVectorCount, pMinZ + nVectorCount,
+                                              pMaxX + nVectorCount, pMaxY + nVectorCount, pMaxZ + nVectorCount,
+                                              nCount - nVectorCount, pOverlap + nVectorCount );
+}
+
+static uint SSEIntersectRayAABBs( const float* pRay, const float* pMinX, const float* pMinY, const float* pMinZ,
+                                  const float* pMaxX, const float* pMaxY, const float* pMaxZ, uint nCount, float* pT )
+{
+    __m128 vOriginX = _mm_set1_ps( pRay[0] ), vOriginY = _mm_set1_ps( pRay[1] ), vOriginZ = _mm_set1_ps( pRay[2] );
+    __m128 vInvDirX = _mm_set1_ps( pRay[3] ), vInvDirY = _mm_set1_ps( pRay[4] ), vInvDirZ = _mm_set1_ps( pRay[5] );
+    __m128 vMiss = _mm_set1_ps( -1.0f );
+
+    uint nHits = 0;
+    uint nVectorCount = nCount & ~3;
+    for( uint i = 0; i < nVectorCount; i += 4 )
+    {
+        __m128 vT1 = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( pMinX + i ), vOriginX ), vInvDirX );
+        __m128 vT2 = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( pMaxX + i ), vOriginX ), vInvDirX );
+        __m128 vEnter = _mm_max_ps( _mm_min_ps( vT1, vT2 ), _mm_setzero_ps() );
+        __m128 vExit = _mm_max_ps( vT1, vT2 );
+
+        vT1 = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( pMinY + i ), vOriginY ), vInvDirY );
+        vT2 = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( pMaxY + i ), vOriginY ), vInvDirY );
+        vEnter = _mm_max_ps( vEnter, _mm_min_ps( vT1, vT2 ) );
+        vExit = _mm_min_ps( vExit, _mm_max_ps( vT1, vT2 ) );
+
+        vT1 = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( pMinZ + i ), vOriginZ ), vInvDirZ );
+        vT2 = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( pMaxZ + i ), vOriginZ ), vInvDirZ );
+        vEnter = _mm_max_ps( vEnter, _mm_min_ps( vT1, vT2 ) );
+        vExit = _mm_min_ps( vExit, _mm_max_ps( vT1, vT2 ) );
+
+        __m128 vHit = _mm_cmple_ps( vEnter, vExit );
+        _mm_storeu_ps( pT + i, _mm_or_ps( _mm_and_ps( vHit, vEnter ), _mm_andnot_ps( vHit, vMiss ) ) );
+        nHits += CountMask( _mm_movemask_ps( vHit ) );
+    }
+    return nHits + ScalarIntersectRayAABBs( pRay, pMinX + nVectorCount, pMinY + nVectorCount, pMinZ + nVectorCount,
+                                            pMaxX + nVectorCount, pMaxY + nVectorCount, pMaxZ + nVectorCount,
+                                            nCount - nVectorCount, pT + nVectorCount );
+}
+
+//-----------------------------------------------------------------------------
+//  SSEFloatsToHalfs
+//  FloatToHalf with all three of its cases computed for every lane and
+//  the right one selected. SSE2 has no unsigned 32 to 16 bit pack, so the
+//  results are sign extended first to make the signed pack exact
+//-----------------------------------------------------------------------------
+static void SSEFloatsToHalfs( const float* pIn, uint16* pOut, uint nCount )
+{
+    __m128i vSignMask = _mm_set1_epi32( (int)0x80000000 );
+    __m128i vFloatInfinity = _mm_set1_epi32( 255 << 23 );
+    __m128i vHalfOverflow = _mm_set1_epi32( ( 127 + 16 ) << 23 );
+    __m128i vHalfNormal = _mm_set1_epi32( ( 127 - 14 ) << 23 );
+    __m128i vDenormalMagic = _mm_set1_epi32( ( ( 127 - 15 ) + ( 23 - 10 ) + 1 ) << 23 );
+    __m128i vRebias = _mm_set1_epi32( (int)( ( (uint32)( 15 - 127 ) << 23 ) + 0xFFF ) );
+    __m128i vOne = _mm_set1_epi32( 1 );
+    __m128i vHalfInfinity = _mm_set1_epi32( 0x7C00 );
+    __m128i vHalfNaN = _mm_set1_epi32( 0x7E00 );
+
+    uint nVectorCount = nCount & ~7;
+    for( uint i = 0; i < nVectorCount; i += 8 )
+    {
+        __m128i pHalfs[2];
+        for( uint j = 0; j < 2; ++j )
+        {
+            __m128i vBits = _mm_castps_si128( _mm_loadu_ps( pIn + i + j * 4 ) );
+            __m128i vSign = _mm_and_si128( vBits, vSignMask );
+            vBits = _mm_xor_si128( vBits, vSign );
+
+            __m128i vNormal = _mm_add_epi32( _mm_add_epi32( vBits, vRebias ), _mm_and_si128( _mm_srli_epi32( vBits, 13 ), vOne ) );
+            vNormal = _mm_srli_epi32( vNormal, 13 );
+            __m128i vDenormal = _mm_castps_si128( _mm_add_ps( _mm_castsi128_ps( vBits ), _mm_castsi128_ps( vDenormalMagic ) ) );
+            vDenormal = _mm_sub_epi32( vDenormal, vDenormalMagic );
+            __m128i vIsNaN = _mm_cmpgt_epi32( vBits, vFloatInfinity );
+            __m128i vOverflow = _mm_or_si128( _mm_and_si128( vIsNaN, vHalfNaN ), _mm_andnot_si128( vIsNaN, vHalfInfinity ) );
+
+            // The bits are positive now, so signed compares are fine
+            __m128i vIsDenormal = _mm_cmplt_epi32( vBits, vHalfNormal );
+            __m128i vIsOverflow = _mm_cmpgt_epi32( vHalfOverflow, vBits );
+            __m128i vHalf = _mm_or_si128( _mm_and_si128( vIsDenormal, vDenormal ), _mm_andnot_si128( vIsDenormal, vNormal ) );
+            vHalf = _mm_or_si128( _mm_and_si128( vIsOverflow, vHalf ), _mm_andnot_si128( vIsOverflow, vOverflow ) );
+            vHalf = _mm_or_si128( vHalf, _mm_srli_epi32( vSign, 16 ) );
+            pHalfs[j] = _mm_srai_epi32( _mm_slli_epi32( vHalf, 16 ), 16 );
+        }
+        _mm_storeu_si128( (__m128i*)( pOut + i ), _mm_packs_epi32( pHalfs[0], pHalfs[1] ) );
+    }
+    ScalarFloatsToHalfs( pIn + nVectorCount, pOut + nVectorCount, nCount - nVectorCount );
+}
+
+//-----------------------------------------------------------------------------
+//  SSEHalfsToFloats
+//  Shifting the half's exponent and mantissa into place and multiplying
+//  by 2^112 rebiases the exponent, and renormalizes denormals for free.
+//  Only infinity and NaN need their exponent patching
+//-----------------------------------------------------------------------------
+static void SSEHalfsToFloats( const uint16* pIn, float* pOut, uint nCount )
+{
+    __m128i vNoSign = _mm_set1_epi32( 0x7FFF );
+    __m128i vWasInfNaN = _mm_set1_epi32( 0x7BFF );
+    __m128i vInfNaNExponent = _mm_set1_epi32( 255 << 23 );
+    __m128 vRebias = _mm_castsi128_ps( _mm_set1_epi32( ( 254 - 15 ) << 23 ) );
+
+    uint nVectorCount = nCount & ~7;
+    for( uint i = 0; i < nVectorCount; i += 8 )
+    {
+        __m128i vHalfs = _mm_loadu_si128( (const __m128i*)( pIn + i ) );
+        __m128i pHalfs[2] = { _mm_unpacklo_epi16( vHalfs, _mm_setzero_si128() ), _mm_unpackhi_epi16( vHalfs, _mm_setzero_si128() ) };
+        for( uint j = 0; j < 2; ++j )
+        {
+            __m128i vExpMantissa = _mm_and_si128( pHalfs[j], vNoSign );
+            __m128i vSign = _mm_slli_epi32( _mm_xor_si128( pHalfs[j], vExpMantissa ), 16 );
+            __m128 vScaled = _mm_mul_ps( _mm_castsi128_ps( _mm_slli_epi32( vExpMantissa, 13 ) ), vRebias );
+            __m128i vInfNaN = _mm_and_si128( _mm_cmpgt_epi32( vExpMantissa, vWasInfNaN ), vInfNaNExponent );
+            _mm_storeu_ps( pOut + i + j * 4, _mm_or_ps( vScaled, _mm_castsi128_ps( _mm_or_si128( vSign, vInfNaN ) ) ) );
+        }
+    }
+    ScalarHalfsToFloats( pIn + nVectorCount, pOut + nVectorCount, nCount - nVectorCount );
+}
+
+const MathStreamKernels g_SSEKernels =
+{
+    SSETransformPoints,
+    SSEProjectPoints,
+    SSEDotProducts,
+    SSENormalize,
+    SSEMinMax,
+    SSEMultiplyMatrices,
+    SSECullSpheres,
+    SSEOverlapAABBs,
+    SSEIntersectRayAABBs,
+    SSEFloatsToHalfs,
+    SSEHalfsToFloats,
+};
+
+#endif // #if defined( RIOT_SSE )
+
+
+/**********************************************************\
+|**********************************************************|
+| Picking the kernels
+|**********************************************************|
+\**********************************************************/
+static const MathStreamKernels* g_pKernels = NULL;
+static eMathISA                 g_nISA = eMathISAScalar;
+
+//-----------------------------------------------------------------------------
+//  MathGetBestISA
+//  AVX2 needs the CPU to have AVX2, FMA and F16C, and the OS to save the
+//  YMM registers on a context switch
+//-----------------------------------------------------------------------------
+eMathISA MathGetBestISA( void )
+{
+    eMathISA nBest = eMathISAScalar;
+#if defined( RIOT_SSE )
+    nBest = eMathISASSE;
+#endif // #if defined( RIOT_SSE )
+
+#if defined( RIOT_X86 )
+    uint32 pRegisters[4] = { 0 }; // eax, ebx, ecx, edx
+    uint32 nMaxLeaf;
+#if defined( _MSC_VER )
+    __cpuid( (int*)pRegisters, 0 );
+    nMaxLeaf = pRegisters[0];
+    if( nMaxLeaf < 7 )
+        return nBest;
+    __cpuid( (int*)pRegisters, 1 );
+#else
+    nMaxLeaf = __get_cpuid_max( 0, NULL );
+    if( nMaxLeaf < 7 )
+        return nBest;
+    __cpuid( 1, pRegisters[0], pRegisters[1], pRegisters[2], pRegisters[3] );
+#endif // #if defined( _MSC_VER )
+
+    bool bOSXSave = ( pRegisters[2] & ( 1 << 27 ) ) != 0;
+    bool bAVX     = ( pRegisters[2] & ( 1 << 28 ) ) != 0;
+    bool bFMA     = ( pRegisters[2] & ( 1 << 12 ) ) != 0;
+    bool bF16C    = ( pRegisters[2] & ( 1 << 29 ) ) != 0;
+    if( !bOSXSave || !bAVX || !bFMA || !bF16C )
+        return nBest;
+
+    // XCR0 bits 1 and 2: the OS saves SSE and AVX state
+#if defined( _MSC_VER )
+    uint64 nXCR0 = _xgetbv( 0 );
+#else
+    uint32 nXCR0Low, nXCR0High;
+    __asm__ __volatile__( "xgetbv" : "=a"( nXCR0Low ), "=d"( nXCR0High ) : "c"( 0 ) );
+    uint64 nXCR0 = ( (uint64)nXCR0High << 32 ) | nXCR0Low;
+#endif // #if defined( _MSC_VER )
+    if( ( nXCR0 & 6 ) != 6 )
+        return nBest;
+
+#if defined( _MSC_VER )
+    __cpuidex( (int*)pRegisters, 7, 0 );
+#else
+    __cpuid_count( 7, 0, pRegisters[0], pRegisters[1], pRegisters[2], pRegisters[3] );
+#endif // #if defined( _MSC_VER )
+    if( pRegisters[1] & ( 1 << 5 ) )
+    {
+        nBest = eMathISAAVX2;
+    }
+#endif // #if defined( RIOT_X86 )
+
+    return nBest;
+}
+
+eMathISA MathSetISA( eMathISA nISA )
+{
+    eMathISA nBest = MathGetBestISA();
+    g_nISA = nISA < nBest ? nISA : nBest;
+#if !defined( RIOT_SSE )
+    // Without RIOT_SSE the SSE kernels aren't built
+    if( g_nISA == eMathISASSE )
+    {
+        g_nISA = eMathISAScalar;
+    }
+#endif // #if !defined( RIOT_SSE )
+
+    switch( g_nISA )
+    {
+#if defined( RIOT_X86 )
+    case eMathISAAVX2:
+        g_pKernels = &g_AVX2Kernels;
+        break;
+#endif // #if defined( RIOT_X86 )
+#if defined( RIOT_SSE )
+    case eMathISASSE:
+        g_pKernels = &g_SSEKernels;
+        break;
+#endif // #if defined( RIOT_SSE )
+    default:
+        g_pKernels = &g_ScalarKernels;
+        break;
+    }
+    return g_nISA;
+}
+
+static __forceinline const MathStreamKernels* GetKernels( void )
+{
+    if( g_pKernels == NULL )
+    {
+        MathSetISA( eNUMMATHISAS );
+    }
+    return g_pKernels;
+}
+
+eMathISA MathGetISA( void )
+{
+    GetKernels();
+    return g_nISA;
+}
+
+const char* MathGetISAName( eMathISA nISA )
+{
+    static const char* s_szNames[eNUMMATHISAS] = { "Scalar", "SSE2", "AVX2" };
+    return nISA < eNUMMATHISAS ? s_szNames[nISA] : "Unknown";
+}
+
+
+/**********************************************************\
+|**********************************************************|
+| Stream kernels
+|**********************************************************|
+\**********************************************************/
+void StreamTransformPoints( const RMatrix4x4& M, const RVec3Stream& In, RVec3Stream* pOut )
+{
+    pOut->Resize( In.GetCount() );
+    GetKernels()->pfnTransformPoints( &M._11, In.x, In.y, In.z, pOut->x, pOut->y, pOut->z, In.GetCount() );
+}
+
+void StreamProjectPoints( const RMatrix4x4& M, const float* pInX, const float* pInY, const float* pInZ,
+                          float* pOutX, float* pOutY, float* pOutZ, float* pOutW, uint nCount )
+{
+    GetKernels()->pfnProjectPoints( &M._11, pInX, pInY, pInZ, pOutX, pOutY, pOutZ, pOutW, nCount );
+}
+
+void StreamDotProducts( const RVec3Stream& A, const RVec3Stream& B, float* pOut )
+{
+    GetKernels()->pfnDotProducts( A.x, A.y, A.z, B.x, B.y, B.z, pOut, A.GetCount() );
+}
+
+void StreamNormalize( RVec3Stream* pStream )
+{
+    GetKernels()->pfnNormalize( pStream->x, pStream->y, pStream->z, pStream->GetCount() );
+}
+
+void StreamMinMax( const RVec3Stream& In, RVector3* pMin, RVector3* pMax )
+{
+    float pStreamMin[3] = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+    float pStreamMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    GetKernels()->pfnMinMax( In.x, In.y, In.z, In.GetCount(), pStreamMin, pStreamMax );
+    *pMin = RVector3( pStreamMin );
+    *pMax = RVector3( pStreamMax );
+}
+
+void StreamMultiplyMatrices( const RMatrix4x4* pA, const RMatrix4x4* pB, RMatrix4x4* pOut, uint nCount )
+{
+    GetKernels()->pfnMultiplyMatrices( &pA->_11, &pB->_11, &pOut->_11, nCount );
+}
+
+uint StreamCullSpheres( const RFrustum& Frustum, const RVec3Stream& Centers, const float* pRadii, uint8* pVisible )
+{
+    return GetKernels()->pfnCullSpheres( Frustum.Planes[0].f, Centers.x, Centers.y, Centers.z, pRadii, Centers.GetCount(), pVisible );
+}
+
+uint StreamOverlapAABBs( const RAABB& Box, const RVec3Stream& Mins, const RVec3Stream& Maxs, uint8* pOverlap )
+{
+    float pBox[6] = { Box.vMin.x, Box.vMin.y, Box.vMin.z, Box.vMax.x, Box.vMax.y, Box.vMax.z };
+    return GetKernels()->pfnOverlapAABBs( pBox, Mins.x, Mins.y, Mins.z, Maxs.x, Maxs.y, Maxs.z, Mins.GetCount(), pOverlap );
+}
+
+uint StreamIntersectRayAABBs( const RVector4& vOrigin, const RVector4& vDirection,
+                              const RVec3Stream& Mins, const RVec3Stream& Maxs, float* pT )
+{
+    float pRay[6] = { vOrigin.x, vOrigin.y, vOrigin.z, 1 / vDirection.x, 1 / vDirection.y, 1 / vDirection.z };
+    return GetKernels()->pfnIntersectRayAABBs( pRay, Mins.x, Mins.y, Mins.z, Maxs.x, Maxs.y, Maxs.z, Mins.GetCount(), pT );
+}
+
+void StreamFloatsToHalfs( const float* pIn, RHalf* pOut, uint nCount )
+{
+    GetKernels()->pfnFloatsToHalfs( pIn, pOut, nCount );
+}
+
+void StreamHalfsToFloats( const RHalf* pIn, float* pOut, uint nCount )
+{
+    GetKernels()->pfnHalfsToFloats( pIn, pOut, nCount );
+}
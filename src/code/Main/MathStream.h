@@ -0,0 +1,135 @@
+/*********************************************************\
+File:       MathStream.h
+Purpose:    Structure of arrays vectors, and math kernels
+            that work on whole streams at once
+\*********************************************************/
+#ifndef _MATHSTREAM_H_
+#define _MATHSTREAM_H_
+#include "Types.h"
+#include "RiotMath.h"
+#include "BoundingVolume.h"
+#include "PackedVector.h"
+
+//-----------------------------------------------------------------------------
+//  Instruction sets
+//  The stream kernels are picked at runtime from the best set the CPU
+//  supports. MathSetISA can force a lower one, to compare them
+//-----------------------------------------------------------------------------
+enum eMathISA
+{
+    eMathISAScalar,
+    eMathISASSE,    // SSE2, 4 wide
+    eMathISAAVX2,   // AVX2 and FMA, 8 wide
+
+    eNUMMATHISAS
+};
+
+eMathISA MathGetBestISA( void );
+eMathISA MathGetISA( void );
+const char* MathGetISAName( eMathISA nISA );
+
+//-----------------------------------------------------------------------------
+//  MathSetISA
+//  Uses nISA, or the best supported set below it. Returns the set in use
+//-----------------------------------------------------------------------------
+eMathISA MathSetISA( eMathISA nISA );
+
+//-----------------------------------------------------------------------------
+//  RVec3Stream
+//  Three separate arrays of x, y and z, so the kernels can load 4 or 8 of
+//  each at once. The arrays are 32 byte aligned and padded to a multiple
+//  of 8
+//-----------------------------------------------------------------------------
+class RVec3Stream
+{
+public:
+    // RVec3Stream constructors
+    RVec3Stream();
+    explicit RVec3Stream( uint nCount );
+
+    // RVec3Stream destructor
+    ~RVec3Stream();
+    /***************************************\
+    | class methods                         |
+    \***************************************/
+
+    //-----------------------------------------------------------------------------
+    //  Resize
+    //  Sets the number of vectors. Growing past the capacity reallocates,
+    //  and keeps the vectors that were there
+    //-----------------------------------------------------------------------------
+    void Resize( uint nCount );
+
+    //-----------------------------------------------------------------------------
+    //  Accessors/mutators
+    //-----------------------------------------------------------------------------
+    uint GetCount( void ) const { return m_nCount; }
+    RVector3 Get( uint nIndex ) const { return RVector3( x[nIndex], y[nIndex], z[nIndex] ); }
+    void Set( uint nIndex, const RVector3& V ) { x[nIndex] = V.x; y[nIndex] = V.y; z[nIndex] = V.z; }
+
+    /***************************************\
+    | class members                         |
+    \***************************************/
+    float*  x;
+    float*  y;
+    float*  z;
+
+private:
+    RVec3Stream( const RVec3Stream& );
+    RVec3Stream& operator=( const RVec3Stream& );
+
+    uint    m_nCount;
+    uint    m_nCapacity;
+};
+
+//-----------------------------------------------------------------------------
+//  Stream kernels
+//  Outputs are resized to match the input, and may be the input itself
+//-----------------------------------------------------------------------------
+
+// Transforms points (w = 1) by an affine matrix
+void StreamTransformPoints( const RMatrix4x4& M, const RVec3Stream& In, RVec3Stream* pOut );
+// Transforms points (w = 1) by a full matrix, eg: a world view projection,
+// and keeps w. This one works on plain arrays of nCount floats, so a vertex
+// buffer can be split up between threads
+void StreamProjectPoints( const RMatrix4x4& M, const float* pInX, const float* pInY, const float* pInZ,
+                          float* pOutX, float* pOutY, float* pOutZ, float* pOutW, uint nCount );
+
+// pOut[i] = A[i] . B[i]. pOut holds at least A.GetCount() floats
+void StreamDotProducts( const RVec3Stream& A, const RVec3Stream& B, float* pOut );
+
+// Normalizes every vector in place
+void StreamNormalize( RVec3Stream* pStream );
+
+// The smallest and largest x, y and z in the stream, eg: a bounding box
+void StreamMinMax( const RVec3Stream& In, RVector3* pMin, RVector3* pMax );
+
+// pOut[i] = pA[i] * pB[i]
+void StreamMultiplyMatrices( const RMatrix4x4* pA, const RMatrix4x4* pB, RMatrix4x4* pOut, uint nCount );
+
+//-----------------------------------------------------------------------------
+//  Batch intersection tests
+//  Each returns how many passed, and writes one result per element: 1 or 0
+//  for the culling and overlap tests, and for the ray, how far along
+//  vDirection it enters each box, 0 if it starts inside, or -1 if it misses
+//-----------------------------------------------------------------------------
+
+// Spheres at Centers[i] with radius pRadii[i], against the frustum
+uint StreamCullSpheres( const RFrustum& Frustum, const RVec3Stream& Centers, const float* pRadii, uint8* pVisible );
+
+// Boxes from Mins[i] to Maxs[i], against Box
+uint StreamOverlapAABBs( const RAABB& Box, const RVec3Stream& Mins, const RVec3Stream& Maxs, uint8* pOverlap );
+
+// A ray from vOrigin along vDirection, against boxes from Mins[i] to Maxs[i]
+uint StreamIntersectRayAABBs( const RVector4& vOrigin, const RVector4& vDirection,
+                              const RVec3Stream& Mins, const RVec3Stream& Maxs, float* pT );
+
+//-----------------------------------------------------------------------------
+//  Half float conversion
+//  The same results as FloatToHalf and HalfToFloat, for whole arrays, eg:
+//  vertex data. pIn and pOut can't overlap
+//-----------------------------------------------------------------------------
+void StreamFloatsToHalfs( const float* pIn, RHalf* pOut, uint nCount );
+void StreamHalfsToFloats( const RHalf* pIn, float* pOut, uint nCount );
+
+#endif // #ifndef _MATHSTREAM_H_
@@ -0,0 +1,299 @@
+/*********************************************************\
+File:       MathStreamAVX2.cpp
+Purpose:    AVX2 stream kernels, 8 at a time. Only called
+            when MathGetBestISA finds AVX2, so nothing in
+            here can be shared with the rest of the engine:
+            it only includes MathStreamKernels.h
+\*********************************************************/
+#include "MathStreamKernels.h"
+
+#if defined( RIOT_X86 )
+
+// MSVC emits AVX intrinsics without /arch. GCC and clang have to be told
+#if !defined( _MSC_VER )
+#pragma GCC target( "avx2,fma,f16c" )
+#endif // #if !defined( _MSC_VER )
+
+#include <immintrin.h>
+
+static void AVX2TransformPoints( const float* pMatrix, const float* pInX, const float* pInY, const float* pInZ,
+                                 float* pOutX, float* pOutY, float* pOutZ, uint nCount )
+{
+    __m256 v11 = _mm256_set1_ps( pMatrix[0] ), v12 = _mm256_set1_ps( pMatrix[1] ), v13 = _mm256_set1_ps( pMatrix[2] );
+    __m256 v21 = _mm256_set1_ps( pMatrix[4] ), v22 = _mm256_set1_ps( pMatrix[5] ), v23 = _mm256_set1_ps( pMatrix[6] );
+    __m256 v31 = _mm256_set1_ps( pMatrix[8] ), v32 = _mm256_set1_ps( pMatrix[9] ), v33 = _mm256_set1_ps( pMatrix[10] );
+    __m256 v41 = _mm256_set1_ps( pMatrix[12] ), v42 = _mm256_set1_ps( pMatrix[13] ), v43 = _mm256_set1_ps( pMatrix[14] );
+
+    uint nVectorCount = nCount & ~7;
+    for( uint i = 0; i < nVectorCount; i += 8 )
+    {
+        __m256 vX = _mm256_loadu_ps( pInX + i ), vY = _mm256_loadu_ps( pInY + i ), vZ = _mm256_loadu_ps( pInZ + i );
+        __m256 vOutX = _mm256_fmadd_ps( vX, v11, _mm256_fmadd_ps( vY, v21, _mm256_fmadd_ps( vZ, v31, v41 ) ) );
+        __m256 vOutY = _mm256_fmadd_ps( vX, v12, _mm256_fmadd_ps( vY, v22, _mm256_fmadd_ps( vZ, v32, v42 ) ) );
+        __m256 vOutZ = _mm256_fmadd_ps( vX, v13, _mm256_fmadd_ps( vY, v23, _mm256_fmadd_ps( vZ, v33, v43 ) ) );
+        _mm256_storeu_ps( pOutX + i, vOutX );
+        _mm256_storeu_ps( pOutY + i, vOutY );
+        _mm256_storeu_ps( pOutZ + i, vOutZ );
+    }
+    g_ScalarKernels.pfnTransformPoints( pMatrix, pInX + nVectorCount, pInY + nVectorCount, pInZ + nVectorCount,
+                                        pOutX + nVectorCount, pOutY + nVectorCount, pOutZ + nVectorCount, nCount - nVectorCount );
+}
+
+static void AVX2ProjectPoints( const float* pMatrix, const float* pInX, const float* pInY, const float* pInZ,
+                               float* pOutX, float* pOutY, float* pOutZ, float* pOutW, uint nCount )
+{
+    __m256 v11 = _mm256_set1_ps( pMatrix[0] ),  v12 = _mm256_set1_ps( pMatrix[1] ),  v13 = _mm256_set1_ps( pMatrix[2] ),  v14 = _mm256_set1_ps( pMatrix[3] );
+    __m256 v21 = _mm256_set1_ps( pMatrix[4] ),  v22 = _mm256_set1_ps( pMatrix[5] ),  v23 = _mm256_set1_ps( pMatrix[6] ),  v24 = _mm256_set1_ps( pMatrix[7] );
+    __m256 v31 = _mm256_set1_ps( pMatrix[8] ),  v32 = _mm256_set1_ps( pMatrix[9] ),  v33 = _mm256_set1_ps( pMatrix[10] ), v34 = _mm256_set1_ps( pMatrix[11] );
+    __m256 v41 = _mm256_set1_ps( pMatrix[12] ), v42 = _mm256_set1_ps( pMatrix[13] ), v43 = _mm256_set1_ps( pMatrix[14] ), v44 = _mm256_set1_ps( pMatrix[15] );
+
+    uint nVectorCount = nCount & ~7;
+    for( uint i = 0; i < nVectorCount; i += 8 )
+    {
+        __m256 vX = _mm256_loadu_ps( pInX + i ), vY = _mm256_loadu_ps( pInY + i ), vZ = _mm256_loadu_ps( pInZ + i );
+        _mm256_storeu_ps( pOutX + i, _mm256_fmadd_ps( vX, v11, _mm256_fmadd_ps( vY, v21, _mm256_fmadd_ps( vZ, v31, v41 ) ) ) );
+        _mm256_storeu_ps( pOutY + i, _mm256_fmadd_ps( vX, v12, _mm256_fmadd_ps( vY, v22, _mm256_fmadd_ps( vZ, v32, v42 ) ) ) );
+        _mm256_storeu_ps( pOutZ + i, _mm256_fmadd_ps( vX, v13, _mm256_fmadd_ps( vY, v23, _mm256_fmadd_ps( vZ, v33, v43 ) ) ) );
+        _mm256_storeu_ps( pOutW + i, _mm256_fmadd_ps( vX, v14, _mm256_fmadd_ps( vY, v24, _mm256_fmadd_ps( vZ, v34, v44 ) ) ) );
+    }
+    g_ScalarKernels.pfnProjectPoints( pMatrix, pInX + nVectorCount, pInY + nVectorCount, pInZ + nVectorCount,
+                                      pOutX + nVectorCount, pOutY + nVectorCount, pOutZ + nVectorCount, pOutW + nVectorCount,
+                                      nCount - nVectorCount );
+}
+
+static void AVX2DotProducts( const float* pAX, const float* pAY, const float* pAZ,
+                             const float* pBX, const float* pBY, const float* pBZ, float* pOut, uint nCount )
+{
+    uint nVectorCount = nCount & ~7;
+    for( uint i = 0; i < nVectorCount; i += 8 )
+    {
+        __m256 vDot = _mm256_mul_ps( _mm256_loadu_ps( pAX + i ), _mm256_loadu_ps( pBX + i ) );
+        vDot = _mm256_fmadd_ps( _mm256_loadu_ps( pAY + i ), _mm256_loadu_ps( pBY + i ), vDot );
+        vDot = _mm256_fmadd_ps( _mm256_loadu_ps( pAZ + i ), _mm256_loadu_ps( pBZ + i ), vDot );
+        _mm256_storeu_ps( pOut + i, vDot );
+    }
+    g_ScalarKernels.pfnDotProducts( pAX + nVectorCount, pAY + nVectorCount, pAZ + nVectorCount,
+                                    pBX + nVectorCount, pBY + nVectorCount, pBZ + nVectorCount, pOut + nVectorCount, nCount - nVectorCount );
+}
+
+static void AVX2Normalize( float* pX, float* pY, float* pZ, uint nCount )
+{
+    __m256 vOne = _mm256_set1_ps( 1.0f );
+    uint nVectorCount = nCount & ~7;
+    for( uint i = 0; i < nVectorCount; i += 8 )
+    {
+        __m256 vX = _mm256_loadu_ps( pX + i ), vY = _mm256_loadu_ps( pY + i ), vZ = _mm256_loadu_ps( pZ + i );
+        __m256 vLengthSq = _mm256_fmadd_ps( vX, vX, _mm256_fmadd_ps( vY, vY, _mm256_mul_ps( vZ, vZ ) ) );
+        __m256 vRecip = _mm256_div_ps( vOne, _mm256_sqrt_ps( vLengthSq ) );
+        _mm256_storeu_ps( pX + i, _mm256_mul_ps( vX, vRecip ) );
+        _mm256_storeu_ps( pY + i, _mm256_mul_ps( vY, vRecip ) );
+        _mm256_storeu_ps( pZ + i, _mm256_mul_ps( vZ, vRecip ) );
+    }
+    g_ScalarKernels.pfnNormalize( pX + nVectorCount, pY + nVectorCount, pZ + nVectorCount, nCount - nVectorCount );
+}
+
+static float HorizontalMin( __m256 v )
+{
+    __m128 v4 = _mm_min_ps( _mm256_castps256_ps128( v ), _mm256_extractf128_ps( v, 1 ) );
+    v4 = _mm_min_ps( v4, _mm_shuffle_ps( v4, v4, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+    v4 = _mm_min_ps( v4, _mm_shuffle_ps( v4, v4, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+    return _mm_cvtss_f32( v4 );
+}
+
+static float HorizontalMax( __m256 v )
+{
+    __m128 v4 = _mm_max_ps( _mm256_castps256_ps128( v ), _mm256_extractf128_ps( v, 1 ) );
+    v4 = _mm_max_ps( v4, _mm_shuffle_ps( v4, v4, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+    v4 = _mm_max_ps( v4, _mm_shuffle_ps( v4, v4, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+    return _mm_cvtss_f32( v4 );
+}
+
+static void AVX2MinMax( const float* pX, const float* pY, const float* pZ, uint nCount, float* pMin, float* pMax )
+{
+    __m256 vMinX = _mm256_set1_ps( pMin[0] ), vMinY = _mm256_set1_ps( pMin[1] ), vMinZ = _mm256_set1_ps( pMin[2] );
+    __m256 vMaxX = _mm256_set1_ps( pMax[0] ), vMaxY = _mm256_set1_ps( pMax[1] ), vMaxZ = _mm256_set1_ps( pMax[2] );
+
+    uint nVectorCount = nCount & ~7;
+    for( uint i = 0; i < nVectorCount; i += 8 )
+    {
+        __m256 vX = _mm256_loadu_ps( pX + i ), vY = _mm256_loadu_ps( pY + i ), vZ = _mm256_loadu_ps( pZ + i );
+        vMinX = _mm256_min_ps( vMinX, vX ); vMaxX = _mm256_max_ps( vMaxX, vX );
+        vMinY = _mm256_min_ps( vMinY, vY ); vMaxY = _mm256_max_ps( vMaxY, vY );
+        vMinZ = _mm256_min_ps( vMinZ, vZ ); vMaxZ = _mm256_max_ps( vMaxZ, vZ );
+    }
+    pMin[0] = HorizontalMin( vMinX ); pMin[1] = HorizontalMin( vMinY ); pMin[2] = HorizontalMin( vMinZ );
+    pMax[0] = HorizontalMax( vMaxX ); pMax[1] = HorizontalMax( vMaxY ); pMax[2] = HorizontalMax( vMaxZ );
+    g_ScalarKernels.pfnMinMax( pX + nVectorCount, pY + nVectorCount, pZ + nVectorCount, nCount - nVectorCount, pMin, pMax );
+}
+
+//-----------------------------------------------------------------------------
+//  AVX2MultiplyMatrices
+//  Two rows of A at a time: each 128 bit half of a register holds one
+//  row, and the rows of B are copied into both halves
+//-----------------------------------------------------------------------------
+static void AVX2MultiplyMatrices( const float* pA, const float* pB, float* pOut, uint nCount )
+{
+    for( uint n = 0; n < nCount; ++n, pA += 16, pB += 16, pOut += 16 )
+    {
+        __m256 vB0 = _mm256_broadcast_ps( (const __m128*)pB );
+        __m256 vB1 = _mm256_broadcast_ps( (const __m128*)( pB + 4 ) );
+        __m256 vB2 = _mm256_broadcast_ps( (const __m128*)( pB + 8 ) );
+        __m256 vB3 = _mm256_broadcast_ps( (const __m128*)( pB + 12 ) );
+        // Loaded up front, so pOut can be pA
+        __m256 vRows01 = _mm256_loadu_ps( pA );
+        __m256 vRows23 = _mm256_loadu_ps( pA + 8 );
+
+        __m256 vResult = _mm256_mul_ps( _mm256_shuffle_ps( vRows01, vRows01, 0x00 ), vB0 );
+        vResult = _mm256_fmadd_ps( _mm256_shuffle_ps( vRows01, vRows01, 0x55 ), vB1, vResult );
+        vResult = _mm256_fmadd_ps( _mm256_shuffle_ps( vRows01, vRows01, 0xAA ), vB2, vResult );
+        vResult = _mm256_fmadd_ps( _mm256_shuffle_ps( vRows01, vRows01, 0xFF ), vB3, vResult );
+        _mm256_storeu_ps( pOut, vResult );
+
+        vResult = _mm256_mul_ps( _mm256_shuffle_ps( vRows23, vRows23, 0x00 ), vB0 );
+        vResult = _mm256_fmadd_ps( _mm256_shuffle_ps( vRows23, vRows23, 0x55 ), vB1, vResult );
+        vResult = _mm256_fmadd_ps( _mm256_shuffle_ps( vRows23, vRows23, 0xAA ), vB2, vResult );
+        vResult = _mm256_fmadd_ps( _mm256_shuffle_ps( vRows23, vRows23, 0xFF ), vB3, vResult );
+        _mm256_storeu_ps( pOut + 8, vResult );
+    }
+}
+
+// How many lanes of a movemask are set
+static uint CountMask( uint nMask )
+{
+    uint nCount = 0;
+    for( ; nMask; nMask &= nMask - 1 )
+    {
+        ++nCount;
+    }
+    return nCount;
+}
+
+// One byte per lane of a movemask
+static uint StoreMask( uint nMask, uint8* pOut )
+{
+    for( uint i = 0; i < 8; ++i )
+    {
+        pOut[i] = ( nMask >> i ) & 1;
+    }
+    return CountMask( nMask );
+}
+
+static uint AVX2CullSpheres( const float* pPlanes, const float* pX, const float* pY, const float* pZ,
+                             const float* pRadius, uint nCount, uint8* pVisible )
+{
+    uint nVisible = 0;
+    uint nVectorCount = nCount & ~7;
+    for( uint i = 0; i < nVectorCount; i += 8 )
+    {
+        __m256 vX = _mm256_loadu_ps( pX + i ), vY = _mm256_loadu_ps( pY + i ), vZ = _mm256_loadu_ps( pZ + i );
+        __m256 vNegRadius = _mm256_sub_ps( _mm256_setzero_ps(), _mm256_loadu_ps( pRadius + i ) );
+        __m256 vInside = _mm256_castsi256_ps( _mm256_set1_epi32( -1 ) );
+        for( const float* pPlane = pPlanes; pPlane < pPlanes + 24; pPlane += 4 )
+        {
+            __m256 vDistance = _mm256_fmadd_ps( vX, _mm256_set1_ps( pPlane[0] ), _mm256_set1_ps( pPlane[3] ) );
+            vDistance = _mm256_fmadd_ps( vY, _mm256_set1_ps( pPlane[1] ), vDistance );
+            vDistance = _mm256_fmadd_ps( vZ, _mm256_set1_ps( pPlane[2] ), vDistance );
+            vInside = _mm256_and_ps( vInside, _mm256_cmp_ps( vDistance, vNegRadius, _CMP_GE_OQ ) );
+        }
+        nVisible += StoreMask( _mm256_movemask_ps( vInside ), pVisible + i );
+    }
+    return nVisible + g_ScalarKernels.pfnCullSpheres( pPlanes, pX + nVectorCount, pY + nVectorCount, pZ + nVectorCount,
+                                                      pRadius + nVectorCount, nCount - nVectorCount, pVisible + nVectorCount );
+}
+
+static uint AVX2OverlapAABBs( const float* pBox, const float* pMinX, const float* pMinY, const float* pMinZ,
+                              const float* pMaxX, const float* pMaxY, const float* pMaxZ, uint nCount, uint8* pOverlap )
+{
+    __m256 vBoxMinX = _mm256_set1_ps( pBox[0] ), vBoxMinY = _mm256_set1_ps( pBox[1] ), vBoxMinZ = _mm256_set1_ps( pBox[2] );
+    __m256 vBoxMaxX = _mm256_set1_ps( pBox[3] ), vBoxMaxY = _mm256_set1_ps( pBox[4] ), vBoxMaxZ = _mm256_set1_ps( pBox[5] );
+
+    uint nOverlapping = 0;
+    uint nVectorCount = nCount & ~7;
+    for( uint i = 0; i < nVectorCount; i += 8 )
+    {
+        __m256 vOverlap = _mm256_and_ps( _mm256_cmp_ps( _mm256_loadu_ps( pMinX + i ), vBoxMaxX, _CMP_LE_OQ ),
+                                         _mm256_cmp_ps( vBoxMinX, _mm256_loadu_ps( pMaxX + i ), _CMP_LE_OQ ) );
+        vOverlap = _mm256_and_ps( vOverlap, _mm256_cmp_ps( _mm256_loadu_ps( pMinY + i ), vBoxMaxY, _CMP_LE_OQ ) );
+        vOverlap = _mm256_and_ps( vOverlap, _mm256_cmp_ps( vBoxMinY, _mm256_loadu_ps( pMaxY + i ), _CMP_LE_OQ ) );
+        vOverlap = _mm256_and_ps( vOverlap, _mm256_cmp_ps( _mm256_loadu_ps( pMinZ + i ), vBoxMaxZ, _CMP_LE_OQ ) );
+        vOverlap = _mm256_and_ps( vOverlap, _mm256_cmp_ps( vBoxMinZ, _mm256_loadu_ps( pMaxZ + i ), _CMP_LE_OQ ) );
+        nOverlapping += StoreMask( _mm256_movemask_ps( vOverlap ), pOverlap + i );
+    }
+    return nOverlapping + g_ScalarKernels.pfnOverlapAABBs( pBox, pMinX + nVectorCount, pMinY + nVectorCount, pMinZ + nVectorCount,
+                                                           pMaxX + nVectorCount, pMaxY + nVectorCount, pMaxZ + nVectorCount,
+                                                           nCount - nVectorCount, pOverlap + nVectorCount );
+}
+
+static uint AVX2IntersectRayAABBs( const float* pRay, const float* pMinX, const float* pMinY, const float* pMinZ,
+                                   const float* pMaxX, const float* pMaxY, const float* pMaxZ, uint nCount, float* pT )
+{
+    __m256 vOriginX = _mm256_set1_ps( pRay[0] ), vOriginY = _mm256_set1_ps( pRay[1] ), vOriginZ = _mm256_set1_ps( pRay[2] );
+    __m256 vInvDirX = _mm256_set1_ps( pRay[3] ), vInvDirY = _mm256_set1_ps( pRay[4] ), vInvDirZ = _mm256_set1_ps( pRay[5] );
+    __m256 vMiss = _mm256_set1_ps( -1.0f );
+
+    uint nHits = 0;
+    uint nVectorCount = nCount & ~7;
+    for( uint i = 0; i < nVectorCount; i += 8 )
+    {
+        __m256 vT1 = _mm256_mul_ps( _mm256_sub_ps( _mm256_loadu_ps( pMinX + i ), vOriginX ), vInvDirX );
+        __m256 vT2 = _mm256_mul_ps( _mm256_sub_ps( _mm256_loadu_ps( pMaxX + i ), vOriginX ), vInvDirX );
+        __m256 vEnter = _mm256_max_ps( _mm256_min_ps( vT1, vT2 ), _mm256_setzero_ps() );
+        __m256 vExit = _mm256_max_ps( vT1, vT2 );
+
+        vT1 = _mm256_mul_ps( _mm256_sub_ps( _mm256_loadu_ps( pMinY + i ), vOriginY ), vInvDirY );
+        vT2 = _mm256_mul_ps( _mm256_sub_ps( _mm256_loadu_ps( pMaxY + i ), vOriginY ), vInvDirY );
+        vEnter = _mm256_max_ps( vEnter, _mm256_min_ps( vT1, vT2 ) );
+        vExit = _mm256_min_ps( vExit, _mm256_max_ps( vT1, vT2 ) );
+
+        vT1 = _mm256_mul_ps( _mm256_sub_ps( _mm256_loadu_ps( pMinZ + i ), vOriginZ ), vInvDirZ );
+        vT2 = _mm256_mul_ps( _mm256_sub_ps( _mm256_loadu_ps( pMaxZ + i ), vOriginZ ), vInvDirZ );
+        vEnter = _mm256_max_ps( vEnter, _mm256_min_ps( vT1, vT2 ) );
+        vExit = _mm256_min_ps( vExit, _mm256_max_ps( vT1, vT2 ) );
+
+        __m256 vHit = _mm256_cmp_ps( vEnter, vExit, _CMP_LE_OQ );
+        _mm256_storeu_ps( pT + i, _mm256_blendv_ps( vMiss, vEnter, vHit ) );
+        nHits += CountMask( _mm256_movemask_ps( vHit ) );
+    }
+    return nHits + g_ScalarKernels.pfnIntersectRayAABBs( pRay, pMinX + nVectorCount, pMinY + nVectorCount, pMinZ + nVectorCount,
+                                                         pMaxX + nVectorCount, pMaxY + nVectorCount, pMaxZ + nVectorCount,
+                                                         nCount - nVectorCount, pT + nVectorCount );
+}
+
+// F16C, which MathGetBestISA checks for along with AVX2
+static void AVX2FloatsToHalfs( const float* pIn, uint16* pOut, uint nCount )
+{
+    uint nVectorCount = nCount & ~7;
+    for( uint i = 0; i < nVectorCount; i += 8 )
+    {
+        __m128i vHalfs = _mm256_cvtps_ph( _mm256_loadu_ps( pIn + i ), _MM_FROUND_TO_NEAREST_INT );
+        _mm_storeu_si128( (__m128i*)( pOut + i ), vHalfs );
+    }
+    g_ScalarKernels.pfnFloatsToHalfs( pIn + nVectorCount, pOut + nVectorCount, nCount - nVectorCount );
+}
+
+static void AVX2HalfsToFloats( const uint16* pIn, float* pOut, uint nCount )
+{
+    uint nVectorCount = nCount & ~7;
+    for( uint i = 0; i < nVectorCount; i += 8 )
+    {
+        _mm256_storeu_ps( pOut + i, _mm256_cvtph_ps( _mm_loadu_si128( (const __m128i*)( pIn + i ) ) ) );
+    }
+    g_ScalarKernels.pfnHalfsToFloats( pIn + nVectorCount, pOut + nVectorCount, nCount - nVectorCount );
+}
+
+const MathStreamKernels g_AVX2Kernels =
+{
+    AVX2TransformPoints,
+    AVX2ProjectPoints,
+    AVX2DotProducts,
+    AVX2Normalize,
+    AVX2MinMax,
+    AVX2MultiplyMatrices,
+    AVX2CullSpheres,
+    AVX2OverlapAABBs,
+    AVX2IntersectRayAABBs,
+    AVX2FloatsToHalfs,
+    AVX2HalfsToFloats,
+};
+
+#endif // #if defined( RIOT_X86 )
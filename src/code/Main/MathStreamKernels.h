@@ -0,0 +1,55 @@
+/*********************************************************\
+File:       MathStreamKernels.h
+Purpose:    The stream kernel table, shared by the
+            instruction set specific files. Only raw
+            floats cross it, so those files don't need
+            RiotMath's inline functions
+\*********************************************************/
+#ifndef _MATHSTREAMKERNELS_H_
+#define _MATHSTREAMKERNELS_H_
+#include "Types.h"
+
+#if defined( _M_IX86 ) || defined( _M_X64 ) || defined( __i386__ ) || defined( __x86_64__ )
+#define RIOT_X86
+#endif
+
+struct MathStreamKernels
+{
+    // pMatrix is 16 floats, a row at a time
+    void (*pfnTransformPoints)( const float* pMatrix, const float* pInX, const float* pInY, const float* pInZ,
+                                float* pOutX, float* pOutY, float* pOutZ, uint nCount );
+    // The same, with the matrix's last column too, keeping w
+    void (*pfnProjectPoints)( const float* pMatrix, const float* pInX, const float* pInY, const float* pInZ,
+                              float* pOutX, float* pOutY, float* pOutZ, float* pOutW, uint nCount );
+    void (*pfnDotProducts)( const float* pAX, const float* pAY, const float* pAZ,
+                            const float* pBX, const float* pBY, const float* pBZ, float* pOut, uint nCount );
+    void (*pfnNormalize)( float* pX, float* pY, float* pZ, uint nCount );
+    // pMin and pMax are 3 floats, and are only lowered/raised
+    void (*pfnMinMax)( const float* pX, const float* pY, const float* pZ, uint nCount, float* pMin, float* pMax );
+    void (*pfnMultiplyMatrices)( const float* pA, const float* pB, float* pOut, uint nCount );
+    // pPlanes is 6 planes of 4 floats. These three return how many of
+    // the nCount tests passed
+    uint (*pfnCullSpheres)( const float* pPlanes, const float* pX, const float* pY, const float* pZ,
+                            const float* pRadius, uint nCount, uint8* pVisible );
+    // pBox is the min corner, then the max corner
+    uint (*pfnOverlapAABBs)( const float* pBox, const float* pMinX, const float* pMinY, const float* pMinZ,
+                             const float* pMaxX, const float* pMaxY, const float* pMaxZ, uint nCount, uint8* pOverlap );
+    // pRay is the origin, then 1 / direction
+    uint (*pfnIntersectRayAABBs)( const float* pRay, const float* pMinX, const float* pMinY, const float* pMinZ,
+                                  const float* pMaxX, const float* pMaxY, const float* pMaxZ, uint nCount, float* pT );
+    // IEEE half floats, as uint16s. Rounds to nearest even
+    void (*pfnFloatsToHalfs)( const float* pIn, uint16* pOut, uint nCount );
+    void (*pfnHalfsToFloats)( const uint16* pIn, float* pOut, uint nCount );
+};
+
+//-----------------------------------------------------------------------------
+//  The kernels for each set. The vector versions hand their leftovers to
+//  the scalar ones
+//-----------------------------------------------------------------------------
+extern const MathStreamKernels g_ScalarKernels;
+extern const MathStreamKernels g_SSEKernels;     // Only built with RIOT_SSE
+#if defined( RIOT_X86 )
+extern const MathStreamKernels g_AVX2Kernels;
+#endif // #if defined( RIOT_X86 )
+
+#endif // #ifndef _MATHSTREAMKERNELS_H_
@@ -7,139 +7,852 @@ Purpose:    Memory allocation/tracking
 #include <string.h>
 #include <stdio.h> // For printf
 #include "Memory.h"
+#include "HeapProfiler.h"
+#include "CallStack.h"
+#include "Atomic.h"
+#if !defined( _MSC_VER )
+#include <signal.h> // For raise
+#endif // #if !defined( _MSC_VER )
+
+//-----------------------------------------------------------------------------
+//  Memory categories
+//-----------------------------------------------------------------------------
+static THREAD_LOCAL eMemoryCategory gs_nCurrentMemoryCategory = eMemoryCategoryGeneral;
+
+static const char* gs_szMemoryCategoryNames[eNUMMEMORYCATEGORIES] =
+{
+    "General",
+    "Scene",
+    "Gfx",
+    "UI",
+    "Terrain",
+    "Components",
+    "Assets",
+};
+
+eMemoryCategory __cdecl GetMemoryCategory( void )
+{
+    return gs_nCurrentMemoryCategory;
+}
+
+void __cdecl SetMemoryCategory( eMemoryCategory nCategory )
+{
+    gs_nCurrentMemoryCategory = nCategory;
+}
+
+const char* __cdecl GetMemoryCategoryName( eMemoryCategory nCategory )
+{
+    return gs_szMemoryCategoryNames[nCategory];
+}
+
+//-----------------------------------------------------------------------------
+//  Charged memory
+//  Memory that didn't come through the global operator new, added onto the
+//  category counters whenever they're read
+//-----------------------------------------------------------------------------
+static volatile sint64 gs_pChargedBytes[eNUMMEMORYCATEGORIES];
+static volatile sint64 gs_pChargedAllocations[eNUMMEMORYCATEGORIES];
+
+void __cdecl ChargeMemoryCategory( eMemoryCategory nCategory, size_t nSize )
+{
+    AtomicAdd64( &gs_pChargedBytes[nCategory], (sint64)nSize );
+    AtomicAdd64( &gs_pChargedAllocations[nCategory], 1 );
+}
+
+static void AddChargedCounters( MemoryCategoryStats* pCategories )
+{
+    for( uint nCategory = 0; nCategory < eNUMMEMORYCATEGORIES; ++nCategory )
+    {
+        sint64 nBytes = AtomicAdd64( &gs_pChargedBytes[nCategory], 0 );
+        sint64 nAllocations = AtomicAdd64( &gs_pChargedAllocations[nCategory], 0 );
+        pCategories[nCategory].nBytesLive += nBytes;
+        pCategories[nCategory].nAllocationsLive += nAllocations;
+        pCategories[nCategory].nTotalAllocations += (uint64)nAllocations;
+        pCategories[nCategory].nTotalBytesAllocated += (uint64)nBytes;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//  Frame allocation checker
+//  MemoryBeginFrame arms the checker once the warm-up is over and
+//  MemoryEndFrame disarms it, so outside of a frame (loading, shutdown) the
+//  allocators only pay for one extra branch. Only the first few offenders of
+//  a frame get a call stack, the rest are just counted
+//-----------------------------------------------------------------------------
+static const uint gs_nMaxFrameAllocReports  = 4;
+static const uint gs_nFrameAllocStackDepth  = 16;
+
+static volatile bool        gs_bFrameAllocCheckArmed = false;
+static eFrameAllocCheck     gs_nFrameAllocCheckMode = eFrameAllocCheckOff;
+static uint                 gs_nFrameAllocWarmupFrames = 0;
+static uint                 gs_nFrameAllocCheckFrame = 0;
+static volatile sint32      gs_nFrameAllocsThisFrame = 0;
+static volatile sint64      gs_nFrameAllocViolations = 0;
+static THREAD_LOCAL uint    gs_nAllowFrameAllocations = 0;
+static THREAD_LOCAL bool    gs_bInFrameAllocReport = false;
+
+static void ReportFrameAllocation( size_t nSize, const char* szFile, uint nLine )
+{
+    if( gs_nAllowFrameAllocations != 0 || gs_bInFrameAllocReport )
+        return;
+    gs_bInFrameAllocReport = true;
+
+    AtomicAdd64( &gs_nFrameAllocViolations, 1 );
+    sint32 nThisFrame = AtomicIncrement( &gs_nFrameAllocsThisFrame );
+    if( nThisFrame <= (sint32)gs_nMaxFrameAllocReports )
+    {
+        if( szFile )
+        {
+            printf( "Frame allocation: %u bytes in frame %u at %s(%d)\n",
+                    (uint)nSize, gs_nFrameAllocCheckFrame, szFile, nLine );
+        }
+        else
+        {
+            printf( "Frame allocation: %u bytes in frame %u\n", (uint)nSize, gs_nFrameAllocCheckFrame );
+        }
+
+        // Skip this function, which leaves operator new on top
+        void* pFrames[gs_nFrameAllocStackDepth];
+        uint nDepth = CaptureCallStack( pFrames, gs_nFrameAllocStackDepth, 1 );
+        char szName[ 256 ];
+        for( uint nFrame = 0; nFrame < nDepth; ++nFrame )
+        {
+            GetCallStackFrameName( pFrames[nFrame], szName, sizeof( szName ) );
+            printf( "    %s\n", szName );
+        }
+    }
+
+    if( gs_nFrameAllocCheckMode == eFrameAllocCheckBreak )
+    {
+#if defined( _MSC_VER )
+        __debugbreak();
+#else
+        raise( SIGTRAP );
+#endif // #if defined( _MSC_VER )
+    }
+    gs_bInFrameAllocReport = false;
+}
+
+static __forceinline void CheckFrameAllocation( size_t nSize, const char* szFile, uint nLine )
+{
+    if( gs_bFrameAllocCheckArmed )
+    {
+        ReportFrameAllocation( nSize, szFile, nLine );
+    }
+}
+
+void __cdecl SetFrameAllocCheck( eFrameAllocCheck nMode, uint nWarmupFrames )
+{
+    if( nMode != eFrameAllocCheckOff )
+    {
+        InitializeCallStacks();
+    }
+    gs_bFrameAllocCheckArmed = false;
+    gs_nFrameAllocCheckMode = nMode;
+    gs_nFrameAllocWarmupFrames = nWarmupFrames;
+    gs_nFrameAllocCheckFrame = 0;
+    gs_nFrameAllocViolations = 0;
+}
+
+void __cdecl MemoryBeginFrame( void )
+{
+    gs_nFrameAllocsThisFrame = 0;
+    gs_bFrameAllocCheckArmed = gs_nFrameAllocCheckMode != eFrameAllocCheckOff
+                            && gs_nFrameAllocCheckFrame >= gs_nFrameAllocWarmupFrames;
+}
+
+//-----------------------------------------------------------------------------
+//  FrameAllocCheckEndFrame
+//  Disarms the checker until the next MemoryBeginFrame
+//-----------------------------------------------------------------------------
+static void FrameAllocCheckEndFrame( void )
+{
+    if( gs_bFrameAllocCheckArmed && gs_nFrameAllocsThisFrame > (sint32)gs_nMaxFrameAllocReports )
+    {
+        printf( "Frame allocation: %d more in frame %u\n",
+                gs_nFrameAllocsThisFrame - (sint32)gs_nMaxFrameAllocReports, gs_nFrameAllocCheckFrame );
+    }
+    gs_bFrameAllocCheckArmed = false;
+    if( gs_nFrameAllocCheckMode != eFrameAllocCheckOff )
+    {
+        ++gs_nFrameAllocCheckFrame;
+    }
+}
+
+uint64 __cdecl GetFrameAllocViolations( void )
+{
+    return (uint64)AtomicAdd64( &gs_nFrameAllocViolations, 0 );
+}
+
+CAllowFrameAllocations::CAllowFrameAllocations()
+{
+    ++gs_nAllowFrameAllocations;
+}
+
+CAllowFrameAllocations::~CAllowFrameAllocations()
+{
+    --gs_nAllowFrameAllocations;
+}
 
 #ifdef DEBUG
 
-void AddAllocation(void* pData, uint nSize, const char* szFile, uint nLine);
+void AddAllocation(void* pData, size_t nSize, const char* szFile, uint nLine, bool bAligned = false);
 void RemoveAllocation(void* pData);
 
+//-----------------------------------------------------------------------------
+//  DebugMalloc/DebugFree
+//  Backing allocations for debug builds. The 32-bit CRT malloc is only 8
+//  byte aligned, so it can't be used directly there
+//-----------------------------------------------------------------------------
+static _inline void* DebugMalloc( size_t nSize )
+{
+#if defined( _MSC_VER ) && !defined( _M_X64 )
+    void* pData = _aligned_malloc( nSize, 16 );
+#else
+    void* pData = malloc( nSize );
+#endif // #if defined( _MSC_VER ) && !defined( _M_X64 )
+    HeapProfilerOnAlloc( pData, nSize );
+    return pData;
+}
+
+static _inline void DebugFree( void* pData )
+{
+    HeapProfilerOnFree( pData );
+#if defined( _MSC_VER ) && !defined( _M_X64 )
+    _aligned_free( pData );
+#else
+    free( pData );
+#endif // #if defined( _MSC_VER ) && !defined( _M_X64 )
+}
+
+//-----------------------------------------------------------------------------
+//  DebugAlignedMalloc/DebugAlignedFree
+//  Over-allocates and stores the original pointer right before the
+//  aligned one
+//-----------------------------------------------------------------------------
+static void* DebugAlignedMalloc( size_t nSize, size_t nAlignment )
+{
+    if( nAlignment < sizeof( void* ) )
+    {
+        nAlignment = sizeof( void* );
+    }
+    byte* pBase = (byte*)DebugMalloc( nSize + nAlignment + sizeof( void* ) );
+    // TODO: Handle out of memory error ( pBase == 0 )
+    nativeuint nAligned = ( (nativeuint)pBase + sizeof( void* ) + nAlignment - 1 ) & ~( (nativeuint)nAlignment - 1 );
+    ( (void**)nAligned )[-1] = pBase;
+    return (void*)nAligned;
+}
+
+static void DebugAlignedFree( void* pData )
+{
+    if( pData == NULL )
+        return;
+    DebugFree( ( (void**)pData )[-1] );
+}
+
 void* __cdecl operator new( size_t nSize, const char* szFile, unsigned int nLine )
 {
-    void* p = malloc( nSize );
+    CheckFrameAllocation( nSize, szFile, nLine );
+    void* p = DebugMalloc( nSize );
     // TODO: Handle out of memory error ( p == 0 )
-    AddAllocation( p, (uint)nSize, szFile, nLine );
+    AddAllocation( p, nSize, szFile, nLine );
     return p;
 };
 void* __cdecl operator new[]( size_t nSize, const char* szFile, unsigned int nLine )
 {
-    void* p = malloc( nSize );
+    CheckFrameAllocation( nSize, szFile, nLine );
+    void* p = DebugMalloc( nSize );
     // TODO: Handle out of memory error ( p == 0 )
-    AddAllocation( p, (uint)nSize, szFile, nLine );
+    AddAllocation( p, nSize, szFile, nLine );
     return p;
 };
-void __cdecl operator delete(void* pVoid)
+// Allocations that didn't go through DEBUG_NEW (eg, the STL) aren't tracked
+void* __cdecl operator new( size_t nSize )
+{
+    CheckFrameAllocation( nSize, NULL, 0 );
+    return DebugMalloc( nSize );
+};
+void* __cdecl operator new[]( size_t nSize )
+{
+    CheckFrameAllocation( nSize, NULL, 0 );
+    return DebugMalloc( nSize );
+};
+void __cdecl operator delete(void* pVoid) throw()
 {
     RemoveAllocation(pVoid);
-    free(pVoid);
+    DebugFree(pVoid);
+};
+void __cdecl operator delete[](void* pVoid) throw()
+{
+    RemoveAllocation( pVoid );
+    DebugFree( pVoid );
+};
+
+void* __cdecl AlignedAlloc( size_t nSize, size_t nAlignment, const char* szFile, unsigned int nLine )
+{
+    CheckFrameAllocation( nSize, szFile, nLine );
+    void* p = DebugAlignedMalloc( nSize, nAlignment );
+    AddAllocation( p, nSize, szFile, nLine, true );
+    return p;
+}
+void __cdecl AlignedFree( void* pData )
+{
+    RemoveAllocation( pData );
+    DebugAlignedFree( pData );
+}
+
+#if defined( __cpp_aligned_new )
+void* __cdecl operator new( size_t nSize, std::align_val_t nAlignment, const char* szFile, unsigned int nLine )
+{
+    return AlignedAlloc( nSize, (size_t)nAlignment, szFile, nLine );
+};
+void* __cdecl operator new[]( size_t nSize, std::align_val_t nAlignment, const char* szFile, unsigned int nLine )
+{
+    return AlignedAlloc( nSize, (size_t)nAlignment, szFile, nLine );
+};
+void* __cdecl operator new( size_t nSize, std::align_val_t nAlignment )
+{
+    CheckFrameAllocation( nSize, NULL, 0 );
+    return DebugAlignedMalloc( nSize, (size_t)nAlignment );
+};
+void* __cdecl operator new[]( size_t nSize, std::align_val_t nAlignment )
+{
+    CheckFrameAllocation( nSize, NULL, 0 );
+    return DebugAlignedMalloc( nSize, (size_t)nAlignment );
+};
+void __cdecl operator delete( void* pVoid, std::align_val_t ) throw()
+{
+    AlignedFree( pVoid );
+};
+void __cdecl operator delete[]( void* pVoid, std::align_val_t ) throw()
+{
+    AlignedFree( pVoid );
+};
+void __cdecl operator delete( void* pVoid, size_t, std::align_val_t ) throw()
+{
+    AlignedFree( pVoid );
 };
-void __cdecl operator delete[](void* pVoid)
+void __cdecl operator delete[]( void* pVoid, size_t, std::align_val_t ) throw()
+{
+    AlignedFree( pVoid );
+};
+#endif // #if defined( __cpp_aligned_new )
+
+#if defined( __cpp_sized_deallocation )
+// C++14 compilers call these directly, make sure they don't end up in the CRT
+void __cdecl operator delete(void* pVoid, size_t) throw()
 {
     RemoveAllocation( pVoid );
-    free( pVoid );
+    DebugFree( pVoid );
 };
+void __cdecl operator delete[](void* pVoid, size_t) throw()
+{
+    RemoveAllocation( pVoid );
+    DebugFree( pVoid );
+};
+#endif // #if defined( __cpp_sized_deallocation )
 
 //-----------------------------------------------------------------------------
 //    Memory allocation tracking
+//    Live allocations are stored in open-addressed hash tables keyed by
+//    address. The address space is split across shards, each with its own
+//    lock, so threads allocating at the same time rarely touch the same
+//    table. Frees from a different thread land in the same shard as the
+//    allocation, since the shard is picked from the address.
 //-----------------------------------------------------------------------------
 struct MemoryAllocation
 {
-    char        szFile[128];
-    uint        nSize;
+    nativeuint  nAddress;   // 0 means the slot is empty
+    const char* szFile;     // Always a __FILE__ literal, so we just keep the pointer
+    uint64      nSize;
     uint        nLine;
-    nativeuint  nAddress;
+    uint8       nCategory;
+    bool        bAligned;   // From AlignedAlloc
+};
+
+struct MemoryCategoryCounters
+{
+    sint64              nBytesLive;
+    sint64              nAllocationsLive;
+    uint64              nTotalAllocations;
+    uint64              nTotalBytesAllocated;
 };
 
-// Define vector to hold allocations
-static MemoryAllocation g_pAllocations[512];
-static uint g_nCurrentAllocations = 0;
-static uint g_nCurrentMemoryUsage = 0;
-static uint g_nMaxMemoryAllocatedAtOnce = 0;
-static uint g_nTotalMemoryAllocated = 0;
+struct MemoryAllocationShard
+{
+    CSpinLock           lock;
+    MemoryAllocation*   pSlots;
+    uint                nCapacity; // Always a power of two
+    uint                nCapacityBits;
+    uint                nCount;
+    MemoryCategoryCounters pCategories[eNUMMEMORYCATEGORIES];
+};
+
+static const uint gs_nNumShardBits      = 6;
+static const uint gs_nNumShards         = 1 << gs_nNumShardBits;
+static const uint gs_nMinShardCapacityBits = 8;
+
+static MemoryAllocationShard g_pAllocationShards[gs_nNumShards];
+
+// The running total is global so the high-water mark is exact. Everything
+// else is kept per shard, under the shard's lock
+static volatile sint64 g_nCurrentMemoryUsage = 0;
+static volatile sint64 g_nMaxMemoryAllocatedAtOnce = 0;
+
+//-----------------------------------------------------------------------------
+//  HashAddress
+//  Fibonacci hash of the 4KB page the address lives in. The top bits
+//  pick the shard and the bits right below them pick where the region
+//  starts in the table. The offset within the page is added back in
+//  SlotIndex, so neighbouring allocations land in neighbouring slots and
+//  stay cache friendly
+//-----------------------------------------------------------------------------
+static _inline uint64 HashAddress( nativeuint nAddress )
+{
+    return ( (uint64)( nAddress >> 12 ) ) * 0x9E3779B97F4A7C15ULL;
+}
+
+static _inline uint ShardIndex( uint64 nHash )
+{
+    return (uint)( nHash >> ( 64 - gs_nNumShardBits ) );
+}
 
+static _inline uint SlotIndex( nativeuint nAddress, uint nCapacityBits )
+{
+    uint64 nHash = HashAddress( nAddress );
+    uint nRegion = (uint)( ( nHash << gs_nNumShardBits ) >> ( 64 - nCapacityBits ) );
+    uint nOffset = (uint)( nAddress >> 4 ) & 0xFF;
+    return ( nRegion ^ nOffset ) & ( ( 1 << nCapacityBits ) - 1 );
+}
 
-void AddAllocation(void* pData, uint nSize, const char* szFile, uint nLine)
+//-----------------------------------------------------------------------------
+//  GrowShard
+//  Doubles the capacity of a shard and reinserts its allocations. The
+//  tables are allocated with malloc directly to keep them out of the tracker
+//-----------------------------------------------------------------------------
+static void GrowShard( MemoryAllocationShard* pShard )
 {
-    MemoryAllocation allocation;
-    allocation.nAddress = (nativeuint)(pData);
+    uint nOldCapacity = pShard->nCapacity;
+    MemoryAllocation* pOldSlots = pShard->pSlots;
+
+    uint nNewCapacityBits = ( nOldCapacity == 0 ) ? gs_nMinShardCapacityBits : pShard->nCapacityBits + 1;
+    uint nNewCapacity = 1 << nNewCapacityBits;
+    MemoryAllocation* pNewSlots = (MemoryAllocation*)malloc( sizeof( MemoryAllocation ) * nNewCapacity );
+    memset( pNewSlots, 0, sizeof( MemoryAllocation ) * nNewCapacity );
+
+    for( uint i = 0; i < nOldCapacity; ++i )
+    {
+        if( pOldSlots[i].nAddress == 0 )
+            continue;
+
+        uint nSlot = SlotIndex( pOldSlots[i].nAddress, nNewCapacityBits );
+        while( pNewSlots[nSlot].nAddress != 0 )
+        {
+            nSlot = ( nSlot + 1 ) & ( nNewCapacity - 1 );
+        }
+        pNewSlots[nSlot] = pOldSlots[i];
+    }
+
+    pShard->pSlots = pNewSlots;
+    pShard->nCapacity = nNewCapacity;
+    pShard->nCapacityBits = nNewCapacityBits;
+    free( pOldSlots );
+}
+
+void AddAllocation(void* pData, size_t nSize, const char* szFile, uint nLine, bool bAligned)
+{
+    if( pData == NULL )
+        return;
+
+    nativeuint nAddress = (nativeuint)(pData);
+    MemoryAllocationShard* pShard = &g_pAllocationShards[ ShardIndex( HashAddress( nAddress ) ) ];
+
+    pShard->lock.Lock();
+    
+    // Keep the load factor under 50% so probe sequences stay short
+    if( ( pShard->nCount + 1 ) * 2 > pShard->nCapacity )
+    {
+        GrowShard( pShard );
+    }
+
+    uint nMask = pShard->nCapacity - 1;
+    uint nSlot = SlotIndex( nAddress, pShard->nCapacityBits );
+    while( pShard->pSlots[nSlot].nAddress != 0 )
+    {
+        nSlot = ( nSlot + 1 ) & nMask;
+    }
+
+    MemoryAllocation& allocation = pShard->pSlots[nSlot];
+    allocation.nAddress = nAddress;
     allocation.nSize = nSize;
-    strcpy(allocation.szFile, szFile);
+    allocation.szFile = szFile;
     allocation.nLine = nLine;
+    allocation.nCategory = (uint8)gs_nCurrentMemoryCategory;
+    allocation.bAligned = bAligned;
+    ++pShard->nCount;
 
-    g_pAllocations[g_nCurrentAllocations++] = allocation;
-    
-    g_nCurrentMemoryUsage += nSize;
-    g_nTotalMemoryAllocated += nSize;
-    g_nMaxMemoryAllocatedAtOnce = ( g_nCurrentMemoryUsage > g_nMaxMemoryAllocatedAtOnce ) ? g_nCurrentMemoryUsage : g_nMaxMemoryAllocatedAtOnce;
+    MemoryCategoryCounters& counters = pShard->pCategories[ allocation.nCategory ];
+    counters.nBytesLive += nSize;
+    counters.nAllocationsLive += 1;
+    counters.nTotalAllocations += 1;
+    counters.nTotalBytesAllocated += nSize;
+
+    pShard->lock.Unlock();
+
+    AtomicMax64( &g_nMaxMemoryAllocatedAtOnce, AtomicAdd64( &g_nCurrentMemoryUsage, (sint64)nSize ) );
 }
 
 void RemoveAllocation(void* pData)
 {
+    if( pData == NULL )
+        return;
+
     nativeuint nAddress = (nativeuint)(pData);
-    for(uint i = 0; i < g_nCurrentAllocations; ++i)
+    MemoryAllocationShard* pShard = &g_pAllocationShards[ ShardIndex( HashAddress( nAddress ) ) ];
+
+    pShard->lock.Lock();
+
+    if( pShard->nCount == 0 )
+    {   // Not one of ours (eg, allocated by the CRT's operator new)
+        pShard->lock.Unlock();
+        return;
+    }
+
+    uint nMask = pShard->nCapacity - 1;
+    uint nSlot = SlotIndex( nAddress, pShard->nCapacityBits );
+    while( pShard->pSlots[nSlot].nAddress != nAddress )
     {
-        if(g_pAllocations[i].nAddress == nAddress)
+        if( pShard->pSlots[nSlot].nAddress == 0 )
+        {   // Not one of ours
+            pShard->lock.Unlock();
+            return;
+        }
+        nSlot = ( nSlot + 1 ) & nMask;
+    }
+
+    uint64 nSize = pShard->pSlots[nSlot].nSize;
+    MemoryCategoryCounters& counters = pShard->pCategories[ pShard->pSlots[nSlot].nCategory ];
+    counters.nBytesLive -= nSize;
+    counters.nAllocationsLive -= 1;
+
+    // Backward-shift deletion: pull later entries of the probe sequence
+    // into the hole so lookups never need tombstones
+    uint nHole = nSlot;
+    uint nNext = ( nHole + 1 ) & nMask;
+    while( pShard->pSlots[nNext].nAddress != 0 )
+    {
+        uint nHome = SlotIndex( pShard->pSlots[nNext].nAddress, pShard->nCapacityBits );
+        // Move the entry if its home slot isn't cyclically in (nHole, nNext]
+        if( ( ( nNext - nHome ) & nMask ) >= ( ( nNext - nHole ) & nMask ) )
         {
-            g_nCurrentMemoryUsage -= g_pAllocations[i].nSize;
-            g_pAllocations[i] = g_pAllocations[--g_nCurrentAllocations];
-            break;
+            pShard->pSlots[nHole] = pShard->pSlots[nNext];
+            nHole = nNext;
         }
+        nNext = ( nNext + 1 ) & nMask;
     }
+    pShard->pSlots[nHole].nAddress = 0;
+    --pShard->nCount;
+
+    pShard->lock.Unlock();
+
+    AtomicAdd64( &g_nCurrentMemoryUsage, -(sint64)nSize );
 }
 
 void __cdecl DumpMemoryLeaks(void)
 {
-    char szBuffer[1024] = { 0 };
-    uint nTotalUnfreed = 0;    
+    uint64 nTotalUnfreed = 0;
+    uint64 nTotalAllocated = 0;
     printf( "\n----------------------------------------Dumping Memory Leaks-----------------------------------------\n" );
-    for(uint i = 0; i < g_nCurrentAllocations; ++i)
+    for(uint nShard = 0; nShard < gs_nNumShards; ++nShard)
     {
-#if defined( _64BIT )
-        sprintf( szBuffer, "%s, Line - %d:\t\tAddress - 0x%.16llu,\t\t%d unfreed\n",
-#else
-        sprintf( szBuffer, "%s, Line - %d:\t\tAddress - 0x%.8X,\t\t% ba d unfreed\n",
-#endif //#if defined( _64BIT )
-                    g_pAllocations[i].szFile,
-                    g_pAllocations[i].nLine,
-                    g_pAllocations[i].nAddress,
-                    g_pAllocations[i].nSize );
+        MemoryAllocationShard* pShard = &g_pAllocationShards[nShard];
+        pShard->lock.Lock();
+        for(uint nCategory = 0; nCategory < eNUMMEMORYCATEGORIES; ++nCategory)
+        {
+            nTotalAllocated += pShard->pCategories[nCategory].nTotalBytesAllocated;
+        }
+        for(uint i = 0; i < pShard->nCapacity; ++i)
+        {
+            MemoryAllocation& allocation = pShard->pSlots[i];
+            if( allocation.nAddress == 0 )
+                continue;
 
-        nTotalUnfreed += g_pAllocations[i].nSize;
+            printf( "%s, Line - %u:\t\tAddress - %p,\t\t%llu unfreed\t(%s)\n",
+                    allocation.szFile,
+                    allocation.nLine,
+                    (void*)allocation.nAddress,
+                    (unsigned long long)allocation.nSize,
+                    gs_szMemoryCategoryNames[ allocation.nCategory ] );
 
-        free( (void*)g_pAllocations[i].nAddress );
+            nTotalUnfreed += allocation.nSize;
 
-        printf( szBuffer );
+            if( allocation.bAligned )
+                DebugAlignedFree( (void*)allocation.nAddress );
+            else
+                DebugFree( (void*)allocation.nAddress );
+            allocation.nAddress = 0;
+        }
+        pShard->nCount = 0;
+        pShard->lock.Unlock();
     }
-    sprintf( szBuffer, "Total unfreed: %d bytes\n\n", nTotalUnfreed );
-    printf( szBuffer );
+    printf( "Total unfreed: %llu bytes\n\n", (unsigned long long)nTotalUnfreed );
 
-    sprintf( szBuffer, "Total Memory Allocated:\t\t%d\n", g_nTotalMemoryAllocated );
-    printf( szBuffer );
-    sprintf( szBuffer, "Max Memory Allocated at Once:\t%d\n", g_nMaxMemoryAllocatedAtOnce );
-    printf( szBuffer );
+    printf( "Total Memory Allocated:\t\t%llu\n", (unsigned long long)nTotalAllocated );
+    printf( "Max Memory Allocated at Once:\t%llu\n", (unsigned long long)g_nMaxMemoryAllocatedAtOnce );
     printf( "\n-----------------------------------------------------------------------------------------------------\n" );
 }
 
+//-----------------------------------------------------------------------------
+//  GetCurrentCounters
+//  Running totals for each category, from the tracker. Fills in everything
+//  up to the per-frame counters
+//-----------------------------------------------------------------------------
+static void GetCurrentCounters( MemoryCategoryStats* pCategories, uint64* pBytesReserved )
+{
+    for(uint nCategory = 0; nCategory < eNUMMEMORYCATEGORIES; ++nCategory)
+    {
+        pCategories[nCategory].nBytesLive = 0;
+        pCategories[nCategory].nAllocationsLive = 0;
+        pCategories[nCategory].nTotalAllocations = 0;
+        pCategories[nCategory].nTotalBytesAllocated = 0;
+    }
+
+    for(uint nShard = 0; nShard < gs_nNumShards; ++nShard)
+    {
+        MemoryAllocationShard* pShard = &g_pAllocationShards[nShard];
+        pShard->lock.Lock();
+        for(uint nCategory = 0; nCategory < eNUMMEMORYCATEGORIES; ++nCategory)
+        {
+            const MemoryCategoryCounters& counters = pShard->pCategories[nCategory];
+            pCategories[nCategory].nBytesLive += counters.nBytesLive;
+            pCategories[nCategory].nAllocationsLive += counters.nAllocationsLive;
+            pCategories[nCategory].nTotalAllocations += counters.nTotalAllocations;
+            pCategories[nCategory].nTotalBytesAllocated += counters.nTotalBytesAllocated;
+        }
+        pShard->lock.Unlock();
+    }
+    AddChargedCounters( pCategories );
+    *pBytesReserved = 0;
+}
+
 #else // #if notdefined( _DEBUG )
+#include "SmallObjectAllocator.h"
+
+//-----------------------------------------------------------------------------
+//  AllocateBlock/AllocateAlignedBlock/FreeBlock
+//  Everything the global operators hand out goes through these
+//-----------------------------------------------------------------------------
+static __forceinline void* AllocateBlock( size_t nSize )
+{
+    CheckFrameAllocation( nSize, NULL, 0 );
+    void* pData = SmallObjectAlloc( nSize, gs_nCurrentMemoryCategory );
+    HeapProfilerOnAlloc( pData, nSize );
+    return pData;
+}
+
+static __forceinline void* AllocateAlignedBlock( size_t nSize, size_t nAlignment )
+{
+    CheckFrameAllocation( nSize, NULL, 0 );
+    void* pData = SmallObjectAllocAligned( nSize, nAlignment, gs_nCurrentMemoryCategory );
+    HeapProfilerOnAlloc( pData, nSize );
+    return pData;
+}
+
+static __forceinline void FreeBlock( void* pData )
+{
+    HeapProfilerOnFree( pData );
+    SmallObjectFree( pData );
+}
 
 void* __cdecl operator new(size_t nSize)
 {
-    return malloc( nSize );
+    return AllocateBlock( nSize );
 };
 
 void* __cdecl operator new[](size_t nSize)
 {
-    return malloc( nSize );
+    return AllocateBlock( nSize );
 };
 
 void __cdecl operator delete(void* pVoid) throw()
 {
-    free( pVoid );
+    FreeBlock( pVoid );
 };
 
 void __cdecl operator delete[](void* pVoid) throw()
 {
-    free( pVoid );
+    FreeBlock( pVoid );
 };
 
+#if defined( __cpp_sized_deallocation )
+// C++14 compilers call these directly, make sure they don't end up in the CRT
+void __cdecl operator delete(void* pVoid, size_t) throw()
+{
+    FreeBlock( pVoid );
+};
+
+void __cdecl operator delete[](void* pVoid, size_t) throw()
+{
+    FreeBlock( pVoid );
+};
+#endif // #if defined( __cpp_sized_deallocation )
+
+void* __cdecl AlignedAlloc( size_t nSize, size_t nAlignment )
+{
+    return AllocateAlignedBlock( nSize, nAlignment );
+}
+
+void __cdecl AlignedFree( void* pData )
+{
+    FreeBlock( pData );
+}
+
+#if defined( __cpp_aligned_new )
+void* __cdecl operator new( size_t nSize, std::align_val_t nAlignment )
+{
+    return AllocateAlignedBlock( nSize, (size_t)nAlignment );
+};
+
+void* __cdecl operator new[]( size_t nSize, std::align_val_t nAlignment )
+{
+    return AllocateAlignedBlock( nSize, (size_t)nAlignment );
+};
+
+void __cdecl operator delete( void* pVoid, std::align_val_t ) throw()
+{
+    FreeBlock( pVoid );
+};
+
+void __cdecl operator delete[]( void* pVoid, std::align_val_t ) throw()
+{
+    FreeBlock( pVoid );
+};
+
+void __cdecl operator delete( void* pVoid, size_t, std::align_val_t ) throw()
+{
+    FreeBlock( pVoid );
+};
+
+void __cdecl operator delete[]( void* pVoid, size_t, std::align_val_t ) throw()
+{
+    FreeBlock( pVoid );
+};
+#endif // #if defined( __cpp_aligned_new )
+
+//-----------------------------------------------------------------------------
+//  GetCurrentCounters
+//  Running totals for each category, from the allocator. Fills in
+//  everything up to the per-frame counters
+//-----------------------------------------------------------------------------
+static void GetCurrentCounters( MemoryCategoryStats* pCategories, uint64* pBytesReserved )
+{
+    SmallObjectStats stats;
+    GetSmallObjectStats( &stats );
+    for( uint nCategory = 0; nCategory < eNUMMEMORYCATEGORIES; ++nCategory )
+    {
+        const SmallObjectCounters& counters = stats.pCategories[nCategory];
+        pCategories[nCategory].nBytesLive = counters.nBytesLive;
+        pCategories[nCategory].nAllocationsLive = counters.nAllocationsLive;
+        pCategories[nCategory].nTotalAllocations = counters.nTotalAllocations;
+        pCategories[nCategory].nTotalBytesAllocated = counters.nTotalBytesAllocated;
+    }
+    AddChargedCounters( pCategories );
+    *pBytesReserved = stats.nBytesReserved;
+}
+
 #endif // #ifdef debug
 
+//-----------------------------------------------------------------------------
+//  Per-frame counters
+//  Everything is sampled once a frame, in MemoryEndFrame. g_pCategoryStats
+//  holds the running totals as of the end of the last frame, along with the
+//  peaks, rates and budgets
+//-----------------------------------------------------------------------------
+void FrameAllocatorEndFrame( void );
+
+static MemoryCategoryStats g_pCategoryStats[eNUMMEMORYCATEGORIES];
+static bool g_pOverBudget[eNUMMEMORYCATEGORIES];
+
+//-----------------------------------------------------------------------------
+//  MemoryEndFrame
+//  Called once at the end of every frame. Flips the frame allocator and
+//  closes off the per-frame counters
+//-----------------------------------------------------------------------------
+void __cdecl MemoryEndFrame( void )
+{
+    FrameAllocCheckEndFrame();
+    FrameAllocatorEndFrame();
+
+    MemoryCategoryStats pCurrent[eNUMMEMORYCATEGORIES];
+    uint64 nBytesReserved;
+    GetCurrentCounters( pCurrent, &nBytesReserved );
+
+    for( uint nCategory = 0; nCategory < eNUMMEMORYCATEGORIES; ++nCategory )
+    {
+        MemoryCategoryStats& stats = g_pCategoryStats[nCategory];
+        stats.nAllocationsLastFrame = pCurrent[nCategory].nTotalAllocations - stats.nTotalAllocations;
+        stats.nBytesAllocatedLastFrame = pCurrent[nCategory].nTotalBytesAllocated - stats.nTotalBytesAllocated;
+        stats.nBytesLive = pCurrent[nCategory].nBytesLive;
+        stats.nAllocationsLive = pCurrent[nCategory].nAllocationsLive;
+        stats.nTotalAllocations = pCurrent[nCategory].nTotalAllocations;
+        stats.nTotalBytesAllocated = pCurrent[nCategory].nTotalBytesAllocated;
+        if( stats.nBytesLive > stats.nPeakBytesLive )
+        {
+            stats.nPeakBytesLive = stats.nBytesLive;
+        }
+
+        bool bOverBudget = stats.nBudget != 0 && stats.nBytesLive > (sint64)stats.nBudget;
+        if( bOverBudget && !g_pOverBudget[nCategory] )
+        {
+            printf( "Memory warning: %s is over budget (%lld of %llu bytes)\n",
+                    gs_szMemoryCategoryNames[nCategory],
+                    (long long)stats.nBytesLive,
+                    (unsigned long long)stats.nBudget );
+        }
+        g_pOverBudget[nCategory] = bOverBudget;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//  GetMemoryStats
+//  Fills out the current statistics
+//-----------------------------------------------------------------------------
+void __cdecl GetMemoryStats( MemoryStats* pStats )
+{
+    MemoryCategoryStats pCurrent[eNUMMEMORYCATEGORIES];
+    GetCurrentCounters( pCurrent, &pStats->nBytesReserved );
+
+    pStats->nBytesLive = 0;
+    pStats->nAllocationsLive = 0;
+    pStats->nTotalAllocations = 0;
+    pStats->nTotalBytesAllocated = 0;
+    pStats->nAllocationsLastFrame = 0;
+    pStats->nBytesAllocatedLastFrame = 0;
+    for( uint nCategory = 0; nCategory < eNUMMEMORYCATEGORIES; ++nCategory )
+    {
+        pStats->nBytesLive += pCurrent[nCategory].nBytesLive;
+        pStats->nAllocationsLive += pCurrent[nCategory].nAllocationsLive;
+        pStats->nTotalAllocations += pCurrent[nCategory].nTotalAllocations;
+        pStats->nTotalBytesAllocated += pCurrent[nCategory].nTotalBytesAllocated;
+        pStats->nAllocationsLastFrame += g_pCategoryStats[nCategory].nAllocationsLastFrame;
+        pStats->nBytesAllocatedLastFrame += g_pCategoryStats[nCategory].nBytesAllocatedLastFrame;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//  GetMemoryCategoryStats
+//  Fills out the statistics for one category, as of the end of last frame
+//-----------------------------------------------------------------------------
+void __cdecl GetMemoryCategoryStats( eMemoryCategory nCategory, MemoryCategoryStats* pStats )
+{
+    *pStats = g_pCategoryStats[nCategory];
+}
+
+//-----------------------------------------------------------------------------
+//  SetMemoryBudget
+//  Sets how many bytes a category is allowed to hold. 0 means no limit
+//-----------------------------------------------------------------------------
+void __cdecl SetMemoryBudget( eMemoryCategory nCategory, uint64 nBudget )
+{
+    g_pCategoryStats[nCategory].nBudget = nBudget;
+}
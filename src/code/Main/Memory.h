@@ -6,7 +6,18 @@ TODO:       Figure out how to do this without size_t
 #ifndef _MEMORY_H_
 #define _MEMORY_H_
 #include "Types.h"
+#include <stddef.h> // For size_t
+#if defined( __cpp_aligned_new )
+#include <new>      // For std::align_val_t
+#endif // #if defined( __cpp_aligned_new )
 
+//-----------------------------------------------------------------------------
+//  Global operator new
+//  Every form returns memory aligned to at least 16 bytes, so anything with
+//  RVector4/RMatrix4x4 members can be allocated with new. Types that need
+//  more than that go through the C++17 aligned forms where the compiler
+//  supports them, or AlignedAlloc otherwise
+//-----------------------------------------------------------------------------
 #ifdef DEBUG
 
 void __cdecl DumpMemoryLeaks(void);
@@ -14,21 +25,202 @@ void __cdecl DumpMemoryLeaks(void);
 void* __cdecl operator new( size_t nSize, const char* szFile, unsigned int nLine );
 void* __cdecl operator new[]( size_t nSize, const char* szFile, unsigned int nLine );
 
+#if defined( __cpp_aligned_new )
+void* __cdecl operator new( size_t nSize, std::align_val_t nAlignment, const char* szFile, unsigned int nLine );
+void* __cdecl operator new[]( size_t nSize, std::align_val_t nAlignment, const char* szFile, unsigned int nLine );
+#endif // #if defined( __cpp_aligned_new )
+
 #define DEBUG_NEW new( __FILE__, __LINE__ )
 
 #else
 
 #define DumpMemoryLeaks()
 
-void* __cdecl operator new(size_t nSize);
-void* __cdecl operator new[](size_t nSize);
-
 #define DEBUG_NEW new
 
 #endif
 
+void* __cdecl operator new(size_t nSize);
+void* __cdecl operator new[](size_t nSize);
 void __cdecl operator delete(void* pVoid) throw();
 void __cdecl operator delete[](void* pVoid) throw();
 
+#if defined( __cpp_aligned_new )
+void* __cdecl operator new( size_t nSize, std::align_val_t nAlignment );
+void* __cdecl operator new[]( size_t nSize, std::align_val_t nAlignment );
+void __cdecl operator delete( void* pVoid, std::align_val_t nAlignment ) throw();
+void __cdecl operator delete[]( void* pVoid, std::align_val_t nAlignment ) throw();
+#endif // #if defined( __cpp_aligned_new )
+
+//-----------------------------------------------------------------------------
+//  Aligned allocation
+//  For raw buffers that need more than 16 byte alignment, like hot arrays
+//  that should start on a cache line. Alignment must be a power of two, up
+//  to 32KB. Memory from ALIGNED_ALLOC must be released with AlignedFree
+//-----------------------------------------------------------------------------
+#define CACHE_LINE_SIZE 64
+
+#ifdef DEBUG
+void* __cdecl AlignedAlloc( size_t nSize, size_t nAlignment, const char* szFile, unsigned int nLine );
+#define ALIGNED_ALLOC( size, alignment ) AlignedAlloc( size, alignment, __FILE__, __LINE__ )
+#else
+void* __cdecl AlignedAlloc( size_t nSize, size_t nAlignment );
+#define ALIGNED_ALLOC( size, alignment ) AlignedAlloc( size, alignment )
+#endif
+
+void __cdecl AlignedFree( void* pData );
+
+#define CACHE_ALIGNED_ARRAY( type, count ) ( (type*)ALIGNED_ALLOC( sizeof( type ) * (count), CACHE_LINE_SIZE ) )
+
+//-----------------------------------------------------------------------------
+//  Frame allocator
+//  Scratch memory for data that only lives for a frame. Allocating is a
+//  pointer bump, and there is no free: the memory stays valid through the
+//  end of the next frame, then is released all at once by MemoryEndFrame.
+//  Main thread only
+//-----------------------------------------------------------------------------
+void* __cdecl FrameAlloc( size_t nSize, uint nAlignment = 16 );
+char* __cdecl FrameStrDup( const char* szString );
+
+#define FRAME_NEW_ARRAY( type, count ) ( (type*)FrameAlloc( sizeof( type ) * (count), __alignof( type ) ) )
+
+//-----------------------------------------------------------------------------
+//  MemoryEndFrame
+//  Called once at the end of every frame. Flips the frame allocator and
+//  closes off the per-frame counters
+//-----------------------------------------------------------------------------
+void __cdecl MemoryEndFrame( void );
+
+//-----------------------------------------------------------------------------
+//  Frame allocation checker
+//  Once a level is loaded, frames shouldn't touch the heap at all. With the
+//  checker on, every allocation through the global operator new between
+//  MemoryBeginFrame and MemoryEndFrame is reported with its call stack (and
+//  file:line in debug), or stops in the debugger, once nWarmupFrames frames
+//  have gone by. Allocations that are expected, like spawning something on
+//  a key press, can be let through for a scope:
+//      ALLOW_FRAME_ALLOCATIONS();
+//-----------------------------------------------------------------------------
+enum eFrameAllocCheck
+{
+    eFrameAllocCheckOff,
+    eFrameAllocCheckReport,
+    eFrameAllocCheckBreak,
+
+    eNUMFRAMEALLOCCHECKS
+};
+
+void __cdecl SetFrameAllocCheck( eFrameAllocCheck nMode, uint nWarmupFrames = 0 );
+void __cdecl MemoryBeginFrame( void );
+uint64 __cdecl GetFrameAllocViolations( void ); // Total since the checker was turned on
+
+class CAllowFrameAllocations
+{
+public:
+    CAllowFrameAllocations();
+    ~CAllowFrameAllocations();
+
+private:
+    CAllowFrameAllocations( const CAllowFrameAllocations& );
+    CAllowFrameAllocations& operator=( const CAllowFrameAllocations& );
+};
+
+#define ALLOW_FRAME_ALLOCATIONS() CAllowFrameAllocations allowFrameAllocations
+
+//-----------------------------------------------------------------------------
+//  Memory statistics
+//  Always available, in release builds too. The counters cover everything
+//  that goes through the global operator new
+//-----------------------------------------------------------------------------
+struct MemoryStats
+{
+    sint64  nBytesLive;
+    sint64  nAllocationsLive;
+    uint64  nTotalAllocations;
+    uint64  nTotalBytesAllocated;
+    uint64  nAllocationsLastFrame;
+    uint64  nBytesAllocatedLastFrame;
+    uint64  nBytesReserved;     // Held from the OS, including free space. 0 in debug
+};
+
+void __cdecl GetMemoryStats( MemoryStats* pStats );
+
+//-----------------------------------------------------------------------------
+//  Memory categories
+//  Every allocation through the global operator new is charged to the
+//  calling thread's current category, General unless a subsystem says
+//  otherwise:
+//      MEMORY_CATEGORY( eMemoryCategoryAssets );   // Rest of the scope
+//      CATEGORY_NEW( eMemoryCategoryTerrain, CTerrain() ); // Just this one
+//  Frees are always charged back to the category that allocated. Pooled
+//  classes ignore the current category, their pool's blocks are charged to
+//  the category given to DEFINE_POOL_ALLOCATED
+//-----------------------------------------------------------------------------
+enum eMemoryCategory
+{
+    eMemoryCategoryGeneral,
+    eMemoryCategoryScene,
+    eMemoryCategoryGfx,
+    eMemoryCategoryUI,
+    eMemoryCategoryTerrain,
+    eMemoryCategoryComponents,
+    eMemoryCategoryAssets,
+
+    eNUMMEMORYCATEGORIES
+};
+
+eMemoryCategory __cdecl GetMemoryCategory( void );
+void __cdecl SetMemoryCategory( eMemoryCategory nCategory );
+const char* __cdecl GetMemoryCategoryName( eMemoryCategory nCategory );
+
+class CMemoryCategoryScope
+{
+public:
+    CMemoryCategoryScope( eMemoryCategory nCategory )
+        : m_nPrevious( GetMemoryCategory() )
+    {
+        SetMemoryCategory( nCategory );
+    }
+    ~CMemoryCategoryScope()
+    {
+        SetMemoryCategory( m_nPrevious );
+    }
+
+private:
+    eMemoryCategory m_nPrevious;
+};
+
+#define MEMORY_CATEGORY( category ) CMemoryCategoryScope memoryCategoryScope( category )
+#define CATEGORY_NEW( category, type ) ( CMemoryCategoryScope( category ), new type )
+
+//-----------------------------------------------------------------------------
+//  ChargeMemoryCategory
+//  For memory a subsystem gets from the system itself, like the pool
+//  allocator's blocks. It's counted as one live allocation of nSize bytes
+//  in the category, but isn't tracked, checked or profiled, and can't be
+//  given back
+//-----------------------------------------------------------------------------
+void __cdecl ChargeMemoryCategory( eMemoryCategory nCategory, size_t nSize );
+
+//-----------------------------------------------------------------------------
+//  Category statistics
+//  Peaks are sampled once a frame, in MemoryEndFrame. When a category goes
+//  over its budget a warning is printed (once, until it drops back under)
+//-----------------------------------------------------------------------------
+struct MemoryCategoryStats
+{
+    sint64  nBytesLive;
+    sint64  nPeakBytesLive;
+    sint64  nAllocationsLive;
+    uint64  nTotalAllocations;
+    uint64  nTotalBytesAllocated;
+    uint64  nAllocationsLastFrame;
+    uint64  nBytesAllocatedLastFrame;
+    uint64  nBudget;            // 0 if there isn't one
+};
+
+void __cdecl GetMemoryCategoryStats( eMemoryCategory nCategory, MemoryCategoryStats* pStats );
+void __cdecl SetMemoryBudget( eMemoryCategory nCategory, uint64 nBudget );
+
 
 #endif // #ifndef _MEMORY_H_
\ No newline at end of file
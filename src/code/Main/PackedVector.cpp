@@ -0,0 +1,91 @@
+/*********************************************************\
+File:       PackedVector.cpp
+Purpose:    Packing and unpacking whole arrays
+\*********************************************************/
+#include "Common.h"
+#include "PackedVector.h"
+
+#define new DEBUG_NEW
+
+//-----------------------------------------------------------------------------
+//  PackUNorm8x4
+//  SSE packs four vectors at a time, narrowing 32 bit ints to 16 and then
+//  8 with saturation, and writes all 16 bytes at once
+//-----------------------------------------------------------------------------
+void PackUNorm8x4( const RVector4* pIn, RUNorm8x4* pOut, uint nCount )
+{
+    uint nStart = 0;
+#if defined( RIOT_SSE )
+    __m128 vZero = _mm_setzero_ps();
+    __m128 vOne = _mm_set1_ps( 1.0f );
+    __m128 vScale = _mm_set1_ps( 255.0f );
+    nStart = nCount & ~3;
+    for( uint i = 0; i < nStart; i += 4 )
+    {
+        __m128i vInt0 = _mm_cvtps_epi32( _mm_mul_ps( _mm_min_ps( _mm_max_ps( pIn[i + 0].v, vZero ), vOne ), vScale ) );
+        __m128i vInt1 = _mm_cvtps_epi32( _mm_mul_ps( _mm_min_ps( _mm_max_ps( pIn[i + 1].v, vZero ), vOne ), vScale ) );
+        __m128i vInt2 = _mm_cvtps_epi32( _mm_mul_ps( _mm_min_ps( _mm_max_ps( pIn[i + 2].v, vZero ), vOne ), vScale ) );
+        __m128i vInt3 = _mm_cvtps_epi32( _mm_mul_ps( _mm_min_ps( _mm_max_ps( pIn[i + 3].v, vZero ), vOne ), vScale ) );
+        __m128i vPacked = _mm_packus_epi16( _mm_packs_epi32( vInt0, vInt1 ), _mm_packs_epi32( vInt2, vInt3 ) );
+        _mm_storeu_si128( (__m128i*)( pOut + i ), vPacked );
+    }
+#endif // #if defined( RIOT_SSE )
+    for( uint i = nStart; i < nCount; ++i )
+    {
+        pOut[i] = RUNorm8x4( pIn[i] );
+    }
+}
+
+void UnpackUNorm8x4( const RUNorm8x4* pIn, RVector4* pOut, uint nCount )
+{
+    for( uint i = 0; i < nCount; ++i )
+    {
+        pOut[i] = pIn[i].ToVector4();
+    }
+}
+
+// Two vectors at a time on SSE
+void PackSNorm16x4( const RVector4* pIn, RSNorm16x4* pOut, uint nCount )
+{
+    uint nStart = 0;
+#if defined( RIOT_SSE )
+    __m128 vMinusOne = _mm_set1_ps( -1.0f );
+    __m128 vOne = _mm_set1_ps( 1.0f );
+    __m128 vScale = _mm_set1_ps( 32767.0f );
+    nStart = nCount & ~1;
+    for( uint i = 0; i < nStart; i += 2 )
+    {
+        __m128i vInt0 = _mm_cvtps_epi32( _mm_mul_ps( _mm_min_ps( _mm_max_ps( pIn[i + 0].v, vMinusOne ), vOne ), vScale ) );
+        __m128i vInt1 = _mm_cvtps_epi32( _mm_mul_ps( _mm_min_ps( _mm_max_ps( pIn[i + 1].v, vMinusOne ), vOne ), vScale ) );
+        _mm_storeu_si128( (__m128i*)( pOut + i ), _mm_packs_epi32( vInt0, vInt1 ) );
+    }
+#endif // #if defined( RIOT_SSE )
+    for( uint i = nStart; i < nCount; ++i )
+    {
+        pOut[i] = RSNorm16x4( pIn[i] );
+    }
+}
+
+void UnpackSNorm16x4( const RSNorm16x4* pIn, RVector4* pOut, uint nCount )
+{
+    for( uint i = 0; i < nCount; ++i )
+    {
+        pOut[i] = pIn[i].ToVector4();
+    }
+}
+
+void PackUNorm1010102( const RVector4* pIn, RUNorm1010102* pOut, uint nCount )
+{
+    for( uint i = 0; i < nCount; ++i )
+    {
+        pOut[i] = RUNorm1010102( pIn[i] );
+    }
+}
+
+void UnpackUNorm1010102( const RUNorm1010102* pIn, RVector4* pOut, uint nCount )
+{
+    for( uint i = 0; i < nCount; ++i )
+    {
+        pOut[i] = pIn[i].ToVector4();
+    }
+}
@@ -0,0 +1,161 @@
+/*********************************************************\
+File:       PackedVector.h
+Purpose:    Compressed vector formats for vertex and bulk
+            data: half floats and normalized integers
+\*********************************************************/
+#ifndef _PACKEDVECTOR_H_
+#define _PACKEDVECTOR_H_
+#include "Types.h"
+#include "RiotMath.h"
+
+// F16C converts halves in hardware. MSVC only says so with /arch:AVX2
+#if !defined( RIOT_NO_SIMD ) && ( defined( __F16C__ ) || defined( __AVX2__ ) )
+#define RIOT_F16C
+#include <immintrin.h>
+#endif
+
+//-----------------------------------------------------------------------------
+//  RHalf
+//  IEEE half precision: 1 sign, 5 exponent and 10 mantissa bits. Exact for
+//  integers up to 2048, with about 3 decimal digits. Converting rounds to
+//  nearest even, and anything past 65504 becomes infinity
+//-----------------------------------------------------------------------------
+typedef uint16 RHalf;
+
+RHalf FloatToHalf( float F );
+float HalfToFloat( RHalf H );
+
+class RHalf2
+{
+public:
+    /***************************************\
+    | class members
+    \***************************************/
+    RHalf   x, y;
+
+public:
+    // RHalf2 constructors
+    RHalf2(  ) { }
+    RHalf2( float X, float Y );
+    explicit RHalf2( const RVector2& V );
+
+    /***************************************\
+    | class methods
+    \***************************************/
+    RVector2 ToVector2( void ) const;
+};
+
+class RHalf4
+{
+public:
+    /***************************************\
+    | class members
+    \***************************************/
+    RHalf   x, y, z, w;
+
+public:
+    // RHalf4 constructors
+    RHalf4(  ) { }
+    RHalf4( float X, float Y, float Z, float W );
+    explicit RHalf4( const RVector4& V );
+
+    /***************************************\
+    | class methods
+    \***************************************/
+    RVector4 ToVector4( void ) const;
+};
+
+//-----------------------------------------------------------------------------
+//  RUNorm8x4
+//  Four bytes mapping 0-255 to 0-1, eg: a color. The same layout as
+//  DXGI_FORMAT_R8G8B8A8_UNORM. Packing clamps to 0-1
+//-----------------------------------------------------------------------------
+class RUNorm8x4
+{
+public:
+    /***************************************\
+    | class members
+    \***************************************/
+    union
+    {
+        struct { uint8 x, y, z, w; };
+        uint32 v;
+    };
+
+public:
+    // RUNorm8x4 constructors
+    RUNorm8x4(  ) { }
+    explicit RUNorm8x4( const RVector4& V );
+
+    /***************************************\
+    | class methods
+    \***************************************/
+    RVector4 ToVector4( void ) const;
+};
+
+//-----------------------------------------------------------------------------
+//  RSNorm16x4
+//  Four shorts mapping -32767-32767 to -1-1, eg: a normal or tangent.
+//  DXGI_FORMAT_R16G16B16A16_SNORM. Packing clamps to -1-1
+//-----------------------------------------------------------------------------
+class RSNorm16x4
+{
+public:
+    /***************************************\
+    | class members
+    \***************************************/
+    int16   x, y, z, w;
+
+public:
+    // RSNorm16x4 constructors
+    RSNorm16x4(  ) { }
+    explicit RSNorm16x4( const RVector4& V );
+
+    /***************************************\
+    | class methods
+    \***************************************/
+    RVector4 ToVector4( void ) const;
+};
+
+//-----------------------------------------------------------------------------
+//  RUNorm1010102
+//  10 bits each of x, y and z, and 2 of w, in one uint32 with x in the
+//  low bits. DXGI_FORMAT_R10G10B10A2_UNORM. Packing clamps to 0-1, so
+//  signed data like normals need * 0.5 + 0.5 first
+//-----------------------------------------------------------------------------
+class RUNorm1010102
+{
+public:
+    /***************************************\
+    | class members
+    \***************************************/
+    uint32  v;
+
+public:
+    // RUNorm1010102 constructors
+    RUNorm1010102(  ) { }
+    explicit RUNorm1010102( const RVector4& V );
+
+    /***************************************\
+    | class methods
+    \***************************************/
+    RVector4 ToVector4( void ) const;
+};
+
+//-----------------------------------------------------------------------------
+//  Bulk packing
+//  Whole arrays at once. The halves are stream kernels, see MathStream.h
+//-----------------------------------------------------------------------------
+void PackUNorm8x4( const RVector4* pIn, RUNorm8x4* pOut, uint nCount );
+void UnpackUNorm8x4( const RUNorm8x4* pIn, RVector4* pOut, uint nCount );
+void PackSNorm16x4( const RVector4* pIn, RSNorm16x4* pOut, uint nCount );
+void UnpackSNorm16x4( const RSNorm16x4* pIn, RVector4* pOut, uint nCount );
+void PackUNorm1010102( const RVector4* pIn, RUNorm1010102* pOut, uint nCount );
+void UnpackUNorm1010102( const RUNorm1010102* pIn, RVector4* pOut, uint nCount );
+
+//-----------------------------------------------------------------------------
+//  Everything else is inlined
+//-----------------------------------------------------------------------------
+#include "PackedVector.inl"
+
+#endif // #ifndef _PACKEDVECTOR_H_
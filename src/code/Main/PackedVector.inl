@@ -0,0 +1,237 @@
+/*********************************************************\
+File:      PackedVector.inl
+Purpose:   Inline definitions for PackedVector.h
+\*********************************************************/
+#include <string.h> // For memcpy
+
+/**********************************************************\
+|**********************************************************|
+| RHalf
+|**********************************************************|
+\**********************************************************/
+//-----------------------------------------------------------------------------
+//  FloatToHalf
+//  Normal halves rebias the exponent and round the mantissa. Anything too
+//  small for a normal half is added to a float whose exponent lines its
+//  mantissa up with the half's denormals, which lets the FPU do the
+//  rounding
+//-----------------------------------------------------------------------------
+_inline RHalf FloatToHalf(float F)
+{
+    static const uint32 nFloatInfinity = 255 << 23;
+    static const uint32 nHalfOverflow = ( 127 + 16 ) << 23;    // 65536
+    static const uint32 nHalfNormal = ( 127 - 14 ) << 23;      // 2^-14
+    static const uint32 nDenormalMagic = ( ( 127 - 15 ) + ( 23 - 10 ) + 1 ) << 23;
+
+    uint32 nBits;
+    memcpy( &nBits, &F, sizeof( nBits ) );
+    uint32 nSign = nBits & 0x80000000;
+    nBits ^= nSign;
+
+    uint32 nHalf;
+    if( nBits >= nHalfOverflow )
+    {
+        // Infinity stays infinity, and NaNs stay NaNs
+        nHalf = nBits > nFloatInfinity ? 0x7E00 : 0x7C00;
+    }
+    else if( nBits < nHalfNormal )
+    {
+        float fMagic;
+        memcpy( &fMagic, &nDenormalMagic, sizeof( fMagic ) );
+        float fShifted;
+        memcpy( &fShifted, &nBits, sizeof( fShifted ) );
+        fShifted += fMagic;
+        memcpy( &nHalf, &fShifted, sizeof( nHalf ) );
+        nHalf -= nDenormalMagic;
+    }
+    else
+    {
+        // Round to nearest even: add just under half, plus the bit that
+        // makes exact halves round up from odd
+        uint32 nMantissaOdd = ( nBits >> 13 ) & 1;
+        nBits += ( (uint32)( 15 - 127 ) << 23 ) + 0xFFF + nMantissaOdd;
+        nHalf = nBits >> 13;
+    }
+    return (RHalf)( nHalf | ( nSign >> 16 ) );
+}
+
+_inline float HalfToFloat(RHalf H)
+{
+    static const uint32 nHalfExponent = 0x7C00 << 13;
+    static const uint32 nDenormalMagic = 113 << 23;
+
+    uint32 nBits = ( H & 0x7FFF ) << 13;
+    uint32 nExponent = nBits & nHalfExponent;
+    nBits += ( 127 - 15 ) << 23;
+
+    if( nExponent == nHalfExponent )
+    {
+        // Infinity or NaN
+        nBits += ( 128 - 16 ) << 23;
+    }
+    else if( nExponent == 0 )
+    {
+        // Zero or a denormal. Renormalize by letting the FPU subtract
+        float fMagic, fResult;
+        nBits += 1 << 23;
+        memcpy( &fMagic, &nDenormalMagic, sizeof( fMagic ) );
+        memcpy( &fResult, &nBits, sizeof( fResult ) );
+        fResult -= fMagic;
+        memcpy( &nBits, &fResult, sizeof( nBits ) );
+    }
+
+    nBits |= (uint32)( H & 0x8000 ) << 16;
+    float fResult;
+    memcpy( &fResult, &nBits, sizeof( fResult ) );
+    return fResult;
+}
+
+
+/**********************************************************\
+|**********************************************************|
+| class RHalf2
+|**********************************************************|
+\**********************************************************/
+_inline RHalf2::RHalf2(float X, float Y) : x( FloatToHalf( X ) ), y( FloatToHalf( Y ) )
+{
+}
+
+_inline RHalf2::RHalf2(const RVector2& V) : x( FloatToHalf( V.x ) ), y( FloatToHalf( V.y ) )
+{
+}
+
+_inline RVector2 RHalf2::ToVector2(void) const
+{
+    return RVector2( HalfToFloat( x ), HalfToFloat( y ) );
+}
+
+
+/**********************************************************\
+|**********************************************************|
+| class RHalf4
+|**********************************************************|
+\**********************************************************/
+_inline RHalf4::RHalf4(float X, float Y, float Z, float W)
+{
+    *this = RHalf4( RVector4( X, Y, Z, W ) );
+}
+
+_inline RHalf4::RHalf4(const RVector4& V)
+{
+#if defined( RIOT_F16C )
+    _mm_storel_epi64( (__m128i*)this, _mm_cvtps_ph( V.v, _MM_FROUND_TO_NEAREST_INT ) );
+#else
+    x = FloatToHalf( V.x );
+    y = FloatToHalf( V.y );
+    z = FloatToHalf( V.z );
+    w = FloatToHalf( V.w );
+#endif // #if defined( RIOT_F16C )
+}
+
+_inline RVector4 RHalf4::ToVector4(void) const
+{
+#if defined( RIOT_F16C )
+    return RVector4( _mm_cvtph_ps( _mm_loadl_epi64( (const __m128i*)this ) ) );
+#else
+    return RVector4( HalfToFloat( x ), HalfToFloat( y ), HalfToFloat( z ), HalfToFloat( w ) );
+#endif // #if defined( RIOT_F16C )
+}
+
+
+/**********************************************************\
+|**********************************************************|
+| class RUNorm8x4
+|**********************************************************|
+\**********************************************************/
+_inline RUNorm8x4::RUNorm8x4(const RVector4& V)
+{
+#if defined( RIOT_SSE )
+    __m128 vScaled = _mm_mul_ps( _mm_min_ps( _mm_max_ps( V.v, _mm_setzero_ps() ), _mm_set1_ps( 1.0f ) ), _mm_set1_ps( 255.0f ) );
+    __m128i vInt = _mm_cvtps_epi32( vScaled );
+    vInt = _mm_packs_epi32( vInt, vInt );
+    v = (uint32)_mm_cvtsi128_si32( _mm_packus_epi16( vInt, vInt ) );
+#else
+    for( uint i = 0; i < 4; ++i )
+    {
+        float fClamped = V.f[i] < 0.0f ? 0.0f : ( V.f[i] > 1.0f ? 1.0f : V.f[i] );
+        ( &x )[i] = (uint8)( fClamped * 255.0f + 0.5f );
+    }
+#endif // #if defined( RIOT_SSE )
+}
+
+_inline RVector4 RUNorm8x4::ToVector4(void) const
+{
+#if defined( RIOT_SSE )
+    __m128i vInt = _mm_cvtsi32_si128( (int)v );
+    vInt = _mm_unpacklo_epi16( _mm_unpacklo_epi8( vInt, _mm_setzero_si128() ), _mm_setzero_si128() );
+    return RVector4( _mm_mul_ps( _mm_cvtepi32_ps( vInt ), _mm_set1_ps( 1.0f / 255.0f ) ) );
+#else
+    return RVector4( x * ( 1.0f / 255.0f ), y * ( 1.0f / 255.0f ), z * ( 1.0f / 255.0f ), w * ( 1.0f / 255.0f ) );
+#endif // #if defined( RIOT_SSE )
+}
+
+
+/**********************************************************\
+|**********************************************************|
+| class RSNorm16x4
+|**********************************************************|
+\**********************************************************/
+_inline RSNorm16x4::RSNorm16x4(const RVector4& V)
+{
+#if defined( RIOT_SSE )
+    __m128 vScaled = _mm_mul_ps( _mm_min_ps( _mm_max_ps( V.v, _mm_set1_ps( -1.0f ) ), _mm_set1_ps( 1.0f ) ), _mm_set1_ps( 32767.0f ) );
+    __m128i vInt = _mm_cvtps_epi32( vScaled );
+    _mm_storel_epi64( (__m128i*)this, _mm_packs_epi32( vInt, vInt ) );
+#else
+    for( uint i = 0; i < 4; ++i )
+    {
+        float fClamped = V.f[i] < -1.0f ? -1.0f : ( V.f[i] > 1.0f ? 1.0f : V.f[i] );
+        ( &x )[i] = (int16)floorf( fClamped * 32767.0f + 0.5f );
+    }
+#endif // #if defined( RIOT_SSE )
+}
+
+_inline RVector4 RSNorm16x4::ToVector4(void) const
+{
+#if defined( RIOT_SSE )
+    // Each short into the top of a 32 bit lane, then shifted down to sign extend
+    __m128i vInt = _mm_loadl_epi64( (const __m128i*)this );
+    vInt = _mm_srai_epi32( _mm_unpacklo_epi16( vInt, vInt ), 16 );
+    // -32768 is -1 too
+    return RVector4( _mm_max_ps( _mm_mul_ps( _mm_cvtepi32_ps( vInt ), _mm_set1_ps( 1.0f / 32767.0f ) ), _mm_set1_ps( -1.0f ) ) );
+#else
+    RVector4 vResult;
+    for( uint i = 0; i < 4; ++i )
+    {
+        float fValue = ( &x )[i] * ( 1.0f / 32767.0f );
+        vResult.f[i] = fValue < -1.0f ? -1.0f : fValue;
+    }
+    return vResult;
+#endif // #if defined( RIOT_SSE )
+}
+
+
+/**********************************************************\
+|**********************************************************|
+| class RUNorm1010102
+|**********************************************************|
+\**********************************************************/
+_inline RUNorm1010102::RUNorm1010102(const RVector4& V)
+{
+    static const float pScale[4] = { 1023.0f, 1023.0f, 1023.0f, 3.0f };
+    uint32 pInt[4];
+    for( uint i = 0; i < 4; ++i )
+    {
+        float fClamped = V.f[i] < 0.0f ? 0.0f : ( V.f[i] > 1.0f ? 1.0f : V.f[i] );
+        pInt[i] = (uint32)( fClamped * pScale[i] + 0.5f );
+    }
+    v = pInt[0] | ( pInt[1] << 10 ) | ( pInt[2] << 20 ) | ( pInt[3] << 30 );
+}
+
+_inline RVector4 RUNorm1010102::ToVector4(void) const
+{
+    return RVector4( ( v & 0x3FF ) * ( 1.0f / 1023.0f ),
+                     ( ( v >> 10 ) & 0x3FF ) * ( 1.0f / 1023.0f ),
+                     ( ( v >> 20 ) & 0x3FF ) * ( 1.0f / 1023.0f ),
+                     ( v >> 30 ) * ( 1.0f / 3.0f ) );
+}
@@ -0,0 +1,160 @@
+/*********************************************************\
+File:       PoolAllocator.cpp
+Purpose:    Fixed-size block allocator with an intrusive
+            free list
+\*********************************************************/
+#include "PoolAllocator.h"
+#include <stdlib.h>
+#include <string.h>
+
+CPoolAllocator* CPoolAllocator::ms_pFirstPool = NULL;
+static CSpinLock gs_PoolListLock;
+
+// CPoolAllocator constructor
+CPoolAllocator::CPoolAllocator( const char* szName, uint nElementSize, uint nAlignment, uint nElementsPerBlock,
+                                eMemoryCategory nCategory )
+    : m_pFreeList( NULL )
+    , m_pBlockCursor( NULL )
+    , m_pBlockEnd( NULL )
+    , m_pBlocks( NULL )
+    , m_szName( szName )
+    , m_nElementSize( 0 )
+    , m_nAlignment( nAlignment )
+    , m_nElementsPerBlock( nElementsPerBlock )
+    , m_nLive( 0 )
+    , m_nHighWater( 0 )
+    , m_nCapacity( 0 )
+    , m_nNumBlocks( 0 )
+    , m_nCategory( nCategory )
+    , m_pNextPool( NULL )
+{
+    // Every element has to be able to hold the free list pointer, and the
+    // stride has to keep every element aligned
+    if( m_nAlignment < sizeof( FreeElement ) )
+    {
+        m_nAlignment = sizeof( FreeElement );
+    }
+    if( nElementSize < sizeof( FreeElement ) )
+    {
+        nElementSize = sizeof( FreeElement );
+    }
+    m_nElementSize = ( nElementSize + m_nAlignment - 1 ) & ~( m_nAlignment - 1 );
+
+    gs_PoolListLock.Lock();
+    m_pNextPool = ms_pFirstPool;
+    ms_pFirstPool = this;
+    gs_PoolListLock.Unlock();
+}
+
+// CPoolAllocator destructor
+CPoolAllocator::~CPoolAllocator()
+{
+}
+
+//-----------------------------------------------------------------------------
+//  AllocateBlock
+//  Gets a new block of elements from the system. Blocks come straight from
+//  malloc, so pooled objects don't show up as individual tracked allocations,
+//  but the block is still charged to the pool's category
+//-----------------------------------------------------------------------------
+void CPoolAllocator::AllocateBlock( void )
+{
+    // The block header holds the link to the previous block, padded out so
+    // the first element is aligned
+    uint nHeaderSize = ( sizeof( void* ) + m_nAlignment - 1 ) & ~( m_nAlignment - 1 );
+    size_t nBlockSize = nHeaderSize + (size_t)m_nElementSize * m_nElementsPerBlock + m_nAlignment;
+
+    byte* pBlock = (byte*)malloc( nBlockSize );
+    // TODO: Handle out of memory error ( pBlock == 0 )
+    ChargeMemoryCategory( m_nCategory, nBlockSize );
+    *(void**)pBlock = m_pBlocks;
+    m_pBlocks = pBlock;
+
+    nativeuint nFirst = ( (nativeuint)pBlock + nHeaderSize + m_nAlignment - 1 ) & ~( (nativeuint)m_nAlignment - 1 );
+    m_pBlockCursor = (byte*)nFirst;
+    m_pBlockEnd = m_pBlockCursor + (size_t)m_nElementSize * m_nElementsPerBlock;
+
+    m_nCapacity += m_nElementsPerBlock;
+    ++m_nNumBlocks;
+}
+
+//-----------------------------------------------------------------------------
+//  Allocate
+//  Returns one element. Freed elements are reused first (most recently freed
+//  first, while it's still in cache), then new blocks are carved up in order
+//-----------------------------------------------------------------------------
+void* CPoolAllocator::Allocate( void )
+{
+    void* pElement = NULL;
+
+    m_Lock.Lock();
+    if( m_pFreeList )
+    {
+        pElement = m_pFreeList;
+        m_pFreeList = m_pFreeList->pNext;
+    }
+    else
+    {
+        if( m_pBlockCursor == m_pBlockEnd )
+        {
+            AllocateBlock();
+        }
+        pElement = m_pBlockCursor;
+        m_pBlockCursor += m_nElementSize;
+    }
+
+    ++m_nLive;
+    if( m_nLive > m_nHighWater )
+    {
+        m_nHighWater = m_nLive;
+    }
+    m_Lock.Unlock();
+
+    return pElement;
+}
+
+//-----------------------------------------------------------------------------
+//  Free
+//  Returns an element to the pool
+//-----------------------------------------------------------------------------
+void CPoolAllocator::Free( void* pElement )
+{
+    if( pElement == NULL )
+        return;
+
+#ifdef DEBUG
+    // Stomp freed memory so use-after-free shows up quickly
+    memset( pElement, 0xDD, m_nElementSize );
+#endif
+
+    m_Lock.Lock();
+    FreeElement* pFree = (FreeElement*)pElement;
+    pFree->pNext = m_pFreeList;
+    m_pFreeList = pFree;
+    --m_nLive;
+    m_Lock.Unlock();
+}
+
+//-----------------------------------------------------------------------------
+//  Accessors
+//-----------------------------------------------------------------------------
+void CPoolAllocator::GetStats( PoolStats* pStats )
+{
+    m_Lock.Lock();
+    pStats->szName = m_szName;
+    pStats->nElementSize = m_nElementSize;
+    pStats->nLive = m_nLive;
+    pStats->nHighWater = m_nHighWater;
+    pStats->nCapacity = m_nCapacity;
+    pStats->nNumBlocks = m_nNumBlocks;
+    m_Lock.Unlock();
+}
+
+//-----------------------------------------------------------------------------
+//  GetFirstPool
+//  Walks every pool that's been created
+//-----------------------------------------------------------------------------
+CPoolAllocator* CPoolAllocator::GetFirstPool( void )
+{
+    return ms_pFirstPool;
+}
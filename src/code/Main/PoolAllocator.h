@@ -0,0 +1,166 @@
+/*********************************************************\
+File:       PoolAllocator.h
+Purpose:    Fixed-size block allocator with an intrusive
+            free list
+\*********************************************************/
+#ifndef _POOLALLOCATOR_H_
+#define _POOLALLOCATOR_H_
+#include "Types.h"
+#include "Memory.h"
+#include "Atomic.h"
+
+//-----------------------------------------------------------------------------
+//  PoolStats
+//  Occupancy of a single pool
+//-----------------------------------------------------------------------------
+struct PoolStats
+{
+    const char* szName;
+    uint        nElementSize;   // Stride of each element, including padding
+    uint        nLive;          // Elements currently allocated
+    uint        nHighWater;     // Most elements ever allocated at once
+    uint        nCapacity;      // Elements available without allocating a new block
+    uint        nNumBlocks;
+};
+
+class CPoolAllocator
+{
+public:
+    // CPoolAllocator constructor
+    // The blocks are charged to nCategory as they're allocated
+    CPoolAllocator( const char* szName, uint nElementSize, uint nAlignment, uint nElementsPerBlock,
+                    eMemoryCategory nCategory );
+
+    // CPoolAllocator destructor
+    // NOTE: The blocks are never freed, pools are expected to
+    //       live until the process exits
+    ~CPoolAllocator();
+    /***************************************\
+    | class methods                         |
+    \***************************************/
+
+    //-----------------------------------------------------------------------------
+    //  Allocate
+    //  Returns one element. O(1) unless a new block is needed
+    //-----------------------------------------------------------------------------
+    void* Allocate( void );
+
+    //-----------------------------------------------------------------------------
+    //  Free
+    //  Returns an element to the pool
+    //-----------------------------------------------------------------------------
+    void Free( void* pElement );
+
+    //-----------------------------------------------------------------------------
+    //  Accessors
+    //-----------------------------------------------------------------------------
+    void GetStats( PoolStats* pStats );
+    uint GetElementSize( void ) const { return m_nElementSize; }
+
+    //-----------------------------------------------------------------------------
+    //  GetFirstPool/GetNextPool
+    //  Walks every pool that's been created
+    //-----------------------------------------------------------------------------
+    static CPoolAllocator* GetFirstPool( void );
+    CPoolAllocator* GetNextPool( void ) { return m_pNextPool; }
+
+private:
+    CPoolAllocator( const CPoolAllocator& );
+    CPoolAllocator& operator=( const CPoolAllocator& );
+
+    //-----------------------------------------------------------------------------
+    //  AllocateBlock
+    //  Gets a new block of elements from the system
+    //-----------------------------------------------------------------------------
+    void AllocateBlock( void );
+
+    /***************************************\
+    | class members                         |
+    \***************************************/
+    struct FreeElement
+    {
+        FreeElement* pNext;
+    };
+
+    CSpinLock           m_Lock;
+    FreeElement*        m_pFreeList;
+    byte*               m_pBlockCursor;     // Unused part of the newest block
+    byte*               m_pBlockEnd;
+    void*               m_pBlocks;          // Singly linked through the first pointer of each block
+
+    const char*         m_szName;
+    uint                m_nElementSize;
+    uint                m_nAlignment;
+    uint                m_nElementsPerBlock;
+    uint                m_nLive;
+    uint                m_nHighWater;
+    uint                m_nCapacity;
+    uint                m_nNumBlocks;
+    eMemoryCategory     m_nCategory;
+
+    CPoolAllocator*     m_pNextPool;
+
+    static CPoolAllocator* ms_pFirstPool;
+};
+
+//-----------------------------------------------------------------------------
+//  Per-class hooks
+//  DECLARE_POOL_ALLOCATED goes in the class definition, DEFINE_POOL_ALLOCATED
+//  in the .cpp. Every `new` of the class then comes from its own pool, whose
+//  blocks are charged to the memory category given to DEFINE_POOL_ALLOCATED.
+//  Derived classes inherit the operators; anything bigger than the pooled
+//  class falls back to the global heap, in the current category.
+//
+//  Both macros spell out operator new, so `new` must not be defined as
+//  DEBUG_NEW where they're expanded:
+//      #pragma push_macro( "new" )
+//      #undef new
+//      DECLARE_POOL_ALLOCATED( CObject )
+//      #pragma pop_macro( "new" )
+//-----------------------------------------------------------------------------
+#define DECLARE_POOL_ALLOCATED( classname )                                         \
+public:                                                                             \
+    static void* operator new( size_t nSize );                                      \
+    static void* operator new( size_t nSize, const char* szFile, unsigned int nLine ); \
+    static void  operator delete( void* pVoid, size_t nSize );                      \
+    static void  operator delete( void* pVoid, const char* szFile, unsigned int nLine ); \
+    static CPoolAllocator* GetPool( void );
+
+#ifdef DEBUG
+#define POOL_FALLBACK_NEW( nSize, szFile, nLine ) ::operator new( nSize, szFile, nLine )
+#else
+#define POOL_FALLBACK_NEW( nSize, szFile, nLine ) ::operator new( nSize )
+#endif
+
+#define DEFINE_POOL_ALLOCATED( classname, elementsperblock, category )              \
+    CPoolAllocator* classname::GetPool( void )                                      \
+    {                                                                               \
+        static CPoolAllocator pool( #classname, sizeof( classname ), __alignof( classname ), elementsperblock, category ); \
+        return &pool;                                                               \
+    }                                                                               \
+    void* classname::operator new( size_t nSize )                                   \
+    {                                                                               \
+        return classname::operator new( nSize, __FILE__, __LINE__ );                \
+    }                                                                               \
+    void* classname::operator new( size_t nSize, const char* szFile, unsigned int nLine ) \
+    {                                                                               \
+        if( nSize <= sizeof( classname ) )                                          \
+            return GetPool()->Allocate();                                           \
+        (void)szFile; (void)nLine;                                                  \
+        return POOL_FALLBACK_NEW( nSize, szFile, nLine );                           \
+    }                                                                               \
+    void classname::operator delete( void* pVoid, size_t nSize )                    \
+    {                                                                               \
+        if( pVoid == NULL )                                                         \
+            return;                                                                 \
+        if( nSize <= sizeof( classname ) )                                          \
+            GetPool()->Free( pVoid );                                               \
+        else                                                                        \
+            ::operator delete( pVoid );                                             \
+    }                                                                               \
+    void classname::operator delete( void* pVoid, const char*, unsigned int )       \
+    {                                                                               \
+        classname::operator delete( pVoid, sizeof( classname ) );                   \
+    }
+
+#endif // #ifndef _POOLALLOCATOR_H_
@@ -0,0 +1,203 @@
+/*********************************************************\
+File:       Profiler.cpp
+Purpose:    Hierarchical CPU profiler
+\*********************************************************/
+#include "Profiler.h"
+#include <stdlib.h>
+#include <string.h>
+
+//-----------------------------------------------------------------------------
+//  Thread buffers
+//  Allocated with calloc, so creating one never shows up as a heap
+//  allocation inside a frame, and never freed: a thread's last events
+//  should still be around after it exits
+//-----------------------------------------------------------------------------
+THREAD_LOCAL ProfileThread* g_pProfileThread = NULL;
+
+static ProfileThread* volatile  gs_pFirstProfileThread = NULL;
+static volatile sint32          gs_nNumProfileThreads = 0;
+
+ProfileThread* ProfilerCreateThread( void )
+{
+    ProfileThread* pThread = (ProfileThread*)calloc( 1, sizeof( ProfileThread ) );
+    // TODO: Handle out of memory error ( pThread == 0 )
+    pThread->nThreadId = (uint)AtomicIncrement( &gs_nNumProfileThreads );
+
+    ProfileThread* pHead;
+    do
+    {
+        pHead = gs_pFirstProfileThread;
+        pThread->pNext = pHead;
+    } while( AtomicCompareExchangePointer( (void* volatile*)&gs_pFirstProfileThread, pThread, pHead ) != pHead );
+
+    g_pProfileThread = pThread;
+    return pThread;
+}
+
+ProfileThread* ProfilerGetFirstThread( void )
+{
+    return gs_pFirstProfileThread;
+}
+
+void ProfilerSetThreadName( const char* szName )
+{
+    ProfilerGetThread()->szName = szName;
+}
+
+//-----------------------------------------------------------------------------
+//  Frame tree
+//  At the end of the frame the frame's events are sorted by start time,
+//  which puts every parent before its children, then merged into the tree
+//  one at a time. g_pFrameNodes holds the last finished frame
+//-----------------------------------------------------------------------------
+static const uint   gs_nMaxProfileDepth = 64;
+static const float  gs_fAverageWeight = 0.1f;  // How much each new frame moves the average
+
+static ProfileNode  g_pFrameNodes[gs_nMaxProfileNodes];
+static uint         g_nNumFrameNodes = 0;
+static ProfileNode  g_pBuildNodes[gs_nMaxProfileNodes];
+
+static sint32       g_nFrameFirstEvent = 0;
+static uint         g_nFrameBaseDepth = 0;
+static uint64       g_nFrameStart = 0;
+
+static uint         g_pSortedEvents[gs_nProfileEventsPerThread];
+static ProfileEvent* g_pSortingEvents = NULL;
+
+static int CompareEvents( const void* pLeft, const void* pRight )
+{
+    const ProfileEvent& left = g_pSortingEvents[ *(const uint*)pLeft ];
+    const ProfileEvent& right = g_pSortingEvents[ *(const uint*)pRight ];
+    if( left.nStart != right.nStart )
+        return left.nStart < right.nStart ? -1 : 1;
+    // Timestamps can tie, the parent still has to come first
+    if( left.nDepth != right.nDepth )
+        return left.nDepth < right.nDepth ? -1 : 1;
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+//  FindOrAddChild
+//  Returns the node for szName under nParent, or gs_nMaxProfileNodes if the
+//  tree is full
+//-----------------------------------------------------------------------------
+static uint FindOrAddChild( uint* pNumNodes, uint nParent, const char* szName )
+{
+    for( uint nNode = nParent + 1; nNode < *pNumNodes; ++nNode )
+    {
+        if( g_pBuildNodes[nNode].nParent == nParent && g_pBuildNodes[nNode].szName == szName )
+            return nNode;
+    }
+    if( *pNumNodes == gs_nMaxProfileNodes )
+        return gs_nMaxProfileNodes;
+
+    uint nNode = (*pNumNodes)++;
+    ProfileNode& node = g_pBuildNodes[nNode];
+    node.szName = szName;
+    node.nParent = nParent;
+    node.nDepth = g_pBuildNodes[nParent].nDepth + 1;
+    node.nCalls = 0;
+    node.fMilliseconds = 0.0f;
+    node.fAverageMilliseconds = 0.0f;
+    return nNode;
+}
+
+//-----------------------------------------------------------------------------
+//  FindLastFrameNode
+//  Finds the same node in the last frame's tree, by name, depth and parent
+//  name, to carry its average forward
+//-----------------------------------------------------------------------------
+static const ProfileNode* FindLastFrameNode( const ProfileNode& node )
+{
+    for( uint nNode = 0; nNode < g_nNumFrameNodes; ++nNode )
+    {
+        const ProfileNode& last = g_pFrameNodes[nNode];
+        if( last.szName == node.szName 
+            && last.nDepth == node.nDepth 
+            && g_pFrameNodes[last.nParent].szName == g_pBuildNodes[node.nParent].szName )
+        {
+            return &last;
+        }
+    }
+    return NULL;
+}
+
+void ProfilerBeginFrame( void )
+{
+    ProfileThread* pThread = ProfilerGetThread();
+    g_nFrameFirstEvent = pThread->nWrite;
+    g_nFrameBaseDepth = pThread->nDepth;
+    g_nFrameStart = GetCPUTicks();
+}
+
+void ProfilerEndFrame( void )
+{
+    uint64 nFrameEnd = GetCPUTicks();
+    ProfileThread* pThread = ProfilerGetThread();
+    double fMillisecondsPerTick = 1000.0 / GetCPUTicksPerSecond();
+
+    // Only what's still in the ring buffer can be used
+    sint32 nLastEvent = pThread->nWrite;
+    sint32 nFirstEvent = g_nFrameFirstEvent;
+    if( nLastEvent - nFirstEvent > (sint32)gs_nProfileEventsPerThread )
+    {
+        nFirstEvent = nLastEvent - (sint32)gs_nProfileEventsPerThread;
+    }
+    uint nNumEvents = 0;
+    for( sint32 nEvent = nFirstEvent; nEvent != nLastEvent; ++nEvent )
+    {
+        uint nIndex = (uint)nEvent % gs_nProfileEventsPerThread;
+        // Scopes that were already open when the frame started aren't part of it
+        if( pThread->pEvents[nIndex].nDepth >= g_nFrameBaseDepth )
+        {
+            g_pSortedEvents[nNumEvents++] = nIndex;
+        }
+    }
+    g_pSortingEvents = pThread->pEvents;
+    qsort( g_pSortedEvents, nNumEvents, sizeof( uint ), CompareEvents );
+
+    // The root is the whole frame
+    uint nNumNodes = 1;
+    ProfileNode& root = g_pBuildNodes[0];
+    root.szName = "Frame";
+    root.nParent = 0;
+    root.nDepth = 0;
+    root.nCalls = 1;
+    root.fMilliseconds = (float)( ( nFrameEnd - g_nFrameStart ) * fMillisecondsPerTick );
+
+    uint pParents[gs_nMaxProfileDepth + 1] = { 0 };
+    for( uint nEvent = 0; nEvent < nNumEvents; ++nEvent )
+    {
+        const ProfileEvent& event = pThread->pEvents[ g_pSortedEvents[nEvent] ];
+        uint nDepth = event.nDepth - g_nFrameBaseDepth;
+        if( nDepth >= gs_nMaxProfileDepth )
+            continue;
+
+        uint nNode = FindOrAddChild( &nNumNodes, pParents[nDepth], event.szName );
+        if( nNode == gs_nMaxProfileNodes )
+            continue;
+
+        ++g_pBuildNodes[nNode].nCalls;
+        g_pBuildNodes[nNode].fMilliseconds += (float)( ( event.nEnd - event.nStart ) * fMillisecondsPerTick );
+        pParents[nDepth + 1] = nNode;
+    }
+
+    // Carry the averages forward
+    for( uint nNode = 0; nNode < nNumNodes; ++nNode )
+    {
+        ProfileNode& node = g_pBuildNodes[nNode];
+        const ProfileNode* pLast = FindLastFrameNode( node );
+        node.fAverageMilliseconds = pLast 
+            ? pLast->fAverageMilliseconds + ( node.fMilliseconds - pLast->fAverageMilliseconds ) * gs_fAverageWeight
+            : node.fMilliseconds;
+    }
+
+    memcpy( g_pFrameNodes, g_pBuildNodes, sizeof( ProfileNode ) * nNumNodes );
+    g_nNumFrameNodes = nNumNodes;
+}
+
+const ProfileNode* ProfilerGetFrame( uint* pNumNodes )
+{
+    *pNumNodes = g_nNumFrameNodes;
+    return g_pFrameNodes;
+}
@@ -0,0 +1,153 @@
+/*********************************************************\
+File:       Profiler.h
+Purpose:    Hierarchical CPU profiler
+\*********************************************************/
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+#include "Types.h"
+#include "Timer.h"
+#include "Atomic.h"
+
+//-----------------------------------------------------------------------------
+//  PROFILE_SCOPE( "name" ) times the rest of the enclosing scope. Scopes can
+//  be nested and used from any thread. Each thread writes finished scopes
+//  into its own ring buffer without locking, and the main thread turns its
+//  own scopes into a tree once a frame, in ProfilerEndFrame. Names have to
+//  be string literals (or at least outlive the profiler), only the pointer
+//  is stored.
+//  Define DISABLE_PROFILER to compile every scope out
+//-----------------------------------------------------------------------------
+#ifndef DISABLE_PROFILER
+#define PROFILE_SCOPE_NAME2( name, line ) name##line
+#define PROFILE_SCOPE_NAME( name, line ) PROFILE_SCOPE_NAME2( name, line )
+#define PROFILE_SCOPE( name ) CProfileScope PROFILE_SCOPE_NAME( profileScope, __LINE__ )( name )
+#else
+#define PROFILE_SCOPE( name )
+#endif // #ifndef DISABLE_PROFILER
+
+//-----------------------------------------------------------------------------
+//  ProfileEvent
+//  One finished scope. Scopes are written when they end, so children come
+//  before their parents
+//-----------------------------------------------------------------------------
+struct ProfileEvent
+{
+    const char* szName;
+    uint64      nStart;     // CPU ticks
+    uint64      nEnd;
+    uint        nDepth;     // 0 for the outermost scope
+};
+
+//-----------------------------------------------------------------------------
+//  ProfileThread
+//  A thread's ring buffer. Events are numbered from the start of the thread,
+//  event n lives at pEvents[n % gs_nProfileEventsPerThread], and everything
+//  from nWrite - gs_nProfileEventsPerThread to nWrite is still there
+//-----------------------------------------------------------------------------
+static const uint gs_nProfileEventsPerThread = 16 * 1024;
+
+struct ProfileThread
+{
+    ProfileEvent    pEvents[gs_nProfileEventsPerThread];
+    volatile sint32 nWrite;     // Only written by the owning thread
+    uint            nDepth;
+    uint            nThreadId;
+    const char*     szName;
+    ProfileThread*  pNext;
+};
+
+//-----------------------------------------------------------------------------
+//  ProfilerGetThread
+//  Returns the calling thread's buffer, creating it the first time
+//-----------------------------------------------------------------------------
+extern THREAD_LOCAL ProfileThread* g_pProfileThread;
+ProfileThread* ProfilerCreateThread( void );
+
+__forceinline ProfileThread* ProfilerGetThread( void )
+{
+    ProfileThread* pThread = g_pProfileThread;
+    if( pThread == NULL )
+    {
+        pThread = ProfilerCreateThread();
+    }
+    return pThread;
+}
+
+//-----------------------------------------------------------------------------
+//  ProfilerGetFirstThread
+//  Walks every thread that's ever profiled anything, through pNext
+//-----------------------------------------------------------------------------
+ProfileThread* ProfilerGetFirstThread( void );
+
+//-----------------------------------------------------------------------------
+//  ProfilerSetThreadName
+//  Names the calling thread, for tools that show every thread
+//-----------------------------------------------------------------------------
+void ProfilerSetThreadName( const char* szName );
+
+class CProfileScope
+{
+public:
+    __forceinline CProfileScope( const char* szName )
+        : m_szName( szName )
+        , m_pThread( ProfilerGetThread() )
+    {
+        ++m_pThread->nDepth;
+        m_nStart = GetCPUTicks();
+    }
+
+    __forceinline ~CProfileScope()
+    {
+        uint64 nEnd = GetCPUTicks();
+        sint32 nIndex = m_pThread->nWrite;
+        ProfileEvent& event = m_pThread->pEvents[ (uint)nIndex % gs_nProfileEventsPerThread ];
+        event.szName = m_szName;
+        event.nStart = m_nStart;
+        event.nEnd = nEnd;
+        event.nDepth = --m_pThread->nDepth;
+        AtomicStoreRelease( &m_pThread->nWrite, nIndex + 1 );
+    }
+
+private:
+    CProfileScope( const CProfileScope& );
+    CProfileScope& operator=( const CProfileScope& );
+
+    const char*     m_szName;
+    ProfileThread*  m_pThread;
+    uint64          m_nStart;
+};
+
+//-----------------------------------------------------------------------------
+//  ProfileNode
+//  One entry in the per-frame tree. Scopes with the same name under the same
+//  parent are merged. Nodes are stored parent first, children in the order
+//  they first ran
+//-----------------------------------------------------------------------------
+static const uint gs_nMaxProfileNodes = 256;
+
+struct ProfileNode
+{
+    const char* szName;
+    uint        nParent;        // Index of the parent node, the root is its own parent
+    uint        nDepth;         // 0 for the root
+    uint        nCalls;
+    float       fMilliseconds;  // Total for the frame, including children
+    float       fAverageMilliseconds; // Smoothed over the last few frames
+};
+
+//-----------------------------------------------------------------------------
+//  ProfilerBeginFrame/ProfilerEndFrame
+//  Bracket a frame on the main thread. ProfilerEndFrame builds the tree for
+//  everything the calling thread timed in between
+//-----------------------------------------------------------------------------
+void ProfilerBeginFrame( void );
+void ProfilerEndFrame( void );
+
+//-----------------------------------------------------------------------------
+//  ProfilerGetFrame
+//  Returns the last finished frame's tree and the number of nodes in it.
+//  Node 0 is the whole frame. Only valid until the next ProfilerEndFrame
+//-----------------------------------------------------------------------------
+const ProfileNode* ProfilerGetFrame( uint* pNumNodes );
+
+#endif // #ifndef _PROFILER_H_
@@ -5,34 +5,44 @@ Purpose:    Definition of the main engine
 #include "Common.h"
 #include "Riot.h"
 #include "Timer.h"
+#include "Profiler.h"
+#include "TraceCapture.h"
+#include "FrameStats.h"
+#include "Benchmark.h"
 #include <stdio.h> // For printf
 #include "Window.h"
-#include "Gfx\Graphics.h"
-#include "Scene\SceneGraph.h"
-#include "Scene\Object.h"
-#include "Scene\Terrain.h"
-#include "Gfx\View.h"
-#include "Gfx\Material.h"
-#include "Scene\ComponentManager.h"
+#include "Gfx/Graphics.h"
+#include "Scene/SceneGraph.h"
+#include "Scene/Object.h"
+#include "Scene/Terrain.h"
+#include "Gfx/View.h"
+#include "Gfx/Material.h"
+#include "Gfx/Mesh.h"
+#include "Scene/ComponentManager.h"
 #include "UI.h"
 
 #if defined( OS_WINDOWS )
-#include "PlatformDependent\Win32Window.h"
-#include "Gfx\D3DGraphics.h"
+#include "PlatformDependent/Win32Window.h"
+#include "Gfx/D3DGraphics.h"
 //#include "OpenGLDevice.h"
-#elif defined( OS_OSX )
-#include "PlatformDependent\OSXWindow.h"
-#include "Gfx\GLGraphics.h"
-#elif defined( OS_LINUX )
-#include "PlatformDependent\LinuxWindow.h"
-#include "Gfx\GLGraphics.h"
 #endif
+#include "PlatformDependent/NullWindow.h"
+#include "Gfx/NullGraphics.h"
+#include "Gfx/SoftGraphics.h"
 #include "Memory.h"
+#include "HeapProfiler.h"
+#include "VirtualArena.h"
+#include <stdlib.h> // For getenv
+#include <string.h> // For strcmp
+#include <math.h> // For fmodf, sinf and cosf
 #define new DEBUG_NEW
 
 uint                Riot::m_nFrameCount     = 0;
+uint                Riot::m_nTickCount      = 0;
 float               Riot::m_fElapsedTime    = 0.0f;
 float               Riot::m_fRunningTime    = 0.0f;
+float               Riot::m_fTickTime       = 1.0f/60.0f;
+uint                Riot::m_nMaxTicksPerFrame = 5;
 RiotInput*          Riot::m_pInput          = NULL;
 CWindow*            Riot::m_pMainWindow     = NULL;
 CGraphics*          Riot::m_pGraphics       = NULL;
@@ -41,126 +51,478 @@ CComponentManager*  Riot::m_pComponentManager = NULL;
 CView*              Riot::m_pMainView       = NULL;
 
 bool                Riot::m_bRunning        = true;
+
+// Where the frame time statistics go at shutdown, if anywhere
+static const char*  gs_szFrameStatsFile     = NULL;
+
+// Input recordings to write and play back, if any
+static const char*  gs_szInputRecordFile    = NULL;
+static const char*  gs_szInputReplayFile    = NULL;
+
+//-----------------------------------------------------------------------------
+//  Graphics backends
+//  Null draws nothing, and runs without a window or GPU. Soft draws
+//  everything on the CPU, into an offscreen framebuffer. They're the only
+//  backends off Windows until there's a GL one
+//-----------------------------------------------------------------------------
+enum eGraphicsBackend
+{
+    eGraphicsBackendD3D,
+    eGraphicsBackendNull,
+    eGraphicsBackendSoft,
+
+    eNUMGRAPHICSBACKENDS
+};
+
+static const char* gs_szGraphicsBackendNames[eNUMGRAPHICSBACKENDS] = { "d3d", "null", "soft" };
+
+#if defined( OS_WINDOWS )
+static eGraphicsBackend gs_nGraphicsBackend = eGraphicsBackendD3D;
+#else
+static eGraphicsBackend gs_nGraphicsBackend = eGraphicsBackendNull;
+#endif // #if defined( OS_WINDOWS )
+
+//-----------------------------------------------------------------------------
+//  Scene size and benchmarking
+//  -objects fills the scene with cubes, placed the same way every time for
+//  a given -seed. A benchmark runs a fixed number of frames with one
+//  simulation tick each and the camera on a fixed path, so runs only
+//  differ in how long things took
+//-----------------------------------------------------------------------------
+static uint         gs_nNumSceneObjects     = 0;        // Besides the terrain
+static uint         gs_nSceneSeed           = 1;
+static uint         gs_nNumFrames           = 0;        // 0 runs until quit
+static uint         gs_nWarmupFrames        = 10;       // The first frames pay for one-time setup
+static bool         gs_bBenchmark           = false;
+static const char*  gs_szBenchmarkFile      = "benchmark.json";
+static const uint   gs_nDefaultBenchmarkFrames = 1000;
+static const uint   gs_nBenchmarkCameraFrames = 600;    // Frames per trip around the scene
+static uint64       gs_nSceneRandomState    = 0;
+
+//-----------------------------------------------------------------------------
+//  SceneRandom
+//  xorshift64*, returning [0, 1)
+//-----------------------------------------------------------------------------
+static float SceneRandom( void )
+{
+    gs_nSceneRandomState ^= gs_nSceneRandomState >> 12;
+    gs_nSceneRandomState ^= gs_nSceneRandomState << 25;
+    gs_nSceneRandomState ^= gs_nSceneRandomState >> 27;
+    uint64 nRandom = gs_nSceneRandomState * 0x2545F4914F6CDD1DULL;
+    return (float)( nRandom >> 40 ) * ( 1.0f / 16777216.0f );
+}
+
+//-----------------------------------------------------------------------------
+//  MoveBenchmarkCamera
+//  Circles the terrain, bobbing up and down, always looking at the middle
+//-----------------------------------------------------------------------------
+static void MoveBenchmarkCamera( CView* pView, uint nFrame )
+{
+    float fAngle = (float)( nFrame % gs_nBenchmarkCameraFrames ) * ( 2.0f * gs_fPi / gs_nBenchmarkCameraFrames );
+    pView->SetPosition( RVector4( 128.0f + 160.0f * cosf( fAngle ),
+                                  60.0f + 20.0f * sinf( fAngle * 2.0f ),
+                                  128.0f + 160.0f * sinf( fAngle ),
+                                  0.0f ) );
+    pView->LookAt( RVector4( 128.0f, 0.0f, 128.0f, 0.0f ) );
+}
+
+//-----------------------------------------------------------------------------
+//  Memory budgets, in bytes. Going over one prints a warning
+//-----------------------------------------------------------------------------
+static const uint64 gs_pMemoryBudgets[eNUMMEMORYCATEGORIES] =
+{
+    0,                      // General
+    64  * 1024 * 1024,      // Scene
+    64  * 1024 * 1024,      // Gfx
+    4   * 1024 * 1024,      // UI
+    64  * 1024 * 1024,      // Terrain
+    64  * 1024 * 1024,      // Components
+    128 * 1024 * 1024,      // Assets
+};
+
+//-----------------------------------------------------------------------------
+//  DrawMemoryStats
+//  Lists the memory categories on screen, starting at nTop
+//-----------------------------------------------------------------------------
+static void DrawMemoryStats( uint nTop )
+{
+    char szLine[ 255 ];
+    sprintf_s( szLine, 255, "%-12s %10s %10s %8s %10s", "Memory", "Live KB", "Peak KB", "Allocs", "Allocs/f" );
+    UI::AddString( 10, nTop, szLine );
+
+    for( uint nCategory = 0; nCategory < eNUMMEMORYCATEGORIES; ++nCategory )
+    {
+        MemoryCategoryStats stats;
+        GetMemoryCategoryStats( (eMemoryCategory)nCategory, &stats );
+        bool bOverBudget = stats.nBudget != 0 && stats.nBytesLive > (sint64)stats.nBudget;
+
+        nTop += 20;
+        sprintf_s( szLine, 255, "%-12s %10lld %10lld %8lld %10llu%s",
+                   GetMemoryCategoryName( (eMemoryCategory)nCategory ),
+                   (long long)( stats.nBytesLive / 1024 ),
+                   (long long)( stats.nPeakBytesLive / 1024 ),
+                   (long long)stats.nAllocationsLive,
+                   (unsigned long long)stats.nAllocationsLastFrame,
+                   bOverBudget ? " OVER BUDGET" : "" );
+        UI::AddString( 10, nTop, szLine );
+    }
+
+    nTop += 20;
+    sprintf_s( szLine, 255, "%-12s %10llu", "Arenas",
+               (unsigned long long)( CVirtualArena::GetTotalCommitted() / 1024 ) );
+    UI::AddString( 10, nTop, szLine );
+}
     
+//-----------------------------------------------------------------------------
+//  DrawProfile
+//  Lists last frame's profile as a tree, starting at nTop
+//-----------------------------------------------------------------------------
+static void DrawProfile( uint nTop )
+{
+    char szLine[ 255 ];
+    sprintf_s( szLine, 255, "%-32s %8s %8s %6s", "Profile", "ms", "avg ms", "calls" );
+    UI::AddString( 10, nTop, szLine );
+
+    uint nNumNodes = 0;
+    const ProfileNode* pNodes = ProfilerGetFrame( &nNumNodes );
+    for( uint nNode = 0; nNode < nNumNodes; ++nNode )
+    {
+        const ProfileNode& node = pNodes[nNode];
+        nTop += 20;
+        sprintf_s( szLine, 255, "%*s%-*s %8.3f %8.3f %6u",
+                   node.nDepth * 2, "",
+                   32 - (int)node.nDepth * 2, node.szName,
+                   node.fMilliseconds,
+                   node.fAverageMilliseconds,
+                   node.nCalls );
+        UI::AddString( 10, nTop, szLine );
+    }
+}
+
+//-----------------------------------------------------------------------------
+//  RecordFrameStats
+//  Adds the frame time, and the time of each top level profile scope, to
+//  the frame statistics
+//-----------------------------------------------------------------------------
+static void RecordFrameStats( float fElapsedTime )
+{
+    FrameStatsRecord( "Frame", fElapsedTime * 1000.0f );
+
+    uint nNumNodes = 0;
+    const ProfileNode* pNodes = ProfilerGetFrame( &nNumNodes );
+    for( uint nNode = 0; nNode < nNumNodes; ++nNode )
+    {
+        if( pNodes[nNode].nDepth == 1 )
+        {
+            FrameStatsRecord( pNodes[nNode].szName, pNodes[nNode].fMilliseconds );
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//  GetDrawStats
+//  Fills in the draw counts from the backends that keep them
+//-----------------------------------------------------------------------------
+static void GetDrawStats( CGraphics* pGraphics, BenchmarkFrame* pFrame )
+{
+    pFrame->nDraws = 0;
+    pFrame->nTriangles = 0;
+    pFrame->nTrianglesDrawn = 0;
+    pFrame->nStateChanges = 0;
+
+    if( gs_nGraphicsBackend == eGraphicsBackendNull )
+    {
+        const NullGraphicsStats& stats = ( (CNullGraphics*)pGraphics )->GetFrameStats();
+        pFrame->nDraws = stats.nDraws;
+        pFrame->nTriangles = stats.nTriangles;
+        pFrame->nTrianglesDrawn = stats.nTriangles;
+        pFrame->nStateChanges = stats.nStateChanges;
+    }
+    else if( gs_nGraphicsBackend == eGraphicsBackendSoft )
+    {
+        const SoftGraphicsStats& stats = ( (CSoftGraphics*)pGraphics )->GetFrameStats();
+        pFrame->nDraws = stats.nDraws;
+        pFrame->nTriangles = stats.nTriangles;
+        pFrame->nTrianglesDrawn = stats.nTrianglesDrawn;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//  DrawFrameStats
+//  Lists the frame time percentiles over the last window, starting at nTop
+//-----------------------------------------------------------------------------
+static void DrawFrameStats( uint nTop )
+{
+    char szLine[ 255 ];
+    sprintf_s( szLine, 255, "%-16s %8s %8s %8s %8s %8s", "Frame times", "avg ms", "p50", "p95", "p99", "max" );
+    UI::AddString( 10, nTop, szLine );
+
+    FrameTimeSummary pSummaries[gs_nMaxFrameStatSeries];
+    uint nNumSummaries = FrameStatsGetSummaries( pSummaries, gs_nMaxFrameStatSeries, false );
+    for( uint nSummary = 0; nSummary < nNumSummaries; ++nSummary )
+    {
+        const FrameTimeSummary& summary = pSummaries[nSummary];
+        nTop += 20;
+        sprintf_s( szLine, 255, "%-16s %8.3f %8.3f %8.3f %8.3f %8.3f",
+                   summary.szName,
+                   summary.fAverage,
+                   summary.fP50,
+                   summary.fP95,
+                   summary.fP99,
+                   summary.fMax );
+        UI::AddString( 10, nTop, szLine );
+    }
+}
+
 //-----------------------------------------------------------------------------
 //  Run
 //  Starts the engine/game. All variables are set programatically
 //-----------------------------------------------------------------------------
-void Riot::Run( void )
+void Riot::Run( int nArgCount, char* ppArgs[] )
 {
     //-----------------------------------------------------------------------------
     // Initialization
-    // TODO: Parse command line
-    Initialize();
-
     Timer timer; // TODO: Should the timer be a class member?
     timer.Reset();
-    float fFPSTime = 0.0f; // TODO: What's the best way to calculate FPS?
-    float fFPS = 0.0f;
+    ParseCommandLine( nArgCount, ppArgs );
+    Initialize();
+    float fLoadTime = (float)timer.GetTime();
+
+    // Close off loading, so the first frame's memory counters only cover
+    // the frame
+    MemoryEndFrame();
+
+    if( gs_bBenchmark )
+    {
+        BenchmarkSettings settings;
+        settings.szFilename = gs_szBenchmarkFile;
+        settings.szBackend = gs_szGraphicsBackendNames[gs_nGraphicsBackend];
+        settings.nNumObjects = gs_nNumSceneObjects;
+        settings.nNumFrames = gs_nNumFrames;
+        settings.nWarmupFrames = gs_nWarmupFrames;
+        settings.nSeed = gs_nSceneSeed;
+        BenchmarkBegin( settings, fLoadTime * 1000.0f );
+    }
+    float fTickAccumulator = 0.0f; // Real time the simulation hasn't caught up on
+    bool bShowMemoryStats = false;
+    bool bShowProfile = false;
+    bool bShowFrameStats = false;
     //-----------------------------------------------------------------------------
     while( m_bRunning )
     {
         //---------------------- Start of frame --------------------
+        MemoryBeginFrame();
+        ProfilerBeginFrame();
+        TraceBeginFrame( m_nFrameCount );
         // pMessageSystem->ProcessMessages();
         // pSceneGraph->StartFrame();
         // pRender->StartFrame();
-        m_pInput->PollInput();
-        if( m_pInput->IsKeyDown( VK_ESCAPE ) )
+        {
+            PROFILE_SCOPE( "Input" );
+            m_pInput->PollInput( gs_bBenchmark ? m_fTickTime : m_fElapsedTime );
+        }
+        // The time this frame simulates. A replay plays back the recorded
+        // times, so the camera and ticks move exactly as they did. Its last
+        // frame is the last one run
+        float fFrameTime = m_pInput->GetFrameTime();
+        if( m_pInput->IsKeyDown( VK_ESCAPE ) || m_pInput->IsReplayFinished() )
             m_bRunning = false;
 
+        // Toggle the memory, profiler and frame time displays
+        if( m_pInput->WasKeyJustPressed( VK_F1 ) )
+            bShowMemoryStats = !bShowMemoryStats;
+        if( m_pInput->WasKeyJustPressed( VK_F3 ) )
+            bShowProfile = !bShowProfile;
+        if( m_pInput->WasKeyJustPressed( VK_F5 ) )
+            bShowFrameStats = !bShowFrameStats;
+
+        // Start or stop a trace capture
+        if( m_pInput->WasKeyJustPressed( VK_F4 ) )
+        {
+            if( TraceIsCapturing() )
+                TraceStopCapture();
+            else
+                TraceStartCapture( "trace.json" );
+        }
+
+        // Write out a heap profile
+        if( m_pInput->WasKeyJustPressed( VK_F2 ) && HeapProfilerIsEnabled() )
+        {
+            ALLOW_FRAME_ALLOCATIONS();
+            HeapProfilerWrite( "heap_profile.collapsed", eHeapProfileCollapsed );
+            HeapProfilerWrite( "heap_profile.heap", eHeapProfilePprof );
+        }
+
         // Add a box everytime UP arrow is pressed
         if( m_pInput->WasKeyPressed( VK_UP ) )
         {
+            ALLOW_FRAME_ALLOCATIONS();
             CObject* pObject = new CObject();
-            CMesh*   pMesh = m_pGraphics->CreateMesh( L"lol not loading a mesh!" );
+            RefPtr<CMesh> pMesh = AdoptRef( m_pGraphics->CreateMesh( L"lol not loading a mesh!" ) );
             pObject->SetMesh( pMesh );
-            CMaterial* pMaterial = m_pGraphics->CreateMaterial( L"Assets/Shaders/StandardVertexShader.hlsl", "PS", "ps_4_0" );
+            RefPtr<CMaterial> pMaterial = AdoptRef( m_pGraphics->CreateMaterial( L"Assets/Shaders/StandardVertexShader.hlsl", "PS", "ps_4_0" ) );
             pObject->SetMaterial( pMaterial );
-            m_pSceneGraph->AddObject( pObject );
-            pObject->AddComponent( eComponentPosition );
-        }
-
-        // Move camera
-        float fCameraSpeed = 10.0f;
-        float fCameraRotationSpeed = fCameraSpeed * 0.15f;
-        if( m_pInput->IsKeyDown( 'W' ) ) // forward
-        {
-            if( m_pInput->IsKeyDown( VK_CONTROL ) )
+            if( m_pSceneGraph->AddObject( pObject ) )
             {
-                m_pMainView->RotateX( -m_fElapsedTime * fCameraRotationSpeed );
+                pObject->AddComponent( eComponentPosition );
             }
             else
-            {
-                m_pMainView->TranslateZ( m_fElapsedTime * fCameraSpeed );
+            {   // The scene's full
+                SAFE_DELETE( pObject );
             }
         }
-        if( m_pInput->IsKeyDown( 'A' ) ) // left
+
+        // Move camera. The camera isn't part of the simulation, so it moves
+        // every frame, but no further than the simulation can catch up.
+        // Benchmarks fly it along a fixed path instead, unless they're
+        // replaying a recording
+        if( gs_bBenchmark && !m_pInput->IsReplaying() )
+        {
+            MoveBenchmarkCamera( m_pMainView, m_nFrameCount );
+        }
+        else
         {
-            if( m_pInput->IsKeyDown( VK_CONTROL ) )
+            float fCameraTime = fFrameTime;
+            if( fCameraTime > m_fTickTime * m_nMaxTicksPerFrame )
             {
-                m_pMainView->RotateY( -m_fElapsedTime * fCameraRotationSpeed );
+                fCameraTime = m_fTickTime * m_nMaxTicksPerFrame;
             }
-            else
+            float fCameraSpeed = 10.0f;
+            float fCameraRotationSpeed = fCameraSpeed * 0.15f;
+            if( m_pInput->IsKeyDown( 'W' ) ) // forward
             {
-                m_pMainView->TranslateX( -m_fElapsedTime * fCameraSpeed );
+                if( m_pInput->IsKeyDown( VK_CONTROL ) )
+                {
+                    m_pMainView->RotateX( -fCameraTime * fCameraRotationSpeed );
+                }
+                else
+                {
+                    m_pMainView->TranslateZ( fCameraTime * fCameraSpeed );
+                }
             }
-        }
-        if( m_pInput->IsKeyDown( 'S' ) ) // back
-        {
-            if( m_pInput->IsKeyDown( VK_CONTROL ) )
+            if( m_pInput->IsKeyDown( 'A' ) ) // left
             {
-                m_pMainView->RotateX( m_fElapsedTime * fCameraRotationSpeed );
+                if( m_pInput->IsKeyDown( VK_CONTROL ) )
+                {
+                    m_pMainView->RotateY( -fCameraTime * fCameraRotationSpeed );
+                }
+                else
+                {
+                    m_pMainView->TranslateX( -fCameraTime * fCameraSpeed );
+                }
             }
-            else
+            if( m_pInput->IsKeyDown( 'S' ) ) // back
             {
-                m_pMainView->TranslateZ( -m_fElapsedTime * fCameraSpeed );
+                if( m_pInput->IsKeyDown( VK_CONTROL ) )
+                {
+                    m_pMainView->RotateX( fCameraTime * fCameraRotationSpeed );
+                }
+                else
+                {
+                    m_pMainView->TranslateZ( -fCameraTime * fCameraSpeed );
+                }
             }
-        }
-        if( m_pInput->IsKeyDown( 'D' ) ) // right
-        {
-            if( m_pInput->IsKeyDown( VK_CONTROL ) )
+            if( m_pInput->IsKeyDown( 'D' ) ) // right
             {
-                m_pMainView->RotateY( m_fElapsedTime * fCameraRotationSpeed );
+                if( m_pInput->IsKeyDown( VK_CONTROL ) )
+                {
+                    m_pMainView->RotateY( fCameraTime * fCameraRotationSpeed );
+                }
+                else
+                {
+                    m_pMainView->TranslateX( fCameraTime * fCameraSpeed );
+                }
             }
-            else
+            if( m_pInput->IsKeyDown( 'E' ) ) // up
             {
-                m_pMainView->TranslateX( m_fElapsedTime * fCameraSpeed );
+                m_pMainView->TranslateY( fCameraTime * fCameraSpeed );
+            }
+            if( m_pInput->IsKeyDown( 'Q' ) ) // down
+            {
+                m_pMainView->TranslateY( -fCameraTime * fCameraSpeed );
             }
-        }
-        if( m_pInput->IsKeyDown( 'E' ) ) // up
-        {
-            m_pMainView->TranslateY( m_fElapsedTime * fCameraSpeed );
-        }
-        if( m_pInput->IsKeyDown( 'Q' ) ) // down
-        {
-            m_pMainView->TranslateY( -m_fElapsedTime * fCameraSpeed );
         }
 
         //-------------------------- Frame -------------------------
 
         //////////////////////////////////////////
         // Update
-        m_pSceneGraph->UpdateObjects( m_fElapsedTime );
+        // The simulation runs in fixed ticks, as many as it takes to catch
+        // up with real time, then the meshes are placed between the last
+        // two ticks. Past m_nMaxTicksPerFrame the simulation gives up on
+        // catching up rather than spending ever longer frames trying
+        {
+            PROFILE_SCOPE( "Update" );
+            fTickAccumulator += fFrameTime;
+            uint nTicks = 0;
+            while( fTickAccumulator >= m_fTickTime && nTicks < m_nMaxTicksPerFrame )
+            {
+                m_pSceneGraph->UpdateObjects( m_fTickTime );
+                fTickAccumulator -= m_fTickTime;
+                ++nTicks;
+                ++m_nTickCount;
+            }
+            if( fTickAccumulator >= m_fTickTime )
+            {   // Drop the time we couldn't simulate, keeping the fraction
+                fTickAccumulator = fmodf( fTickAccumulator, m_fTickTime );
+            }
+
+            m_pSceneGraph->InterpolateObjects( fTickAccumulator / m_fTickTime );
+        }
 
 
         //////////////////////////////////////////
         // Render
-        m_pGraphics->PrepareRender();
+        {
+            PROFILE_SCOPE( "Render" );
+            m_pGraphics->PrepareRender();
 
-        // draw scene
-        uint nNumRenderObjects = 0;
-        CObject** ppObjects = m_pSceneGraph->GetRenderObjects( &nNumRenderObjects );
-        m_pGraphics->Render( ppObjects, nNumRenderObjects );
+            // draw scene
+            uint nNumRenderObjects = 0;
+            CObject** ppObjects = m_pSceneGraph->GetRenderObjects( &nNumRenderObjects );
+            m_pGraphics->Render( ppObjects, nNumRenderObjects );
+        }
 
         // draw some text
         char szFPS[ 255 ];
-        XMVECTOR vCamPos = m_pMainView->GetPosition();
-        sprintf_s( szFPS, 255, "Camera: (%f, %f, %f)", XMVectorGetX(vCamPos), XMVectorGetY(vCamPos), XMVectorGetZ(vCamPos) );
+        const RVector4& vCamPos = m_pMainView->GetPosition();
+        sprintf_s( szFPS, 255, "Camera: (%f, %f, %f)", vCamPos.x, vCamPos.y, vCamPos.z );
         UI::AddString( 10, 30, szFPS );
 
-        UI::Draw();
+        if( bShowMemoryStats )
+        {
+            DrawMemoryStats( 50 );
+        }
+        if( bShowProfile )
+        {
+            DrawProfile( bShowMemoryStats ? 250 : 50 );
+        }
+        if( bShowFrameStats )
+        {
+            DrawFrameStats( bShowMemoryStats || bShowProfile ? 550 : 50 );
+        }
+
+        // Frame times over the last window. The worst frames are what
+        // make it feel slow, so show the 99th percentile next to the fps
+        {
+            FrameTimeSummary frameSummary;
+            if( FrameStatsGetSummaries( &frameSummary, 1, false ) > 0 && frameSummary.fAverage > 0.0f )
+            {
+                sprintf_s( szFPS, 255, "fps: %.1f  avg: %.2f ms  p99: %.2f ms",
+                           1000.0f / frameSummary.fAverage, frameSummary.fAverage, frameSummary.fP99 );
+                UI::AddString( 10, 10, szFPS );
+            }
+        }
 
-        m_pGraphics->Present();
+        {
+            PROFILE_SCOPE( "UI::Draw" );
+            UI::Draw();
+        }
+
+        {
+            PROFILE_SCOPE( "Present" );
+            m_pGraphics->Present();
+        }
 
         //----------------------- End of frame ---------------------
         // Perform system messaging
@@ -169,26 +531,203 @@ void Riot::Run( void )
         // Perform timing
         ++m_nFrameCount;
         m_fElapsedTime = (float)timer.GetTime();
-        if( m_fElapsedTime > 0.5f )
-        {   // Protection from huge lapses when debugging
-            m_fElapsedTime = 1.0f/60.0f;
-        }
         m_fRunningTime += m_fElapsedTime;
-        fFPSTime += m_fElapsedTime;
-        // Calculate FPS every 16 frames
-        if( ( m_nFrameCount & 0xF ) == 0x0 )
+
+        // Destroy anything that was released during the frame
+        ProcessDeferredReleases();
+
+        // Close off the frame's timings and counters
+        ProfilerEndFrame();
+        RecordFrameStats( m_fElapsedTime );
+
+        // Release the frame memory from last frame. This also closes off
+        // the memory counters, so the trace gets this frame's allocations
+        MemoryEndFrame();
+        {
+            MemoryStats memoryStats;
+            GetMemoryStats( &memoryStats );
+            TraceCounter( "Objects", (double)m_pSceneGraph->GetNumObjects() );
+            TraceCounter( "Heap KB", (double)memoryStats.nBytesLive / 1024.0 );
+            TraceCounter( "Allocations/frame", (double)memoryStats.nAllocationsLastFrame );
+        }
+        TraceEndFrame();
+
+        // Stop after -frames, or when the benchmark has all its frames. The
+        // memory counters are only closed off by MemoryEndFrame
+        if( gs_bBenchmark )
         {
-            fFPS = 16.0f / fFPSTime;
-            fFPSTime = 0.0f;
+            BenchmarkFrame benchmarkFrame;
+            benchmarkFrame.fFrameMs = m_fElapsedTime * 1000.0f;
+            MemoryStats memoryStats;
+            GetMemoryStats( &memoryStats );
+            benchmarkFrame.nAllocations = memoryStats.nAllocationsLastFrame;
+            benchmarkFrame.nBytesAllocated = memoryStats.nBytesAllocatedLastFrame;
+            GetDrawStats( m_pGraphics, &benchmarkFrame );
+            if( !BenchmarkRecordFrame( benchmarkFrame ) )
+                m_bRunning = false;
+        }
+        else if( gs_nNumFrames != 0 && m_nFrameCount >= gs_nNumFrames )
+        {
+            m_bRunning = false;
         }
-        sprintf_s( szFPS, 255, "fps: %f", fFPS );
-        UI::AddString( 10, 10, szFPS );
     }
     //-----------------------------------------------------------------------------
 
     //-----------------------------------------------------------------------------
     // Cleanup
     //-----------------------------------------------------------------------------
+    if( gs_bBenchmark && !BenchmarkEnd() )
+    {
+        printf( "Couldn't write benchmark results to %s\n", gs_szBenchmarkFile );
+    }
+}
+
+//-----------------------------------------------------------------------------
+//  ParseCommandLine
+//  Applies the command line options. Called from Run, before Initialize
+//      -trace <file>                   Capture a trace of the whole run
+//      -traceframes <first> <last>     Only capture these frames
+//      -framestats <file>              Write frame time statistics at exit
+//      -framewindow <frames>           Frames the on-screen statistics cover
+//      -tickrate <hz>                  Simulation ticks per second
+//      -maxticks <ticks>               Most ticks to catch up on in a frame
+//      -backend <d3d|null|soft>        Graphics backend. null and soft need no GPU
+//      -objects <count>                Cubes to fill the scene with
+//      -seed <seed>                    Where -objects puts them
+//      -frames <count>                 Quit after this many frames
+//      -bench                          Benchmark: -frames frames (1000 if not given)
+//                                      with a scripted camera, then write results
+//      -benchfile <file>               Benchmark results, .csv for a row per frame,
+//                                      JSON otherwise. benchmark.json by default
+//      -warmup <frames>                Frames to run before the benchmark starts, 10
+//                                      by default
+//      -record <file>                  Record the keyboard and frame times
+//      -replay <file>                  Play back a recording instead of the keyboard,
+//                                      and quit when it ends
+//  Options can start with -- as well
+//-----------------------------------------------------------------------------
+void Riot::ParseCommandLine( int nArgCount, char* ppArgs[] )
+{
+    const char* szTraceFile = NULL;
+    uint nFirstTraceFrame = 0;
+    uint nLastTraceFrame = 0xFFFFFFFF;
+    for( int nArg = 1; nArg < nArgCount; ++nArg )
+    {
+        if( ppArgs[nArg][0] == '-' && ppArgs[nArg][1] == '-' )
+        {
+            ++ppArgs[nArg];
+        }
+
+        if( strcmp( ppArgs[nArg], "-trace" ) == 0 && nArg + 1 < nArgCount )
+        {
+            szTraceFile = ppArgs[++nArg];
+        }
+        else if( strcmp( ppArgs[nArg], "-traceframes" ) == 0 && nArg + 2 < nArgCount )
+        {
+            nFirstTraceFrame = (uint)strtoul( ppArgs[++nArg], NULL, 10 );
+            nLastTraceFrame = (uint)strtoul( ppArgs[++nArg], NULL, 10 );
+            if( szTraceFile == NULL )
+            {
+                szTraceFile = "trace.json";
+            }
+        }
+        else if( strcmp( ppArgs[nArg], "-framestats" ) == 0 && nArg + 1 < nArgCount )
+        {
+            gs_szFrameStatsFile = ppArgs[++nArg];
+        }
+        else if( strcmp( ppArgs[nArg], "-framewindow" ) == 0 && nArg + 1 < nArgCount )
+        {
+            FrameStatsSetWindow( (uint)strtoul( ppArgs[++nArg], NULL, 10 ) );
+        }
+        else if( strcmp( ppArgs[nArg], "-tickrate" ) == 0 && nArg + 1 < nArgCount )
+        {
+            float fTickRate = (float)atof( ppArgs[++nArg] );
+            if( fTickRate > 0.0f )
+            {
+                m_fTickTime = 1.0f / fTickRate;
+            }
+        }
+        else if( strcmp( ppArgs[nArg], "-maxticks" ) == 0 && nArg + 1 < nArgCount )
+        {
+            uint nMaxTicks = (uint)strtoul( ppArgs[++nArg], NULL, 10 );
+            m_nMaxTicksPerFrame = nMaxTicks ? nMaxTicks : 1;
+        }
+        else if( strcmp( ppArgs[nArg], "-backend" ) == 0 && nArg + 1 < nArgCount )
+        {
+            const char* szBackend = ppArgs[++nArg];
+            uint nBackend = 0;
+            while( nBackend < eNUMGRAPHICSBACKENDS && strcmp( szBackend, gs_szGraphicsBackendNames[nBackend] ) != 0 )
+            {
+                ++nBackend;
+            }
+#if !defined( OS_WINDOWS )
+            if( nBackend == eGraphicsBackendD3D )
+            {
+                nBackend = eNUMGRAPHICSBACKENDS;
+            }
+#endif // #if !defined( OS_WINDOWS )
+            if( nBackend < eNUMGRAPHICSBACKENDS )
+            {
+                gs_nGraphicsBackend = (eGraphicsBackend)nBackend;
+            }
+            else
+            {
+                printf( "Unknown graphics backend: %s\n", szBackend );
+            }
+        }
+        else if( strcmp( ppArgs[nArg], "-objects" ) == 0 && nArg + 1 < nArgCount )
+        {
+            gs_nNumSceneObjects = (uint)strtoul( ppArgs[++nArg], NULL, 10 );
+        }
+        else if( strcmp( ppArgs[nArg], "-seed" ) == 0 && nArg + 1 < nArgCount )
+        {
+            gs_nSceneSeed = (uint)strtoul( ppArgs[++nArg], NULL, 10 );
+        }
+        else if( strcmp( ppArgs[nArg], "-frames" ) == 0 && nArg + 1 < nArgCount )
+        {
+            gs_nNumFrames = (uint)strtoul( ppArgs[++nArg], NULL, 10 );
+        }
+        else if( strcmp( ppArgs[nArg], "-bench" ) == 0 )
+        {
+            gs_bBenchmark = true;
+        }
+        else if( strcmp( ppArgs[nArg], "-benchfile" ) == 0 && nArg + 1 < nArgCount )
+        {
+            gs_szBenchmarkFile = ppArgs[++nArg];
+        }
+        else if( strcmp( ppArgs[nArg], "-warmup" ) == 0 && nArg + 1 < nArgCount )
+        {
+            gs_nWarmupFrames = (uint)strtoul( ppArgs[++nArg], NULL, 10 );
+        }
+        else if( strcmp( ppArgs[nArg], "-record" ) == 0 && nArg + 1 < nArgCount )
+        {
+            gs_szInputRecordFile = ppArgs[++nArg];
+        }
+        else if( strcmp( ppArgs[nArg], "-replay" ) == 0 && nArg + 1 < nArgCount )
+        {
+            gs_szInputReplayFile = ppArgs[++nArg];
+        }
+        else
+        {
+            printf( "Unknown command line option: %s\n", ppArgs[nArg] );
+        }
+    }
+
+    if( szTraceFile )
+    {
+        TraceCaptureFrames( szTraceFile, nFirstTraceFrame, nLastTraceFrame );
+    }
+
+    // The camera and terrain take a slot each
+    if( gs_nNumSceneObjects > MAX_OBJECTS - 2 )
+    {
+        gs_nNumSceneObjects = MAX_OBJECTS - 2;
+        printf( "The scene can only hold %u objects\n", gs_nNumSceneObjects );
+    }
+    if( gs_bBenchmark && gs_nNumFrames == 0 )
+    {
+        gs_nNumFrames = gs_nDefaultBenchmarkFrames;
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -197,22 +736,63 @@ void Riot::Run( void )
 //-----------------------------------------------------------------------------
 void Riot::Initialize( void )
 {
+    ProfilerSetThreadName( "Main" );
+
+    //////////////////////////////////////////
+    // Set up memory budgets
+    for( uint nCategory = 0; nCategory < eNUMMEMORYCATEGORIES; ++nCategory )
+    {
+        SetMemoryBudget( (eMemoryCategory)nCategory, gs_pMemoryBudgets[nCategory] );
+    }
+
+    //////////////////////////////////////////
+    // Start the heap profiler if RIOT_HEAP_PROFILE is set. It's the mean
+    // number of bytes between samples, 0 for the default
+    const char* szHeapProfile = getenv( "RIOT_HEAP_PROFILE" );
+    if( szHeapProfile )
+    {
+        uint64 nSampleInterval = (uint64)strtoul( szHeapProfile, NULL, 10 );
+        if( nSampleInterval > 0 )
+            HeapProfilerEnable( nSampleInterval );
+        else
+            HeapProfilerEnable( );
+    }
+
+    //////////////////////////////////////////
+    // Check for heap allocations during frames if RIOT_FRAME_ALLOC_CHECK is
+    // set. It's the number of frames to skip while everything warms up.
+    // RIOT_FRAME_ALLOC_BREAK stops in the debugger instead of printing
+    const char* szFrameAllocCheck = getenv( "RIOT_FRAME_ALLOC_CHECK" );
+    if( szFrameAllocCheck )
+    {
+        uint nWarmupFrames = (uint)strtoul( szFrameAllocCheck, NULL, 10 );
+        SetFrameAllocCheck( getenv( "RIOT_FRAME_ALLOC_BREAK" ) ? eFrameAllocCheckBreak : eFrameAllocCheckReport,
+                            nWarmupFrames );
+    }
+
     //////////////////////////////////////////
     // Create window
     uint nWindowWidth = 1024,
          nWindowHeight = 768; // TODO: Read in from file
 
     // Create the new window object...
+    switch( gs_nGraphicsBackend )
+    {
 #if defined( OS_WINDOWS )
-    m_pMainWindow = new CWin32Window();
-    m_pGraphics = new CD3DGraphics();
-#elif defined( OS_OSX )
-    m_pMainWindow = new COSXWindow();
-    m_pGraphics = new CGLGraphics();
-#elif defined( OS_LINUX )
-    m_pMainWindow = new CLinuxWindow();
-    m_pGraphics = new CGLGraphics();
-#endif
+    case eGraphicsBackendD3D:
+        m_pMainWindow = new CWin32Window();
+        m_pGraphics = new CD3DGraphics();
+        break;
+#endif // #if defined( OS_WINDOWS )
+    case eGraphicsBackendSoft:
+        m_pMainWindow = new CNullWindow();
+        m_pGraphics = new CSoftGraphics();
+        break;
+    default:
+        m_pMainWindow = new CNullWindow();
+        m_pGraphics = new CNullGraphics();
+        break;
+    }
     // ...then create the actual window
     m_pMainWindow->CreateMainWindow( nWindowWidth, nWindowHeight );
     // ...and finally the graphics device
@@ -221,10 +801,30 @@ void Riot::Initialize( void )
     //////////////////////////////////////////
     // Create the input system
     m_pInput = new RiotInput();
+    if( gs_szInputReplayFile )
+    {
+        if( !m_pInput->StartReplay( gs_szInputReplayFile, m_fTickTime ) )
+        {
+            printf( "Couldn't replay input from %s\n", gs_szInputReplayFile );
+        }
+        else if( m_pInput->IsReplayFinished() )
+        {
+            printf( "%s has no frames to replay\n", gs_szInputReplayFile );
+            m_bRunning = false;
+        }
+    }
+    if( gs_szInputRecordFile && !m_pInput->StartRecording( gs_szInputRecordFile, m_fTickTime ) )
+    {
+        printf( "Couldn't record input to %s\n", gs_szInputRecordFile );
+    }
 
     //////////////////////////////////////////
-    // Create the UI
-    UI::Initialize();
+    // Create the UI. It draws straight through D3D, so the other backends
+    // go without
+    if( gs_nGraphicsBackend == eGraphicsBackendD3D )
+    {
+        UI::Initialize();
+    }
 
     //////////////////////////////////////////
     //  Get the scene graph
@@ -260,19 +860,54 @@ void Riot::LoadLevel( void )
     //pBox->AddComponent( eComponentPosition );
 
     // TODO: Load terrain
-    CTerrain* pTerrain = new CTerrain();
+    CTerrain* pTerrain = CATEGORY_NEW( eMemoryCategoryTerrain, CTerrain() );
     //CMesh* pTerrainMesh = m_pGraphics->CreateMesh( L"lol not loading a mesh!" );
-    CMesh* pTerrainMesh = m_pGraphics->CreateMesh( pTerrain->GetVertices(), 
-                                                   pTerrain->GetVertexStride(),
-                                                   pTerrain->GetNumVertices(),
-                                                   pTerrain->GetIndices(),
-                                                   pTerrain->GetIndexSize(),
-                                                   pTerrain->GetNumIndices() );
+    RefPtr<CMesh> pTerrainMesh = AdoptRef( m_pGraphics->CreateMesh( pTerrain->GetVertices(), 
+                                                                     pTerrain->GetVertexStride(),
+                                                                     pTerrain->GetNumVertices(),
+                                                                     pTerrain->GetIndices(),
+                                                                     pTerrain->GetIndexSize(),
+                                                                     pTerrain->GetNumIndices() ) );
     pTerrain->SetMesh( pTerrainMesh );
-    CMaterial* pTerrainMaterial = m_pGraphics->CreateMaterial( L"Assets/Shaders/Terrain.hlsl", "PS", "ps_4_0" );
+    RefPtr<CMaterial> pTerrainMaterial = AdoptRef( m_pGraphics->CreateMaterial( L"Assets/Shaders/Terrain.hlsl", "PS", "ps_4_0" ) );
     pTerrain->SetMaterial( pTerrainMaterial );
-    m_pSceneGraph->AddObject( pTerrain );
-    pTerrain->AddComponent( eComponentPosition );
+    if( m_pSceneGraph->AddObject( pTerrain ) )
+    {
+        pTerrain->AddComponent( eComponentPosition );
+    }
+    else
+    {
+        SAFE_DELETE( pTerrain );
+    }
+
+    //////////////////////////////////////////
+    // Scatter -objects cubes over the terrain. They share a material, but
+    // the mesh is what gets placed, so each needs its own
+    if( gs_nNumSceneObjects > 0 )
+    {
+        gs_nSceneRandomState = ( (uint64)gs_nSceneSeed << 1 ) | 1;
+        RefPtr<CMaterial> pMaterial = AdoptRef( m_pGraphics->CreateMaterial( L"Assets/Shaders/StandardVertexShader.hlsl", "PS", "ps_4_0" ) );
+        for( uint nObject = 0; nObject < gs_nNumSceneObjects; ++nObject )
+        {
+            CObject* pObject = new CObject();
+            RefPtr<CMesh> pMesh = AdoptRef( m_pGraphics->CreateMesh( L"lol not loading a mesh!" ) );
+            pObject->SetMesh( pMesh );
+            pObject->SetMaterial( pMaterial );
+            float fX = SceneRandom() * 256.0f;
+            float fY = SceneRandom() * 64.0f + 8.0f;
+            float fZ = SceneRandom() * 256.0f;
+            pObject->SetPosition( RVector4( fX, fY, fZ, 1.0f ) );
+            pObject->SetOrientation( RQuaternionRotationAxis( RVector4( 0.0f, 1.0f, 0.0f, 0.0f ), SceneRandom() * 2.0f * gs_fPi ) );
+            pObject->SaveState();
+            if( !m_pSceneGraph->AddObject( pObject ) )
+            {
+                printf( "The scene is full, only %u of %u objects were added\n", nObject, gs_nNumSceneObjects );
+                SAFE_DELETE( pObject );
+                break;
+            }
+            pObject->AddComponent( eComponentPosition );
+        }
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -281,6 +916,35 @@ void Riot::LoadLevel( void )
 //-----------------------------------------------------------------------------
 void Riot::Shutdown( void )
 {    
+    if( GetFrameAllocViolations() > 0 )
+    {
+        printf( "%llu heap allocations were made during frames\n",
+                (unsigned long long)GetFrameAllocViolations() );
+    }
+    SetFrameAllocCheck( eFrameAllocCheckOff );
+    TraceStopCapture();
+
+    if( gs_szFrameStatsFile && !FrameStatsWriteCSV( gs_szFrameStatsFile ) )
+    {
+        printf( "Couldn't write frame statistics to %s\n", gs_szFrameStatsFile );
+    }
+
+    //////////////////////////////////////////
+    // Whatever's still sampled at this point is what the engine holds
+    // onto for its whole lifetime
+    if( HeapProfilerIsEnabled() )
+    {
+        HeapProfilerWrite( "heap_profile.collapsed", eHeapProfileCollapsed );
+        HeapProfilerWrite( "heap_profile.heap", eHeapProfilePprof );
+        HeapProfilerDisable();
+    }
+
+    //////////////////////////////////////////
+    // Nothing processes the deferred queue from here on, so everything
+    // released later (the scene graph goes at exit) is deleted immediately
+    ProcessDeferredReleases();
+    SetDeferredReleasesEnabled( false );
+
     SAFE_RELEASE( m_pInput );
     SAFE_RELEASE( m_pGraphics );
     SAFE_RELEASE( m_pMainWindow );
@@ -23,9 +23,10 @@ class Riot
 public:    
     //-----------------------------------------------------------------------------
     //  Run
-    //  Starts the engine/game. All variables are set programatically
+    //  Starts the engine/game. All variables are set programatically, or
+    //  from the command line
     //-----------------------------------------------------------------------------
-    static void Run( void );
+    static void Run( int nArgCount, char* ppArgs[] );
 
     //-----------------------------------------------------------------------------
     //  Shutdown
@@ -45,6 +46,12 @@ private:
     //-----------------------------------------------------------------------------
     static void Initialize( void );
 
+    //-----------------------------------------------------------------------------
+    //  ParseCommandLine
+    //  Applies the command line options. Called from Run, before Initialize
+    //-----------------------------------------------------------------------------
+    static void ParseCommandLine( int nArgCount, char* ppArgs[] );
+
     //-----------------------------------------------------------------------------
     //  LoadLevel
     //  Defines the scene objects.  Called from Initialize
@@ -55,8 +62,11 @@ private:
 //  Members
 private:
     static uint         m_nFrameCount;
-    static float        m_fElapsedTime;
+    static uint         m_nTickCount;
+    static float        m_fElapsedTime;     // Real time of the last frame
     static float        m_fRunningTime;
+    static float        m_fTickTime;        // Fixed simulation timestep
+    static uint         m_nMaxTicksPerFrame;
     static RiotInput*   m_pInput;
     static CWindow*     m_pMainWindow;
     static CGraphics*   m_pGraphics;
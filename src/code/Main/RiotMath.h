@@ -8,6 +8,39 @@ Purpose:    Vector and matrix implementations
 #include <math.h>
 #include "Types.h"
 
+//-----------------------------------------------------------------------------
+//  SIMD selection
+//  RVector4 is built on SSE or NEON registers when the compiler targets
+//  them, and on plain floats otherwise. Define RIOT_NO_SIMD to force the
+//  scalar version
+//-----------------------------------------------------------------------------
+#if !defined( RIOT_NO_SIMD )
+#if defined( __SSE4_1__ ) || defined( __AVX__ )
+#define RIOT_SSE
+#define RIOT_SSE4
+#elif defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define RIOT_SSE
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ ) || defined( _M_ARM64 )
+#define RIOT_NEON
+#endif
+#endif // #if !defined( RIOT_NO_SIMD )
+
+#if defined( RIOT_SSE4 )
+#include <smmintrin.h>
+#elif defined( RIOT_SSE )
+#include <emmintrin.h>
+#elif defined( RIOT_NEON )
+#include <arm_neon.h>
+#endif
+
+#if defined( RIOT_SSE )
+typedef __m128      RVectorReg;
+#elif defined( RIOT_NEON )
+typedef float32x4_t RVectorReg;
+#else
+struct RVectorReg { float f[4]; };
+#endif // #if defined( RIOT_SSE )
+
 static const float gs_fPi = 3.14159265358979f;
 static const float gs_fPiRecip = (1.0f/gs_fPi);
 static const float gs_fDegToRad = (gs_fPi/180.0f);
@@ -16,6 +49,31 @@ static const float gs_fEpsilon = (0.0001f);
 _inline float DegToRad( float fDeg ) { return fDeg * gs_fDegToRad; }
 _inline float RadToDeg( float fRad ) { return fRad * gs_fRadToDeg; }
 
+//-----------------------------------------------------------------------------
+//  Fast math
+//  Opt-in replacements for libm, for code that can trade the last few
+//  bits for speed. There are two tiers: the plain names are accurate to
+//  about float precision, the Est versions are coarser still. Error bounds
+//  are the worst seen against libm over the valid range
+//
+//  RecipSqrtEst    rsqrt estimate + 1 Newton step      rel err < 3e-7
+//  RecipEst        rcp estimate + 1 Newton step        rel err < 2.5e-7
+//  SinCos          11/10 degree polynomial             abs err < 5e-7
+//  SinCosEst       7/6 degree polynomial               abs err < 1e-5
+//  Atan2Est        9 degree polynomial                 abs err < 2e-5
+//
+//  The sine and cosine reduce the angle themselves, and hold those bounds
+//  up to |fAngle| = 8192. Atan2Est ignores the sign of a zero fY, so it
+//  gives pi where atan2 gives -pi. Without SIMD the reciprocals are exact.
+//  The Est normalizes and axis builders are built on RecipSqrtEst and
+//  SinCos. Tools/MathTest.cpp checks these bounds
+//-----------------------------------------------------------------------------
+float RecipSqrtEst( float F );
+float RecipEst( float F );
+void SinCos( float fAngle, float* pSin, float* pCos );
+void SinCosEst( float fAngle, float* pSin, float* pCos );
+float Atan2Est( float fY, float fX );
+
 class RVector2
 {
 public:
@@ -73,6 +131,7 @@ public:
     float Distance( const RVector2& V ) const;
     float DistanceSquared( const RVector2& V ) const;
     void Normalize( void );
+    void NormalizeEst( void );
     void Zero( void );
 };
 
@@ -80,6 +139,7 @@ float DotProduct( const RVector2& V1, const RVector2& V2 );
 float Distance( const RVector2& V1, const RVector2& V2 );
 float DistanceSquared( const RVector2& V1, const RVector2& V2 );
 RVector2 Normalize( const RVector2& V );
+RVector2 NormalizeEst( const RVector2& V );
 
 class RVector3
 {
@@ -140,6 +200,7 @@ public:
     float Distance( const RVector3& V ) const;
     float DistanceSquared( const RVector3& V ) const;
     void Normalize( void );
+    void NormalizeEst( void );
     void Zero( void );
 };
 
@@ -148,9 +209,15 @@ RVector3 CrossProduct( const RVector3& V1, const RVector3& V2 );
 float Distance( const RVector3& V1, const RVector3& V2 );
 float DistanceSquared( const RVector3& V1, const RVector3& V2 );
 RVector3 Normalize( const RVector3& V );
+RVector3 NormalizeEst( const RVector3& V );
 RVector3 RVector3Zero( void );
 
-class RVector4
+//-----------------------------------------------------------------------------
+//  RVector4
+//  Lives in a SIMD register, so it's 16 byte aligned. Anything holding
+//  one has to be allocated aligned too
+//-----------------------------------------------------------------------------
+class ALIGN( 16 ) RVector4
 {
 public:
     /***************************************\
@@ -160,6 +227,7 @@ public:
     {
         struct { float x, y, z, w; };
         float f[4];
+        RVectorReg v;
     };
 
 public:
@@ -169,6 +237,7 @@ public:
     RVector4( float X, float Y, float Z );
     RVector4( const RVector4& V );
     RVector4( const float* F );
+    explicit RVector4( RVectorReg V );
     RVector4& operator=( const RVector4& V );
 
     /***************************************\
@@ -202,7 +271,7 @@ public:
 
     // Vector-Vector operations
     float DotProduct( const RVector4& V ) const;
-    RVector4 CrossProduct( const RVector4& V ) const;
+    RVector4 CrossProduct( const RVector4& V ) const;  // Of xyz, w = 0
 
     // Misc operations
     float Magnitude( void ) const;
@@ -210,6 +279,7 @@ public:
     float Distance( const RVector4& V ) const;
     float DistanceSquared( const RVector4& V ) const;
     void Normalize( void );
+    void NormalizeEst( void );
     void Zero( void );
 };
 
@@ -218,25 +288,188 @@ RVector4 CrossProduct( const RVector4& V1, const RVector4& V2 );
 float Distance( const RVector4& V1, const RVector4& V2 );
 float DistanceSquared( const RVector4& V1, const RVector4& V2 );
 RVector4 Normalize( const RVector4& V );
+RVector4 NormalizeEst( const RVector4& V );
 RVector4 RVector4Zero(  );
 
-//template< class T >
-//class RMatrix3x3
-//{
-//public:
-//    RVector3<T> r1;
-//    RVector3<T> r2;
-//    RVector3<T> r3;
-//};
-//
-//template< class T >
-//class RMatrix4x4
-//{
-//public:
-//    RVector4<T> r1;
-//    RVector4<T> r2;
-//    RVector4<T> r3;
-//    RVector4<T> r4;
-//};
+RVector4 Lerp( const RVector4& V1, const RVector4& V2, float fT );
+
+//-----------------------------------------------------------------------------
+//  RQuaternion
+//  A rotation, stored x, y, z, w. Multiplying applies the left rotation,
+//  then the right one, the same order as the matrices
+//-----------------------------------------------------------------------------
+class ALIGN( 16 ) RQuaternion
+{
+public:
+    /***************************************\
+    | class members
+    \***************************************/
+    union
+    {
+        struct { float x, y, z, w; };
+        float f[4];
+        RVectorReg v;
+    };
+
+public:
+    // RQuaternion constructors
+    RQuaternion(  ) { }
+    RQuaternion( float X, float Y, float Z, float W );
+    RQuaternion( const RQuaternion& Q );
+    explicit RQuaternion( RVectorReg V );
+    RQuaternion& operator=( const RQuaternion& Q );
+
+    /***************************************\
+    | class methods
+    \***************************************/
+    // This rotation, then Q
+    RQuaternion operator*( const RQuaternion& Q ) const;
+    RQuaternion& operator*=( const RQuaternion& Q );
+
+    // Comparison
+    bool operator==( const RQuaternion& Q ) const;
+    bool operator!=( const RQuaternion& Q ) const;
+
+    // Misc operations
+    float DotProduct( const RQuaternion& Q ) const;
+    float Magnitude( void ) const;
+    void Normalize( void );
+    void NormalizeEst( void );
+    void Conjugate( void );
+    void Identity( void );
+};
+
+RQuaternion Normalize( const RQuaternion& Q );
+RQuaternion NormalizeEst( const RQuaternion& Q );
+RQuaternion Conjugate( const RQuaternion& Q );
+RQuaternion Inverse( const RQuaternion& Q );
+RQuaternion Slerp( const RQuaternion& Q1, const RQuaternion& Q2, float fT );
+RQuaternion RQuaternionIdentity( void );
+RQuaternion RQuaternionRotationAxis( const RVector4& vAxis, float fAngle );
+RQuaternion RQuaternionRotationAxisEst( const RVector4& vAxis, float fAngle );
+
+//-----------------------------------------------------------------------------
+//  RMatrix3x3
+//  Row vector convention, like RMatrix4x4. Nine floats don't fit
+//  registers any better than RVector3 does, so it's scalar
+//-----------------------------------------------------------------------------
+class RMatrix3x3
+{
+public:
+    /***************************************\
+    | class members
+    \***************************************/
+    union
+    {
+        struct
+        {
+            float _11, _12, _13;
+            float _21, _22, _23;
+            float _31, _32, _33;
+        };
+        float m[3][3];
+    };
+
+public:
+    // RMatrix3x3 constructors
+    RMatrix3x3(  ) { }
+    RMatrix3x3( const RVector3& R1, const RVector3& R2, const RVector3& R3 );
+    RMatrix3x3( const float* F );    // 9 floats, a row at a time
+
+    /***************************************\
+    | class methods
+    \***************************************/
+    RMatrix3x3 operator*( const RMatrix3x3& M ) const;
+    RMatrix3x3& operator*=( const RMatrix3x3& M );
+
+    RVector3 GetRow( uint nRow ) const;
+    float Determinant( void ) const;
+    void Transpose( void );
+    void Identity( void );
+};
+
+RVector3 operator*( const RVector3& V, const RMatrix3x3& M );
+RMatrix3x3 Transpose( const RMatrix3x3& M );
+RMatrix3x3 Inverse( const RMatrix3x3& M );
+RMatrix3x3 RMatrix3x3Identity( void );
+RMatrix3x3 RMatrix3x3RotationQuaternion( const RQuaternion& Q );
+
+//-----------------------------------------------------------------------------
+//  RMatrix4x4
+//  Row vector convention, the same as XNA Math and D3DX: a point is
+//  transformed by V * M, the translation is in the last row, and A * B
+//  applies A, then B. Each row is a register
+//-----------------------------------------------------------------------------
+class ALIGN( 16 ) RMatrix4x4
+{
+public:
+    /***************************************\
+    | class members
+    \***************************************/
+    union
+    {
+        struct
+        {
+            float _11, _12, _13, _14;
+            float _21, _22, _23, _24;
+            float _31, _32, _33, _34;
+            float _41, _42, _43, _44;
+        };
+        float m[4][4];
+        RVectorReg r[4];
+    };
+
+public:
+    // RMatrix4x4 constructors
+    RMatrix4x4(  ) { }
+    RMatrix4x4( const RVector4& R1, const RVector4& R2, const RVector4& R3, const RVector4& R4 );
+    RMatrix4x4( const float* F );    // 16 floats, a row at a time
+
+    /***************************************\
+    | class methods
+    \***************************************/
+    RMatrix4x4 operator*( const RMatrix4x4& M ) const;
+    RMatrix4x4& operator*=( const RMatrix4x4& M );
+
+    // Comparison
+    bool operator==( const RMatrix4x4& M ) const;
+    bool operator!=( const RMatrix4x4& M ) const;
+
+    RVector4 GetRow( uint nRow ) const;
+    void Transpose( void );
+    void Identity( void );
+};
+
+RVector4 operator*( const RVector4& V, const RMatrix4x4& M );
+RMatrix4x4 Transpose( const RMatrix4x4& M );
+
+//-----------------------------------------------------------------------------
+//  AffineInverse
+//  Inverts a matrix whose last column is (0, 0, 0, 1): any mix of
+//  rotation, scale, shear and translation. Much cheaper than a general
+//  4x4 inverse. If the top 3x3 is only a rotation, Transpose it instead
+//-----------------------------------------------------------------------------
+RMatrix4x4 AffineInverse( const RMatrix4x4& M );
+
+RMatrix4x4 RMatrix4x4Identity( void );
+RMatrix4x4 RMatrix4x4Translation( const RVector4& V );
+RMatrix4x4 RMatrix4x4Scaling( float X, float Y, float Z );
+RMatrix4x4 RMatrix4x4RotationQuaternion( const RQuaternion& Q );
+RMatrix4x4 RMatrix4x4RotationAxis( const RVector4& vAxis, float fAngle );
+RMatrix4x4 RMatrix4x4RotationAxisEst( const RVector4& vAxis, float fAngle );
+
+//-----------------------------------------------------------------------------
+//  View and projection matrices
+//  Left handed, looking down +z, with depth from 0 to 1, the same as
+//  their XNA Math namesakes
+//-----------------------------------------------------------------------------
+RMatrix4x4 RMatrix4x4LookToLH( const RVector4& vEye, const RVector4& vDirection, const RVector4& vUp );
+RMatrix4x4 RMatrix4x4LookAtLH( const RVector4& vEye, const RVector4& vTarget, const RVector4& vUp );
+RMatrix4x4 RMatrix4x4PerspectiveFovLH( float fFovY, float fAspectRatio, float fNear, float fFar );
+
+//-----------------------------------------------------------------------------
+//  Everything's inlined
+//-----------------------------------------------------------------------------
+#include "RiotMath.inl"
 
 #endif // #ifndef _RIOTMATH_H_
@@ -0,0 +1,1548 @@
+/*********************************************************\
+File:      RiotMath.inl
+Purpose:   Inline definitions for RiotMath.h
+\*********************************************************/
+
+/**********************************************************\
+|**********************************************************|
+| Fast math
+|**********************************************************|
+\**********************************************************/
+_inline float RecipSqrtEst(float F)
+{
+#if defined( RIOT_SSE )
+    // The estimate is good to 12 bits, Newton-Raphson doubles that
+    float fEst = _mm_cvtss_f32( _mm_rsqrt_ss( _mm_set_ss( F ) ) );
+    return fEst * ( 1.5f - 0.5f * F * fEst * fEst );
+#elif defined( RIOT_NEON )
+    // NEON's estimate is only good to 8 bits, so it takes two steps
+    float32x2_t vF = vdup_n_f32( F );
+    float32x2_t vEst = vrsqrte_f32( vF );
+    vEst = vmul_f32( vEst, vrsqrts_f32( vmul_f32( vF, vEst ), vEst ) );
+    vEst = vmul_f32( vEst, vrsqrts_f32( vmul_f32( vF, vEst ), vEst ) );
+    return vget_lane_f32( vEst, 0 );
+#else
+    return 1 / sqrtf( F );
+#endif // #if defined( RIOT_SSE )
+}
+
+_inline float RecipEst(float F)
+{
+#if defined( RIOT_SSE )
+    float fEst = _mm_cvtss_f32( _mm_rcp_ss( _mm_set_ss( F ) ) );
+    return fEst * ( 2.0f - F * fEst );
+#elif defined( RIOT_NEON )
+    float32x2_t vF = vdup_n_f32( F );
+    float32x2_t vEst = vrecpe_f32( vF );
+    vEst = vmul_f32( vEst, vrecps_f32( vF, vEst ) );
+    vEst = vmul_f32( vEst, vrecps_f32( vF, vEst ) );
+    return vget_lane_f32( vEst, 0 );
+#else
+    return 1 / F;
+#endif // #if defined( RIOT_SSE )
+}
+
+//-----------------------------------------------------------------------------
+//  SinCosReduce
+//  Wraps the angle into [-pi, pi], then folds it into [-pi/2, pi/2] where
+//  the polynomials are accurate. The cosine changes sign with the fold.
+//  2pi is split in two so the high half times the quotient stays exact
+//-----------------------------------------------------------------------------
+__forceinline float SinCosReduce(float fAngle, float* pCosSign)
+{
+    static const float fTwoPiHigh = 6.28125f;
+    static const float fTwoPiLow = 1.9353071795864769e-3f;
+    static const float fHalfPi = gs_fPi * 0.5f;
+
+    float fQuotient = fAngle * ( 0.5f * gs_fPiRecip );
+    fQuotient = (float)(int)( fQuotient >= 0.0f ? fQuotient + 0.5f : fQuotient - 0.5f );
+    float fReduced = ( fAngle - fQuotient * fTwoPiHigh ) - fQuotient * fTwoPiLow;
+
+    *pCosSign = 1.0f;
+    if( fReduced > fHalfPi )
+    {
+        fReduced = gs_fPi - fReduced;
+        *pCosSign = -1.0f;
+    }
+    else if( fReduced < -fHalfPi )
+    {
+        fReduced = -gs_fPi - fReduced;
+        *pCosSign = -1.0f;
+    }
+    return fReduced;
+}
+
+_inline void SinCos(float fAngle, float* pSin, float* pCos)
+{
+    float fCosSign;
+    float fX = SinCosReduce( fAngle, &fCosSign );
+    float fX2 = fX * fX;
+
+    *pSin = ( ( ( ( ( -2.3889859e-08f * fX2 + 2.7525562e-06f ) * fX2 - 1.9840874e-04f ) * fX2
+            + 8.3333310e-03f ) * fX2 - 1.6666667e-01f ) * fX2 + 1.0f ) * fX;
+    *pCos = ( ( ( ( ( -2.6051615e-07f * fX2 + 2.4760495e-05f ) * fX2 - 1.3888378e-03f ) * fX2
+            + 4.1666638e-02f ) * fX2 - 0.5f ) * fX2 + 1.0f ) * fCosSign;
+}
+
+_inline void SinCosEst(float fAngle, float* pSin, float* pCos)
+{
+    float fCosSign;
+    float fX = SinCosReduce( fAngle, &fCosSign );
+    float fX2 = fX * fX;
+
+    *pSin = ( ( ( -1.8524670e-04f * fX2 + 8.3139502e-03f ) * fX2 - 1.6665852e-01f ) * fX2 + 1.0f ) * fX;
+    *pCos = ( ( ( -1.2712436e-03f * fX2 + 4.1493919e-02f ) * fX2 - 4.9992746e-01f ) * fX2 + 1.0f ) * fCosSign;
+}
+
+//-----------------------------------------------------------------------------
+//  Atan2Est
+//  Works out atan of the smaller coordinate over the larger, which is in
+//  [0, 1], and then reflects it into the right octant
+//-----------------------------------------------------------------------------
+_inline float Atan2Est(float fY, float fX)
+{
+    float fAbsY = fabsf( fY );
+    float fAbsX = fabsf( fX );
+    float fMax = fAbsY > fAbsX ? fAbsY : fAbsX;
+    float fMin = fAbsY > fAbsX ? fAbsX : fAbsY;
+    if( fMax == 0.0f )
+    {
+        return 0.0f;
+    }
+
+    float fZ = fMin / fMax;
+    float fZ2 = fZ * fZ;
+    float fAngle = ( ( ( ( 2.08351e-02f * fZ2 - 8.51330e-02f ) * fZ2 + 1.801410e-01f ) * fZ2
+                   - 3.302995e-01f ) * fZ2 + 9.998660e-01f ) * fZ;
+
+    if( fAbsY > fAbsX )
+    {
+        fAngle = gs_fPi * 0.5f - fAngle;
+    }
+    if( fX < 0.0f )
+    {
+        fAngle = gs_fPi - fAngle;
+    }
+    return fY < 0.0f ? -fAngle : fAngle;
+}
+
+/**********************************************************\
+|**********************************************************|
+| class RVector2
+|**********************************************************|
+\**********************************************************/
+_inline RVector2::RVector2(float X, float Y) : x(X), y(Y)
+{
+}
+
+_inline RVector2::RVector2(const RVector2& V) : x(V.x), y(V.y)
+{
+}
+
+_inline RVector2::RVector2(const float* F) : x(F[0]), y(F[1])
+{
+}
+
+_inline RVector2& RVector2::operator=(const RVector2& V)
+{
+    x = V.x, y = V.y;
+    return *this;
+}
+
+/***************************************\
+| class methods
+\***************************************/
+// Scalar math operations
+
+// Add
+_inline RVector2 RVector2::operator+(const RVector2& V) const
+{
+    return RVector2( x + V.x, y + V.y);
+}
+
+_inline RVector2 RVector2::operator+(float F) const
+{
+    return RVector2( x + F, y + F);
+}
+
+_inline RVector2& RVector2::operator+=(const RVector2& V)
+{
+    x += V.x, y += V.y; return *this;
+}
+
+_inline RVector2& RVector2::operator+=(float F)
+{
+    x += F, y += F; return *this;
+}
+
+
+// Subtract
+_inline RVector2 RVector2::operator-(const RVector2& V) const
+{
+    return RVector2( x - V.x, y - V.y);
+}
+
+_inline RVector2 RVector2::operator-(float F) const
+{
+    return RVector2( x - F, y - F);
+}
+
+_inline RVector2& RVector2::operator-=(const RVector2& V)
+{
+    x -= V.x, y -= V.y; return *this;
+}
+
+_inline RVector2& RVector2::operator-=(float F)
+{
+    x -= F, y -= F; return *this;
+}
+
+
+// Multiply and divide
+_inline RVector2 RVector2::operator*(float F) const
+{
+    return RVector2( x * F, y * F);
+}
+
+_inline RVector2& RVector2::operator*=(float F)
+{
+    x *= F, y *= F; return *this;
+}
+
+_inline RVector2 RVector2::operator/(float F) const
+{
+    float recip = 1 / F;
+    return RVector2( x * recip, y * recip);
+}
+
+_inline RVector2& RVector2::operator/=(float F)
+{
+    float recip = 1 / F;
+    x *= recip, y *= recip; return *this;
+}
+
+
+// Comparison
+_inline bool RVector2::operator==(const RVector2& V) const
+{
+    return (x == V.x && y == V.y);
+}
+
+_inline bool RVector2::operator!=(const RVector2& V) const
+{
+    return !(*this == V);
+}
+
+
+// Vector operations
+
+// Vector-Vector operations
+_inline float RVector2::DotProduct(const RVector2& V) const
+{
+    return x * V.x + y * V.y;
+}
+
+// Misc operations
+_inline float RVector2::Magnitude(void) const
+{
+    return sqrtf(MagnitudeSquared());
+}
+
+_inline float RVector2::MagnitudeSquared(void) const
+{
+    return x*x + y*y;
+}
+
+_inline float RVector2::Distance(const RVector2& V) const
+{
+    return sqrtf(DistanceSquared(V));
+}
+
+_inline float RVector2::DistanceSquared(const RVector2& V) const
+{
+    return RVector2(x - V.x, y - V.y).MagnitudeSquared();
+}
+
+_inline void RVector2::Normalize(void)
+{
+    *this /= Magnitude();
+}
+
+_inline void RVector2::NormalizeEst(void)
+{
+    *this *= RecipSqrtEst( MagnitudeSquared() );
+}
+
+_inline void RVector2::Zero(void)
+{
+    x = 0.0f, y = 0.0f;
+}
+
+// Non-member functions
+_inline float DotProduct(const RVector2& V1, const RVector2& V2)
+{
+    return V1.DotProduct(V2);
+}
+
+_inline float Distance(const RVector2& V1, const RVector2& V2)
+{
+    return V1.Distance(V2);
+}
+
+_inline float DistanceSquared(const RVector2& V1, const RVector2& V2)
+{
+    return V1.DistanceSquared(V2);
+}
+
+_inline RVector2 Normalize(const RVector2& V)
+{
+    return V / V.Magnitude();
+}
+
+_inline RVector2 NormalizeEst(const RVector2& V)
+{
+    return V * RecipSqrtEst( V.MagnitudeSquared() );
+}
+
+
+/**********************************************************\
+|**********************************************************|
+| class RVector3
+| Three floats don't fill a register, and loading them into
+| one costs more than the math saves, so RVector3 stays
+| scalar. Inlined, the compiler vectorizes it where it can
+\**********************************************************/
+_inline RVector3::RVector3(float X, float Y, float Z) : x(X), y(Y), z(Z)
+{
+}
+
+_inline RVector3::RVector3(const RVector3& V) : x(V.x), y(V.y), z(V.z)
+{
+}
+
+_inline RVector3::RVector3(const float* F) : x(F[0]), y(F[1]), z(F[2])
+{
+}
+
+_inline RVector3& RVector3::operator=(const RVector3& V)
+{
+    x = V.x, y = V.y, z= V.z;
+    return *this;
+}
+
+/***************************************\
+| class methods
+\***************************************/
+// Scalar math operations
+
+// Add
+_inline RVector3 RVector3::operator+(const RVector3& V) const
+{
+    return RVector3( x + V.x, y + V.y, z + V.z);
+}
+
+_inline RVector3 RVector3::operator+(float F) const
+{
+    return RVector3( x + F, y + F, z + F);
+}
+
+_inline RVector3& RVector3::operator+=(const RVector3& V)
+{
+    x += V.x, y += V.y, z += V.z; return *this;
+}
+
+_inline RVector3& RVector3::operator+=(float F)
+{
+    x += F, y += F, z += F; return *this;
+}
+
+
+// Subtract
+_inline RVector3 RVector3::operator-(const RVector3& V) const
+{
+    return RVector3( x - V.x, y - V.y, z - V.z);
+}
+
+_inline RVector3 RVector3::operator-(float F) const
+{
+    return RVector3( x - F, y - F, z - F);
+}
+
+_inline RVector3& RVector3::operator-=(const RVector3& V)
+{
+    x -= V.x, y -= V.y, z -= V.z; return *this;
+}
+
+_inline RVector3& RVector3::operator-=(float F)
+{
+    x -= F, y -= F, z -= F; return *this;
+}
+
+// Multiply and divide
+_inline RVector3 RVector3::operator*(float F) const
+{
+    return RVector3( x * F, y * F, z * F);
+}
+
+_inline RVector3& RVector3::operator*=(float F)
+{
+    x *= F, y *= F, z *= F; return *this;
+}
+
+_inline RVector3 RVector3::operator/(float F) const
+{
+    float recip = 1 / F;
+    return RVector3( x * recip, y * recip, z * recip);
+}
+
+_inline RVector3& RVector3::operator/=(float F)
+{
+    float recip = 1 / F;
+    x *= recip, y *= recip, z *= recip; return *this;
+}
+
+
+// Comparison
+_inline bool RVector3::operator==(const RVector3& V) const
+{
+    return (x == V.x && y == V.y && z == V.z);
+}
+
+_inline bool RVector3::operator!=(const RVector3& V) const
+{
+    return !(*this == V);
+}
+
+
+// Vector operations
+
+// Vector-Vector operations
+_inline float RVector3::DotProduct(const RVector3& V) const
+{
+    return x * V.x + y * V.y + z * V.z;
+}
+
+_inline RVector3 RVector3::CrossProduct(const RVector3& V) const
+{
+    float X = y * V.z - z * V.y;
+    float Y = z * V.x - x * V.z;
+    float Z = x * V.y - y * V.x;
+
+    return RVector3(X, Y, Z);
+}
+
+// Misc operations
+_inline float RVector3::Magnitude(void) const
+{
+    return sqrtf(MagnitudeSquared());
+}
+
+_inline float RVector3::MagnitudeSquared(void) const
+{
+    return x*x + y*y + z*z;
+}
+
+_inline float RVector3::Distance(const RVector3& V) const
+{
+    return sqrtf(DistanceSquared(V));
+}
+
+_inline float RVector3::DistanceSquared(const RVector3& V) const
+{
+    return RVector3(x - V.x, y - V.y, z - V.z).MagnitudeSquared();
+}
+
+_inline void RVector3::Normalize(void)
+{
+    float recip = 1 / Magnitude();
+    *this *= recip;
+}
+
+_inline void RVector3::NormalizeEst(void)
+{
+    *this *= RecipSqrtEst( MagnitudeSquared() );
+}
+
+_inline void RVector3::Zero(void)
+{
+    x = 0.0f, y = 0.0f, z = 0.0f;
+}
+
+// Non-member functions
+_inline float DotProduct(const RVector3& V1, const RVector3& V2)
+{
+    return V1.DotProduct(V2);
+}
+
+_inline RVector3 CrossProduct(const RVector3& V1, const RVector3& V2)
+{
+    return V1.CrossProduct(V2);
+}
+
+_inline float Distance(const RVector3& V1, const RVector3& V2)
+{
+    return V1.Distance(V2);
+}
+
+_inline float DistanceSquared(const RVector3& V1, const RVector3& V2)
+{
+    return V1.DistanceSquared(V2);
+}
+
+_inline RVector3 Normalize(const RVector3& V)
+{
+    float recip = 1 / V.Magnitude();
+    return V * recip;
+}
+
+_inline RVector3 NormalizeEst(const RVector3& V)
+{
+    return V * RecipSqrtEst( V.MagnitudeSquared() );
+}
+
+_inline RVector3 RVector3Zero(void)
+{
+    return RVector3(0.0f, 0.0f, 0.0f);
+}
+
+
+/**********************************************************\
+|**********************************************************|
+| RVectorReg operations
+| The few register operations RVector4 is built on, once
+| per instruction set
+|**********************************************************|
+\**********************************************************/
+#if defined( RIOT_SSE )
+
+__forceinline RVectorReg RVecSet( float X, float Y, float Z, float W )
+{
+    return _mm_setr_ps( X, Y, Z, W );
+}
+
+__forceinline RVectorReg RVecLoad( const float* F )
+{
+    return _mm_loadu_ps( F );
+}
+
+__forceinline RVectorReg RVecSplat( float F )
+{
+    return _mm_set1_ps( F );
+}
+
+__forceinline RVectorReg RVecAdd( RVectorReg A, RVectorReg B )
+{
+    return _mm_add_ps( A, B );
+}
+
+__forceinline RVectorReg RVecSub( RVectorReg A, RVectorReg B )
+{
+    return _mm_sub_ps( A, B );
+}
+
+__forceinline RVectorReg RVecMul( RVectorReg A, RVectorReg B )
+{
+    return _mm_mul_ps( A, B );
+}
+
+// The dot product in every lane
+__forceinline RVectorReg RVecDot( RVectorReg A, RVectorReg B )
+{
+#if defined( RIOT_SSE4 )
+    return _mm_dp_ps( A, B, 0xFF );
+#else
+    RVectorReg vMul = _mm_mul_ps( A, B );
+    RVectorReg vSum = _mm_add_ps( vMul, _mm_shuffle_ps( vMul, vMul, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+    return _mm_add_ps( vSum, _mm_shuffle_ps( vSum, vSum, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+#endif // #if defined( RIOT_SSE4 )
+}
+
+__forceinline float RVecGetX( RVectorReg A )
+{
+    return _mm_cvtss_f32( A );
+}
+
+// Estimate plus one Newton-Raphson step, see RecipSqrtEst
+__forceinline RVectorReg RVecRecipSqrtEst( RVectorReg A )
+{
+    RVectorReg vEst = _mm_rsqrt_ps( A );
+    RVectorReg vHalfA = _mm_mul_ps( A, _mm_set1_ps( 0.5f ) );
+    return _mm_mul_ps( vEst, _mm_sub_ps( _mm_set1_ps( 1.5f ), _mm_mul_ps( vHalfA, _mm_mul_ps( vEst, vEst ) ) ) );
+}
+
+__forceinline bool RVecEqual( RVectorReg A, RVectorReg B )
+{
+    return _mm_movemask_ps( _mm_cmpeq_ps( A, B ) ) == 0xF;
+}
+
+// x, y and z of A are all <= those of B
+__forceinline bool RVecAllLessEqual3( RVectorReg A, RVectorReg B )
+{
+    return ( _mm_movemask_ps( _mm_cmple_ps( A, B ) ) & 0x7 ) == 0x7;
+}
+
+__forceinline RVectorReg RVecMin( RVectorReg A, RVectorReg B )
+{
+    return _mm_min_ps( A, B );
+}
+
+__forceinline RVectorReg RVecMax( RVectorReg A, RVectorReg B )
+{
+    return _mm_max_ps( A, B );
+}
+
+__forceinline RVectorReg RVecCross3( RVectorReg A, RVectorReg B )
+{
+    // a.yzx * b.zxy - a.zxy * b.yzx. The w's cancel out
+    RVectorReg vA1 = _mm_shuffle_ps( A, A, _MM_SHUFFLE( 3, 0, 2, 1 ) );
+    RVectorReg vB1 = _mm_shuffle_ps( B, B, _MM_SHUFFLE( 3, 1, 0, 2 ) );
+    RVectorReg vA2 = _mm_shuffle_ps( A, A, _MM_SHUFFLE( 3, 1, 0, 2 ) );
+    RVectorReg vB2 = _mm_shuffle_ps( B, B, _MM_SHUFFLE( 3, 0, 2, 1 ) );
+    return _mm_sub_ps( _mm_mul_ps( vA1, vB1 ), _mm_mul_ps( vA2, vB2 ) );
+}
+
+__forceinline RVectorReg RVecSplatX( RVectorReg A ) { return _mm_shuffle_ps( A, A, _MM_SHUFFLE( 0, 0, 0, 0 ) ); }
+__forceinline RVectorReg RVecSplatY( RVectorReg A ) { return _mm_shuffle_ps( A, A, _MM_SHUFFLE( 1, 1, 1, 1 ) ); }
+__forceinline RVectorReg RVecSplatZ( RVectorReg A ) { return _mm_shuffle_ps( A, A, _MM_SHUFFLE( 2, 2, 2, 2 ) ); }
+__forceinline RVectorReg RVecSplatW( RVectorReg A ) { return _mm_shuffle_ps( A, A, _MM_SHUFFLE( 3, 3, 3, 3 ) ); }
+
+__forceinline void RVecTranspose( RVectorReg& R0, RVectorReg& R1, RVectorReg& R2, RVectorReg& R3 )
+{
+    _MM_TRANSPOSE4_PS( R0, R1, R2, R3 );
+}
+
+// Hamilton product B * A, which rotates by A, then B
+__forceinline RVectorReg RVecQuatMul( RVectorReg A, RVectorReg B )
+{
+    RVectorReg vResult = _mm_mul_ps( RVecSplatW( B ), A );
+    RVectorReg vTerm = _mm_mul_ps( RVecSplatX( B ), _mm_shuffle_ps( A, A, _MM_SHUFFLE( 0, 1, 2, 3 ) ) );
+    vResult = _mm_add_ps( vResult, _mm_mul_ps( vTerm, _mm_setr_ps( 1.0f, -1.0f, 1.0f, -1.0f ) ) );
+    vTerm = _mm_mul_ps( RVecSplatY( B ), _mm_shuffle_ps( A, A, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+    vResult = _mm_add_ps( vResult, _mm_mul_ps( vTerm, _mm_setr_ps( 1.0f, 1.0f, -1.0f, -1.0f ) ) );
+    vTerm = _mm_mul_ps( RVecSplatZ( B ), _mm_shuffle_ps( A, A, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+    return _mm_add_ps( vResult, _mm_mul_ps( vTerm, _mm_setr_ps( -1.0f, 1.0f, 1.0f, -1.0f ) ) );
+}
+
+#elif defined( RIOT_NEON )
+
+__forceinline RVectorReg RVecSet( float X, float Y, float Z, float W )
+{
+    float pF[4] = { X, Y, Z, W };
+    return vld1q_f32( pF );
+}
+
+__forceinline RVectorReg RVecLoad( const float* F )
+{
+    return vld1q_f32( F );
+}
+
+__forceinline RVectorReg RVecSplat( float F )
+{
+    return vdupq_n_f32( F );
+}
+
+__forceinline RVectorReg RVecAdd( RVectorReg A, RVectorReg B )
+{
+    return vaddq_f32( A, B );
+}
+
+__forceinline RVectorReg RVecSub( RVectorReg A, RVectorReg B )
+{
+    return vsubq_f32( A, B );
+}
+
+__forceinline RVectorReg RVecMul( RVectorReg A, RVectorReg B )
+{
+    return vmulq_f32( A, B );
+}
+
+// The dot product in every lane
+__forceinline RVectorReg RVecDot( RVectorReg A, RVectorReg B )
+{
+    RVectorReg vMul = vmulq_f32( A, B );
+    float32x2_t vSum = vadd_f32( vget_low_f32( vMul ), vget_high_f32( vMul ) );
+    vSum = vpadd_f32( vSum, vSum );
+    return vcombine_f32( vSum, vSum );
+}
+
+__forceinline float RVecGetX( RVectorReg A )
+{
+    return vgetq_lane_f32( A, 0 );
+}
+
+// Estimate plus two Newton-Raphson steps, see RecipSqrtEst
+__forceinline RVectorReg RVecRecipSqrtEst( RVectorReg A )
+{
+    RVectorReg vEst = vrsqrteq_f32( A );
+    vEst = vmulq_f32( vEst, vrsqrtsq_f32( vmulq_f32( A, vEst ), vEst ) );
+    return vmulq_f32( vEst, vrsqrtsq_f32( vmulq_f32( A, vEst ), vEst ) );
+}
+
+__forceinline bool RVecEqual( RVectorReg A, RVectorReg B )
+{
+    uint32x4_t vEqual = vceqq_f32( A, B );
+    uint32x2_t vAnd = vand_u32( vget_low_u32( vEqual ), vget_high_u32( vEqual ) );
+    return ( vget_lane_u32( vAnd, 0 ) & vget_lane_u32( vAnd, 1 ) ) == 0xFFFFFFFF;
+}
+
+// x, y and z of A are all <= those of B
+__forceinline bool RVecAllLessEqual3( RVectorReg A, RVectorReg B )
+{
+    uint32x4_t vLess = vcleq_f32( A, B );
+    return ( vgetq_lane_u32( vLess, 0 ) & vgetq_lane_u32( vLess, 1 ) & vgetq_lane_u32( vLess, 2 ) ) == 0xFFFFFFFF;
+}
+
+__forceinline RVectorReg RVecMin( RVectorReg A, RVectorReg B )
+{
+    return vminq_f32( A, B );
+}
+
+__forceinline RVectorReg RVecMax( RVectorReg A, RVectorReg B )
+{
+    return vmaxq_f32( A, B );
+}
+
+__forceinline RVectorReg RVecCross3( RVectorReg A, RVectorReg B )
+{
+    float pA[4], pB[4];
+    vst1q_f32( pA, A );
+    vst1q_f32( pB, B );
+    return RVecSet( pA[1] * pB[2] - pA[2] * pB[1],
+                    pA[2] * pB[0] - pA[0] * pB[2],
+                    pA[0] * pB[1] - pA[1] * pB[0],
+                    0.0f );
+}
+
+__forceinline RVectorReg RVecSplatX( RVectorReg A ) { return vdupq_lane_f32( vget_low_f32( A ), 0 ); }
+__forceinline RVectorReg RVecSplatY( RVectorReg A ) { return vdupq_lane_f32( vget_low_f32( A ), 1 ); }
+__forceinline RVectorReg RVecSplatZ( RVectorReg A ) { return vdupq_lane_f32( vget_high_f32( A ), 0 ); }
+__forceinline RVectorReg RVecSplatW( RVectorReg A ) { return vdupq_lane_f32( vget_high_f32( A ), 1 ); }
+
+__forceinline void RVecTranspose( RVectorReg& R0, RVectorReg& R1, RVectorReg& R2, RVectorReg& R3 )
+{
+    float32x4x2_t v01 = vtrnq_f32( R0, R1 );
+    float32x4x2_t v23 = vtrnq_f32( R2, R3 );
+    R0 = vcombine_f32( vget_low_f32( v01.val[0] ), vget_low_f32( v23.val[0] ) );
+    R1 = vcombine_f32( vget_low_f32( v01.val[1] ), vget_low_f32( v23.val[1] ) );
+    R2 = vcombine_f32( vget_high_f32( v01.val[0] ), vget_high_f32( v23.val[0] ) );
+    R3 = vcombine_f32( vget_high_f32( v01.val[1] ), vget_high_f32( v23.val[1] ) );
+}
+
+// Hamilton product B * A, which rotates by A, then B
+__forceinline RVectorReg RVecQuatMul( RVectorReg A, RVectorReg B )
+{
+    float pA[4], pB[4];
+    vst1q_f32( pA, A );
+    vst1q_f32( pB, B );
+    return RVecSet( pB[3] * pA[0] + pB[0] * pA[3] + pB[1] * pA[2] - pB[2] * pA[1],
+                    pB[3] * pA[1] - pB[0] * pA[2] + pB[1] * pA[3] + pB[2] * pA[0],
+                    pB[3] * pA[2] + pB[0] * pA[1] - pB[1] * pA[0] + pB[2] * pA[3],
+                    pB[3] * pA[3] - pB[0] * pA[0] - pB[1] * pA[1] - pB[2] * pA[2] );
+}
+
+#else // Scalar
+
+__forceinline RVectorReg RVecSet( float X, float Y, float Z, float W )
+{
+    RVectorReg vResult = { { X, Y, Z, W } };
+    return vResult;
+}
+
+__forceinline RVectorReg RVecLoad( const float* F )
+{
+    return RVecSet( F[0], F[1], F[2], F[3] );
+}
+
+__forceinline RVectorReg RVecSplat( float F )
+{
+    return RVecSet( F, F, F, F );
+}
+
+__forceinline RVectorReg RVecAdd( RVectorReg A, RVectorReg B )
+{
+    return RVecSet( A.f[0] + B.f[0], A.f[1] + B.f[1], A.f[2] + B.f[2], A.f[3] + B.f[3] );
+}
+
+__forceinline RVectorReg RVecSub( RVectorReg A, RVectorReg B )
+{
+    return RVecSet( A.f[0] - B.f[0], A.f[1] - B.f[1], A.f[2] - B.f[2], A.f[3] - B.f[3] );
+}
+
+__forceinline RVectorReg RVecMul( RVectorReg A, RVectorReg B )
+{
+    return RVecSet( A.f[0] * B.f[0], A.f[1] * B.f[1], A.f[2] * B.f[2], A.f[3] * B.f[3] );
+}
+
+// The dot product in every lane
+__forceinline RVectorReg RVecDot( RVectorReg A, RVectorReg B )
+{
+    return RVecSplat( A.f[0] * B.f[0] + A.f[1] * B.f[1] + A.f[2] * B.f[2] + A.f[3] * B.f[3] );
+}
+
+__forceinline float RVecGetX( RVectorReg A )
+{
+    return A.f[0];
+}
+
+__forceinline RVectorReg RVecRecipSqrtEst( RVectorReg A )
+{
+    return RVecSet( 1 / sqrtf( A.f[0] ), 1 / sqrtf( A.f[1] ), 1 / sqrtf( A.f[2] ), 1 / sqrtf( A.f[3] ) );
+}
+
+__forceinline bool RVecEqual( RVectorReg A, RVectorReg B )
+{
+    return A.f[0] == B.f[0] && A.f[1] == B.f[1] && A.f[2] == B.f[2] && A.f[3] == B.f[3];
+}
+
+// x, y and z of A are all <= those of B
+__forceinline bool RVecAllLessEqual3( RVectorReg A, RVectorReg B )
+{
+    return A.f[0] <= B.f[0] && A.f[1] <= B.f[1] && A.f[2] <= B.f[2];
+}
+
+__forceinline RVectorReg RVecMin( RVectorReg A, RVectorReg B )
+{
+    return RVecSet( A.f[0] < B.f[0] ? A.f[0] : B.f[0], A.f[1] < B.f[1] ? A.f[1] : B.f[1],
+                    A.f[2] < B.f[2] ? A.f[2] : B.f[2], A.f[3] < B.f[3] ? A.f[3] : B.f[3] );
+}
+
+__forceinline RVectorReg RVecMax( RVectorReg A, RVectorReg B )
+{
+    return RVecSet( A.f[0] > B.f[0] ? A.f[0] : B.f[0], A.f[1] > B.f[1] ? A.f[1] : B.f[1],
+                    A.f[2] > B.f[2] ? A.f[2] : B.f[2], A.f[3] > B.f[3] ? A.f[3] : B.f[3] );
+}
+
+__forceinline RVectorReg RVecCross3( RVectorReg A, RVectorReg B )
+{
+    return RVecSet( A.f[1] * B.f[2] - A.f[2] * B.f[1],
+                    A.f[2] * B.f[0] - A.f[0] * B.f[2],
+                    A.f[0] * B.f[1] - A.f[1] * B.f[0],
+                    0.0f );
+}
+
+__forceinline RVectorReg RVecSplatX( RVectorReg A ) { return RVecSplat( A.f[0] ); }
+__forceinline RVectorReg RVecSplatY( RVectorReg A ) { return RVecSplat( A.f[1] ); }
+__forceinline RVectorReg RVecSplatZ( RVectorReg A ) { return RVecSplat( A.f[2] ); }
+__forceinline RVectorReg RVecSplatW( RVectorReg A ) { return RVecSplat( A.f[3] ); }
+
+__forceinline void RVecTranspose( RVectorReg& R0, RVectorReg& R1, RVectorReg& R2, RVectorReg& R3 )
+{
+    RVectorReg vR0 = R0, vR1 = R1, vR2 = R2, vR3 = R3;
+    R0 = RVecSet( vR0.f[0], vR1.f[0], vR2.f[0], vR3.f[0] );
+    R1 = RVecSet( vR0.f[1], vR1.f[1], vR2.f[1], vR3.f[1] );
+    R2 = RVecSet( vR0.f[2], vR1.f[2], vR2.f[2], vR3.f[2] );
+    R3 = RVecSet( vR0.f[3], vR1.f[3], vR2.f[3], vR3.f[3] );
+}
+
+// Hamilton product B * A, which rotates by A, then B
+__forceinline RVectorReg RVecQuatMul( RVectorReg A, RVectorReg B )
+{
+    return RVecSet( B.f[3] * A.f[0] + B.f[0] * A.f[3] + B.f[1] * A.f[2] - B.f[2] * A.f[1],
+                    B.f[3] * A.f[1] - B.f[0] * A.f[2] + B.f[1] * A.f[3] + B.f[2] * A.f[0],
+                    B.f[3] * A.f[2] + B.f[0] * A.f[1] - B.f[1] * A.f[0] + B.f[2] * A.f[3],
+                    B.f[3] * A.f[3] - B.f[0] * A.f[0] - B.f[1] * A.f[1] - B.f[2] * A.f[2] );
+}
+
+#endif // #if defined( RIOT_SSE )
+
+
+/**********************************************************\
+|**********************************************************|
+| class RVector4
+|**********************************************************|
+\**********************************************************/
+_inline RVector4::RVector4(float X, float Y, float Z, float W) : v( RVecSet( X, Y, Z, W ) )
+{
+}
+
+_inline RVector4::RVector4(const RVector4& V) : v( V.v )
+{
+}
+
+_inline RVector4::RVector4(float X, float Y, float Z) : v( RVecSet( X, Y, Z, 0.0f ) )
+{
+}
+
+_inline RVector4::RVector4(const float* F) : v( RVecLoad( F ) )
+{
+}
+
+_inline RVector4::RVector4(RVectorReg V) : v( V )
+{
+}
+
+_inline RVector4& RVector4::operator=(const RVector4& V)
+{
+    v = V.v;
+    return *this;
+}
+
+/***************************************\
+| class methods
+\***************************************/
+// Scalar math operations
+
+// Add
+_inline RVector4 RVector4::operator+(const RVector4& V) const
+{
+    return RVector4( RVecAdd( v, V.v ) );
+}
+
+_inline RVector4 RVector4::operator+(float F) const
+{
+    return RVector4( RVecAdd( v, RVecSplat( F ) ) );
+}
+
+_inline RVector4& RVector4::operator+=(const RVector4& V)
+{
+    v = RVecAdd( v, V.v );
+    return *this;
+}
+
+_inline RVector4& RVector4::operator+=(float F)
+{
+    v = RVecAdd( v, RVecSplat( F ) );
+    return *this;
+}
+
+
+// Subtract
+_inline RVector4 RVector4::operator-(const RVector4& V) const
+{
+    return RVector4( RVecSub( v, V.v ) );
+}
+
+_inline RVector4 RVector4::operator-(float F) const
+{
+    return RVector4( RVecSub( v, RVecSplat( F ) ) );
+}
+
+_inline RVector4& RVector4::operator-=(const RVector4& V)
+{
+    v = RVecSub( v, V.v );
+    return *this;
+}
+
+_inline RVector4& RVector4::operator-=(float F)
+{
+    v = RVecSub( v, RVecSplat( F ) );
+    return *this;
+}
+
+
+// Multiply and divide
+_inline RVector4 RVector4::operator*(float F) const
+{
+    return RVector4( RVecMul( v, RVecSplat( F ) ) );
+}
+
+_inline RVector4& RVector4::operator*=(float F)
+{
+    v = RVecMul( v, RVecSplat( F ) );
+    return *this;
+}
+
+_inline RVector4 RVector4::operator/(float F) const
+{
+    return RVector4( RVecMul( v, RVecSplat( 1 / F ) ) );
+}
+
+_inline RVector4& RVector4::operator/=(float F)
+{
+    v = RVecMul( v, RVecSplat( 1 / F ) );
+    return *this;
+}
+
+
+// Comparison
+_inline bool RVector4::operator==(const RVector4& V) const
+{
+    return RVecEqual( v, V.v );
+}
+
+_inline bool RVector4::operator!=(const RVector4& V) const
+{
+    return !(*this == V);
+}
+
+
+// Vector operations
+
+// Vector-Vector operations
+_inline float RVector4::DotProduct(const RVector4& V) const
+{
+    return RVecGetX( RVecDot( v, V.v ) );
+}
+
+_inline RVector4 RVector4::CrossProduct(const RVector4& V) const
+{
+    return RVector4( RVecCross3( v, V.v ) );
+}
+
+
+// Misc operations
+_inline float RVector4::Magnitude(void) const
+{
+    return sqrtf(MagnitudeSquared());
+}
+
+_inline float RVector4::MagnitudeSquared(void) const
+{
+    return DotProduct(*this);
+}
+
+_inline float RVector4::Distance(const RVector4& V) const
+{
+    return sqrtf(DistanceSquared(V));
+}
+
+_inline float RVector4::DistanceSquared(const RVector4& V) const
+{
+    return (*this - V).MagnitudeSquared();
+}
+
+_inline void RVector4::Normalize(void)
+{
+    *this *= 1 / Magnitude();
+}
+
+_inline void RVector4::NormalizeEst(void)
+{
+    v = RVecMul( v, RVecRecipSqrtEst( RVecDot( v, v ) ) );
+}
+
+_inline void RVector4::Zero(void)
+{
+    v = RVecSplat( 0.0f );
+}
+
+// Non-member functions
+_inline float DotProduct(const RVector4& V1, const RVector4& V2)
+{
+    return V1.DotProduct(V2);
+}
+
+_inline RVector4 CrossProduct(const RVector4& V1, const RVector4& V2)
+{
+    return V1.CrossProduct(V2);
+}
+
+_inline float Distance(const RVector4& V1, const RVector4& V2)
+{
+    return V1.Distance(V2);
+}
+
+_inline float DistanceSquared(const RVector4& V1, const RVector4& V2)
+{
+    return V1.DistanceSquared(V2);
+}
+
+_inline RVector4 Normalize(const RVector4& V)
+{
+    return V * (1 / V.Magnitude());
+}
+
+_inline RVector4 NormalizeEst(const RVector4& V)
+{
+    return RVector4( RVecMul( V.v, RVecRecipSqrtEst( RVecDot( V.v, V.v ) ) ) );
+}
+
+_inline RVector4 RVector4Zero()
+{
+    return RVector4( RVecSplat( 0.0f ) );
+}
+
+_inline RVector4 Lerp(const RVector4& V1, const RVector4& V2, float fT)
+{
+    return RVector4( RVecAdd( V1.v, RVecMul( RVecSub( V2.v, V1.v ), RVecSplat( fT ) ) ) );
+}
+
+
+/**********************************************************\
+|**********************************************************|
+| class RQuaternion
+|**********************************************************|
+\**********************************************************/
+_inline RQuaternion::RQuaternion(float X, float Y, float Z, float W) : v( RVecSet( X, Y, Z, W ) )
+{
+}
+
+_inline RQuaternion::RQuaternion(const RQuaternion& Q) : v( Q.v )
+{
+}
+
+_inline RQuaternion::RQuaternion(RVectorReg V) : v( V )
+{
+}
+
+_inline RQuaternion& RQuaternion::operator=(const RQuaternion& Q)
+{
+    v = Q.v;
+    return *this;
+}
+
+/***************************************\
+| class methods
+\***************************************/
+_inline RQuaternion RQuaternion::operator*(const RQuaternion& Q) const
+{
+    return RQuaternion( RVecQuatMul( v, Q.v ) );
+}
+
+_inline RQuaternion& RQuaternion::operator*=(const RQuaternion& Q)
+{
+    v = RVecQuatMul( v, Q.v );
+    return *this;
+}
+
+// Comparison
+_inline bool RQuaternion::operator==(const RQuaternion& Q) const
+{
+    return RVecEqual( v, Q.v );
+}
+
+_inline bool RQuaternion::operator!=(const RQuaternion& Q) const
+{
+    return !(*this == Q);
+}
+
+// Misc operations
+_inline float RQuaternion::DotProduct(const RQuaternion& Q) const
+{
+    return RVecGetX( RVecDot( v, Q.v ) );
+}
+
+_inline float RQuaternion::Magnitude(void) const
+{
+    return sqrtf(DotProduct(*this));
+}
+
+_inline void RQuaternion::Normalize(void)
+{
+    v = RVecMul( v, RVecSplat( 1 / Magnitude() ) );
+}
+
+_inline void RQuaternion::NormalizeEst(void)
+{
+    v = RVecMul( v, RVecRecipSqrtEst( RVecDot( v, v ) ) );
+}
+
+_inline void RQuaternion::Conjugate(void)
+{
+    v = RVecMul( v, RVecSet( -1.0f, -1.0f, -1.0f, 1.0f ) );
+}
+
+_inline void RQuaternion::Identity(void)
+{
+    v = RVecSet( 0.0f, 0.0f, 0.0f, 1.0f );
+}
+
+// Non-member functions
+_inline RQuaternion Normalize(const RQuaternion& Q)
+{
+    return RQuaternion( RVecMul( Q.v, RVecSplat( 1 / Q.Magnitude() ) ) );
+}
+
+_inline RQuaternion NormalizeEst(const RQuaternion& Q)
+{
+    return RQuaternion( RVecMul( Q.v, RVecRecipSqrtEst( RVecDot( Q.v, Q.v ) ) ) );
+}
+
+_inline RQuaternion Conjugate(const RQuaternion& Q)
+{
+    return RQuaternion( RVecMul( Q.v, RVecSet( -1.0f, -1.0f, -1.0f, 1.0f ) ) );
+}
+
+_inline RQuaternion Inverse(const RQuaternion& Q)
+{
+    float fRecip = 1 / Q.DotProduct(Q);
+    return RQuaternion( RVecMul( Q.v, RVecSet( -fRecip, -fRecip, -fRecip, fRecip ) ) );
+}
+
+//-----------------------------------------------------------------------------
+//  Slerp
+//  Takes the short way round. Nearly parallel quaternions are lerped and
+//  normalized instead, since the sine gets too small to divide by
+//-----------------------------------------------------------------------------
+_inline RQuaternion Slerp(const RQuaternion& Q1, const RQuaternion& Q2, float fT)
+{
+    float fCos = Q1.DotProduct(Q2);
+    float fSign = 1.0f;
+    if( fCos < 0.0f )
+    {
+        fCos = -fCos;
+        fSign = -1.0f;
+    }
+
+    float fScale1, fScale2;
+    if( fCos > 1.0f - gs_fEpsilon )
+    {
+        fScale1 = 1.0f - fT;
+        fScale2 = fT;
+    }
+    else
+    {
+        float fAngle = acosf( fCos );
+        float fRecipSin = 1 / sinf( fAngle );
+        fScale1 = sinf( (1.0f - fT) * fAngle ) * fRecipSin;
+        fScale2 = sinf( fT * fAngle ) * fRecipSin;
+    }
+
+    RQuaternion qResult( RVecAdd( RVecMul( Q1.v, RVecSplat( fScale1 ) ),
+                                  RVecMul( Q2.v, RVecSplat( fScale2 * fSign ) ) ) );
+    if( fCos > 1.0f - gs_fEpsilon )
+    {
+        qResult.Normalize();
+    }
+    return qResult;
+}
+
+_inline RQuaternion RQuaternionIdentity(void)
+{
+    return RQuaternion( 0.0f, 0.0f, 0.0f, 1.0f );
+}
+
+_inline RQuaternion RQuaternionRotationAxis(const RVector4& vAxis, float fAngle)
+{
+    RVector4 vNormal( vAxis.x, vAxis.y, vAxis.z, 0.0f );
+    vNormal.Normalize();
+    float fSin = sinf( fAngle * 0.5f );
+    return RQuaternion( vNormal.x * fSin, vNormal.y * fSin, vNormal.z * fSin, cosf( fAngle * 0.5f ) );
+}
+
+_inline RQuaternion RQuaternionRotationAxisEst(const RVector4& vAxis, float fAngle)
+{
+    RVector4 vNormal( vAxis.x, vAxis.y, vAxis.z, 0.0f );
+    vNormal.NormalizeEst();
+    float fSin, fCos;
+    SinCos( fAngle * 0.5f, &fSin, &fCos );
+    return RQuaternion( vNormal.x * fSin, vNormal.y * fSin, vNormal.z * fSin, fCos );
+}
+
+
+/**********************************************************\
+|**********************************************************|
+| class RMatrix3x3
+|**********************************************************|
+\**********************************************************/
+_inline RMatrix3x3::RMatrix3x3(const RVector3& R1, const RVector3& R2, const RVector3& R3)
+    : _11(R1.x), _12(R1.y), _13(R1.z)
+    , _21(R2.x), _22(R2.y), _23(R2.z)
+    , _31(R3.x), _32(R3.y), _33(R3.z)
+{
+}
+
+_inline RMatrix3x3::RMatrix3x3(const float* F)
+    : _11(F[0]), _12(F[1]), _13(F[2])
+    , _21(F[3]), _22(F[4]), _23(F[5])
+    , _31(F[6]), _32(F[7]), _33(F[8])
+{
+}
+
+/***************************************\
+| class methods
+\***************************************/
+_inline RMatrix3x3 RMatrix3x3::operator*(const RMatrix3x3& M) const
+{
+    RMatrix3x3 mResult;
+    for( uint i = 0; i < 3; ++i )
+    {
+        for( uint j = 0; j < 3; ++j )
+        {
+            mResult.m[i][j] = m[i][0] * M.m[0][j] + m[i][1] * M.m[1][j] + m[i][2] * M.m[2][j];
+        }
+    }
+    return mResult;
+}
+
+_inline RMatrix3x3& RMatrix3x3::operator*=(const RMatrix3x3& M)
+{
+    *this = *this * M;
+    return *this;
+}
+
+_inline RVector3 RMatrix3x3::GetRow(uint nRow) const
+{
+    return RVector3( m[nRow] );
+}
+
+_inline float RMatrix3x3::Determinant(void) const
+{
+    return GetRow(0).DotProduct( GetRow(1).CrossProduct( GetRow(2) ) );
+}
+
+_inline void RMatrix3x3::Transpose(void)
+{
+    float fTemp;
+    fTemp = _12; _12 = _21; _21 = fTemp;
+    fTemp = _13; _13 = _31; _31 = fTemp;
+    fTemp = _23; _23 = _32; _32 = fTemp;
+}
+
+_inline void RMatrix3x3::Identity(void)
+{
+    _11 = 1.0f; _12 = 0.0f; _13 = 0.0f;
+    _21 = 0.0f; _22 = 1.0f; _23 = 0.0f;
+    _31 = 0.0f; _32 = 0.0f; _33 = 1.0f;
+}
+
+// Non-member functions
+_inline RVector3 operator*(const RVector3& V, const RMatrix3x3& M)
+{
+    return RVector3( V.x * M._11 + V.y * M._21 + V.z * M._31,
+                     V.x * M._12 + V.y * M._22 + V.z * M._32,
+                     V.x * M._13 + V.y * M._23 + V.z * M._33 );
+}
+
+_inline RMatrix3x3 Transpose(const RMatrix3x3& M)
+{
+    RMatrix3x3 mResult( M );
+    mResult.Transpose();
+    return mResult;
+}
+
+//-----------------------------------------------------------------------------
+//  Inverse
+//  The rows of the inverse's transpose are the cross products of the
+//  other two rows, over the determinant
+//-----------------------------------------------------------------------------
+_inline RMatrix3x3 Inverse(const RMatrix3x3& M)
+{
+    RVector3 vRow0 = M.GetRow(0), vRow1 = M.GetRow(1), vRow2 = M.GetRow(2);
+    RVector3 vCross0 = vRow1.CrossProduct( vRow2 );
+    RVector3 vCross1 = vRow2.CrossProduct( vRow0 );
+    RVector3 vCross2 = vRow0.CrossProduct( vRow1 );
+    float fRecipDet = 1 / vRow0.DotProduct( vCross0 );
+
+    RMatrix3x3 mResult( vCross0 * fRecipDet, vCross1 * fRecipDet, vCross2 * fRecipDet );
+    mResult.Transpose();
+    return mResult;
+}
+
+_inline RMatrix3x3 RMatrix3x3Identity(void)
+{
+    RMatrix3x3 mResult;
+    mResult.Identity();
+    return mResult;
+}
+
+_inline RMatrix3x3 RMatrix3x3RotationQuaternion(const RQuaternion& Q)
+{
+    float fXX = Q.x * Q.x, fYY = Q.y * Q.y, fZZ = Q.z * Q.z;
+    float fXY = Q.x * Q.y, fXZ = Q.x * Q.z, fYZ = Q.y * Q.z;
+    float fWX = Q.w * Q.x, fWY = Q.w * Q.y, fWZ = Q.w * Q.z;
+
+    RMatrix3x3 mResult;
+    mResult._11 = 1.0f - 2.0f * (fYY + fZZ);
+    mResult._12 = 2.0f * (fXY + fWZ);
+    mResult._13 = 2.0f * (fXZ - fWY);
+    mResult._21 = 2.0f * (fXY - fWZ);
+    mResult._22 = 1.0f - 2.0f * (fXX + fZZ);
+    mResult._23 = 2.0f * (fYZ + fWX);
+    mResult._31 = 2.0f * (fXZ + fWY);
+    mResult._32 = 2.0f * (fYZ - fWX);
+    mResult._33 = 1.0f - 2.0f * (fXX + fYY);
+    return mResult;
+}
+
+
+/**********************************************************\
+|**********************************************************|
+| class RMatrix4x4
+|**********************************************************|
+\**********************************************************/
+_inline RMatrix4x4::RMatrix4x4(const RVector4& R1, const RVector4& R2, const RVector4& R3, const RVector4& R4)
+{
+    r[0] = R1.v;
+    r[1] = R2.v;
+    r[2] = R3.v;
+    r[3] = R4.v;
+}
+
+_inline RMatrix4x4::RMatrix4x4(const float* F)
+{
+    r[0] = RVecLoad( F );
+    r[1] = RVecLoad( F + 4 );
+    r[2] = RVecLoad( F + 8 );
+    r[3] = RVecLoad( F + 12 );
+}
+
+// Row vector times matrix: V.x * row 0 + V.y * row 1 + ...
+__forceinline RVectorReg RVecTransform( RVectorReg V, const RMatrix4x4& M )
+{
+    RVectorReg vResult = RVecMul( RVecSplatX( V ), M.r[0] );
+    vResult = RVecAdd( vResult, RVecMul( RVecSplatY( V ), M.r[1] ) );
+    vResult = RVecAdd( vResult, RVecMul( RVecSplatZ( V ), M.r[2] ) );
+    return RVecAdd( vResult, RVecMul( RVecSplatW( V ), M.r[3] ) );
+}
+
+/***************************************\
+| class methods
+\***************************************/
+_inline RMatrix4x4 RMatrix4x4::operator*(const RMatrix4x4& M) const
+{
+    RMatrix4x4 mResult;
+    mResult.r[0] = RVecTransform( r[0], M );
+    mResult.r[1] = RVecTransform( r[1], M );
+    mResult.r[2] = RVecTransform( r[2], M );
+    mResult.r[3] = RVecTransform( r[3], M );
+    return mResult;
+}
+
+_inline RMatrix4x4& RMatrix4x4::operator*=(const RMatrix4x4& M)
+{
+    *this = *this * M;
+    return *this;
+}
+
+// Comparison
+_inline bool RMatrix4x4::operator==(const RMatrix4x4& M) const
+{
+    return RVecEqual( r[0], M.r[0] ) && RVecEqual( r[1], M.r[1] )
+        && RVecEqual( r[2], M.r[2] ) && RVecEqual( r[3], M.r[3] );
+}
+
+_inline bool RMatrix4x4::operator!=(const RMatrix4x4& M) const
+{
+    return !(*this == M);
+}
+
+_inline RVector4 RMatrix4x4::GetRow(uint nRow) const
+{
+    return RVector4( r[nRow] );
+}
+
+_inline void RMatrix4x4::Transpose(void)
+{
+    RVecTranspose( r[0], r[1], r[2], r[3] );
+}
+
+_inline void RMatrix4x4::Identity(void)
+{
+    r[0] = RVecSet( 1.0f, 0.0f, 0.0f, 0.0f );
+    r[1] = RVecSet( 0.0f, 1.0f, 0.0f, 0.0f );
+    r[2] = RVecSet( 0.0f, 0.0f, 1.0f, 0.0f );
+    r[3] = RVecSet( 0.0f, 0.0f, 0.0f, 1.0f );
+}
+
+// Non-member functions
+_inline RVector4 operator*(const RVector4& V, const RMatrix4x4& M)
+{
+    return RVector4( RVecTransform( V.v, M ) );
+}
+
+_inline RMatrix4x4 Transpose(const RMatrix4x4& M)
+{
+    RMatrix4x4 mResult( M );
+    mResult.Transpose();
+    return mResult;
+}
+
+//-----------------------------------------------------------------------------
+//  AffineInverse
+//  The top 3x3 is inverted the same way as RMatrix3x3's Inverse, then the
+//  translation is run back through it
+//-----------------------------------------------------------------------------
+_inline RMatrix4x4 AffineInverse(const RMatrix4x4& M)
+{
+    RMatrix4x4 mResult;
+    mResult.r[0] = RVecCross3( M.r[1], M.r[2] );
+    mResult.r[1] = RVecCross3( M.r[2], M.r[0] );
+    mResult.r[2] = RVecCross3( M.r[0], M.r[1] );
+    mResult.r[3] = RVecSplat( 0.0f );
+
+    RVectorReg vRecipDet = RVecSplat( 1 / RVecGetX( RVecDot( M.r[0], mResult.r[0] ) ) );
+    mResult.r[0] = RVecMul( mResult.r[0], vRecipDet );
+    mResult.r[1] = RVecMul( mResult.r[1], vRecipDet );
+    mResult.r[2] = RVecMul( mResult.r[2], vRecipDet );
+    mResult.Transpose();
+
+    // The w column came out of the transpose as zero
+    RVectorReg vTranslation = RVecMul( RVecSplatX( M.r[3] ), mResult.r[0] );
+    vTranslation = RVecAdd( vTranslation, RVecMul( RVecSplatY( M.r[3] ), mResult.r[1] ) );
+    vTranslation = RVecAdd( vTranslation, RVecMul( RVecSplatZ( M.r[3] ), mResult.r[2] ) );
+    mResult.r[3] = RVecSub( RVecSet( 0.0f, 0.0f, 0.0f, 1.0f ), vTranslation );
+    return mResult;
+}
+
+_inline RMatrix4x4 RMatrix4x4Identity(void)
+{
+    RMatrix4x4 mResult;
+    mResult.Identity();
+    return mResult;
+}
+
+_inline RMatrix4x4 RMatrix4x4Translation(const RVector4& V)
+{
+    RMatrix4x4 mResult;
+    mResult.Identity();
+    mResult.r[3] = RVecSet( V.x, V.y, V.z, 1.0f );
+    return mResult;
+}
+
+_inline RMatrix4x4 RMatrix4x4Scaling(float X, float Y, float Z)
+{
+    RMatrix4x4 mResult;
+    mResult.r[0] = RVecSet( X, 0.0f, 0.0f, 0.0f );
+    mResult.r[1] = RVecSet( 0.0f, Y, 0.0f, 0.0f );
+    mResult.r[2] = RVecSet( 0.0f, 0.0f, Z, 0.0f );
+    mResult.r[3] = RVecSet( 0.0f, 0.0f, 0.0f, 1.0f );
+    return mResult;
+}
+
+_inline RMatrix4x4 RMatrix4x4RotationQuaternion(const RQuaternion& Q)
+{
+    RMatrix3x3 mRotation = RMatrix3x3RotationQuaternion( Q );
+
+    RMatrix4x4 mResult;
+    mResult.r[0] = RVecSet( mRotation._11, mRotation._12, mRotation._13, 0.0f );
+    mResult.r[1] = RVecSet( mRotation._21, mRotation._22, mRotation._23, 0.0f );
+    mResult.r[2] = RVecSet( mRotation._31, mRotation._32, mRotation._33, 0.0f );
+    mResult.r[3] = RVecSet( 0.0f, 0.0f, 0.0f, 1.0f );
+    return mResult;
+}
+
+_inline RMatrix4x4 RMatrix4x4RotationAxis(const RVector4& vAxis, float fAngle)
+{
+    return RMatrix4x4RotationQuaternion( RQuaternionRotationAxis( vAxis, fAngle ) );
+}
+
+_inline RMatrix4x4 RMatrix4x4RotationAxisEst(const RVector4& vAxis, float fAngle)
+{
+    return RMatrix4x4RotationQuaternion( RQuaternionRotationAxisEst( vAxis, fAngle ) );
+}
+
+_inline RMatrix4x4 RMatrix4x4LookToLH(const RVector4& vEye, const RVector4& vDirection, const RVector4& vUp)
+{
+    RVector4 vZ = Normalize( vDirection );
+    RVector4 vX = Normalize( CrossProduct( vUp, vZ ) );
+    RVector4 vY = CrossProduct( vZ, vX );
+
+    // Build the rows of the transpose, with the translation down the w's
+    RMatrix4x4 mResult;
+    mResult.r[0] = RVecSet( vX.x, vX.y, vX.z, -vX.DotProduct( vEye ) );
+    mResult.r[1] = RVecSet( vY.x, vY.y, vY.z, -vY.DotProduct( vEye ) );
+    mResult.r[2] = RVecSet( vZ.x, vZ.y, vZ.z, -vZ.DotProduct( vEye ) );
+    mResult.r[3] = RVecSet( 0.0f, 0.0f, 0.0f, 1.0f );
+    mResult.Transpose();
+    return mResult;
+}
+
+_inline RMatrix4x4 RMatrix4x4LookAtLH(const RVector4& vEye, const RVector4& vTarget, const RVector4& vUp)
+{
+    return RMatrix4x4LookToLH( vEye, vTarget - vEye, vUp );
+}
+
+_inline RMatrix4x4 RMatrix4x4PerspectiveFovLH(float fFovY, float fAspectRatio, float fNear, float fFar)
+{
+    float fHeight = 1 / tanf( fFovY * 0.5f );
+    float fWidth = fHeight / fAspectRatio;
+    float fRange = fFar / (fFar - fNear);
+
+    RMatrix4x4 mResult;
+    mResult.r[0] = RVecSet( fWidth, 0.0f, 0.0f, 0.0f );
+    mResult.r[1] = RVecSet( 0.0f, fHeight, 0.0f, 0.0f );
+    mResult.r[2] = RVecSet( 0.0f, 0.0f, fRange, 1.0f );
+    mResult.r[3] = RVecSet( 0.0f, 0.0f, -fRange * fNear, 0.0f );
+    return mResult;
+}
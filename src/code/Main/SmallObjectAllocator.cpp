@@ -0,0 +1,513 @@
+/*********************************************************\
+File:       SmallObjectAllocator.cpp
+Purpose:    Size-class allocator with thread-local caches,
+            backing the global operator new
+\*********************************************************/
+#include "SmallObjectAllocator.h"
+#include "Atomic.h"
+#include <string.h> // For memset
+
+#if defined( OS_WINDOWS )
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#endif // #if defined( OS_WINDOWS )
+
+//-----------------------------------------------------------------------------
+//  Layout
+//  Small objects are carved out of 64KB spans, aligned to 64KB, so the span
+//  header (and the size class) of any block is found by masking its address.
+//  Large blocks get their own 64KB aligned pages with the same header, so
+//  free never has to search for anything. Freed large blocks up to 1MB are
+//  kept around (up to a limit) and reused for the same page count, since
+//  mapping and unmapping pages is far slower than anything else here.
+//  Spans, large blocks and the caches are all kept separate per memory
+//  category, so the header also says who to charge a free to.
+//  Freed objects go on the freeing thread's cache. When a cache gets too
+//  big, a batch is handed back to the central list for that class, and
+//  empty caches refill a whole batch at a time, so the central locks
+//  are only touched once every few dozen operations.
+//-----------------------------------------------------------------------------
+static const size_t gs_nSpanSize        = 64 * 1024;
+static const size_t gs_nSpanHeaderSize  = 64;   // Keeps every object 16 byte aligned
+static const size_t gs_nSpansPerChunk   = 16;   // Spans are mapped 1MB at a time
+static const size_t gs_nPageSize        = 4096;
+
+static const uint   gs_nNumSizeClasses  = 28;
+static const uint   gs_nLargeSizeClass  = 0xFFFFFFFF;
+
+static const uint   gs_nNumLargeCacheBins   = 256;  // One per page count
+static const size_t gs_nMaxLargeCacheSize   = 32 * 1024 * 1024;
+
+struct SpanHeader
+{
+    uint        nSizeClass;
+    uint        nCategory;
+    uint        nDataOffset;    // Only used by large blocks, gs_nSpanHeaderSize unless over-aligned
+    size_t      nMappedSize;    // Only used by large blocks
+    SpanHeader* pNextCached;    // Only used by cached large blocks
+};
+
+struct FreeObject
+{
+    FreeObject* pNext;
+};
+
+struct ThreadCacheBin
+{
+    FreeObject* pHead;
+    uint        nCount;
+};
+
+struct ThreadCache
+{
+    ThreadCacheBin      pBins[eNUMMEMORYCATEGORIES][gs_nNumSizeClasses];
+
+    // Frees are counted against the thread doing the freeing, so these only
+    // make sense summed across every cache
+    SmallObjectCounters pCounters[eNUMMEMORYCATEGORIES];
+
+    ThreadCache*        pNext;
+};
+
+struct CentralBin
+{
+    CSpinLock   lock;
+    FreeObject* pHead;
+    byte*       pSpanCursor;    // Unused part of the newest span
+    byte*       pSpanEnd;
+};
+
+static CentralBin   g_pCentralBins[eNUMMEMORYCATEGORIES][gs_nNumSizeClasses];
+
+static CSpinLock    g_SpanLock;
+static byte*        g_pSpanChunkCursor = NULL;
+static byte*        g_pSpanChunkEnd = NULL;
+static volatile sint64 g_nBytesReserved = 0;
+
+static CSpinLock    g_LargeCacheLock;
+static SpanHeader*  g_pLargeCache[gs_nNumLargeCacheBins];
+static size_t       g_nLargeCacheSize = 0;
+
+static CSpinLock    g_ThreadCacheLock;
+static ThreadCache* g_pFirstThreadCache = NULL;
+static THREAD_LOCAL ThreadCache* gs_pThreadCache = NULL;
+
+//-----------------------------------------------------------------------------
+//  Size classes
+//  16 byte steps up to 128, then four classes per power of two up to 4KB:
+//  16, 32, ... 128, 160, 192, 224, 256, 320, ... 3584, 4096
+//  which caps the wasted space at 25% (12.5% on average)
+//-----------------------------------------------------------------------------
+static __forceinline uint HighestBit( uint nValue )
+{
+#if defined( _MSC_VER )
+    unsigned long nIndex;
+    _BitScanReverse( &nIndex, nValue );
+    return (uint)nIndex;
+#else
+    return 31 - (uint)__builtin_clz( nValue );
+#endif // #if defined( _MSC_VER )
+}
+
+static __forceinline uint SizeToClass( size_t nSize )
+{
+    if( nSize <= 128 )
+    {
+        return nSize == 0 ? 0 : (uint)( ( nSize - 1 ) >> 4 );
+    }
+    uint nValue = (uint)nSize - 1;
+    uint nBit = HighestBit( nValue );
+    return 8 + ( nBit - 7 ) * 4 + ( nValue >> ( nBit - 2 ) ) - 4;
+}
+
+static const uint gs_pClassSizes[gs_nNumSizeClasses] =
+{
+    16,   32,   48,   64,   80,   96,   112,  128,
+    160,  192,  224,  256,  320,  384,  448,  512,
+    640,  768,  896,  1024, 1280, 1536, 1792, 2048,
+    2560, 3072, 3584, 4096,
+};
+
+// Objects moved between a thread cache and the central list at once:
+// around 16KB worth, within reason
+static const uint gs_pBatchSizes[gs_nNumSizeClasses] =
+{
+    64,   64,   64,   64,   64,   64,   64,   64,
+    64,   64,   64,   64,   51,   42,   36,   32,
+    25,   21,   18,   16,   12,   10,   9,    8,
+    6,    5,    4,    4,
+};
+
+//-----------------------------------------------------------------------------
+//  PageAlloc/PageFree
+//  Maps memory straight from the OS, aligned to gs_nSpanSize
+//-----------------------------------------------------------------------------
+static void* PageAlloc( size_t nSize )
+{
+#if defined( OS_WINDOWS )
+    // Windows always hands out 64KB aligned allocations
+    void* pData = VirtualAlloc( NULL, nSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE );
+#else
+    // Map a bit extra, then trim it down to an aligned range
+    size_t nMapSize = nSize + gs_nSpanSize;
+    byte* pMapped = (byte*)mmap( NULL, nMapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    if( pMapped == (byte*)MAP_FAILED )
+        return NULL;
+
+    byte* pData = (byte*)( ( (nativeuint)pMapped + gs_nSpanSize - 1 ) & ~( (nativeuint)gs_nSpanSize - 1 ) );
+    size_t nHead = pData - pMapped;
+    size_t nTail = nMapSize - nHead - nSize;
+    if( nHead )
+        munmap( pMapped, nHead );
+    if( nTail )
+        munmap( pData + nSize, nTail );
+#endif // #if defined( OS_WINDOWS )
+
+    // TODO: Handle out of memory error ( pData == 0 )
+    if( pData )
+    {
+        AtomicAdd64( &g_nBytesReserved, (sint64)nSize );
+    }
+    return pData;
+}
+
+static void PageFree( void* pData, size_t nSize )
+{
+#if defined( OS_WINDOWS )
+    VirtualFree( pData, 0, MEM_RELEASE );
+#else
+    munmap( pData, nSize );
+#endif // #if defined( OS_WINDOWS )
+    AtomicAdd64( &g_nBytesReserved, -(sint64)nSize );
+}
+
+static __forceinline SpanHeader* GetSpanHeader( void* pData )
+{
+    return (SpanHeader*)( (nativeuint)pData & ~( (nativeuint)gs_nSpanSize - 1 ) );
+}
+
+//-----------------------------------------------------------------------------
+//  AllocateSpan
+//  Returns a fresh span for nClass. Called with the class's central lock held
+//-----------------------------------------------------------------------------
+static byte* AllocateSpan( uint nCategory, uint nClass )
+{
+    g_SpanLock.Lock();
+    if( g_pSpanChunkCursor == g_pSpanChunkEnd )
+    {
+        g_pSpanChunkCursor = (byte*)PageAlloc( gs_nSpanSize * gs_nSpansPerChunk );
+        g_pSpanChunkEnd = g_pSpanChunkCursor + gs_nSpanSize * gs_nSpansPerChunk;
+    }
+    byte* pSpan = g_pSpanChunkCursor;
+    g_pSpanChunkCursor += gs_nSpanSize;
+    g_SpanLock.Unlock();
+
+    SpanHeader* pHeader = (SpanHeader*)pSpan;
+    pHeader->nSizeClass = nClass;
+    pHeader->nCategory = nCategory;
+    pHeader->nMappedSize = gs_nSpanSize;
+    return pSpan;
+}
+
+//-----------------------------------------------------------------------------
+//  AllocateLarge/FreeLarge
+//  Blocks too big for a size class, nMappedSize is a multiple of the page
+//  size and includes the header
+//-----------------------------------------------------------------------------
+static SpanHeader* AllocateLarge( size_t nMappedSize )
+{
+    uint nBin = (uint)( nMappedSize / gs_nPageSize ) - 1;
+    if( nBin < gs_nNumLargeCacheBins )
+    {
+        g_LargeCacheLock.Lock();
+        SpanHeader* pHeader = g_pLargeCache[nBin];
+        if( pHeader )
+        {
+            g_pLargeCache[nBin] = pHeader->pNextCached;
+            g_nLargeCacheSize -= nMappedSize;
+            g_LargeCacheLock.Unlock();
+            return pHeader;
+        }
+        g_LargeCacheLock.Unlock();
+    }
+
+    SpanHeader* pHeader = (SpanHeader*)PageAlloc( nMappedSize );
+    pHeader->nSizeClass = gs_nLargeSizeClass;
+    pHeader->nMappedSize = nMappedSize;
+    return pHeader;
+}
+
+static void FreeLarge( SpanHeader* pHeader )
+{
+    size_t nMappedSize = pHeader->nMappedSize;
+    uint nBin = (uint)( nMappedSize / gs_nPageSize ) - 1;
+    if( nBin < gs_nNumLargeCacheBins )
+    {
+        g_LargeCacheLock.Lock();
+        if( g_nLargeCacheSize + nMappedSize <= gs_nMaxLargeCacheSize )
+        {
+            pHeader->pNextCached = g_pLargeCache[nBin];
+            g_pLargeCache[nBin] = pHeader;
+            g_nLargeCacheSize += nMappedSize;
+            g_LargeCacheLock.Unlock();
+            return;
+        }
+        g_LargeCacheLock.Unlock();
+    }
+
+    PageFree( pHeader, nMappedSize );
+}
+
+//-----------------------------------------------------------------------------
+//  CreateThreadCache
+//  First allocation on a thread. Caches are never freed; whatever is left in
+//  one when its thread exits stays there
+//-----------------------------------------------------------------------------
+static ThreadCache* CreateThreadCache( void )
+{
+    size_t nSize = ( sizeof( ThreadCache ) + gs_nPageSize - 1 ) & ~( gs_nPageSize - 1 );
+    ThreadCache* pCache = (ThreadCache*)PageAlloc( nSize );
+    // Fresh pages are already zeroed
+
+    g_ThreadCacheLock.Lock();
+    pCache->pNext = g_pFirstThreadCache;
+    g_pFirstThreadCache = pCache;
+    g_ThreadCacheLock.Unlock();
+
+    gs_pThreadCache = pCache;
+    return pCache;
+}
+
+//-----------------------------------------------------------------------------
+//  RefillBin
+//  Slow path of SmallObjectAlloc. Moves a batch of objects from the central
+//  list (or a new span) into the thread cache and returns one of them
+//-----------------------------------------------------------------------------
+static void* RefillBin( ThreadCacheBin* pBin, uint nCategory, uint nClass )
+{
+    CentralBin* pCentral = &g_pCentralBins[nCategory][nClass];
+    size_t nClassSize = gs_pClassSizes[nClass];
+    uint nBatch = gs_pBatchSizes[nClass];
+
+    FreeObject* pHead = NULL;
+    uint nCount = 0;
+
+    pCentral->lock.Lock();
+    while( nCount < nBatch && pCentral->pHead )
+    {
+        FreeObject* pObject = pCentral->pHead;
+        pCentral->pHead = pObject->pNext;
+        pObject->pNext = pHead;
+        pHead = pObject;
+        ++nCount;
+    }
+    while( nCount < nBatch )
+    {
+        if( pCentral->pSpanCursor + nClassSize > pCentral->pSpanEnd )
+        {
+            byte* pSpan = AllocateSpan( nCategory, nClass );
+            pCentral->pSpanCursor = pSpan + gs_nSpanHeaderSize;
+            pCentral->pSpanEnd = pSpan + gs_nSpanSize;
+        }
+        FreeObject* pObject = (FreeObject*)pCentral->pSpanCursor;
+        pCentral->pSpanCursor += nClassSize;
+        pObject->pNext = pHead;
+        pHead = pObject;
+        ++nCount;
+    }
+    pCentral->lock.Unlock();
+
+    pBin->pHead = pHead->pNext;
+    pBin->nCount = nCount - 1;
+    return pHead;
+}
+
+//-----------------------------------------------------------------------------
+//  FlushBin
+//  Hands a batch of objects from an overfull thread cache back to the
+//  central list
+//-----------------------------------------------------------------------------
+static void FlushBin( ThreadCacheBin* pBin, uint nCategory, uint nClass )
+{
+    uint nBatch = gs_pBatchSizes[nClass];
+
+    FreeObject* pFirst = pBin->pHead;
+    FreeObject* pLast = pFirst;
+    for( uint i = 1; i < nBatch; ++i )
+    {
+        pLast = pLast->pNext;
+    }
+    pBin->pHead = pLast->pNext;
+    pBin->nCount -= nBatch;
+
+    CentralBin* pCentral = &g_pCentralBins[nCategory][nClass];
+    pCentral->lock.Lock();
+    pLast->pNext = pCentral->pHead;
+    pCentral->pHead = pFirst;
+    pCentral->lock.Unlock();
+}
+
+//-----------------------------------------------------------------------------
+//  AllocateLargeBlock
+//  Gives a block its own pages. The data starts nDataOffset bytes in, which
+//  has to be a multiple of nAlignment
+//-----------------------------------------------------------------------------
+static void* AllocateLargeBlock( ThreadCache* pCache, size_t nSize, size_t nDataOffset, eMemoryCategory nCategory )
+{
+    size_t nMappedSize = ( nSize + nDataOffset + gs_nPageSize - 1 ) & ~( gs_nPageSize - 1 );
+    SpanHeader* pHeader = AllocateLarge( nMappedSize );
+    pHeader->nCategory = nCategory;
+    pHeader->nDataOffset = (uint)nDataOffset;
+
+    SmallObjectCounters* pCounters = &pCache->pCounters[nCategory];
+    pCounters->nBytesLive += nMappedSize;
+    pCounters->nAllocationsLive += 1;
+    pCounters->nTotalAllocations += 1;
+    pCounters->nTotalBytesAllocated += nMappedSize;
+    return (byte*)pHeader + nDataOffset;
+}
+
+//-----------------------------------------------------------------------------
+//  SmallObjectAlloc
+//  Allocates nSize bytes
+//-----------------------------------------------------------------------------
+void* SmallObjectAlloc( size_t nSize, eMemoryCategory nCategory )
+{
+    ThreadCache* pCache = gs_pThreadCache;
+    if( pCache == NULL )
+    {
+        pCache = CreateThreadCache();
+    }
+
+    if( nSize > gs_nMaxSmallObjectSize )
+    {
+        return AllocateLargeBlock( pCache, nSize, gs_nSpanHeaderSize, nCategory );
+    }
+
+    uint nClass = SizeToClass( nSize );
+    size_t nClassSize = gs_pClassSizes[nClass];
+    SmallObjectCounters* pCounters = &pCache->pCounters[nCategory];
+    pCounters->nBytesLive += nClassSize;
+    pCounters->nAllocationsLive += 1;
+    pCounters->nTotalAllocations += 1;
+    pCounters->nTotalBytesAllocated += nClassSize;
+
+    ThreadCacheBin* pBin = &pCache->pBins[nCategory][nClass];
+    FreeObject* pObject = pBin->pHead;
+    if( pObject )
+    {
+        pBin->pHead = pObject->pNext;
+        --pBin->nCount;
+        return pObject;
+    }
+
+    return RefillBin( pBin, nCategory, nClass );
+}
+
+//-----------------------------------------------------------------------------
+//  SmallObjectAllocAligned
+//  Allocates nSize bytes aligned to nAlignment.
+//  Objects start 64 bytes into a 64KB aligned span, and every size class
+//  from 64 bytes up is a multiple of 64, so anything up to cache line
+//  alignment just needs its size rounded up. Bigger alignments are rare
+//  enough to get their own pages, with the data offset from the header
+//-----------------------------------------------------------------------------
+void* SmallObjectAllocAligned( size_t nSize, size_t nAlignment, eMemoryCategory nCategory )
+{
+    if( nAlignment <= 16 )
+    {
+        return SmallObjectAlloc( nSize, nCategory );
+    }
+    if( nAlignment <= gs_nSpanHeaderSize )
+    {
+        size_t nRoundedSize = ( nSize + gs_nSpanHeaderSize - 1 ) & ~( gs_nSpanHeaderSize - 1 );
+        return SmallObjectAlloc( nRoundedSize ? nRoundedSize : gs_nSpanHeaderSize, nCategory );
+    }
+
+    ThreadCache* pCache = gs_pThreadCache;
+    if( pCache == NULL )
+    {
+        pCache = CreateThreadCache();
+    }
+    return AllocateLargeBlock( pCache, nSize, nAlignment, nCategory );
+}
+
+//-----------------------------------------------------------------------------
+//  SmallObjectFree
+//  Frees a block from SmallObjectAlloc. Any thread can free any block
+//-----------------------------------------------------------------------------
+void SmallObjectFree( void* pData )
+{
+    if( pData == NULL )
+        return;
+
+    ThreadCache* pCache = gs_pThreadCache;
+    if( pCache == NULL )
+    {
+        pCache = CreateThreadCache();
+    }
+
+    SpanHeader* pHeader = GetSpanHeader( pData );
+    uint nClass = pHeader->nSizeClass;
+    uint nCategory = pHeader->nCategory;
+    SmallObjectCounters* pCounters = &pCache->pCounters[nCategory];
+    if( nClass == gs_nLargeSizeClass )
+    {
+        pCounters->nBytesLive -= pHeader->nMappedSize;
+        pCounters->nAllocationsLive -= 1;
+        FreeLarge( pHeader );
+        return;
+    }
+
+    pCounters->nBytesLive -= gs_pClassSizes[nClass];
+    pCounters->nAllocationsLive -= 1;
+
+    ThreadCacheBin* pBin = &pCache->pBins[nCategory][nClass];
+    FreeObject* pObject = (FreeObject*)pData;
+    pObject->pNext = pBin->pHead;
+    pBin->pHead = pObject;
+    if( ++pBin->nCount > gs_pBatchSizes[nClass] * 2 )
+    {
+        FlushBin( pBin, nCategory, nClass );
+    }
+}
+
+//-----------------------------------------------------------------------------
+//  SmallObjectSize
+//  Returns the usable size of a block from SmallObjectAlloc
+//-----------------------------------------------------------------------------
+size_t SmallObjectSize( void* pData )
+{
+    SpanHeader* pHeader = GetSpanHeader( pData );
+    if( pHeader->nSizeClass == gs_nLargeSizeClass )
+    {
+        return pHeader->nMappedSize - pHeader->nDataOffset;
+    }
+    return gs_pClassSizes[ pHeader->nSizeClass ];
+}
+
+//-----------------------------------------------------------------------------
+//  GetSmallObjectStats
+//  Fills out the current statistics
+//-----------------------------------------------------------------------------
+void GetSmallObjectStats( SmallObjectStats* pStats )
+{
+    memset( pStats->pCategories, 0, sizeof( pStats->pCategories ) );
+
+    g_ThreadCacheLock.Lock();
+    for( ThreadCache* pCache = g_pFirstThreadCache; pCache != NULL; pCache = pCache->pNext )
+    {
+        for( uint i = 0; i < eNUMMEMORYCATEGORIES; ++i )
+        {
+            SmallObjectCounters* pTotal = &pStats->pCategories[i];
+            pTotal->nBytesLive += pCache->pCounters[i].nBytesLive;
+            pTotal->nAllocationsLive += pCache->pCounters[i].nAllocationsLive;
+            pTotal->nTotalAllocations += pCache->pCounters[i].nTotalAllocations;
+            pTotal->nTotalBytesAllocated += pCache->pCounters[i].nTotalBytesAllocated;
+        }
+    }
+    g_ThreadCacheLock.Unlock();
+
+    pStats->nBytesReserved = (uint64)g_nBytesReserved;
+}
@@ -0,0 +1,70 @@
+/*********************************************************\
+File:       SmallObjectAllocator.h
+Purpose:    Size-class allocator with thread-local caches,
+            backing the global operator new
+\*********************************************************/
+#ifndef _SMALLOBJECTALLOCATOR_H_
+#define _SMALLOBJECTALLOCATOR_H_
+#include "Types.h"
+#include "Memory.h"
+#include <stddef.h> // For size_t
+
+//-----------------------------------------------------------------------------
+//  Requests up to gs_nMaxSmallObjectSize bytes are rounded up to one of the
+//  segregated size classes (16 bytes to 4KB) and served from 64KB spans,
+//  through a per-thread cache. Anything bigger gets its own pages from the
+//  OS. Every block is at least 16 byte aligned
+//-----------------------------------------------------------------------------
+static const size_t gs_nMaxSmallObjectSize = 4096;
+
+//-----------------------------------------------------------------------------
+//  SmallObjectStats
+//  Totals across every thread. Counters are per-thread and summed without
+//  locking, so they're only exact when nothing else is allocating
+//-----------------------------------------------------------------------------
+struct SmallObjectCounters
+{
+    sint64  nBytesLive;         // Rounded up to the size class
+    sint64  nAllocationsLive;
+    uint64  nTotalAllocations;
+    uint64  nTotalBytesAllocated;
+};
+
+struct SmallObjectStats
+{
+    SmallObjectCounters pCategories[eNUMMEMORYCATEGORIES];
+    uint64              nBytesReserved; // Spans and large blocks mapped from the OS
+};
+
+//-----------------------------------------------------------------------------
+//  SmallObjectAlloc
+//  Allocates nSize bytes, charged to nCategory
+//-----------------------------------------------------------------------------
+void* SmallObjectAlloc( size_t nSize, eMemoryCategory nCategory );
+
+//-----------------------------------------------------------------------------
+//  SmallObjectAllocAligned
+//  Allocates nSize bytes aligned to nAlignment, which must be a power of
+//  two no bigger than half a span (32KB). Freed with SmallObjectFree
+//-----------------------------------------------------------------------------
+void* SmallObjectAllocAligned( size_t nSize, size_t nAlignment, eMemoryCategory nCategory );
+
+//-----------------------------------------------------------------------------
+//  SmallObjectFree
+//  Frees a block from SmallObjectAlloc. Any thread can free any block
+//-----------------------------------------------------------------------------
+void SmallObjectFree( void* pData );
+
+//-----------------------------------------------------------------------------
+//  SmallObjectSize
+//  Returns the usable size of a block from SmallObjectAlloc
+//-----------------------------------------------------------------------------
+size_t SmallObjectSize( void* pData );
+
+//-----------------------------------------------------------------------------
+//  GetSmallObjectStats
+//  Fills out the current statistics
+//-----------------------------------------------------------------------------
+void GetSmallObjectStats( SmallObjectStats* pStats );
+
+#endif // #ifndef _SMALLOBJECTALLOCATOR_H_
@@ -0,0 +1,57 @@
+/*********************************************************\
+File:       Timer.cpp
+Purpose:    Tick rates for the timestamps in Timer.h
+\*********************************************************/
+#include "Timer.h"
+
+//-----------------------------------------------------------------------------
+//  GetOSTicksPerSecond
+//  The OS clock's rate never changes, so it's only looked up once
+//-----------------------------------------------------------------------------
+double GetOSTicksPerSecond( void )
+{
+    static double fTicksPerSecond = 0.0;
+    if( fTicksPerSecond == 0.0 )
+    {
+#if defined( OS_WINDOWS )
+        LARGE_INTEGER nFrequency;
+        QueryPerformanceFrequency( &nFrequency );
+        fTicksPerSecond = (double)nFrequency.QuadPart;
+#elif defined( OS_OSX )
+        mach_timebase_info_data_t timebase;
+        mach_timebase_info( &timebase );
+        fTicksPerSecond = 1000000000.0 * timebase.denom / timebase.numer;
+#else
+        fTicksPerSecond = 1000000000.0;
+#endif // #if defined( OS_WINDOWS )
+    }
+    return fTicksPerSecond;
+}
+
+//-----------------------------------------------------------------------------
+//  GetCPUTicksPerSecond
+//  Measures the time stamp counter against the OS clock over a few
+//  milliseconds. Every CPU from the last few years keeps the counter at a
+//  fixed rate no matter what the clock speed is doing, so once is enough
+//-----------------------------------------------------------------------------
+double GetCPUTicksPerSecond( void )
+{
+    static double fTicksPerSecond = 0.0;
+    if( fTicksPerSecond == 0.0 )
+    {
+        double fOSTicksPerSecond = GetOSTicksPerSecond();
+        uint64 nOSWait = (uint64)( fOSTicksPerSecond * 0.01 );
+
+        uint64 nOSStart = GetOSTicks();
+        uint64 nCPUStart = GetCPUTicks();
+        uint64 nOSEnd;
+        do
+        {
+            nOSEnd = GetOSTicks();
+        } while( nOSEnd - nOSStart < nOSWait );
+        uint64 nCPUEnd = GetCPUTicks();
+
+        fTicksPerSecond = (double)( nCPUEnd - nCPUStart ) * fOSTicksPerSecond / (double)( nOSEnd - nOSStart );
+    }
+    return fTicksPerSecond;
+}
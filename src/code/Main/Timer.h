@@ -6,46 +6,83 @@ Purpose:    High performance, high precision timer
 #define _TIMER_H_
 #include "Common.h"
 
-#ifdef WIN32
+#if defined( OS_WINDOWS )
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
-#endif // #ifdef WIN32
+#include <intrin.h> // For __rdtsc
+#elif defined( OS_OSX )
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif // #if defined( OS_WINDOWS )
+
+//-----------------------------------------------------------------------------
+//  Timestamps
+//  The OS ticks come from the OS's high resolution clock (QueryPerformance-
+//  Counter, mach_absolute_time or clock_gettime) and are right everywhere.
+//  The CPU ticks come straight from the time stamp counter, which is a lot
+//  cheaper to read, so they're what the profiler uses. Their rate is
+//  measured against the OS clock the first time it's asked for. On CPUs
+//  without a usable counter they're just the OS ticks
+//-----------------------------------------------------------------------------
+__forceinline uint64 GetOSTicks( void )
+{
+#if defined( OS_WINDOWS )
+    LARGE_INTEGER nTicks;
+    QueryPerformanceCounter( &nTicks );
+    return (uint64)nTicks.QuadPart;
+#elif defined( OS_OSX )
+    return mach_absolute_time();
+#else
+    timespec time;
+    clock_gettime( CLOCK_MONOTONIC, &time );
+    return (uint64)time.tv_sec * 1000000000ULL + (uint64)time.tv_nsec;
+#endif // #if defined( OS_WINDOWS )
+}
+
+__forceinline uint64 GetCPUTicks( void )
+{
+#if defined( _MSC_VER )
+    return __rdtsc();
+#elif defined( __i386__ ) || defined( __x86_64__ )
+    return __builtin_ia32_rdtsc();
+#else
+    return GetOSTicks();
+#endif // #if defined( _MSC_VER )
+}
+
+double GetOSTicksPerSecond( void );
+double GetCPUTicksPerSecond( void );
 
 class Timer
 {
 private:
     double          m_Freq;
-#ifdef WIN32
-    LARGE_INTEGER   m_PrevTime;
-    LARGE_INTEGER   m_CurrTime;
-#endif // #ifdef WIN32
+    uint64          m_PrevTime;
+    uint64          m_CurrTime;
 
 public:
     Timer() 
         : m_Freq(0)
+        , m_PrevTime(0)
+        , m_CurrTime(0)
     { }
     ~Timer() { }
 
     // Reset timer
     __forceinline void Reset(void)
     {
-#ifdef WIN32
-        LARGE_INTEGER freq;
-        QueryPerformanceFrequency(&freq);
-        m_Freq = 1.0/(double)freq.QuadPart;
-        QueryPerformanceCounter(&m_PrevTime);
-#endif // #ifdef WIN32
+        m_Freq = 1.0/GetOSTicksPerSecond();
+        m_PrevTime = GetOSTicks();
     }
 
     // Return time in seconds since last GetTime
     __forceinline double GetTime(void)
     {
-#ifdef WIN32
-        QueryPerformanceCounter(&m_CurrTime);
-        double dTime = ((m_CurrTime.QuadPart - m_PrevTime.QuadPart) * m_Freq);
+        m_CurrTime = GetOSTicks();
+        double dTime = (m_CurrTime - m_PrevTime) * m_Freq;
         m_PrevTime = m_CurrTime;
         return dTime;
-#endif // #ifdef WIN32
     }
 };
 
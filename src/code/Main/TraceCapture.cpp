@@ -0,0 +1,328 @@
+/*********************************************************\
+File:       TraceCapture.cpp
+Purpose:    Streams profiler scopes, counters and frames
+            to a Chrome trace-event file
+\*********************************************************/
+#include "TraceCapture.h"
+#include "Profiler.h"
+#include <stdio.h>
+#include <string.h>
+
+//-----------------------------------------------------------------------------
+//  Capture state
+//  Each profiled thread has a read cursor into its ring buffer. Anything the
+//  thread wrote more than a ring buffer ago is gone by the time it's read,
+//  so it's counted as dropped instead
+//-----------------------------------------------------------------------------
+static const uint   gs_nMaxTraceThreads = 64;
+static const uint   gs_nMaxTraceFilename = 260;
+static const uint   gs_nNoFrame = 0xFFFFFFFF;
+
+struct TraceThread
+{
+    ProfileThread*  pThread;
+    sint32          nRead;
+};
+
+static FILE*        g_pTraceFile = NULL;
+static char         g_szTraceFilename[gs_nMaxTraceFilename];
+static bool         g_bStartPending = false;
+static bool         g_bStopPending = false;
+static uint         g_nStartFrame = gs_nNoFrame;   // For TraceCaptureFrames
+static uint         g_nStopFrame = gs_nNoFrame;
+
+static bool         g_bInFrame = false;
+static uint         g_nFrame = 0;
+static uint64       g_nFrameStart = 0;
+
+static uint64       g_nCaptureStart = 0;
+static double       g_fMicrosecondsPerTick = 0.0;
+static bool         g_bFirstEvent = true;
+static uint64       g_nDroppedEvents = 0;
+
+static TraceThread  g_pTraceThreads[gs_nMaxTraceThreads];
+static uint         g_nNumTraceThreads = 0;
+
+//-----------------------------------------------------------------------------
+//  WriteEventStart
+//  Every event goes on its own line, with the comma in front
+//-----------------------------------------------------------------------------
+static void WriteEventStart( void )
+{
+    fputs( g_bFirstEvent ? "\n" : ",\n", g_pTraceFile );
+    g_bFirstEvent = false;
+}
+
+static double TicksToMicroseconds( uint64 nTicks )
+{
+    // Scopes can start before the capture did
+    if( nTicks < g_nCaptureStart )
+        return 0.0;
+    return (double)( nTicks - g_nCaptureStart ) * g_fMicrosecondsPerTick;
+}
+
+//-----------------------------------------------------------------------------
+//  WriteString
+//  Writes a JSON string, escaped
+//-----------------------------------------------------------------------------
+static void WriteString( const char* szString )
+{
+    fputc( '"', g_pTraceFile );
+    for( const char* pChar = szString; *pChar; ++pChar )
+    {
+        if( *pChar == '"' || *pChar == '\\' )
+        {
+            fputc( '\\', g_pTraceFile );
+        }
+        if( (unsigned char)*pChar >= ' ' )
+        {
+            fputc( *pChar, g_pTraceFile );
+        }
+    }
+    fputc( '"', g_pTraceFile );
+}
+
+//-----------------------------------------------------------------------------
+//  FindTraceThread
+//  Returns the read cursor for a thread, naming it in the trace the first
+//  time it's seen. New threads start reading from the oldest event that's
+//  still in their ring buffer and was written during the capture
+//-----------------------------------------------------------------------------
+static TraceThread* FindTraceThread( ProfileThread* pThread )
+{
+    for( uint nThread = 0; nThread < g_nNumTraceThreads; ++nThread )
+    {
+        if( g_pTraceThreads[nThread].pThread == pThread )
+            return &g_pTraceThreads[nThread];
+    }
+    if( g_nNumTraceThreads == gs_nMaxTraceThreads )
+        return NULL;
+
+    TraceThread* pTraceThread = &g_pTraceThreads[ g_nNumTraceThreads++ ];
+    pTraceThread->pThread = pThread;
+    sint32 nWrite = AtomicLoadAcquire( &pThread->nWrite );
+    pTraceThread->nRead = nWrite > (sint32)gs_nProfileEventsPerThread ? nWrite - (sint32)gs_nProfileEventsPerThread : 0;
+
+    WriteEventStart();
+    fprintf( g_pTraceFile, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", pThread->nThreadId );
+    if( pThread->szName )
+    {
+        WriteString( pThread->szName );
+    }
+    else
+    {
+        fprintf( g_pTraceFile, "\"Thread %u\"", pThread->nThreadId );
+    }
+    fputs( "}}", g_pTraceFile );
+    return pTraceThread;
+}
+
+//-----------------------------------------------------------------------------
+//  WriteThreadEvents
+//  Writes every event the thread finished since it was last read
+//-----------------------------------------------------------------------------
+static void WriteThreadEvents( TraceThread* pTraceThread )
+{
+    ProfileThread* pThread = pTraceThread->pThread;
+    sint32 nWrite = AtomicLoadAcquire( &pThread->nWrite );
+    sint32 nRead = pTraceThread->nRead;
+    if( nWrite - nRead > (sint32)gs_nProfileEventsPerThread )
+    {
+        g_nDroppedEvents += (uint32)( nWrite - nRead - (sint32)gs_nProfileEventsPerThread );
+        nRead = nWrite - (sint32)gs_nProfileEventsPerThread;
+    }
+
+    for( ; nRead != nWrite; ++nRead )
+    {
+        ProfileEvent event = pThread->pEvents[ (uint)nRead % gs_nProfileEventsPerThread ];
+
+        // The thread may have lapped us while the event was being copied
+        sint32 nLatest = AtomicLoadAcquire( &pThread->nWrite );
+        if( nLatest - nRead > (sint32)gs_nProfileEventsPerThread )
+        {
+            ++g_nDroppedEvents;
+            continue;
+        }
+        // Nothing from before the capture
+        if( event.nStart < g_nCaptureStart )
+            continue;
+
+        WriteEventStart();
+        fputs( "{\"name\":", g_pTraceFile );
+        WriteString( event.szName );
+        fprintf( g_pTraceFile, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+                 TicksToMicroseconds( event.nStart ),
+                 (double)( event.nEnd - event.nStart ) * g_fMicrosecondsPerTick,
+                 pThread->nThreadId );
+    }
+    pTraceThread->nRead = nWrite;
+}
+
+//-----------------------------------------------------------------------------
+//  OpenCapture/CloseCapture
+//-----------------------------------------------------------------------------
+static void OpenCapture( void )
+{
+#if defined( _MSC_VER )
+    if( fopen_s( &g_pTraceFile, g_szTraceFilename, "w" ) != 0 )
+    {
+        g_pTraceFile = NULL;
+    }
+#else
+    g_pTraceFile = fopen( g_szTraceFilename, "w" );
+#endif // #if defined( _MSC_VER )
+    if( g_pTraceFile == NULL )
+    {
+        printf( "Trace capture: couldn't open %s\n", g_szTraceFilename );
+        return;
+    }
+
+    g_nCaptureStart = GetCPUTicks();
+    g_fMicrosecondsPerTick = 1000000.0 / GetCPUTicksPerSecond();
+    g_bFirstEvent = true;
+    g_nDroppedEvents = 0;
+    fputs( "{\"traceEvents\":[", g_pTraceFile );
+
+    // Only read what's written from here on
+    g_nNumTraceThreads = 0;
+    for( ProfileThread* pThread = ProfilerGetFirstThread(); pThread; pThread = pThread->pNext )
+    {
+        TraceThread* pTraceThread = FindTraceThread( pThread );
+        if( pTraceThread )
+        {
+            pTraceThread->nRead = AtomicLoadAcquire( &pThread->nWrite );
+        }
+    }
+}
+
+static void CloseCapture( void )
+{
+    if( g_pTraceFile == NULL )
+        return;
+
+    fputs( "\n],\"displayTimeUnit\":\"ms\"}\n", g_pTraceFile );
+    fclose( g_pTraceFile );
+    g_pTraceFile = NULL;
+
+    if( g_nDroppedEvents )
+    {
+        printf( "Trace capture: %llu events were overwritten before they were written out\n",
+                (unsigned long long)g_nDroppedEvents );
+    }
+    printf( "Trace capture: wrote %s\n", g_szTraceFilename );
+}
+
+static void SetFilename( const char* szFilename )
+{
+#if defined( _MSC_VER )
+    strncpy_s( g_szTraceFilename, gs_nMaxTraceFilename, szFilename, _TRUNCATE );
+#else
+    strncpy( g_szTraceFilename, szFilename, gs_nMaxTraceFilename - 1 );
+    g_szTraceFilename[gs_nMaxTraceFilename - 1] = '\0';
+#endif // #if defined( _MSC_VER )
+}
+
+//-----------------------------------------------------------------------------
+//  TraceStartCapture/TraceStopCapture
+//-----------------------------------------------------------------------------
+void TraceStartCapture( const char* szFilename )
+{
+    if( g_pTraceFile )
+        return;
+    SetFilename( szFilename );
+    g_bStartPending = true;
+    g_bStopPending = false;
+}
+
+void TraceStopCapture( void )
+{
+    g_bStartPending = false;
+    g_nStartFrame = gs_nNoFrame;
+    if( g_bInFrame )
+    {
+        g_bStopPending = true;
+    }
+    else
+    {
+        CloseCapture();
+    }
+}
+
+bool TraceIsCapturing( void )
+{
+    return g_pTraceFile != NULL;
+}
+
+void TraceCaptureFrames( const char* szFilename, uint nFirstFrame, uint nLastFrame )
+{
+    SetFilename( szFilename );
+    g_nStartFrame = nFirstFrame;
+    g_nStopFrame = nLastFrame;
+}
+
+//-----------------------------------------------------------------------------
+//  TraceBeginFrame/TraceEndFrame
+//-----------------------------------------------------------------------------
+void TraceBeginFrame( uint nFrame )
+{
+    if( g_nStartFrame == nFrame )
+    {
+        g_nStartFrame = gs_nNoFrame;
+        g_bStartPending = true;
+    }
+    if( g_bStartPending && g_pTraceFile == NULL )
+    {
+        g_bStartPending = false;
+        OpenCapture();
+    }
+
+    g_bInFrame = true;
+    g_nFrame = nFrame;
+    g_nFrameStart = GetCPUTicks();
+}
+
+void TraceEndFrame( void )
+{
+    g_bInFrame = false;
+    if( g_pTraceFile == NULL )
+        return;
+
+    uint64 nFrameEnd = GetCPUTicks();
+    ProfileThread* pMainThread = ProfilerGetThread();
+
+    WriteEventStart();
+    fprintf( g_pTraceFile, "{\"name\":\"Frame %u\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+             g_nFrame,
+             TicksToMicroseconds( g_nFrameStart ),
+             (double)( nFrameEnd - g_nFrameStart ) * g_fMicrosecondsPerTick,
+             pMainThread->nThreadId );
+
+    for( ProfileThread* pThread = ProfilerGetFirstThread(); pThread; pThread = pThread->pNext )
+    {
+        TraceThread* pTraceThread = FindTraceThread( pThread );
+        if( pTraceThread )
+        {
+            WriteThreadEvents( pTraceThread );
+        }
+    }
+
+    if( g_bStopPending || g_nFrame == g_nStopFrame )
+    {
+        g_bStopPending = false;
+        g_nStopFrame = gs_nNoFrame;
+        CloseCapture();
+    }
+}
+
+//-----------------------------------------------------------------------------
+//  TraceCounter
+//-----------------------------------------------------------------------------
+void TraceCounter( const char* szName, double fValue )
+{
+    if( g_pTraceFile == NULL )
+        return;
+
+    WriteEventStart();
+    fprintf( g_pTraceFile, "{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"args\":{\"value\":%.3f}}",
+             szName, TicksToMicroseconds( GetCPUTicks() ), fValue );
+}
@@ -0,0 +1,50 @@
+/*********************************************************\
+File:       TraceCapture.h
+Purpose:    Streams profiler scopes, counters and frames
+            to a Chrome trace-event file
+\*********************************************************/
+#ifndef _TRACECAPTURE_H_
+#define _TRACECAPTURE_H_
+#include "Types.h"
+
+//-----------------------------------------------------------------------------
+//  While a capture is running, every PROFILE_SCOPE on every thread, every
+//  frame and every TraceCounter is written out as JSON in the Chrome
+//  trace-event format, which chrome://tracing and ui.perfetto.dev both
+//  open. Events are written as they come in, at the end of each frame, so
+//  captures can be as long as the disk allows.
+//  Captures always start and stop on frame boundaries. Everything here is
+//  main thread only, except the scopes themselves
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+//  TraceStartCapture/TraceStopCapture
+//  Starts capturing to szFilename at the start of the next frame, and stops
+//  at the end of the current one (or right away, outside of a frame)
+//-----------------------------------------------------------------------------
+void TraceStartCapture( const char* szFilename );
+void TraceStopCapture( void );
+bool TraceIsCapturing( void );
+
+//-----------------------------------------------------------------------------
+//  TraceCaptureFrames
+//  Captures frames nFirstFrame through nLastFrame, inclusive
+//-----------------------------------------------------------------------------
+void TraceCaptureFrames( const char* szFilename, uint nFirstFrame, uint nLastFrame );
+
+//-----------------------------------------------------------------------------
+//  TraceBeginFrame/TraceEndFrame
+//  Bracket every frame. TraceEndFrame writes out everything the profiler
+//  recorded since the last one
+//-----------------------------------------------------------------------------
+void TraceBeginFrame( uint nFrame );
+void TraceEndFrame( void );
+
+//-----------------------------------------------------------------------------
+//  TraceCounter
+//  Records the value of a counter at this point in the frame. szName has to
+//  be a string literal, and shouldn't need escaping
+//-----------------------------------------------------------------------------
+void TraceCounter( const char* szName, double fValue );
+
+#endif // #ifndef _TRACECAPTURE_H_
@@ -88,6 +88,35 @@ typedef uint32 nativeuint;
 //-----------------------------------------------------------------------------
 
 
+//-----------------------------------------------------------------------------
+//  Compiler defines
+//-----------------------------------------------------------------------------
+#if !defined( _MSC_VER )
+#define __cdecl
+#define _inline         inline
+#define __forceinline   inline __attribute__((always_inline))
+#endif // #if !defined( _MSC_VER )
+
+#if defined( _MSC_VER )
+#define THREAD_LOCAL    __declspec( thread )
+#else
+#define THREAD_LOCAL    __thread
+#endif // #if defined( _MSC_VER )
+
+// Goes between class/struct and the name, or before a variable
+#if defined( _MSC_VER )
+#define ALIGN( n )      __declspec( align( n ) )
+#else
+#define ALIGN( n )      __attribute__( ( aligned( n ) ) )
+#endif // #if defined( _MSC_VER )
+
+// The bounded sprintf has the same arguments as C99's snprintf
+#if !defined( _MSC_VER )
+#define sprintf_s       snprintf
+#endif // #if !defined( _MSC_VER )
+//-----------------------------------------------------------------------------
+
+
 //-----------------------------------------------------------------------------
 //  Platform defines
 //-----------------------------------------------------------------------------
@@ -148,7 +177,7 @@ typedef uint32 nativeuint;
 
 //-----------------------------------------------------------------------------
 // Linux
-#if defined( __LINUX__ )
+#if defined( __LINUX__ ) || defined( __linux__ )
 
 // TODO: Support Android
 #define OS_LINUX
@@ -159,7 +188,7 @@ typedef uint32 nativeuint;
 #define _32BIT
 #endif // #ifdef __LP64__
 
-#endif // #if defined( __LINUX__ )
+#endif // #if defined( __LINUX__ ) || defined( __linux__ )
 //-----------------------------------------------------------------------------
 
 #endif // #ifndef _TYPES_H_
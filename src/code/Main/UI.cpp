@@ -2,13 +2,18 @@
 File:       UI.cpp
 Purpose:    User interface...renders to a separate target
 \*********************************************************/
+#include "Types.h"
+#if defined( OS_WINDOWS )
 #include <D3D11.h>
 #include <D3DX11.h>
 #include <D3Dcompiler.h>
 #include <xnamath.h>
+#endif // #if defined( OS_WINDOWS )
 #include "UI.h"
 #include "Riot.h"
-#include "Gfx\D3DGraphics.h"
+
+#if defined( OS_WINDOWS )
+#include "Gfx/D3DGraphics.h"
 
 //////////////////////////////////////////
 // UI vertex definition
@@ -28,6 +33,7 @@ D3D11_INPUT_ELEMENT_DESC pVertexLayout[] =
     { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,       0, 32, D3D11_INPUT_PER_VERTEX_DATA, 0 },
 };
 UINT nNumVertexLayoutElements = ARRAYSIZE( pVertexLayout );
+#endif // #if defined( OS_WINDOWS )
 
 //////////////////////////////////////////
 // static members
@@ -46,16 +52,17 @@ ID3D11Buffer*              UI::m_pVertexBuffer = NULL;
 wchar_t*                   UI::m_szShaderFile  = L"Assets/Shaders/UI.hlsl";
 static const uint          gs_nMaxNumChars     = 255 * 6;
 
-static const uint          gs_nMaxNumStrings   = 100;
-UIString*                  UI::m_pUIStrings    = new UIString[ gs_nMaxNumStrings ];
-uint                       UI::m_nNumStrings   = 0;
+UIString*                  UI::m_pUIStrings    = NULL;
+UIString*                  UI::m_pLastUIString = NULL;
 
+#if defined( OS_WINDOWS )
 //-----------------------------------------------------------------------------
 //  Initialize
 //  Define shaders, input layout, and font texture
 //-----------------------------------------------------------------------------
 void UI::Initialize( void )
 {
+    MEMORY_CATEGORY( eMemoryCategoryUI );
     HRESULT hr = S_OK;
 
     // TODO: needs to be generic
@@ -254,6 +261,19 @@ void UI::Destroy( void )
     SAFE_RELEASE( m_pFontSRV );
     SAFE_RELEASE( m_pVertexBuffer );
 }
+#else
+//-----------------------------------------------------------------------------
+//  Initialize/Destroy
+//  The UI is drawn with D3D, so there's nothing to create elsewhere
+//-----------------------------------------------------------------------------
+void UI::Initialize( void )
+{
+}
+
+void UI::Destroy( void )
+{
+}
+#endif // #if defined( OS_WINDOWS )
 
 //-----------------------------------------------------------------------------
 //  AddText
@@ -261,10 +281,21 @@ void UI::Destroy( void )
 //-----------------------------------------------------------------------------
 void UI::AddString( uint nLeft, uint nTop, const char* szText )
 {
-    m_pUIStrings[ m_nNumStrings ].nLeft = nLeft;
-    m_pUIStrings[ m_nNumStrings ].nTop = nTop;
-    strcpy_s( m_pUIStrings[ m_nNumStrings ].szText, 255, szText );
-    m_nNumStrings++;
+    UIString* pString = FRAME_NEW_ARRAY( UIString, 1 );
+    pString->nLeft = nLeft;
+    pString->nTop = nTop;
+    pString->szText = FrameStrDup( szText );
+    pString->pNext = NULL;
+
+    if( m_pLastUIString )
+    {
+        m_pLastUIString->pNext = pString;
+    }
+    else
+    {
+        m_pUIStrings = pString;
+    }
+    m_pLastUIString = pString;
 }
 
 //-----------------------------------------------------------------------------
@@ -273,18 +304,21 @@ void UI::AddString( uint nLeft, uint nTop, const char* szText )
 //-----------------------------------------------------------------------------
 void UI::Draw( void )
 {
-    // draw all strings
-    for( uint i = 0; i < m_nNumStrings; ++i )
+    // draw all strings. Without Initialize, eg: on the null graphics
+    // backend, they're only thrown away
+    if( m_pContext != NULL )
     {
-        uint nLeft = m_pUIStrings[ i ].nLeft;
-        uint nTop = m_pUIStrings[ i ].nTop;
-        const char* szText = m_pUIStrings[ i ].szText;
-        DrawString( nLeft, nTop, szText );
+        for( UIString* pString = m_pUIStrings; pString != NULL; pString = pString->pNext )
+        {
+            DrawString( pString->nLeft, pString->nTop, pString->szText );
+        }
     }
 
-    m_nNumStrings = 0;
+    m_pUIStrings = NULL;
+    m_pLastUIString = NULL;
 }
 
+#if defined( OS_WINDOWS )
 //-----------------------------------------------------------------------------
 //  DrawString
 //  Draw szText at (nLeft, nTop)
@@ -302,64 +336,6 @@ void UI::DrawString( uint nLeft, uint nTop, const char* szText )
     m_fScreenX = 2.0f * ( nLeft / 1024.0f ) - 1.0f;  // [-1, 1]
     m_fScreenY = -2.0f * ( nTop / 768.0f ) + 1.0f - fFontHeight; // [1-font_height, -1-font_height]
 
-    // Vertices info
-    uint nNumVertices = nNumChars * 6;
-    UIVertex* pVertices = new UIVertex[ nNumVertices ];
-    uint j = 0;
-    
-    // Create quads for the string
-    for( uint i = 0; i < nNumChars; ++i )
-    {
-        float fCurrentScreenX = m_fScreenX + ( i * fFontWidth );
-        float fLeftX = fCurrentScreenX;
-        float fRightX = fCurrentScreenX + (fCharWidth * fScaleFactor);
-        float fTopY = m_fScreenY + fFontHeight;
-        float fBottomY = m_fScreenY;
-
-        char cCurrentChar = szText[i];
-        uint nAsciiPos = cCurrentChar - 32;
-        float fTexcoord_x0 = nAsciiPos * fCharWidth;      // left
-        float fTexcoord_x1 = fTexcoord_x0 + fCharWidth;   // right
-        float fTexcoord_y0 = 0.0f;                        // top
-        float fTexcoord_y1 = 1.0f;                        // bottom
-
-        j = i * 6;
-
-        // Triangle 1
-        // left bottom
-        pVertices[ j + 0 ].vPos      = XMVectorSet( fLeftX,  fBottomY, 0.0f, 1.0f );
-        pVertices[ j + 0 ].vColor    = XMVectorSet( 1.0f, 1.0f, 0.0f, 1.0f );
-        pVertices[ j + 0 ].vTexcoord = XMVectorSet( fTexcoord_x0, fTexcoord_y1, 0.0f, 0.0f );
-        // left top
-        pVertices[ j + 1 ].vPos      = XMVectorSet( fLeftX,  fTopY, 0.0f, 1.0f );
-        pVertices[ j + 1 ].vColor    = XMVectorSet( 1.0f, 1.0f, 0.0f, 1.0f );
-        pVertices[ j + 1 ].vTexcoord = XMVectorSet( fTexcoord_x0, fTexcoord_y0, 0.0f, 0.0f );
-        // right top
-        pVertices[ j + 2 ].vPos      = XMVectorSet( fRightX, fTopY, 0.0f, 1.0f );
-        pVertices[ j + 2 ].vColor    = XMVectorSet( 1.0f, 1.0f, 0.0f, 1.0f );
-        pVertices[ j + 2 ].vTexcoord = XMVectorSet( fTexcoord_x1, fTexcoord_y0, 0.0f, 0.0f );
-        // Triangle 2
-        // left bottom
-        pVertices[ j + 3 ].vPos      = XMVectorSet( fLeftX,  fBottomY, 0.0f, 1.0f );
-        pVertices[ j + 3 ].vColor    = XMVectorSet( 1.0f, 1.0f, 0.0f, 1.0f );
-        pVertices[ j + 3 ].vTexcoord = XMVectorSet( fTexcoord_x0, fTexcoord_y1, 0.0f, 0.0f );
-        // right top
-        pVertices[ j + 4 ].vPos      = XMVectorSet( fRightX, fTopY, 0.0f, 1.0f );
-        pVertices[ j + 4 ].vColor    = XMVectorSet( 1.0f, 1.0f, 0.0f, 1.0f );
-        pVertices[ j + 4 ].vTexcoord = XMVectorSet( fTexcoord_x1, fTexcoord_y0, 0.0f, 0.0f );
-        // right bottom
-        pVertices[ j + 5 ].vPos      = XMVectorSet( fRightX, fBottomY, 0.0f, 1.0f );
-        pVertices[ j + 5 ].vColor    = XMVectorSet( 1.0f, 1.0f, 0.0f, 1.0f );
-        pVertices[ j + 5 ].vTexcoord = XMVectorSet( fTexcoord_x1, fTexcoord_y1, 0.0f, 0.0f );
-    }
-
-    // Update the vertex buffer
-    D3D11_MAPPED_SUBRESOURCE pMappedVB;
-    m_pContext->Map( m_pVertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &pMappedVB );
-    UIVertex* pMappedVertices = ( UIVertex* )pMappedVB.pData;
-    memcpy_s( pMappedVertices, gs_nMaxNumChars * sizeof( UIVertex ), pVertices, nNumChars * 6 * sizeof( UIVertex ) );
-    m_pContext->Unmap( m_pVertexBuffer, 0 );
-
     // Set the shaders
     m_pContext->VSSetShader( m_pVertexShader, NULL, 0 );
     m_pContext->PSSetShader( m_pPixelShader, NULL, 0 );
@@ -369,13 +345,91 @@ void UI::DrawString( uint nLeft, uint nTop, const char* szText )
     m_pContext->PSSetShaderResources( 0, 1, &m_pFontSRV );
     m_pContext->OMSetBlendState( m_pFontBlend, 0, 0xFFFFFFFF );
 
-    // Draw text
     unsigned int nStrides[] = { sizeof( UIVertex ) };
     unsigned int nOffsets[] = { 0 };
     m_pContext->IASetInputLayout( m_pInputLayout );
     m_pContext->IASetVertexBuffers( 0, 1, &m_pVertexBuffer, nStrides, nOffsets );
     m_pContext->IASetPrimitiveTopology( D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST );
-    m_pContext->Draw( nNumVertices, 0 );
 
-    SAFE_DELETE_ARRAY( pVertices );
+    // The vertex buffer only holds so many characters,
+    // so longer strings are drawn in batches
+    static const uint nMaxCharsPerDraw = gs_nMaxNumChars / 6;
+    for( uint nFirstChar = 0; nFirstChar < nNumChars; nFirstChar += nMaxCharsPerDraw )
+    {
+        uint nBatchChars = nNumChars - nFirstChar;
+        if( nBatchChars > nMaxCharsPerDraw )
+        {
+            nBatchChars = nMaxCharsPerDraw;
+        }
+
+        // Vertices info
+        uint nNumVertices = nBatchChars * 6;
+        UIVertex* pVertices = FRAME_NEW_ARRAY( UIVertex, nNumVertices );
+        uint j = 0;
+
+        // Create quads for the string
+        for( uint i = 0; i < nBatchChars; ++i )
+        {
+            float fCurrentScreenX = m_fScreenX + ( ( nFirstChar + i ) * fFontWidth );
+            float fLeftX = fCurrentScreenX;
+            float fRightX = fCurrentScreenX + (fCharWidth * fScaleFactor);
+            float fTopY = m_fScreenY + fFontHeight;
+            float fBottomY = m_fScreenY;
+
+            char cCurrentChar = szText[ nFirstChar + i ];
+            uint nAsciiPos = cCurrentChar - 32;
+            float fTexcoord_x0 = nAsciiPos * fCharWidth;      // left
+            float fTexcoord_x1 = fTexcoord_x0 + fCharWidth;   // right
+            float fTexcoord_y0 = 0.0f;                        // top
+            float fTexcoord_y1 = 1.0f;                        // bottom
+
+            j = i * 6;
+
+            // Triangle 1
+            // left bottom
+            pVertices[ j + 0 ].vPos      = XMVectorSet( fLeftX,  fBottomY, 0.0f, 1.0f );
+            pVertices[ j + 0 ].vColor    = XMVectorSet( 1.0f, 1.0f, 0.0f, 1.0f );
+            pVertices[ j + 0 ].vTexcoord = XMVectorSet( fTexcoord_x0, fTexcoord_y1, 0.0f, 0.0f );
+            // left top
+            pVertices[ j + 1 ].vPos      = XMVectorSet( fLeftX,  fTopY, 0.0f, 1.0f );
+            pVertices[ j + 1 ].vColor    = XMVectorSet( 1.0f, 1.0f, 0.0f, 1.0f );
+            pVertices[ j + 1 ].vTexcoord = XMVectorSet( fTexcoord_x0, fTexcoord_y0, 0.0f, 0.0f );
+            // right top
+            pVertices[ j + 2 ].vPos      = XMVectorSet( fRightX, fTopY, 0.0f, 1.0f );
+            pVertices[ j + 2 ].vColor    = XMVectorSet( 1.0f, 1.0f, 0.0f, 1.0f );
+            pVertices[ j + 2 ].vTexcoord = XMVectorSet( fTexcoord_x1, fTexcoord_y0, 0.0f, 0.0f );
+            // Triangle 2
+            // left bottom
+            pVertices[ j + 3 ].vPos      = XMVectorSet( fLeftX,  fBottomY, 0.0f, 1.0f );
+            pVertices[ j + 3 ].vColor    = XMVectorSet( 1.0f, 1.0f, 0.0f, 1.0f );
+            pVertices[ j + 3 ].vTexcoord = XMVectorSet( fTexcoord_x0, fTexcoord_y1, 0.0f, 0.0f );
+            // right top
+            pVertices[ j + 4 ].vPos      = XMVectorSet( fRightX, fTopY, 0.0f, 1.0f );
+            pVertices[ j + 4 ].vColor    = XMVectorSet( 1.0f, 1.0f, 0.0f, 1.0f );
+            pVertices[ j + 4 ].vTexcoord = XMVectorSet( fTexcoord_x1, fTexcoord_y0, 0.0f, 0.0f );
+            // right bottom
+            pVertices[ j + 5 ].vPos      = XMVectorSet( fRightX, fBottomY, 0.0f, 1.0f );
+            pVertices[ j + 5 ].vColor    = XMVectorSet( 1.0f, 1.0f, 0.0f, 1.0f );
+            pVertices[ j + 5 ].vTexcoord = XMVectorSet( fTexcoord_x1, fTexcoord_y1, 0.0f, 0.0f );
+        }
+
+        // Update the vertex buffer
+        D3D11_MAPPED_SUBRESOURCE pMappedVB;
+        m_pContext->Map( m_pVertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &pMappedVB );
+        UIVertex* pMappedVertices = ( UIVertex* )pMappedVB.pData;
+        memcpy_s( pMappedVertices, gs_nMaxNumChars * sizeof( UIVertex ), pVertices, nNumVertices * sizeof( UIVertex ) );
+        m_pContext->Unmap( m_pVertexBuffer, 0 );
+
+        // Draw text
+        m_pContext->Draw( nNumVertices, 0 );
+    }
+}
+#else
+//-----------------------------------------------------------------------------
+//  DrawString
+//  Never called without a device context
+//-----------------------------------------------------------------------------
+void UI::DrawString( uint nLeft, uint nTop, const char* szText )
+{
 }
+#endif // #if defined( OS_WINDOWS )
@@ -23,11 +23,15 @@ struct ID3D11Buffer;
 
 //////////////////////////////////////////
 // UI item definition
+// Strings and the list itself live in frame
+// memory, so they're only valid until the
+// end of the next frame
 typedef struct _UIString
 {
     uint nLeft;
     uint nTop;
-    char szText[255];
+    const char* szText;
+    struct _UIString* pNext;
 } UIString;
 
 class UI
@@ -80,7 +84,7 @@ private:
     static wchar_t* m_szShaderFile;
 
     static UIString* m_pUIStrings;
-    static uint m_nNumStrings;
+    static UIString* m_pLastUIString;
 };
 
 #endif // _UI_H_
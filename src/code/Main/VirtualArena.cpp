@@ -0,0 +1,156 @@
+/*********************************************************\
+File:       VirtualArena.cpp
+Purpose:    Reserves a big range of address space up front
+            and commits it as it's used
+\*********************************************************/
+#include "VirtualArena.h"
+#include "Atomic.h"
+#include <stdio.h>
+
+#if defined( OS_WINDOWS )
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#endif // #if defined( OS_WINDOWS )
+
+static const size_t gs_nCommitGranularity   = 64 * 1024;
+static const size_t gs_nHugePageSize        = 2 * 1024 * 1024;
+
+static volatile sint64 g_nTotalCommitted = 0;
+
+// CVirtualArena constructor
+CVirtualArena::CVirtualArena()
+    : m_pBase( NULL )
+    , m_pMapped( NULL )
+    , m_nMappedSize( 0 )
+    , m_nReservedSize( 0 )
+    , m_nCommittedSize( 0 )
+    , m_nGranularity( gs_nCommitGranularity )
+{
+}
+
+// CVirtualArena destructor
+CVirtualArena::~CVirtualArena()
+{
+    Release();
+}
+
+//-----------------------------------------------------------------------------
+//  Reserve
+//  Reserves nMaxSize bytes of address space, without committing any of
+//  it. Returns the base address, or NULL if there wasn't enough address
+//  space left
+//-----------------------------------------------------------------------------
+void* CVirtualArena::Reserve( size_t nMaxSize, bool bHugePages )
+{
+    Release();
+
+#if defined( OS_WINDOWS )
+    bHugePages = false;
+#endif // #if defined( OS_WINDOWS )
+    m_nGranularity = bHugePages ? gs_nHugePageSize : gs_nCommitGranularity;
+    m_nReservedSize = ( nMaxSize + m_nGranularity - 1 ) & ~( m_nGranularity - 1 );
+
+#if defined( OS_WINDOWS )
+    // Reservations are always 64KB aligned
+    m_nMappedSize = m_nReservedSize;
+    m_pMapped = VirtualAlloc( NULL, m_nMappedSize, MEM_RESERVE, PAGE_NOACCESS );
+    m_pBase = (byte*)m_pMapped;
+#else
+    // Huge pages only back 2MB aligned ranges, so map a bit extra to align to
+    m_nMappedSize = m_nReservedSize + ( bHugePages ? gs_nHugePageSize : 0 );
+    m_pMapped = mmap( NULL, m_nMappedSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0 );
+    if( m_pMapped == MAP_FAILED )
+    {
+        m_pMapped = NULL;
+    }
+    m_pBase = (byte*)( ( (nativeuint)m_pMapped + m_nGranularity - 1 ) & ~( (nativeuint)m_nGranularity - 1 ) );
+
+#if defined( MADV_HUGEPAGE )
+    if( m_pMapped && bHugePages )
+    {
+        madvise( m_pBase, m_nReservedSize, MADV_HUGEPAGE );
+    }
+#endif // #if defined( MADV_HUGEPAGE )
+#endif // #if defined( OS_WINDOWS )
+
+    if( m_pMapped == NULL )
+    {   // Out of address space. Leave the arena empty, so every Commit fails
+        printf( "CVirtualArena: Couldn't reserve %llu bytes\n", (unsigned long long)m_nReservedSize );
+        m_pBase = NULL;
+        m_nMappedSize = 0;
+        m_nReservedSize = 0;
+    }
+    return m_pBase;
+}
+
+//-----------------------------------------------------------------------------
+//  Release
+//  Gives the whole range back to the OS
+//-----------------------------------------------------------------------------
+void CVirtualArena::Release( void )
+{
+    if( m_pMapped == NULL )
+        return;
+
+#if defined( OS_WINDOWS )
+    VirtualFree( m_pMapped, 0, MEM_RELEASE );
+#else
+    munmap( m_pMapped, m_nMappedSize );
+#endif // #if defined( OS_WINDOWS )
+    AtomicAdd64( &g_nTotalCommitted, -(sint64)m_nCommittedSize );
+
+    m_pBase = NULL;
+    m_pMapped = NULL;
+    m_nMappedSize = 0;
+    m_nReservedSize = 0;
+    m_nCommittedSize = 0;
+}
+
+//-----------------------------------------------------------------------------
+//  Grow
+//  Commits enough pages to cover nSize bytes. Pages are committed in
+//  m_nGranularity steps so growing an array an element at a time doesn't
+//  call into the OS for every element. Returns false, committing nothing,
+//  if nSize is past the reservation or the OS won't commit the pages
+//-----------------------------------------------------------------------------
+bool CVirtualArena::Grow( size_t nSize )
+{
+    if( nSize > m_nReservedSize )
+    {
+        printf( "CVirtualArena: %llu bytes is past the %llu reserved\n",
+                (unsigned long long)nSize, (unsigned long long)m_nReservedSize );
+        return false;
+    }
+
+    // The reservation is a multiple of the granularity, so this stays inside it
+    size_t nNewSize = ( nSize + m_nGranularity - 1 ) & ~( m_nGranularity - 1 );
+    if( nNewSize <= m_nCommittedSize )
+        return true;
+
+    byte*  pStart = m_pBase + m_nCommittedSize;
+    size_t nGrowth = nNewSize - m_nCommittedSize;
+#if defined( OS_WINDOWS )
+    bool bCommitted = VirtualAlloc( pStart, nGrowth, MEM_COMMIT, PAGE_READWRITE ) != NULL;
+#else
+    bool bCommitted = mprotect( pStart, nGrowth, PROT_READ | PROT_WRITE ) == 0;
+#endif // #if defined( OS_WINDOWS )
+    if( !bCommitted )
+    {
+        printf( "CVirtualArena: Couldn't commit %llu bytes\n", (unsigned long long)nGrowth );
+        return false;
+    }
+
+    m_nCommittedSize = nNewSize;
+    AtomicAdd64( &g_nTotalCommitted, (sint64)nGrowth );
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//  GetTotalCommitted
+//  Bytes committed across every arena
+//-----------------------------------------------------------------------------
+uint64 CVirtualArena::GetTotalCommitted( void )
+{
+    return (uint64)AtomicAdd64( &g_nTotalCommitted, 0 );
+}
@@ -0,0 +1,97 @@
+/*********************************************************\
+File:       VirtualArena.h
+Purpose:    Reserves a big range of address space up front
+            and commits it as it's used
+\*********************************************************/
+#ifndef _VIRTUALARENA_H_
+#define _VIRTUALARENA_H_
+#include "Types.h"
+#include <stddef.h> // For size_t
+
+//-----------------------------------------------------------------------------
+//  CVirtualArena
+//  Reserving address space is free, only committed pages cost memory, so
+//  an array can be given room for its worst case without paying for it.
+//  The array never moves, so pointers into it stay valid as it grows.
+//  Newly committed memory is always zeroed by the OS.
+//  With bHugePages the arena commits 2MB at a time and asks the OS to back
+//  it with transparent huge pages, which cuts TLB misses on arrays that
+//  are walked every frame. It's only a hint, Windows ignores it since its
+//  large pages can't be committed a piece at a time
+//-----------------------------------------------------------------------------
+class CVirtualArena
+{
+public:
+    // CVirtualArena constructor
+    CVirtualArena();
+
+    // CVirtualArena destructor
+    ~CVirtualArena();
+    /***************************************\
+    | class methods                         |
+    \***************************************/
+
+    //-----------------------------------------------------------------------------
+    //  Reserve
+    //  Reserves nMaxSize bytes of address space, without committing any of
+    //  it. Returns the base address, or NULL if there wasn't enough address
+    //  space left
+    //-----------------------------------------------------------------------------
+    void* Reserve( size_t nMaxSize, bool bHugePages = false );
+
+    //-----------------------------------------------------------------------------
+    //  Release
+    //  Gives the whole range back to the OS
+    //-----------------------------------------------------------------------------
+    void Release( void );
+
+    //-----------------------------------------------------------------------------
+    //  Commit
+    //  Makes sure the first nSize bytes are usable. Cheap when they already are.
+    //  Returns false if they couldn't be committed, either because nSize is
+    //  past the reservation or the OS is out of memory
+    //-----------------------------------------------------------------------------
+    __forceinline bool Commit( size_t nSize )
+    {
+        if( nSize > m_nCommittedSize )
+        {
+            return Grow( nSize );
+        }
+        return true;
+    }
+
+    //-----------------------------------------------------------------------------
+    //  Accessors
+    //-----------------------------------------------------------------------------
+    void*   GetBase( void ) const { return m_pBase; }
+    size_t  GetCommittedSize( void ) const { return m_nCommittedSize; }
+    size_t  GetReservedSize( void ) const { return m_nReservedSize; }
+
+    //-----------------------------------------------------------------------------
+    //  GetTotalCommitted
+    //  Bytes committed across every arena
+    //-----------------------------------------------------------------------------
+    static uint64 GetTotalCommitted( void );
+
+private:
+    CVirtualArena( const CVirtualArena& );
+    CVirtualArena& operator=( const CVirtualArena& );
+
+    //-----------------------------------------------------------------------------
+    //  Grow
+    //  Commits enough pages to cover nSize bytes
+    //-----------------------------------------------------------------------------
+    bool Grow( size_t nSize );
+
+    /***************************************\
+    | class members                         |
+    \***************************************/
+    byte*   m_pBase;
+    void*   m_pMapped;          // What was actually mapped, before aligning m_pBase
+    size_t  m_nMappedSize;
+    size_t  m_nReservedSize;
+    size_t  m_nCommittedSize;
+    size_t  m_nGranularity;     // Commits are rounded up to this
+};
+
+#endif // #ifndef _VIRTUALARENA_H_
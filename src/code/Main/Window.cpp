@@ -5,7 +5,7 @@ Purpose:    Abstration for creating a platform-independent
 \*********************************************************/
 #include "Common.h"
 #include "Window.h"
-#include "memory.h"
+#include "Memory.h"
 
 CWindow::CWindow()
     : m_pSystemWindow( NULL )
@@ -2,13 +2,11 @@
 File:      main.cpp
 Purpose:   Main entry point for the program
 \*********************************************************/
+#include <stdlib.h>
 #include "Common.h"
 #include "Riot.h"
-#include <xnamath.h>
 
-XMVECTOR v;
-
-int main()
+int main( int argc, char* argv[] )
 {
     //////////////////////////////////////////
     // Make sure Shutdown is the last thing called
@@ -16,7 +14,7 @@ int main()
     
     //////////////////////////////////////////
     // Run the game
-    Riot::Run();
+    Riot::Run( argc, argv );
     
     return 0;
 }
@@ -6,7 +6,6 @@ Modified:       3/23/2011 11:15:22 PM
 Modified by:    Kyle Weicht
 \*********************************************************/
 #include "Component.h"
-#include <memory>
 
 // CComponent constructor
 CComponent::CComponent()
@@ -15,17 +14,18 @@ CComponent::CComponent()
     , m_ppObjects( NULL )
     , m_nNumComponents( 0 )
 {
-    m_pFreeSlots = new uint[MAX_OBJECTS];
-    memset( m_pFreeSlots, 0, sizeof(uint) * MAX_OBJECTS );
-    m_ppObjects = new CObject*[MAX_OBJECTS];
-    memset( m_ppObjects, 0, sizeof(CObject*) * MAX_OBJECTS );
+    // Nothing is committed until it's used, committed memory starts out zeroed
+    m_pFreeSlots = (uint*)m_FreeSlotArena.Reserve( sizeof(uint) * MAX_OBJECTS );
+    m_ppObjects = (CObject**)m_ObjectArena.Reserve( sizeof(CObject*) * MAX_OBJECTS );
 }
 
 // CComponent destructor
 CComponent::~CComponent()
 {
-    SAFE_DELETE_ARRAY( m_pFreeSlots );
-    SAFE_DELETE_ARRAY( m_ppObjects );
+    m_FreeSlotArena.Release();
+    m_ObjectArena.Release();
+    m_pFreeSlots = NULL;
+    m_ppObjects = NULL;
 }
 
 //-----------------------------------------------------------------------------
@@ -38,7 +38,7 @@ void CComponent::ProcessComponent( void )
 
 //-----------------------------------------------------------------------------
 //  AddComponent
-//  "Adds" a component to an object
+//  "Adds" a component to an object. Returns -1 if there's no room left
 //-----------------------------------------------------------------------------
 uint CComponent::AddComponent( CObject* pObject )
 {    
@@ -50,6 +50,11 @@ uint CComponent::AddComponent( CObject* pObject )
     }
     else
     {
+        if( m_nNumComponents >= MAX_OBJECTS
+            || !m_ObjectArena.Commit( sizeof(CObject*) * ( m_nNumComponents + 1 ) ) )
+        {
+            return (uint)-1;
+        }
         nIndex = m_nNumComponents++;
     }
 
@@ -63,27 +68,39 @@ uint CComponent::AddComponent( CObject* pObject )
 CPositionComponent::CPositionComponent()
     : m_vPosition( NULL )
 {    
-    m_vPosition = new XMVECTOR[MAX_OBJECTS];
+    // Processed in bulk, so back it with huge pages. The arena is page
+    // aligned, so it starts on a cache line
+    m_vPosition = (RVector4*)m_PositionArena.Reserve( sizeof(RVector4) * MAX_OBJECTS, true );
 }
 
 // CPositionComponent destructor
 CPositionComponent::~CPositionComponent()
 {
-    SAFE_DELETE_ARRAY( m_vPosition );
+    m_PositionArena.Release();
+    m_vPosition = NULL;
 }
 
 
 //-----------------------------------------------------------------------------
 //  AddComponent
-//  "Adds" a component to an object
+//  "Adds" a component to an object. Returns -1 if there's no room left
 //-----------------------------------------------------------------------------
 uint CPositionComponent::AddComponent( CObject* pObject )
 {
     // Get the index of the new component
     uint nIndex = CComponent::AddComponent( pObject );
+    if( nIndex == (uint)-1 )
+        return nIndex;
+
+    if( !m_PositionArena.Commit( sizeof(RVector4) * m_nNumComponents ) )
+    {   // Reused slots are already committed, so this was a new one on the end.
+        // Give it back
+        m_ppObjects[ --m_nNumComponents ] = NULL;
+        return (uint)-1;
+    }
 
     // Now initialize this component
-    m_vPosition[nIndex] = XMVectorSet( 0.0f, 0.0f, 0.0f, 0.0f );
+    m_vPosition[nIndex].Zero();
 
     return nIndex;
 }
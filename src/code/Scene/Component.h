@@ -8,13 +8,14 @@ Modified by:    Kyle Weicht
 \*********************************************************/
 #ifndef _COMPONENT_H_
 #define _COMPONENT_H_
-#include "common.h"
+#include "Common.h"
 #include "IRefCounted.h"
+#include "VirtualArena.h"
+#include "RiotMath.h"
 
-#include <Windows.h>
-#include <xnamath.h>
-
-#define MAX_OBJECTS (16*1024)
+// Only address space is reserved for this many, memory is committed as
+// objects are added
+#define MAX_OBJECTS (1024*1024)
 
 enum eComponentMessageType
 {
@@ -57,7 +58,7 @@ public:
 
     //-----------------------------------------------------------------------------
     //  AddComponent
-    //  "Adds" a component to an object
+    //  "Adds" a component to an object. Returns -1 if there's no room left
     //-----------------------------------------------------------------------------
     virtual uint AddComponent( CObject* pObject );
 
@@ -70,6 +71,8 @@ protected:
     /***************************************\
     | class members                         |
     \***************************************/
+    CVirtualArena   m_ObjectArena;
+    CVirtualArena   m_FreeSlotArena;
     CObject**   m_ppObjects;
     uint*       m_pFreeSlots;
     uint        m_nNumFreeSlots;
@@ -90,7 +93,7 @@ public:
     
     //-----------------------------------------------------------------------------
     //  AddComponent
-    //  "Adds" a component to an object
+    //  "Adds" a component to an object. Returns -1 if there's no room left
     //-----------------------------------------------------------------------------
     uint AddComponent( CObject* pObject );
 
@@ -98,7 +101,8 @@ private:
     /***************************************\
     | class members                         |
     \***************************************/
-    XMVECTOR*   m_vPosition;
+    CVirtualArena   m_PositionArena;
+    RVector4*   m_vPosition;
 };
 
 
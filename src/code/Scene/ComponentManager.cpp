@@ -6,11 +6,13 @@ Modified:       3/23/2011 11:42:13 PM
 Modified by:    Kyle Weicht
 \*********************************************************/
 #include "ComponentManager.h"
+#include "Profiler.h"
 
 // CComponentManager constructor
 CComponentManager::CComponentManager()
     : m_nNumMessages( 0 )
 {
+    MEMORY_CATEGORY( eMemoryCategoryComponents );
     memset( m_ppComponents, 0, sizeof( CComponent* ) * eNUMCOMPONENTS );
 
     m_ppComponents[ eComponentPosition ] = new CPositionComponent;
@@ -51,6 +53,7 @@ uint CComponentManager::AddComponent( eComponentType nType, CObject* pObject )
 //-----------------------------------------------------------------------------
 void CComponentManager::ProcessComponents( void )
 {
+    PROFILE_SCOPE( "ProcessComponents" );
     // First update the components...
     for( uint i = 0; i < eNUMCOMPONENTS; ++i )
     {
@@ -8,8 +8,8 @@ Modified by:    Kyle Weicht
 \*********************************************************/
 #ifndef _COMPONENTMANAGER_H_
 #define _COMPONENTMANAGER_H_
-#include "common.h"
-#include "irefcounted.h"
+#include "Common.h"
+#include "IRefCounted.h"
 #include "Component.h"
 
 #define MAX_COMPONENT_MESSAGES (1024)
@@ -6,19 +6,24 @@ Modified:       3/23/2011 10:40:45 PM
 Modified by:    Kyle Weicht
 \*********************************************************/
 #include "Object.h"
-#include "memory.h"
-#include "Gfx\Mesh.h"
-#include "Gfx\Material.h"
+#include "Memory.h"
+#include "Gfx/Mesh.h"
+#include "Gfx/Material.h"
 #include "ComponentManager.h"
 #define new DEBUG_NEW
 
+#pragma push_macro( "new" )
+#undef new
+DEFINE_POOL_ALLOCATED( CObject, 1024, eMemoryCategoryScene )
+#pragma pop_macro( "new" )
+
 // CObject constructor
 CObject::CObject()
-    : m_pMesh( NULL )
-    , m_pMaterial( NULL )
 {
-    m_vPosition = XMVectorSet( 0.0f, 0.0f, 0.0f, 0.0f );
-    m_vOrientation = XMVectorSet( 0.0f, 0.0f, 0.0f, 1.0f );
+    m_vPosition = RVector4Zero();
+    m_vOrientation = RQuaternionIdentity();
+    m_vPrevPosition = m_vPosition;
+    m_vPrevOrientation = m_vOrientation;
 
     for( uint i = 0; i < eNUMCOMPONENTS; ++i )
     {
@@ -29,8 +34,6 @@ CObject::CObject()
 // CObject destructor
 CObject::~CObject()
 {
-    SAFE_RELEASE( m_pMesh );
-    SAFE_RELEASE( m_pMaterial );
 }
 
 
@@ -53,14 +56,33 @@ void CObject::AddComponent( eComponentType nType )
 void CObject::Update( float fDeltaTime )
 {
     // TODO: temporarily get rid of rotating objects behavior
-    //m_vPosition = m_vPosition + XMVectorSet( fDeltaTime * 0.1f, fDeltaTime * 0.1f, 0.0f, 0.0f );
+    //m_vPosition = m_vPosition + RVector4( fDeltaTime * 0.1f, fDeltaTime * 0.1f, 0.0f, 0.0f );
+
+    //m_vOrientation = m_vOrientation * RQuaternionRotationAxis( RVector4( 0.0f, 1.0f, 0.0f, 0.0f ), 0.1f * fDeltaTime );
+}
 
-    //m_vOrientation = XMQuaternionMultiply( m_vOrientation, XMQuaternionRotationAxis( XMVectorSet( 0.0f, 1.0f, 0.0f, 0.0f ), 0.1f * fDeltaTime ) );
+//-----------------------------------------------------------------------------
+//  SaveState
+//  Remembers the current transform as the previous simulation state.
+//  Called before every simulation tick
+//-----------------------------------------------------------------------------
+void CObject::SaveState( void )
+{
+    m_vPrevPosition = m_vPosition;
+    m_vPrevOrientation = m_vOrientation;
+}
 
+//-----------------------------------------------------------------------------
+//  Interpolate
+//  Places the mesh fAlpha (0-1) of the way from the previous simulation
+//  state to the current one. Called once per rendered frame
+//-----------------------------------------------------------------------------
+void CObject::Interpolate( float fAlpha )
+{
     if( m_pMesh )
     {
-        m_pMesh->m_vPosition = m_vPosition;
-        m_pMesh->m_vOrientation = m_vOrientation;
+        m_pMesh->m_vPosition = Lerp( m_vPrevPosition, m_vPosition, fAlpha );
+        m_pMesh->m_vOrientation = Slerp( m_vPrevOrientation, m_vOrientation, fAlpha );
     }
 }
 
@@ -88,22 +110,22 @@ void CObject::SetMaterial( CMaterial* pMaterial )
 }
 
 
-const XMVECTOR& CObject::GetPosition( void )
+const RVector4& CObject::GetPosition( void )
 {
     return m_vPosition;
 }
 
-const XMVECTOR& CObject::GetOrientation( void )
+const RQuaternion& CObject::GetOrientation( void )
 {
     return m_vOrientation;
 }
 
-void CObject::SetPosition( const XMVECTOR& vPosition )
+void CObject::SetPosition( const RVector4& vPosition )
 {
     m_vPosition = vPosition;
 }
 
-void CObject::SetOrientation( const XMVECTOR& vOrientation )
+void CObject::SetOrientation( const RQuaternion& vOrientation )
 {
     m_vOrientation = vOrientation;
 }
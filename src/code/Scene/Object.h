@@ -12,15 +12,18 @@ Modified by:    Kyle Weicht
 #include "IRefCounted.h"
 #include "Types.h"
 #include "Component.h"
-
-#include <Windows.h> // TODO: Remove XNA math
-#include <xnamath.h>
+#include "PoolAllocator.h"
+#include "RiotMath.h"
 
 class CMesh;
 class CMaterial;
 
 class CObject : public IRefCounted
 {
+#pragma push_macro( "new" )
+#undef new
+    DECLARE_POOL_ALLOCATED( CObject )
+#pragma pop_macro( "new" )
 public:
     // CObject constructor
     CObject();
@@ -44,29 +47,46 @@ public:
     //-----------------------------------------------------------------------------
     virtual void Update( float fDeltaTime );
 
+    //-----------------------------------------------------------------------------
+    //  SaveState
+    //  Remembers the current transform as the previous simulation state.
+    //  Called before every simulation tick
+    //-----------------------------------------------------------------------------
+    void SaveState( void );
+
+    //-----------------------------------------------------------------------------
+    //  Interpolate
+    //  Places the mesh fAlpha (0-1) of the way from the previous simulation
+    //  state to the current one. Called once per rendered frame
+    //-----------------------------------------------------------------------------
+    void Interpolate( float fAlpha );
+
     //-----------------------------------------------------------------------------
     //  Accessors/mutators
     //-----------------------------------------------------------------------------
     CMesh*      GetMesh( void );
     CMaterial*  GetMaterial( void );
+    // The object adds its own reference
     void SetMesh( CMesh* pMesh );
     void SetMaterial( CMaterial* pMaterial );
 
-    const XMVECTOR& GetPosition( void );
-    const XMVECTOR& GetOrientation( void );
-    void SetPosition( const XMVECTOR& vPosition );
-    void SetOrientation( const XMVECTOR& vOrientation );
+    const RVector4& GetPosition( void );
+    const RQuaternion& GetOrientation( void );
+    void SetPosition( const RVector4& vPosition );
+    void SetOrientation( const RQuaternion& vOrientation );
 protected:
     /***************************************\
     | class members                         |
     \***************************************/
-    XMVECTOR    m_vPosition;
-    XMVECTOR    m_vOrientation;
+    RVector4    m_vPosition;
+    RQuaternion m_vOrientation;
+    RVector4    m_vPrevPosition;    // As of the start of the last tick
+    RQuaternion m_vPrevOrientation;
 
     uint        m_pComponentIndices[eNUMCOMPONENTS];
 
-    CMesh*      m_pMesh;
-    CMaterial*  m_pMaterial;
+    RefPtr<CMesh>       m_pMesh;
+    RefPtr<CMaterial>   m_pMaterial;
 };
 
 
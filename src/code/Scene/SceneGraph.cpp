@@ -6,14 +6,15 @@ Modified:       3/23/2011 11:14:58 PM
 Modified by:    Kyle Weicht
 \*********************************************************/
 #include "SceneGraph.h"
-#include "memory.h"
+#include "Memory.h"
 #include "Object.h"
 #include "Riot.h"
-#include "Gfx\View.h"
-#include "Gfx\Graphics.h"
+#include "Gfx/View.h"
+#include "Gfx/Graphics.h"
 #include "ComponentManager.h"
 #include <memory> // for memcpy
-#include "Main\UI.h"
+#include "Main/UI.h"
+#include "Profiler.h"
 #define new DEBUG_NEW
 
 // CSceneGraph constructor
@@ -25,10 +26,9 @@ CSceneGraph::CSceneGraph()
     , m_nNumViews( 0 )
     , m_pActiveView( NULL )
 {
-    m_ppAllSceneObjects = new CObject*[MAX_OBJECTS];
-    memset( m_ppAllSceneObjects, 0, sizeof( CObject* ) * MAX_OBJECTS );
-    m_ppRenderObjects = new CObject*[MAX_OBJECTS];
-    memset( m_ppRenderObjects, 0, sizeof( CObject* ) * MAX_OBJECTS );
+    // Room for every object is reserved up front, but only committed as
+    // objects are added
+    m_ppAllSceneObjects = (CObject**)m_ObjectArena.Reserve( sizeof( CObject* ) * MAX_OBJECTS );
 }
 
 CSceneGraph::~CSceneGraph()
@@ -38,8 +38,8 @@ CSceneGraph::~CSceneGraph()
     {
         SAFE_DELETE( m_ppAllSceneObjects[i] );
     }
-    SAFE_DELETE_ARRAY( m_ppAllSceneObjects );
-    SAFE_DELETE_ARRAY( m_ppRenderObjects );
+    m_ObjectArena.Release();
+    m_ppAllSceneObjects = NULL;
 }
 
 //-----------------------------------------------------------------------------
@@ -55,11 +55,18 @@ CSceneGraph* CSceneGraph::GetInstance( void )
 
 //-----------------------------------------------------------------------------
 //  AddObject
-//  Adds an object to the scene
+//  Adds an object to the scene, which then owns it. Returns false if
+//  the scene is full, in which case the caller still owns the object
 //-----------------------------------------------------------------------------
-void CSceneGraph::AddObject( CObject* pObject )
+bool CSceneGraph::AddObject( CObject* pObject )
 {
+    if( m_nNumTotalObjects >= MAX_OBJECTS
+        || !m_ObjectArena.Commit( sizeof( CObject* ) * ( m_nNumTotalObjects + 1 ) ) )
+    {
+        return false;
+    }
     m_ppAllSceneObjects[ m_nNumTotalObjects++ ] = pObject;
+    return true;
 }
 
 
@@ -78,23 +85,41 @@ void CSceneGraph::AddView( CView* pView )
 
 //-----------------------------------------------------------------------------
 //  UpdateObjects
-//  Updates all the objects
+//  Runs one fixed simulation tick of fDeltaTime seconds on every object
+//  and component
 //-----------------------------------------------------------------------------
 void CSceneGraph::UpdateObjects( float fDeltaTime )
 {
+    PROFILE_SCOPE( "UpdateObjects" );
     // Each object still has an Update for anything super specialized it might need?
     // Hmm.......
-    Riot::GetGraphics()->SetCurrentView( m_pActiveView );
     for( uint i = 0; i < m_nNumTotalObjects; ++i )
     {
-        m_ppAllSceneObjects[i]->Update( ((i%2) == 0) ? fDeltaTime : -fDeltaTime );
+        m_ppAllSceneObjects[i]->SaveState();
+        m_ppAllSceneObjects[i]->Update( fDeltaTime );
     }
 
     // Update the components
     CComponentManager::GetInstance()->ProcessComponents();
+}
+
+//-----------------------------------------------------------------------------
+//  InterpolateObjects
+//  Moves every object's mesh fAlpha (0-1) of the way between its last
+//  two simulation states, and updates the camera
+//-----------------------------------------------------------------------------
+void CSceneGraph::InterpolateObjects( float fAlpha )
+{
+    PROFILE_SCOPE( "InterpolateObjects" );
+    for( uint i = 0; i < m_nNumTotalObjects; ++i )
+    {
+        m_ppAllSceneObjects[i]->Interpolate( fAlpha );
+    }
 
-    // Update the current view
-    m_pActiveView->Update( fDeltaTime );
+    // The camera is moved every frame rather than every tick, so its
+    // matrices are rebuilt here
+    Riot::GetGraphics()->SetCurrentView( m_pActiveView );
+    m_pActiveView->Update( 0.0f );
 
     char szNumObj[ 255 ];
     sprintf_s( szNumObj, 255, "Total objects in scengraph: %d", m_nNumTotalObjects );
@@ -107,6 +132,8 @@ void CSceneGraph::UpdateObjects( float fDeltaTime )
 //-----------------------------------------------------------------------------
 CObject** CSceneGraph::GetRenderObjects( uint* nCount )
 {
+    // The render list is rebuilt every frame, so it lives in frame memory
+    m_ppRenderObjects = FRAME_NEW_ARRAY( CObject*, m_nNumTotalObjects );
     memcpy( m_ppRenderObjects, m_ppAllSceneObjects, sizeof( CObject* ) * m_nNumTotalObjects );
     *nCount = m_nNumRenderObjects = m_nNumTotalObjects;
 
@@ -37,9 +37,10 @@ public:
 
     //-----------------------------------------------------------------------------
     //  AddObject
-    //  Adds an object to the scene
+    //  Adds an object to the scene, which then owns it. Returns false if
+    //  the scene is full, in which case the caller still owns the object
     //-----------------------------------------------------------------------------
-    void AddObject( CObject* pObject );
+    bool AddObject( CObject* pObject );
     // TODO: How do we remove an object?
     // TODO: Where are the objects created?
     
@@ -51,9 +52,18 @@ public:
     
     //-----------------------------------------------------------------------------
     //  UpdateObjects
-    //  Updates all the objects
+    //  Runs one fixed simulation tick of fDeltaTime seconds on every object
+    //  and component
     //-----------------------------------------------------------------------------
     void UpdateObjects( float fDeltaTime );
+
+    //-----------------------------------------------------------------------------
+    //  InterpolateObjects
+    //  Moves every object's mesh fAlpha (0-1) of the way between its last
+    //  two simulation states, and updates the camera. Called once per
+    //  rendered frame, after the ticks
+    //-----------------------------------------------------------------------------
+    void InterpolateObjects( float fAlpha );
     
     //-----------------------------------------------------------------------------
     //  GetRenderObjects
@@ -61,12 +71,19 @@ public:
     //-----------------------------------------------------------------------------
     CObject** GetRenderObjects( uint* nCount );
 
+    //-----------------------------------------------------------------------------
+    //  GetNumObjects
+    //  Returns how many objects are in the scene
+    //-----------------------------------------------------------------------------
+    uint GetNumObjects( void ) const { return m_nNumTotalObjects; }
+
 private:
     /***************************************\
     | class members                         |
     \***************************************/
+    CVirtualArena   m_ObjectArena;
     CObject**   m_ppAllSceneObjects;
-    CObject**   m_ppRenderObjects;
+    CObject**   m_ppRenderObjects;  // Frame memory, rebuilt every frame
     CView*      m_ppViews[8];
     CView*      m_pActiveView;
     uint        m_nNumViews;
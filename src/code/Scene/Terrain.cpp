@@ -4,17 +4,19 @@ Purpose:    Defines terrain based on heightmap
 \*********************************************************/
 
 #include "Terrain.h"
+#include "PackedVector.h"
 #include <cstdio>
-#include <xnamath.h>
 
 // CTerrainVertex
+// 12 bytes instead of two full float4s. Halves hold the grid coordinates
+// and quarter step heights exactly, and the color is only ever red
 class CTerrainVertex
 {
 public:
     // Position
-    XMVECTOR vPos;
+    RHalf4      vPos;
     // Color
-    XMVECTOR vColor;
+    RUNorm8x4   vColor;
 };
 
 // CTerrain
@@ -68,6 +70,8 @@ CTerrain::~CTerrain( void )
 //-----------------------------------------------------------------------------
 void CTerrain::SetHeightMap( const char* szFilename, const uint nWidth, const uint nHeight )
 {
+    MEMORY_CATEGORY( eMemoryCategoryTerrain );
+
     // clear current height map
     if( m_ppHeightMap != NULL )
     {
@@ -87,10 +91,21 @@ void CTerrain::SetHeightMap( const char* szFilename, const uint nWidth, const ui
     m_pMeshIndices = new uint[ (m_nWidth - 1) * (m_nHeight - 1) * 3 * 2 ];
 
     // Read in heightmap info
-    FILE* pFile;
-    errno_t errFile = fopen_s( &pFile, szFilename, "rb" );
-    uint nBytesCopied = fread_s( m_ppHeightMap, nSize * sizeof(byte), sizeof(byte), nSize, pFile );
-    fclose( pFile );
+    FILE* pFile = NULL;
+    uint nBytesCopied = 0;
+#if defined( _MSC_VER )
+    if( fopen_s( &pFile, szFilename, "rb" ) != 0 )
+    {
+        pFile = NULL;
+    }
+#else
+    pFile = fopen( szFilename, "rb" );
+#endif // #if defined( _MSC_VER )
+    if( pFile != NULL )
+    {
+        nBytesCopied = (uint)fread( m_ppHeightMap, sizeof(byte), nSize, pFile );
+        fclose( pFile );
+    }
     // If reading heightmap fails, set the heightmap to all zeroes
     if( nBytesCopied != nSize )
     {
@@ -105,8 +120,8 @@ void CTerrain::SetHeightMap( const char* szFilename, const uint nWidth, const ui
             uint index  = ( m_nHeight * j ) + i;
             float height = m_ppHeightMap[ index ] / 4.0f;
 
-            m_pMeshVertices[ index ].vPos = XMVectorSet( (float)i, height, (float)j, 1.0f );
-            m_pMeshVertices[ index ].vColor = XMVectorSet( height / 256.0f, 0.0f, 0.0f, 1.0f );
+            m_pMeshVertices[ index ].vPos = RHalf4( (float)i, height, (float)j, 1.0f );
+            m_pMeshVertices[ index ].vColor = RUNorm8x4( RVector4( height / 256.0f, 0.0f, 0.0f, 1.0f ) );
 
             m_nNumVertices++;
         }
@@ -6,7 +6,7 @@ Purpose:    Defines terrain based on heightmap
 #define _TERRAIN_H_
 
 #include "Common.h"
-#include "Scene\Object.h"
+#include "Scene/Object.h"
 
 // CTerrainVertex
 class CTerrainVertex;
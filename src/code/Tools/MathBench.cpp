@@ -0,0 +1,728 @@
+/*********************************************************\
+File:       MathBench.cpp
+Purpose:    Microbenchmarks for RiotMath, one call at a time
+            and through the stream kernels, with checking
+            against a saved baseline
+\*********************************************************/
+//-----------------------------------------------------------------------------
+//  Building
+//  A standalone program, built apart from the game. From src/code:
+//
+//      g++ -std=c++11 -O2 -msse2 -IMain Tools/MathBench.cpp Main/MathStream.cpp
+//          Main/MathStreamAVX2.cpp Main/Memory.cpp Main/FrameAllocator.cpp
+//          Main/SmallObjectAllocator.cpp Main/HeapProfiler.cpp Main/CallStack.cpp
+//          Main/Timer.cpp -lpthread -ldl -o MathBench
+//
+//  The single call benchmarks measure whatever RiotMath was compiled as,
+//  so build a second time with -DRIOT_NO_SIMD to compare it to scalar.
+//  The stream benchmarks run every instruction set the CPU has
+//
+//  Running
+//      -filter <text>          Only run benchmarks whose name contains text
+//      -save <file>            Write the results as JSON
+//      -baseline <file>        Compare against results saved with -save
+//      -threshold <percent>    How much slower counts as a regression (5)
+//      -quick                  Shorter runs, for a rough look
+//
+//  With -baseline, the exit code is 1 if anything regressed
+//-----------------------------------------------------------------------------
+#include "Common.h"
+#include "RiotMath.h"
+#include "MathStream.h"
+#include "PackedVector.h"
+#include "BoundingVolume.h"
+#include "Timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define new DEBUG_NEW
+
+#define ARRAY_LENGTH( a ) ( sizeof( a ) / sizeof( ( a )[0] ) )
+
+#if defined( RIOT_SSE )
+static const char* gs_szBuildISA = "SSE";
+#elif defined( RIOT_NEON )
+static const char* gs_szBuildISA = "NEON";
+#else
+static const char* gs_szBuildISA = "Scalar";
+#endif // #if defined( RIOT_SSE )
+
+//-----------------------------------------------------------------------------
+//  Inputs and outputs
+//  The single call benchmarks loop over gs_nSingleCount inputs, which all
+//  fit in L1, so they measure the math and not the memory. Results go to
+//  the outputs so the compiler can't throw the work away
+//-----------------------------------------------------------------------------
+static const uint gs_nSingleCount = 1024;
+
+static RVector3     gs_pVec3A[gs_nSingleCount];
+static RVector3     gs_pVec3B[gs_nSingleCount];
+static RVector3     gs_pVec3Out[gs_nSingleCount];
+static RVector4     gs_pVec4A[gs_nSingleCount];
+static RVector4     gs_pVec4B[gs_nSingleCount];
+static RVector4     gs_pVec4Out[gs_nSingleCount];
+static RQuaternion  gs_pQuatA[gs_nSingleCount];
+static RQuaternion  gs_pQuatB[gs_nSingleCount];
+static RQuaternion  gs_pQuatOut[gs_nSingleCount];
+static RMatrix4x4   gs_pMatA[gs_nSingleCount];
+static RMatrix4x4   gs_pMatB[gs_nSingleCount];
+static RMatrix4x4   gs_pMatOut[gs_nSingleCount];
+static RSphere      gs_pSpheres[gs_nSingleCount];
+static float        gs_pFloats[gs_nSingleCount];
+static float        gs_pFloatOut[gs_nSingleCount];
+static RHalf4       gs_pHalfOut[gs_nSingleCount];
+static uint8        gs_pBoolOut[gs_nSingleCount];
+static RFrustum     gs_Frustum;
+
+static volatile float gs_fSink;
+
+static float RandomFloat( float fMin, float fMax )
+{
+    return fMin + ( fMax - fMin ) * ( rand() / (float)RAND_MAX );
+}
+
+static RVector4 RandomAxis( void )
+{
+    return Normalize( RVector4( RandomFloat( -1.0f, 1.0f ), RandomFloat( -1.0f, 1.0f ), RandomFloat( 0.1f, 1.0f ), 0.0f ) );
+}
+
+static void CreateInputs( void )
+{
+    srand( 1 );
+    for( uint i = 0; i < gs_nSingleCount; ++i )
+    {
+        gs_pVec3A[i] = RVector3( RandomFloat( -100.0f, 100.0f ), RandomFloat( -100.0f, 100.0f ), RandomFloat( -100.0f, 100.0f ) );
+        gs_pVec3B[i] = RVector3( RandomFloat( -100.0f, 100.0f ), RandomFloat( -100.0f, 100.0f ), RandomFloat( -100.0f, 100.0f ) );
+        gs_pVec4A[i] = RVector4( gs_pVec3A[i].x, gs_pVec3A[i].y, gs_pVec3A[i].z, 1.0f );
+        gs_pVec4B[i] = RVector4( gs_pVec3B[i].x, gs_pVec3B[i].y, gs_pVec3B[i].z, 0.0f );
+        gs_pQuatA[i] = RQuaternionRotationAxis( RandomAxis(), RandomFloat( -gs_fPi, gs_fPi ) );
+        gs_pQuatB[i] = RQuaternionRotationAxis( RandomAxis(), RandomFloat( -gs_fPi, gs_fPi ) );
+        gs_pMatA[i] = RMatrix4x4RotationQuaternion( gs_pQuatA[i] ) * RMatrix4x4Translation( gs_pVec4B[i] );
+        gs_pMatB[i] = RMatrix4x4RotationQuaternion( gs_pQuatB[i] ) * RMatrix4x4Translation( gs_pVec4A[i] );
+        gs_pSpheres[i] = RSphere( gs_pVec4A[i], RandomFloat( 0.5f, 10.0f ) );
+        gs_pFloats[i] = RandomFloat( 0.01f, 100.0f );
+    }
+
+    // Roughly the camera CView sets up
+    RMatrix4x4 mView = RMatrix4x4LookToLH( RVector4( 0.0f, 10.0f, -50.0f, 1.0f ), RVector4( 0.0f, 0.0f, 1.0f, 0.0f ), RVector4( 0.0f, 1.0f, 0.0f, 0.0f ) );
+    RMatrix4x4 mProj = RMatrix4x4PerspectiveFovLH( gs_fPi / 4.0f, 16.0f / 9.0f, 0.1f, 1000.0f );
+    gs_Frustum = RFrustumFromMatrix( mView * mProj );
+}
+
+/**********************************************************\
+|**********************************************************|
+| Single call benchmarks
+| Each does gs_nSingleCount operations
+|**********************************************************|
+\**********************************************************/
+static void BenchVec3Normalize( void )
+{
+    for( uint i = 0; i < gs_nSingleCount; ++i )
+        gs_pVec3Out[i] = Normalize( gs_pVec3A[i] );
+}
+
+static void BenchVec3NormalizeEst( void )
+{
+    for( uint i = 0; i < gs_nSingleCount; ++i )
+        gs_pVec3Out[i] = NormalizeEst( gs_pVec3A[i] );
+}
+
+static void BenchVec3Cross( void )
+{
+    for( uint i = 0; i < gs_nSingleCount; ++i )
+        gs_pVec3Out[i] = CrossProduct( gs_pVec3A[i], gs_pVec3B[i] );
+}
+
+static void BenchVec3Dot( void )
+{
+    for( uint i = 0; i < gs_nSingleCount; ++i )
+        gs_pFloatOut[i] = DotProduct( gs_pVec3A[i], gs_pVec3B[i] );
+}
+
+static void BenchVec4Normalize( void )
+{
+    for( uint i = 0; i < gs_nSingleCount; ++i )
+        gs_pVec4Out[i] = Normalize( gs_pVec4A[i] );
+}
+
+static void BenchVec4NormalizeEst( void )
+{
+    for( uint i = 0; i < gs_nSingleCount; ++i )
+        gs_pVec4Out[i] = NormalizeEst( gs_pVec4A[i] );
+}
+
+static void BenchVec4Cross( void )
+{
+    for( uint i = 0; i < gs_nSingleCount; ++i )
+        gs_pVec4Out[i] = CrossProduct( gs_pVec4A[i], gs_pVec4B[i] );
+}
+
+static void BenchVec4Dot( void )
+{
+    for( uint i = 0; i < gs_nSingleCount; ++i )
+        gs_pFloatOut[i] = DotProduct( gs_pVec4A[i], gs_pVec4B[i] );
+}
+
+static void BenchVec4Transform( void )
+{
+    for( uint i = 0; i < gs_nSingleCount; ++i )
+        gs_pVec4Out[i] = gs_pVec4A[i] * gs_pMatA[i];
+}
+
+static void BenchMatMultiply( void )
+{
+    for( uint i = 0; i < gs_nSingleCount; ++i )
+        gs_pMatOut[i] = gs_pMatA[i] * gs_pMatB[i];
+}
+
+static void BenchMatTranspose( void )
+{
+    for( uint i = 0; i < gs_nSingleCount; ++i )
+        gs_pMatOut[i] = Transpose( gs_pMatA[i] );
+}
+
+static void BenchMatAffineInverse( void )
+{
+    for( uint i = 0; i < gs_nSingleCount; ++i )
+        gs_pMatOut[i] = AffineInverse( gs_pMatA[i] );
+}
+
+static void BenchMatRotationAxis( void )
+{
+    for( uint i = 0; i < gs_nSingleCount; ++i )
+        gs_pMatOut[i] = RMatrix4x4RotationAxis( gs_pVec4B[i], gs_pFloats[i] );
+}
+
+static void BenchMatRotationAxisEst( void )
+{
+    for( uint i = 0; i < gs_nSingleCount; ++i )
+        gs_pMatOut[i] = RMatrix4x4RotationAxisEst( gs_pVec4B[i], gs_pFloats[i] );
+}
+
+static void BenchMatFromQuat( void )
+{
+    for( uint i = 0; i < gs_nSingleCount; ++i )
+        gs_pMatOut[i] = RMatrix4x4RotationQuaternion( gs_pQuatA[i] );
+}
+
+// What CView::UpdateViewMatrix and CView::GetFrustum do each frame
+static void BenchViewProj( void )
+{
+    RVector4 vUp( 0.0f, 1.0f, 0.0f, 0.0f );
+    for( uint i = 0; i < gs_nSingleCount; ++i )
+    {
+        RMatrix4x4 mView = RMatrix4x4LookToLH( gs_pVec4A[i], Normalize( gs_pVec4B[i] ), vUp );
+        gs_pMatOut[i] = mView * gs_pMatB[i];
+    }
+}
+
+static void BenchQuatMultiply( void )
+{
+    for( uint i = 0; i < gs_nSingleCount; ++i )
+        gs_pQuatOut[i] = gs_pQuatA[i] * gs_pQuatB[i];
+}
+
+static void BenchQuatSlerp( void )
+{
+    for( uint i = 0; i < gs_nSingleCount; ++i )
+        gs_pQuatOut[i] = Slerp( gs_pQuatA[i], gs_pQuatB[i], 0.3f );
+}
+
+static void BenchSinCos( void )
+{
+    for( uint i = 0; i < gs_nSingleCount; ++i )
+        SinCos( gs_pFloats[i], &gs_pFloatOut[i], &gs_pVec4Out[i].x );
+}
+
+static void BenchSinCosEst( void )
+{
+    for( uint i = 0; i < gs_nSingleCount; ++i )
+        SinCosEst( gs_pFloats[i], &gs_pFloatOut[i], &gs_pVec4Out[i].x );
+}
+
+static void BenchRecipSqrtEst( void )
+{
+    for( uint i = 0; i < gs_nSingleCount; ++i )
+        gs_pFloatOut[i] = RecipSqrtEst( gs_pFloats[i] );
+}
+
+static void BenchPackHalf4( void )
+{
+    for( uint i = 0; i < gs_nSingleCount; ++i )
+        gs_pHalfOut[i] = RHalf4( gs_pVec4A[i] );
+}
+
+static void BenchFrustumSphere( void )
+{
+    for( uint i = 0; i < gs_nSingleCount; ++i )
+        gs_pBoolOut[i] = Intersect( gs_Frustum, gs_pSpheres[i] );
+}
+
+struct SingleBench
+{
+    const char* szName;
+    void (*pfnRun)( void );
+};
+
+static const SingleBench gs_pSingleBenches[] =
+{
+    { "RVector3.Normalize",             BenchVec3Normalize },
+    { "RVector3.NormalizeEst",          BenchVec3NormalizeEst },
+    { "RVector3.CrossProduct",          BenchVec3Cross },
+    { "RVector3.DotProduct",            BenchVec3Dot },
+    { "RVector4.Normalize",             BenchVec4Normalize },
+    { "RVector4.NormalizeEst",          BenchVec4NormalizeEst },
+    { "RVector4.CrossProduct",          BenchVec4Cross },
+    { "RVector4.DotProduct",            BenchVec4Dot },
+    { "RVector4.Transform",             BenchVec4Transform },
+    { "RMatrix4x4.Multiply",            BenchMatMultiply },
+    { "RMatrix4x4.Transpose",           BenchMatTranspose },
+    { "RMatrix4x4.AffineInverse",       BenchMatAffineInverse },
+    { "RMatrix4x4.RotationAxis",        BenchMatRotationAxis },
+    { "RMatrix4x4.RotationAxisEst",     BenchMatRotationAxisEst },
+    { "RMatrix4x4.RotationQuaternion",  BenchMatFromQuat },
+    { "RMatrix4x4.ViewProj",            BenchViewProj },
+    { "RQuaternion.Multiply",           BenchQuatMultiply },
+    { "RQuaternion.Slerp",              BenchQuatSlerp },
+    { "SinCos",                         BenchSinCos },
+    { "SinCosEst",                      BenchSinCosEst },
+    { "RecipSqrtEst",                   BenchRecipSqrtEst },
+    { "RHalf4.Pack",                    BenchPackHalf4 },
+    { "Intersect.FrustumSphere",        BenchFrustumSphere },
+};
+
+/**********************************************************\
+|**********************************************************|
+| Stream benchmarks
+| Each does nCount operations on streams set up by
+| CreateStreams, sized from in cache to well out of it
+|**********************************************************|
+\**********************************************************/
+static const uint gs_pStreamCounts[] = { 256, 16 * 1024, 1024 * 1024 };
+
+static RVec3Stream* gs_pStreamA;
+static RVec3Stream* gs_pStreamB;
+static RVec3Stream* gs_pStreamOut;
+static float*       gs_pStreamFloats;
+static RHalf*       gs_pStreamHalfs;
+static uint8*       gs_pStreamBools;
+static RMatrix4x4*  gs_pStreamMatA;
+static RMatrix4x4*  gs_pStreamMatB;
+static RMatrix4x4*  gs_pStreamMatOut;
+
+static void CreateStreams( uint nCount )
+{
+    gs_pStreamA = new RVec3Stream( nCount );
+    gs_pStreamB = new RVec3Stream( nCount );
+    gs_pStreamOut = new RVec3Stream( nCount );
+    gs_pStreamFloats = new float[nCount];
+    gs_pStreamHalfs = new RHalf[nCount];
+    gs_pStreamBools = new uint8[nCount];
+    gs_pStreamMatA = (RMatrix4x4*)ALIGNED_ALLOC( sizeof( RMatrix4x4 ) * nCount, 16 );
+    gs_pStreamMatB = (RMatrix4x4*)ALIGNED_ALLOC( sizeof( RMatrix4x4 ) * nCount, 16 );
+    gs_pStreamMatOut = (RMatrix4x4*)ALIGNED_ALLOC( sizeof( RMatrix4x4 ) * nCount, 16 );
+    for( uint i = 0; i < nCount; ++i )
+    {
+        uint nInput = i % gs_nSingleCount;
+        gs_pStreamA->Set( i, gs_pVec3A[nInput] );
+        gs_pStreamB->Set( i, gs_pVec3B[nInput] );
+        gs_pStreamFloats[i] = gs_pFloats[nInput];
+        gs_pStreamMatA[i] = gs_pMatA[nInput];
+        gs_pStreamMatB[i] = gs_pMatB[nInput];
+    }
+}
+
+static void DestroyStreams( void )
+{
+    SAFE_DELETE( gs_pStreamA );
+    SAFE_DELETE( gs_pStreamB );
+    SAFE_DELETE( gs_pStreamOut );
+    SAFE_DELETE_ARRAY( gs_pStreamFloats );
+    SAFE_DELETE_ARRAY( gs_pStreamHalfs );
+    SAFE_DELETE_ARRAY( gs_pStreamBools );
+    AlignedFree( gs_pStreamMatA );
+    AlignedFree( gs_pStreamMatB );
+    AlignedFree( gs_pStreamMatOut );
+}
+
+static void BenchStreamTransform( uint )
+{
+    StreamTransformPoints( gs_pMatA[0], *gs_pStreamA, gs_pStreamOut );
+}
+
+static void BenchStreamProject( uint nCount )
+{
+    StreamProjectPoints( gs_pMatA[0], gs_pStreamA->x, gs_pStreamA->y, gs_pStreamA->z,
+                         gs_pStreamOut->x, gs_pStreamOut->y, gs_pStreamOut->z, gs_pStreamFloats, nCount );
+}
+
+static void BenchStreamDot( uint )
+{
+    StreamDotProducts( *gs_pStreamA, *gs_pStreamB, gs_pStreamFloats );
+}
+
+static void BenchStreamNormalize( uint )
+{
+    // Normalizing what's already normalized is the same work
+    StreamNormalize( gs_pStreamA );
+}
+
+static void BenchStreamMinMax( uint )
+{
+    RVector3 vMin, vMax;
+    StreamMinMax( *gs_pStreamA, &vMin, &vMax );
+    gs_fSink = vMin.x + vMax.x;
+}
+
+static void BenchStreamMultiply( uint nCount )
+{
+    StreamMultiplyMatrices( gs_pStreamMatA, gs_pStreamMatB, gs_pStreamMatOut, nCount );
+}
+
+static void BenchStreamCull( uint )
+{
+    StreamCullSpheres( gs_Frustum, *gs_pStreamA, gs_pStreamFloats, gs_pStreamBools );
+}
+
+static void BenchStreamOverlap( uint )
+{
+    RAABB Box( RVector4( -50.0f, -50.0f, -50.0f, 0.0f ), RVector4( 50.0f, 50.0f, 50.0f, 0.0f ) );
+    StreamOverlapAABBs( Box, *gs_pStreamA, *gs_pStreamB, gs_pStreamBools );
+}
+
+static void BenchStreamRay( uint )
+{
+    RVector4 vOrigin( 0.0f, 0.0f, -200.0f, 1.0f );
+    RVector4 vDirection( 0.1f, 0.2f, 1.0f, 0.0f );
+    StreamIntersectRayAABBs( vOrigin, vDirection, *gs_pStreamA, *gs_pStreamB, gs_pStreamFloats );
+}
+
+static void BenchStreamToHalfs( uint nCount )
+{
+    StreamFloatsToHalfs( gs_pStreamFloats, gs_pStreamHalfs, nCount );
+}
+
+static void BenchStreamFromHalfs( uint nCount )
+{
+    StreamHalfsToFloats( gs_pStreamHalfs, gs_pStreamFloats, nCount );
+}
+
+struct StreamBench
+{
+    const char* szName;
+    void (*pfnRun)( uint nCount );
+};
+
+static const StreamBench gs_pStreamBenches[] =
+{
+    { "Stream.TransformPoints",     BenchStreamTransform },
+    { "Stream.ProjectPoints",       BenchStreamProject },
+    { "Stream.DotProducts",         BenchStreamDot },
+    { "Stream.Normalize",           BenchStreamNormalize },
+    { "Stream.MinMax",              BenchStreamMinMax },
+    { "Stream.MultiplyMatrices",    BenchStreamMultiply },
+    { "Stream.CullSpheres",         BenchStreamCull },
+    { "Stream.OverlapAABBs",        BenchStreamOverlap },
+    { "Stream.IntersectRayAABBs",   BenchStreamRay },
+    { "Stream.FloatsToHalfs",       BenchStreamToHalfs },
+    { "Stream.HalfsToFloats",       BenchStreamFromHalfs },
+};
+
+/**********************************************************\
+|**********************************************************|
+| Timing and results
+|**********************************************************|
+\**********************************************************/
+struct BenchResult
+{
+    char    szName[64];
+    char    szISA[16];
+    uint    nCount;
+    double  fNsPerOp;
+};
+
+static const uint   gs_nMaxResults = 256;
+static BenchResult  gs_pResults[gs_nMaxResults];
+static uint         gs_nNumResults = 0;
+
+static BenchResult  gs_pBaseline[gs_nMaxResults];
+static uint         gs_nNumBaseline = 0;
+
+static double       gs_fSampleTime = 0.02;
+static uint         gs_nSamples = 7;
+
+//-----------------------------------------------------------------------------
+//  TimeBench
+//  Calibrates how many runs fill a sample, then takes the fastest of
+//  several samples. The fastest is the one least disturbed by the rest of
+//  the system, so it's the most repeatable
+//-----------------------------------------------------------------------------
+template< class TRun >
+static double TimeBench( TRun Run, uint nOpsPerRun )
+{
+    double fTicksToNs = 1.0e9 / GetOSTicksPerSecond();
+
+    // Warm up the caches and branch predictors
+    Run();
+
+    uint nRuns = 1;
+    for( ;; )
+    {
+        uint64 nStart = GetOSTicks();
+        for( uint i = 0; i < nRuns; ++i )
+            Run();
+        double fTime = ( GetOSTicks() - nStart ) * fTicksToNs * 1.0e-9;
+        if( fTime >= gs_fSampleTime * 0.5 || nRuns >= 0x40000000 )
+        {
+            if( fTime > 0.0 )
+            {
+                double fRuns = nRuns * gs_fSampleTime / fTime;
+                nRuns = fRuns < 1.0 ? 1 : ( fRuns > 0x40000000 ? 0x40000000 : (uint)fRuns );
+            }
+            break;
+        }
+        nRuns *= 2;
+    }
+
+    double fBestNs = 0.0;
+    for( uint nSample = 0; nSample < gs_nSamples; ++nSample )
+    {
+        uint64 nStart = GetOSTicks();
+        for( uint i = 0; i < nRuns; ++i )
+            Run();
+        double fNs = ( GetOSTicks() - nStart ) * fTicksToNs / ( (double)nRuns * nOpsPerRun );
+        if( nSample == 0 || fNs < fBestNs )
+            fBestNs = fNs;
+    }
+    return fBestNs;
+}
+
+// Adapters so TimeBench can call both kinds of benchmark the same way
+class CSingleRun
+{
+public:
+    CSingleRun( void (*pfnRun)( void ) ) : m_pfnRun( pfnRun ) { }
+    void operator()( void ) const { m_pfnRun(); }
+private:
+    void (*m_pfnRun)( void );
+};
+
+class CStreamRun
+{
+public:
+    CStreamRun( void (*pfnRun)( uint ), uint nCount ) : m_pfnRun( pfnRun ), m_nCount( nCount ) { }
+    void operator()( void ) const { m_pfnRun( m_nCount ); }
+private:
+    void (*m_pfnRun)( uint );
+    uint m_nCount;
+};
+
+static const BenchResult* FindBaseline( const BenchResult& Result )
+{
+    for( uint i = 0; i < gs_nNumBaseline; ++i )
+    {
+        const BenchResult& Baseline = gs_pBaseline[i];
+        if( Baseline.nCount == Result.nCount
+            && strcmp( Baseline.szName, Result.szName ) == 0
+            && strcmp( Baseline.szISA, Result.szISA ) == 0 )
+        {
+            return &Baseline;
+        }
+    }
+    return NULL;
+}
+
+//-----------------------------------------------------------------------------
+//  AddResult
+//  Records and prints a result, and compares it to the baseline. Returns
+//  true if it's more than fThreshold percent slower than the baseline
+//-----------------------------------------------------------------------------
+static bool AddResult( const char* szName, const char* szISA, uint nCount, double fNsPerOp, double fThreshold )
+{
+    bool bRegressed = false;
+    if( gs_nNumResults == gs_nMaxResults )
+    {
+        return bRegressed;
+    }
+
+    BenchResult& Result = gs_pResults[gs_nNumResults++];
+    strncpy( Result.szName, szName, sizeof( Result.szName ) - 1 );
+    Result.szName[sizeof( Result.szName ) - 1] = 0;
+    strncpy( Result.szISA, szISA, sizeof( Result.szISA ) - 1 );
+    Result.szISA[sizeof( Result.szISA ) - 1] = 0;
+    Result.nCount = nCount;
+    Result.fNsPerOp = fNsPerOp;
+
+    printf( "%-32s %-7s %8u %10.3f ns %10.2f Mop/s", szName, szISA, nCount, fNsPerOp, 1.0e3 / fNsPerOp );
+
+    const BenchResult* pBaseline = FindBaseline( Result );
+    if( pBaseline )
+    {
+        double fDelta = ( fNsPerOp - pBaseline->fNsPerOp ) / pBaseline->fNsPerOp * 100.0;
+        bRegressed = fDelta > fThreshold;
+        printf( " %+8.1f%%%s", fDelta, bRegressed ? "  REGRESSED" : ( fDelta < -fThreshold ? "  faster" : "" ) );
+    }
+    printf( "\n" );
+    return bRegressed;
+}
+
+static FILE* OpenFile( const char* szFilename, const char* szMode )
+{
+    FILE* pFile = NULL;
+#if defined( _MSC_VER )
+    if( fopen_s( &pFile, szFilename, szMode ) != 0 )
+    {
+        pFile = NULL;
+    }
+#else
+    pFile = fopen( szFilename, szMode );
+#endif // #if defined( _MSC_VER )
+    return pFile;
+}
+
+//-----------------------------------------------------------------------------
+//  SaveResults/LoadBaseline
+//  One result to a line, so loading only has to understand what saving
+//  writes
+//-----------------------------------------------------------------------------
+static bool SaveResults( const char* szFilename )
+{
+    FILE* pFile = OpenFile( szFilename, "w" );
+    if( pFile == NULL )
+    {
+        printf( "Couldn't write %s\n", szFilename );
+        return false;
+    }
+
+    fprintf( pFile, "{\n\"build\": \"%s\",\n\"results\": [\n", gs_szBuildISA );
+    for( uint i = 0; i < gs_nNumResults; ++i )
+    {
+        const BenchResult& Result = gs_pResults[i];
+        fprintf( pFile, "{ \"name\": \"%s\", \"isa\": \"%s\", \"count\": %u, \"ns_per_op\": %.4f }%s\n",
+                 Result.szName, Result.szISA, Result.nCount, Result.fNsPerOp, i + 1 < gs_nNumResults ? "," : "" );
+    }
+    fprintf( pFile, "]\n}\n" );
+    fclose( pFile );
+    return true;
+}
+
+static bool LoadBaseline( const char* szFilename )
+{
+    FILE* pFile = OpenFile( szFilename, "r" );
+    if( pFile == NULL )
+    {
+        printf( "Couldn't read %s\n", szFilename );
+        return false;
+    }
+
+    char szLine[256];
+    while( gs_nNumBaseline < gs_nMaxResults && fgets( szLine, sizeof( szLine ), pFile ) )
+    {
+        BenchResult& Result = gs_pBaseline[gs_nNumBaseline];
+        if( sscanf( szLine, " { \"name\": \"%63[^\"]\", \"isa\": \"%15[^\"]\", \"count\": %u, \"ns_per_op\": %lf",
+                    Result.szName, Result.szISA, &Result.nCount, &Result.fNsPerOp ) == 4 )
+        {
+            ++gs_nNumBaseline;
+        }
+    }
+    fclose( pFile );
+    return true;
+}
+
+/**********************************************************\
+|**********************************************************|
+| main
+|**********************************************************|
+\**********************************************************/
+int main( int argc, char* argv[] )
+{
+    const char* szFilter = NULL;
+    const char* szSaveFile = NULL;
+    const char* szBaselineFile = NULL;
+    double fThreshold = 5.0;
+    for( int nArg = 1; nArg < argc; ++nArg )
+    {
+        if( strcmp( argv[nArg], "-filter" ) == 0 && nArg + 1 < argc )
+        {
+            szFilter = argv[++nArg];
+        }
+        else if( strcmp( argv[nArg], "-save" ) == 0 && nArg + 1 < argc )
+        {
+            szSaveFile = argv[++nArg];
+        }
+        else if( strcmp( argv[nArg], "-baseline" ) == 0 && nArg + 1 < argc )
+        {
+            szBaselineFile = argv[++nArg];
+        }
+        else if( strcmp( argv[nArg], "-threshold" ) == 0 && nArg + 1 < argc )
+        {
+            fThreshold = atof( argv[++nArg] );
+        }
+        else if( strcmp( argv[nArg], "-quick" ) == 0 )
+        {
+            gs_fSampleTime = 0.002;
+            gs_nSamples = 3;
+        }
+        else
+        {
+            printf( "Unknown command line option: %s\n", argv[nArg] );
+            return 2;
+        }
+    }
+
+    if( szBaselineFile && !LoadBaseline( szBaselineFile ) )
+    {
+        return 2;
+    }
+
+    CreateInputs();
+    eMathISA nBestISA = MathGetBestISA();
+    printf( "RiotMath built for %s, best stream ISA %s\n\n", gs_szBuildISA, MathGetISAName( nBestISA ) );
+    printf( "%-32s %-7s %8s %13s %16s%s\n", "Benchmark", "ISA", "Count", "Time/op", "Throughput", szBaselineFile ? "    Delta" : "" );
+
+    uint nRegressions = 0;
+    for( uint nBench = 0; nBench < ARRAY_LENGTH( gs_pSingleBenches ); ++nBench )
+    {
+        const SingleBench& Bench = gs_pSingleBenches[nBench];
+        if( szFilter && strstr( Bench.szName, szFilter ) == NULL )
+            continue;
+        double fNsPerOp = TimeBench( CSingleRun( Bench.pfnRun ), gs_nSingleCount );
+        nRegressions += AddResult( Bench.szName, gs_szBuildISA, gs_nSingleCount, fNsPerOp, fThreshold );
+    }
+
+    for( uint nSize = 0; nSize < ARRAY_LENGTH( gs_pStreamCounts ); ++nSize )
+    {
+        uint nCount = gs_pStreamCounts[nSize];
+        CreateStreams( nCount );
+        for( uint nBench = 0; nBench < ARRAY_LENGTH( gs_pStreamBenches ); ++nBench )
+        {
+            const StreamBench& Bench = gs_pStreamBenches[nBench];
+            if( szFilter && strstr( Bench.szName, szFilter ) == NULL )
+                continue;
+            for( uint nISA = 0; nISA <= (uint)nBestISA; ++nISA )
+            {
+                // Skip the sets this build doesn't have
+                if( MathSetISA( (eMathISA)nISA ) != (eMathISA)nISA )
+                    continue;
+                double fNsPerOp = TimeBench( CStreamRun( Bench.pfnRun, nCount ), nCount );
+                nRegressions += AddResult( Bench.szName, MathGetISAName( (eMathISA)nISA ), nCount, fNsPerOp, fThreshold );
+            }
+        }
+        DestroyStreams();
+    }
+    MathSetISA( nBestISA );
+
+    gs_fSink = gs_pVec3Out[0].x + gs_pVec4Out[0].x + gs_pQuatOut[0].x + gs_pMatOut[0]._11 + gs_pFloatOut[0]
+             + gs_pHalfOut[0].x + gs_pBoolOut[0];
+
+    if( szSaveFile && !SaveResults( szSaveFile ) )
+    {
+        return 2;
+    }
+    if( szBaselineFile )
+    {
+        printf( "\n%u regression%s over %.1f%%\n", nRegressions, nRegressions == 1 ? "" : "s", fThreshold );
+    }
+    return nRegressions ? 1 : 0;
+}
@@ -0,0 +1,1411 @@
+/*********************************************************\
+File:       MathTest.cpp
+Purpose:    Checks the fast math in RiotMath against
+            double precision libm, and the bounding volume
+            tests and packed vectors against known answers
+\*********************************************************/
+//-----------------------------------------------------------------------------
+//  Building
+//  A standalone program, built apart from the game. From src/code:
+//
+//      g++ -std=c++11 -O2 -msse2 -IMain Tools/MathTest.cpp Main/MathStream.cpp
+//          Main/MathStreamAVX2.cpp Main/Memory.cpp Main/FrameAllocator.cpp
+//          Main/SmallObjectAllocator.cpp Main/HeapProfiler.cpp Main/CallStack.cpp
+//          Main/Timer.cpp Main/PackedVector.cpp -lpthread -ldl -o MathTest
+//
+//  It tests whatever RiotMath was compiled as, so build it again with
+//  -msse4.1, -mf16c and -DRIOT_NO_SIMD to cover the other paths. The
+//  stream kernels run every instruction set the CPU has
+//
+//  Running
+//      -quick                  Fewer samples, for a rough look
+//
+//  Every function is swept over its valid range, and the worst error is
+//  compared to the bound RiotMath.h documents. The bounding volume tests
+//  are given pairs built to overlap or be apart, and a wrong answer is an
+//  error of 1. The exit code is 1 if any bound was exceeded
+//-----------------------------------------------------------------------------
+#include "Common.h"
+#include "RiotMath.h"
+#include "MathStream.h"
+#include "BoundingVolume.h"
+#include "PackedVector.h"
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define new DEBUG_NEW
+
+#define ARRAY_LENGTH( a ) ( sizeof( a ) / sizeof( ( a )[0] ) )
+
+#if defined( RIOT_SSE4 )
+static const char* gs_szBuildISA = "SSE4.1";
+#elif defined( RIOT_SSE )
+static const char* gs_szBuildISA = "SSE";
+#elif defined( RIOT_NEON )
+static const char* gs_szBuildISA = "NEON";
+#else
+static const char* gs_szBuildISA = "Scalar";
+#endif // #if defined( RIOT_SSE4 )
+
+//-----------------------------------------------------------------------------
+//  Bounds
+//  These have to match the table in RiotMath.h
+//-----------------------------------------------------------------------------
+static const double gs_fRecipSqrtEstBound   = 3e-7;     // Relative
+static const double gs_fRecipEstBound       = 2.5e-7;   // Relative
+static const double gs_fSinCosBound         = 5e-7;     // Absolute
+static const double gs_fSinCosEstBound      = 1e-5;     // Absolute
+static const double gs_fAtan2EstBound       = 2e-5;     // Absolute
+static const float  gs_fMaxAngle            = 8192.0f;
+static const double gs_fTwoPi               = 6.28318530717958647692;
+
+// RiotMath.h doesn't give these, they're what float math should manage
+static const double gs_fPlaneBound          = 1e-6;     // Relative
+static const double gs_fPlanePointsBound    = 1e-5;     // Relative to the points
+static const double gs_fFrustumBound        = 1e-5;     // Relative to the frustum
+static const double gs_fRayBound            = 1e-6;     // Relative to the distance
+static const double gs_fNormBound           = 0.505;    // Steps
+
+static uint gs_nSamples = 1 << 24;
+
+//-----------------------------------------------------------------------------
+//  CWorstError
+//  Tracks the worst error seen, and where
+//-----------------------------------------------------------------------------
+class CWorstError
+{
+public:
+    CWorstError( void ) : m_fError( 0.0 ), m_fInputA( 0.0f ), m_fInputB( 0.0f ) { }
+
+    void Add( double fError, float fInputA, float fInputB = 0.0f )
+    {
+        // NaNs compare false, so check for them the other way round
+        if( !( fError <= m_fError ) )
+        {
+            m_fError = fError;
+            m_fInputA = fInputA;
+            m_fInputB = fInputB;
+        }
+    }
+
+    double  m_fError;
+    float   m_fInputA;
+    float   m_fInputB;
+};
+
+//-----------------------------------------------------------------------------
+//  Report
+//  Prints the result, returns 1 if the bound was exceeded
+//-----------------------------------------------------------------------------
+static uint Report( const char* szName, const CWorstError& Worst, double fBound, bool bTwoInputs )
+{
+    // A NaN error fails the comparison, so it fails the test
+    bool bPassed = Worst.m_fError <= fBound;
+    char szInput[64];
+    if( bTwoInputs )
+    {
+        sprintf_s( szInput, sizeof( szInput ), "( %.9g, %.9g )", Worst.m_fInputA, Worst.m_fInputB );
+    }
+    else
+    {
+        sprintf_s( szInput, sizeof( szInput ), "( %.9g )", Worst.m_fInputA );
+    }
+    printf( "%-28s %-7s %12.4g %12.4g   %-4s at %s\n", szName, gs_szBuildISA,
+            Worst.m_fError, fBound, bPassed ? "ok" : "FAIL", szInput );
+    return bPassed ? 0 : 1;
+}
+
+//-----------------------------------------------------------------------------
+//  NextFloat
+//  Steps through floats, every nStep-th representable value
+//-----------------------------------------------------------------------------
+static float NextFloat( float F, uint nStep )
+{
+    uint32 nBits;
+    memcpy( &nBits, &F, sizeof( nBits ) );
+    nBits += nStep;
+    memcpy( &F, &nBits, sizeof( F ) );
+    return F;
+}
+
+//-----------------------------------------------------------------------------
+//  The reciprocals
+//  The relative error only depends on the mantissa and whether the exponent
+//  is odd, so every mantissa in [1, 4) is checked, then a spread of
+//  exponents. Denormal results are left out, the hardware flushes them
+//-----------------------------------------------------------------------------
+static uint TestRecipSqrtEst( void )
+{
+    CWorstError Worst;
+    CWorstError WorstReg;
+    uint nStep = gs_nSamples < ( 1 << 24 ) ? ( 1 << 24 ) / gs_nSamples : 1;
+    for( float F = 1.0f; F < 4.0f; F = NextFloat( F, nStep ) )
+    {
+        double fExact = 1.0 / sqrt( (double)F );
+        Worst.Add( fabs( RecipSqrtEst( F ) - fExact ) / fExact, F );
+        WorstReg.Add( fabs( RVecGetX( RVecRecipSqrtEst( RVecSet( F, F, F, F ) ) ) - fExact ) / fExact, F );
+    }
+    for( float F = 1e-37f; F < 1e37f; F = NextFloat( F, 0x1234 ) )
+    {
+        double fExact = 1.0 / sqrt( (double)F );
+        Worst.Add( fabs( RecipSqrtEst( F ) - fExact ) / fExact, F );
+        WorstReg.Add( fabs( RVecGetX( RVecRecipSqrtEst( RVecSet( F, F, F, F ) ) ) - fExact ) / fExact, F );
+    }
+    return Report( "RecipSqrtEst", Worst, gs_fRecipSqrtEstBound, false )
+         + Report( "RVecRecipSqrtEst", WorstReg, gs_fRecipSqrtEstBound, false );
+}
+
+static uint TestRecipEst( void )
+{
+    CWorstError Worst;
+    uint nStep = gs_nSamples < ( 1 << 23 ) ? ( 1 << 23 ) / gs_nSamples : 1;
+    for( float F = 1.0f; F < 2.0f; F = NextFloat( F, nStep ) )
+    {
+        double fExact = 1.0 / (double)F;
+        Worst.Add( fabs( RecipEst( F ) - fExact ) / fExact, F );
+        Worst.Add( fabs( RecipEst( -F ) + fExact ) / fExact, -F );
+    }
+    for( float F = 1e-37f; F < 1e37f; F = NextFloat( F, 0x1234 ) )
+    {
+        double fExact = 1.0 / (double)F;
+        Worst.Add( fabs( RecipEst( F ) - fExact ) / fExact, F );
+    }
+    return Report( "RecipEst", Worst, gs_fRecipEstBound, false );
+}
+
+//-----------------------------------------------------------------------------
+//  The sines and cosines
+//  Swept evenly over the whole valid range, and densely over the first
+//  turn, where the reduction does nothing and the polynomial is all there is
+//-----------------------------------------------------------------------------
+typedef void (*SinCosFunc)( float fAngle, float* pSin, float* pCos );
+
+static uint TestSinCos( const char* szName, SinCosFunc pfnSinCos, double fBound )
+{
+    CWorstError WorstSin;
+    CWorstError WorstCos;
+    for( uint i = 0; i <= gs_nSamples; ++i )
+    {
+        float pAngles[2] =
+        {
+            ( (float)i / (float)gs_nSamples * 2.0f - 1.0f ) * gs_fMaxAngle,
+            ( (float)i / (float)gs_nSamples * 2.0f - 1.0f ) * gs_fPi * 2.0f,
+        };
+        for( uint nAngle = 0; nAngle < ARRAY_LENGTH( pAngles ); ++nAngle )
+        {
+            float fAngle = pAngles[nAngle];
+            float fSin, fCos;
+            pfnSinCos( fAngle, &fSin, &fCos );
+            WorstSin.Add( fabs( fSin - sin( (double)fAngle ) ), fAngle );
+            WorstCos.Add( fabs( fCos - cos( (double)fAngle ) ), fAngle );
+        }
+    }
+
+    char szSinName[32];
+    char szCosName[32];
+    sprintf_s( szSinName, sizeof( szSinName ), "%s sin", szName );
+    sprintf_s( szCosName, sizeof( szCosName ), "%s cos", szName );
+    return Report( szSinName, WorstSin, fBound, false )
+         + Report( szCosName, WorstCos, fBound, false );
+}
+
+//-----------------------------------------------------------------------------
+//  Atan2Est
+//  Goes round the circle at a spread of radii, so every octant and both
+//  axes are covered, including the signed zeros. The error is measured
+//  round the circle, so pi and -pi are the same angle
+//-----------------------------------------------------------------------------
+static double AngleError( float fAngle, double fExact )
+{
+    double fError = fmod( fabs( fAngle - fExact ), gs_fTwoPi );
+    return fError < gs_fTwoPi - fError ? fError : gs_fTwoPi - fError;
+}
+
+static uint TestAtan2Est( void )
+{
+    static const float pRadii[] = { 1e-30f, 1e-3f, 1.0f, 7.5f, 1e4f, 1e30f };
+
+    CWorstError Worst;
+    uint nSteps = gs_nSamples / ARRAY_LENGTH( pRadii );
+    for( uint nRadius = 0; nRadius < ARRAY_LENGTH( pRadii ); ++nRadius )
+    {
+        for( uint i = 0; i < nSteps; ++i )
+        {
+            double fTheta = ( (double)i / nSteps - 0.5 ) * gs_fTwoPi;
+            float fY = (float)( sin( fTheta ) * pRadii[nRadius] );
+            float fX = (float)( cos( fTheta ) * pRadii[nRadius] );
+            Worst.Add( AngleError( Atan2Est( fY, fX ), atan2( (double)fY, (double)fX ) ), fY, fX );
+        }
+    }
+
+    static const float pAxes[][2] =
+    {
+        { 0.0f, 1.0f }, { 1.0f, 0.0f }, { 0.0f, -1.0f }, { -1.0f, 0.0f },
+        { 1.0f, 1.0f }, { -1.0f, 1.0f }, { 1.0f, -1.0f }, { -1.0f, -1.0f },
+        { -0.0f, 1.0f }, { 0.0f, 0.0f },
+    };
+    for( uint nAxis = 0; nAxis < ARRAY_LENGTH( pAxes ); ++nAxis )
+    {
+        float fY = pAxes[nAxis][0];
+        float fX = pAxes[nAxis][1];
+        Worst.Add( AngleError( Atan2Est( fY, fX ), atan2( (double)fY, (double)fX ) ), fY, fX );
+    }
+    return Report( "Atan2Est", Worst, gs_fAtan2EstBound, true );
+}
+
+//-----------------------------------------------------------------------------
+//  Random inputs
+//  From rand, so every run checks the same cases
+//-----------------------------------------------------------------------------
+static float RandomFloat( float fMin, float fMax )
+{
+    return fMin + ( fMax - fMin ) * ( rand() / (float)RAND_MAX );
+}
+
+static RVector4 RandomPoint( float fRange )
+{
+    return RVector4( RandomFloat( -fRange, fRange ), RandomFloat( -fRange, fRange ), RandomFloat( -fRange, fRange ), 0.0f );
+}
+
+// Unit length, and even over the sphere
+static RVector4 RandomDirection( void )
+{
+    for( ;; )
+    {
+        RVector4 V = RandomPoint( 1.0f );
+        float fLengthSq = V.MagnitudeSquared();
+        if( fLengthSq > 0.01f && fLengthSq <= 1.0f )
+        {
+            return V * ( 1.0f / sqrtf( fLengthSq ) );
+        }
+    }
+}
+
+static RQuaternion RandomOrientation( void )
+{
+    return RQuaternionRotationAxis( RandomDirection(), RandomFloat( -gs_fPi, gs_fPi ) );
+}
+
+//-----------------------------------------------------------------------------
+//  Expect
+//  A yes or no answer counts as an error of 1 when it's wrong. The first
+//  case that was wrong is the one reported
+//-----------------------------------------------------------------------------
+static void Expect( CWorstError* pWorst, bool bResult, bool bExpected, uint nCase )
+{
+    pWorst->Add( bResult == bExpected ? 0.0 : 1.0, (float)nCase );
+}
+
+//-----------------------------------------------------------------------------
+//  Planes
+//  Normalizing has to give a unit normal without moving the plane, so the
+//  distances are compared to the plane before it was normalized, relative
+//  to the size of the terms. RPlaneFromPoints has to go through all three
+//  points, and face the side they wind clockwise from
+//-----------------------------------------------------------------------------
+static uint TestPlanes( void )
+{
+    CWorstError WorstNormalize;
+    CWorstError WorstFromPoints;
+    uint nCases = gs_nSamples / 64;
+    for( uint i = 0; i < nCases; ++i )
+    {
+        RVector4 vNormal = RandomDirection() * RandomFloat( 0.01f, 100.0f );
+        float fD = RandomFloat( -100.0f, 100.0f );
+        RPlane Plane( vNormal.x, vNormal.y, vNormal.z, fD );
+        Plane.Normalize();
+
+        double fLength = sqrt( (double)vNormal.x * vNormal.x + (double)vNormal.y * vNormal.y + (double)vNormal.z * vNormal.z );
+        double fNewLength = sqrt( (double)Plane.a * Plane.a + (double)Plane.b * Plane.b + (double)Plane.c * Plane.c );
+        WorstNormalize.Add( fabs( fNewLength - 1.0 ), vNormal.Magnitude(), fD );
+
+        RVector4 vPoint = RandomPoint( 100.0f );
+        double fExact = ( (double)vNormal.x * vPoint.x + (double)vNormal.y * vPoint.y + (double)vNormal.z * vPoint.z + fD ) / fLength;
+        double fScale = vPoint.Magnitude() + fabs( fD ) / fLength;
+        WorstNormalize.Add( fabs( Plane.Distance( vPoint ) - fExact ) / fScale, vNormal.Magnitude(), fD );
+
+        RVector4 A = RandomPoint( 100.0f );
+        RVector4 B = RandomPoint( 100.0f );
+        RVector4 C = RandomPoint( 100.0f );
+        // Slivers lose too much to the cross product to say anything
+        RVector4 vCross = CrossProduct( B - A, C - A );
+        if( vCross.Magnitude() < 0.1f * ( B - A ).Magnitude() * ( C - A ).Magnitude() )
+            continue;
+        Plane = RPlaneFromPoints( A, B, C );
+        WorstFromPoints.Add( fabs( Plane.Distance( A ) ) / 100.0, (float)i );
+        WorstFromPoints.Add( fabs( Plane.Distance( B ) ) / 100.0, (float)i );
+        WorstFromPoints.Add( fabs( Plane.Distance( C ) ) / 100.0, (float)i );
+        WorstFromPoints.Add( Plane.GetNormal().DotProduct( vCross ) > 0.0f ? 0.0 : 1.0, (float)i );
+    }
+
+    // Seen from -z, ( 0, 0, 0 ), ( 0, 1, 0 ), ( 1, 0, 0 ) go clockwise
+    RPlane Plane = RPlaneFromPoints( RVector4( 0.0f, 0.0f, 0.0f, 0.0f ), RVector4( 0.0f, 1.0f, 0.0f, 0.0f ), RVector4( 1.0f, 0.0f, 0.0f, 0.0f ) );
+    WorstFromPoints.Add( fabs( Plane.Distance( RVector4( 0.0f, 0.0f, -1.0f, 0.0f ) ) - 1.0 ), -1.0f );
+
+    return Report( "RPlane Normalize", WorstNormalize, gs_fPlaneBound, true )
+         + Report( "RPlaneFromPoints", WorstFromPoints, gs_fPlanePointsBound, false );
+}
+
+//-----------------------------------------------------------------------------
+//  Boxes and spheres
+//  Every pair is built to either overlap or be apart, so the answer is
+//  known. Boxes that only touch overlap
+//-----------------------------------------------------------------------------
+static RAABB RandomAABB( const RVector4& vCenter )
+{
+    RVector4 vExtents( RandomFloat( 0.1f, 10.0f ), RandomFloat( 0.1f, 10.0f ), RandomFloat( 0.1f, 10.0f ), 0.0f );
+    return RAABBFromCenterExtents( vCenter, vExtents );
+}
+
+// A point in Box, no more than fScale of the way from the center to a face
+static RVector4 RandomPointIn( const RAABB& Box, float fScale )
+{
+    RVector4 vCenter = Box.GetCenter();
+    RVector4 vExtents = Box.GetExtents();
+    return RVector4( vCenter.x + vExtents.x * RandomFloat( -fScale, fScale ),
+                     vCenter.y + vExtents.y * RandomFloat( -fScale, fScale ),
+                     vCenter.z + vExtents.z * RandomFloat( -fScale, fScale ), 0.0f );
+}
+
+static uint TestAABBsAndSpheres( void )
+{
+    CWorstError WorstBoxes;
+    CWorstError WorstSpheres;
+    CWorstError WorstSphereBox;
+    uint nCases = gs_nSamples / 64;
+    for( uint i = 0; i < nCases; ++i )
+    {
+        uint nAxis = i % 3;
+        bool bBelow = ( i & 4 ) != 0;
+
+        // B is around a point in A
+        RAABB A = RandomAABB( RandomPoint( 100.0f ) );
+        RAABB B = RandomAABB( RandomPointIn( A, 1.0f ) );
+        Expect( &WorstBoxes, Intersect( A, B ), true, i );
+        Expect( &WorstBoxes, Intersect( B, A ), true, i );
+
+        // B is moved off one face of A, or just onto it
+        float fGap = ( i & 8 ) ? 0.0f : RandomFloat( 0.01f, 10.0f );
+        float fSize = B.vMax.f[nAxis] - B.vMin.f[nAxis];
+        if( bBelow )
+        {
+            B.vMax.f[nAxis] = A.vMin.f[nAxis] - fGap;
+            B.vMin.f[nAxis] = B.vMax.f[nAxis] - fSize;
+        }
+        else
+        {
+            B.vMin.f[nAxis] = A.vMax.f[nAxis] + fGap;
+            B.vMax.f[nAxis] = B.vMin.f[nAxis] + fSize;
+        }
+        Expect( &WorstBoxes, Intersect( A, B ), fGap == 0.0f, i );
+        Expect( &WorstBoxes, Intersect( B, A ), fGap == 0.0f, i );
+
+        // Spheres closer and further apart than their radii add up to
+        RSphere SphereA( RandomPoint( 100.0f ), RandomFloat( 0.1f, 10.0f ) );
+        float fRadius = RandomFloat( 0.1f, 10.0f );
+        RVector4 vDirection = RandomDirection() * ( SphereA.fRadius + fRadius );
+        RSphere SphereB( SphereA.vCenter + vDirection * RandomFloat( 0.0f, 0.99f ), fRadius );
+        Expect( &WorstSpheres, Intersect( SphereA, SphereB ), true, i );
+        Expect( &WorstSpheres, Intersect( SphereB, SphereA ), true, i );
+        SphereB = RSphere( SphereA.vCenter + vDirection * RandomFloat( 1.01f, 3.0f ), fRadius );
+        Expect( &WorstSpheres, Intersect( SphereA, SphereB ), false, i );
+        Expect( &WorstSpheres, Intersect( SphereB, SphereA ), false, i );
+
+        // A sphere within its radius of a point in the box, then one off a
+        // face and one off a corner, where the closest point is that corner
+        RSphere Sphere( RandomPointIn( A, 1.0f ) + RandomDirection() * ( fRadius * RandomFloat( 0.0f, 0.99f ) ), fRadius );
+        Expect( &WorstSphereBox, Intersect( Sphere, A ), true, i );
+
+        RVector4 vFace = RandomPointIn( A, 1.0f );
+        vFace.f[nAxis] = bBelow ? A.vMin.f[nAxis] : A.vMax.f[nAxis];
+        Sphere.vCenter = vFace;
+        Sphere.vCenter.f[nAxis] += ( bBelow ? -fRadius : fRadius ) * RandomFloat( 1.01f, 3.0f );
+        Expect( &WorstSphereBox, Intersect( Sphere, A ), false, i );
+
+        RVector4 vCorner( ( i & 1 ) ? A.vMax.x : A.vMin.x, ( i & 2 ) ? A.vMax.y : A.vMin.y, bBelow ? A.vMin.z : A.vMax.z, 0.0f );
+        RVector4 vOut = RandomDirection();
+        vOut = RVector4( ( i & 1 ) ? fabsf( vOut.x ) : -fabsf( vOut.x ),
+                         ( i & 2 ) ? fabsf( vOut.y ) : -fabsf( vOut.y ),
+                         bBelow ? -fabsf( vOut.z ) : fabsf( vOut.z ), 0.0f );
+        Sphere.vCenter = vCorner + vOut * ( fRadius * RandomFloat( 1.01f, 3.0f ) );
+        Expect( &WorstSphereBox, Intersect( Sphere, A ), false, i );
+    }
+    return Report( "Intersect AABBs", WorstBoxes, 0.0, false )
+         + Report( "Intersect spheres", WorstSpheres, 0.0, false )
+         + Report( "Intersect sphere AABB", WorstSphereBox, 0.0, false );
+}
+
+//-----------------------------------------------------------------------------
+//  Oriented boxes
+//  Apart pairs are pushed off along one of A's or B's axes, which only
+//  needs the face axes of the separating axis test. There's also a pair
+//  that only the cross product of two edges separates, turned every which
+//  way
+//-----------------------------------------------------------------------------
+static ROBB RandomOBB( const RVector4& vCenter )
+{
+    RVector4 vExtents( RandomFloat( 0.1f, 10.0f ), RandomFloat( 0.1f, 10.0f ), RandomFloat( 0.1f, 10.0f ), 0.0f );
+    return ROBB( vCenter, vExtents, RandomOrientation() );
+}
+
+static RVector4 RandomPointIn( const ROBB& Box, float fScale )
+{
+    RVector4 pAxes[3];
+    Box.GetAxes( pAxes );
+    return Box.vCenter + pAxes[0] * ( Box.vExtents.x * RandomFloat( -fScale, fScale ) )
+                       + pAxes[1] * ( Box.vExtents.y * RandomFloat( -fScale, fScale ) )
+                       + pAxes[2] * ( Box.vExtents.z * RandomFloat( -fScale, fScale ) );
+}
+
+// How far Box reaches from its center along the unit vAxis
+static float OBBReach( const ROBB& Box, const RVector4& vAxis )
+{
+    RVector4 pAxes[3];
+    Box.GetAxes( pAxes );
+    return Box.vExtents.x * fabsf( vAxis.DotProduct( pAxes[0] ) )
+         + Box.vExtents.y * fabsf( vAxis.DotProduct( pAxes[1] ) )
+         + Box.vExtents.z * fabsf( vAxis.DotProduct( pAxes[2] ) );
+}
+
+static uint TestOBBs( void )
+{
+    static const float fRoot2 = 1.41421356f;
+    const RVector4 vUnit( 1.0f, 1.0f, 1.0f, 0.0f );
+
+    CWorstError WorstFaces;
+    CWorstError WorstEdges;
+    uint nCases = gs_nSamples / 64;
+    for( uint i = 0; i < nCases; ++i )
+    {
+        // B contains a point in A
+        ROBB A = RandomOBB( RandomPoint( 100.0f ) );
+        ROBB B = RandomOBB( RVector4( 0.0f, 0.0f, 0.0f, 0.0f ) );
+        B.vCenter = RandomPointIn( A, 0.99f ) - RandomPointIn( B, 0.99f );
+        Expect( &WorstFaces, Intersect( A, B ), true, i );
+        Expect( &WorstFaces, Intersect( B, A ), true, i );
+
+        // B is pushed along one of the axes until it's past A, then slid
+        // somewhere across it
+        RVector4 pAxes[3];
+        ( i % 6 < 3 ? A : B ).GetAxes( pAxes );
+        RVector4 vAxis = pAxes[i % 3];
+        float fDistance = OBBReach( A, vAxis ) + OBBReach( B, vAxis ) + RandomFloat( 0.05f, 10.0f );
+        RVector4 vSlide = RandomPoint( 10.0f );
+        vSlide = vSlide - vAxis * vSlide.DotProduct( vAxis );
+        B.vCenter = A.vCenter + vAxis * ( ( i & 8 ) ? -fDistance : fDistance ) + vSlide;
+        Expect( &WorstFaces, Intersect( A, B ), false, i );
+        Expect( &WorstFaces, Intersect( B, A ), false, i );
+
+        // A turned 45 degrees about z has an edge along z at x = root 2.
+        // B turned 45 degrees about y, 2 root 2 + fGap along x, has one
+        // along y at x = root 2 + fGap. Only x separates them
+        RQuaternion qTurn = RandomOrientation();
+        RMatrix4x4 mTurn = RMatrix4x4RotationQuaternion( qTurn );
+        float fGap = ( i & 1 ) ? RandomFloat( 0.05f, 0.9f ) : -RandomFloat( 0.05f, 0.9f );
+        RVector4 vCenter = RandomPoint( 100.0f );
+        ROBB EdgeA( vCenter, vUnit, RQuaternionRotationAxis( RVector4( 0.0f, 0.0f, 1.0f, 0.0f ), gs_fPi / 4 ) * qTurn );
+        ROBB EdgeB( vCenter + RVector4( 2 * fRoot2 + fGap, 0.0f, 0.0f, 0.0f ) * mTurn, vUnit,
+                    RQuaternionRotationAxis( RVector4( 0.0f, 1.0f, 0.0f, 0.0f ), gs_fPi / 4 ) * qTurn );
+        Expect( &WorstEdges, Intersect( EdgeA, EdgeB ), fGap < 0.0f, i );
+        Expect( &WorstEdges, Intersect( EdgeB, EdgeA ), fGap < 0.0f, i );
+    }
+    return Report( "Intersect OBBs", WorstFaces, 0.0, false )
+         + Report( "Intersect OBB edges", WorstEdges, 0.0, false );
+}
+
+//-----------------------------------------------------------------------------
+//  The frustum
+//  A camera is put somewhere random, and its planes worked out in double
+//  from the field of view. The planes pulled out of the view projection
+//  matrix have to match them, and the culling tests have to agree with
+//  them, plane by plane. Volumes too close to a plane to call are skipped.
+//  The far plane comes out of the matrix as 1 - far / ( far - near ) times
+//  the camera's z, which loses bits as far / near grows, so its errors are
+//  measured against far * far / near instead of far
+//-----------------------------------------------------------------------------
+struct TestFrustum
+{
+    RFrustum    Frustum;
+    double      pPlanes[eNUMFRUSTUMPLANES][4];
+    double      pScales[eNUMFRUSTUMPLANES];     // What each plane's errors are relative to
+    RVector4    vEye;
+    RVector4    pAxes[3];   // The camera's x, y and z
+    float       fWidth;     // x / z at the right plane
+    float       fHeight;    // y / z at the top plane
+    float       fFar;
+};
+
+static void RandomFrustum( TestFrustum* pTest )
+{
+    float fFovY = RandomFloat( 0.5f, 2.0f );
+    float fAspect = RandomFloat( 0.5f, 2.0f );
+    float fNear = RandomFloat( 0.1f, 1.0f );
+    float fFar = RandomFloat( 50.0f, 500.0f );
+    RVector4 vEye = RandomPoint( 100.0f );
+    RVector4 vDirection = RandomDirection();
+    while( fabsf( vDirection.y ) > 0.9f )
+    {
+        vDirection = RandomDirection();
+    }
+    RVector4 vUp( 0.0f, 1.0f, 0.0f, 0.0f );
+    RMatrix4x4 mViewProj = RMatrix4x4LookToLH( vEye, vDirection, vUp ) * RMatrix4x4PerspectiveFovLH( fFovY, fAspect, fNear, fFar );
+    pTest->Frustum = RFrustumFromMatrix( mViewProj );
+
+    // The camera's axes, the same way RMatrix4x4LookToLH makes them
+    double pAxes[3][3];
+    double fLength = sqrt( (double)vDirection.x * vDirection.x + (double)vDirection.y * vDirection.y + (double)vDirection.z * vDirection.z );
+    pAxes[2][0] = vDirection.x / fLength;
+    pAxes[2][1] = vDirection.y / fLength;
+    pAxes[2][2] = vDirection.z / fLength;
+    fLength = sqrt( pAxes[2][2] * pAxes[2][2] + pAxes[2][0] * pAxes[2][0] );
+    pAxes[0][0] = pAxes[2][2] / fLength;
+    pAxes[0][1] = 0.0;
+    pAxes[0][2] = -pAxes[2][0] / fLength;
+    pAxes[1][0] = pAxes[2][1] * pAxes[0][2] - pAxes[2][2] * pAxes[0][1];
+    pAxes[1][1] = pAxes[2][2] * pAxes[0][0] - pAxes[2][0] * pAxes[0][2];
+    pAxes[1][2] = pAxes[2][0] * pAxes[0][1] - pAxes[2][1] * pAxes[0][0];
+
+    // Each plane in view space, then in world space
+    double fHeight = 1.0 / tan( fFovY * 0.5 );
+    double fWidth = fHeight / fAspect;
+    double pViewPlanes[eNUMFRUSTUMPLANES][4] =
+    {
+        { fWidth, 0.0, 1.0, 0.0 },
+        { -fWidth, 0.0, 1.0, 0.0 },
+        { 0.0, fHeight, 1.0, 0.0 },
+        { 0.0, -fHeight, 1.0, 0.0 },
+        { 0.0, 0.0, 1.0, -fNear },
+        { 0.0, 0.0, -1.0, fFar },
+    };
+    for( uint nPlane = 0; nPlane < eNUMFRUSTUMPLANES; ++nPlane )
+    {
+        const double* pView = pViewPlanes[nPlane];
+        double fScale = 1.0 / sqrt( pView[0] * pView[0] + pView[1] * pView[1] + pView[2] * pView[2] );
+        double* pPlane = pTest->pPlanes[nPlane];
+        for( uint nAxis = 0; nAxis < 3; ++nAxis )
+        {
+            pPlane[nAxis] = ( pView[0] * pAxes[0][nAxis] + pView[1] * pAxes[1][nAxis] + pView[2] * pAxes[2][nAxis] ) * fScale;
+        }
+        pPlane[3] = pView[3] * fScale - ( pPlane[0] * vEye.x + pPlane[1] * vEye.y + pPlane[2] * vEye.z );
+        pTest->pScales[nPlane] = nPlane == eFrustumFar ? (double)fFar * fFar / fNear : fFar;
+    }
+
+    pTest->vEye = vEye;
+    for( uint nAxis = 0; nAxis < 3; ++nAxis )
+    {
+        pTest->pAxes[nAxis] = RVector4( (float)pAxes[nAxis][0], (float)pAxes[nAxis][1], (float)pAxes[nAxis][2], 0.0f );
+    }
+    pTest->fWidth = (float)fWidth;
+    pTest->fHeight = (float)fHeight;
+    pTest->fFar = fFar;
+}
+
+// Anywhere from just behind the camera to just past the far plane, and a
+// bit either side of the frustum
+static RVector4 RandomPointNear( const TestFrustum& Test )
+{
+    float fZ = RandomFloat( -0.1f, 1.1f ) * Test.fFar;
+    float fX = RandomFloat( -1.3f, 1.3f ) * ( fabsf( fZ ) / Test.fWidth + 1.0f );
+    float fY = RandomFloat( -1.3f, 1.3f ) * ( fabsf( fZ ) / Test.fHeight + 1.0f );
+    return Test.vEye + Test.pAxes[0] * fX + Test.pAxes[1] * fY + Test.pAxes[2] * fZ;
+}
+
+static double PlaneDistance( const double* pPlane, const RVector4& vPoint )
+{
+    return pPlane[0] * vPoint.x + pPlane[1] * vPoint.y + pPlane[2] * vPoint.z + pPlane[3];
+}
+
+static double PlaneReach( const double* pPlane, const RVector4& vAxis, float fExtent )
+{
+    return fabs( pPlane[0] * vAxis.x + pPlane[1] * vAxis.y + pPlane[2] * vAxis.z ) * fExtent;
+}
+
+//-----------------------------------------------------------------------------
+//  FrustumAnswer
+//  pInside is how far inside each plane the volume reaches. Returns 1 if
+//  it's inside them all, 0 if it's outside one, and -1 if it's too close
+//  to a plane to call
+//-----------------------------------------------------------------------------
+static int FrustumAnswer( const TestFrustum& Test, const double* pInside )
+{
+    bool bClose = false;
+    for( uint nPlane = 0; nPlane < eNUMFRUSTUMPLANES; ++nPlane )
+    {
+        double fMargin = gs_fFrustumBound * 10.0 * Test.pScales[nPlane];
+        if( pInside[nPlane] < -fMargin )
+            return 0;
+        bClose = bClose || pInside[nPlane] <= fMargin;
+    }
+    return bClose ? -1 : 1;
+}
+
+static int CullSphere( const TestFrustum& Test, const RVector4& vCenter, float fRadius )
+{
+    double pInside[eNUMFRUSTUMPLANES];
+    for( uint nPlane = 0; nPlane < eNUMFRUSTUMPLANES; ++nPlane )
+    {
+        pInside[nPlane] = PlaneDistance( Test.pPlanes[nPlane], vCenter ) + fRadius;
+    }
+    return FrustumAnswer( Test, pInside );
+}
+
+// Boxes reach along each plane's normal as far as their extents projected
+// on it
+static int CullBox( const TestFrustum& Test, const RVector4& vCenter, const RVector4* pAxes, const RVector4& vExtents )
+{
+    double pInside[eNUMFRUSTUMPLANES];
+    for( uint nPlane = 0; nPlane < eNUMFRUSTUMPLANES; ++nPlane )
+    {
+        const double* pPlane = Test.pPlanes[nPlane];
+        pInside[nPlane] = PlaneDistance( pPlane, vCenter );
+        for( uint nAxis = 0; nAxis < 3; ++nAxis )
+        {
+            pInside[nPlane] += PlaneReach( pPlane, pAxes[nAxis], vExtents.f[nAxis] );
+        }
+    }
+    return FrustumAnswer( Test, pInside );
+}
+
+static uint TestFrustums( void )
+{
+    static const RVector4 pWorldAxes[3] =
+    {
+        RVector4( 1.0f, 0.0f, 0.0f, 0.0f ), RVector4( 0.0f, 1.0f, 0.0f, 0.0f ), RVector4( 0.0f, 0.0f, 1.0f, 0.0f ),
+    };
+
+    CWorstError WorstPlanes;
+    CWorstError WorstSpheres;
+    CWorstError WorstAABBs;
+    CWorstError WorstOBBs;
+    uint nCases = gs_nSamples / 4096;
+    for( uint nFrustum = 0; nFrustum < 64; ++nFrustum )
+    {
+        TestFrustum Test;
+        RandomFrustum( &Test );
+        for( uint nPlane = 0; nPlane < eNUMFRUSTUMPLANES; ++nPlane )
+        {
+            WorstPlanes.Add( fabs( Test.Frustum.Planes[nPlane].GetNormal().Magnitude() - 1.0 ), (float)nFrustum );
+        }
+
+        for( uint i = 0; i < nCases; ++i )
+        {
+            uint nCase = nFrustum * nCases + i;
+            RVector4 vPoint = RandomPointNear( Test );
+            for( uint nPlane = 0; nPlane < eNUMFRUSTUMPLANES; ++nPlane )
+            {
+                double fExact = PlaneDistance( Test.pPlanes[nPlane], vPoint );
+                WorstPlanes.Add( fabs( Test.Frustum.Planes[nPlane].Distance( vPoint ) - fExact ) / Test.pScales[nPlane], (float)nCase );
+            }
+
+            RSphere Sphere( vPoint, RandomFloat( 0.001f, 0.05f ) * Test.fFar );
+            int nAnswer = CullSphere( Test, Sphere.vCenter, Sphere.fRadius );
+            if( nAnswer >= 0 )
+            {
+                Expect( &WorstSpheres, Intersect( Test.Frustum, Sphere ), nAnswer == 1, nCase );
+            }
+
+            RAABB Box = RandomAABB( vPoint );
+            nAnswer = CullBox( Test, vPoint, pWorldAxes, Box.GetExtents() );
+            if( nAnswer >= 0 )
+            {
+                Expect( &WorstAABBs, Intersect( Test.Frustum, Box ), nAnswer == 1, nCase );
+            }
+
+            ROBB OBB = RandomOBB( vPoint );
+            RVector4 pAxes[3];
+            OBB.GetAxes( pAxes );
+            nAnswer = CullBox( Test, vPoint, pAxes, OBB.vExtents );
+            if( nAnswer >= 0 )
+            {
+                Expect( &WorstOBBs, Intersect( Test.Frustum, OBB ), nAnswer == 1, nCase );
+            }
+        }
+    }
+    return Report( "RFrustumFromMatrix", WorstPlanes, gs_fFrustumBound, false )
+         + Report( "Intersect frustum sphere", WorstSpheres, 0.0, false )
+         + Report( "Intersect frustum AABB", WorstAABBs, 0.0, false )
+         + Report( "Intersect frustum OBB", WorstOBBs, 0.0, false );
+}
+
+//-----------------------------------------------------------------------------
+//  Rays
+//  The slab test again in double, with rays parallel to a slab handled
+//  apart. Returns where the ray enters Box, or -1 if it misses. *pMargin
+//  is how close it came to the other answer, so the close calls can be
+//  left out
+//-----------------------------------------------------------------------------
+static double RayAABB( const RVector4& vOrigin, const RVector4& vDirection, const RAABB& Box, double* pMargin )
+{
+    double fEnter = 0.0;
+    double fExit = DBL_MAX;
+    double fMargin = DBL_MAX;
+    bool bMissed = false;
+    for( uint nAxis = 0; nAxis < 3; ++nAxis )
+    {
+        double fOrigin = vOrigin.f[nAxis];
+        double fMin = Box.vMin.f[nAxis];
+        double fMax = Box.vMax.f[nAxis];
+        if( vDirection.f[nAxis] == 0.0f )
+        {
+            bMissed = bMissed || fOrigin < fMin || fOrigin > fMax;
+            fMargin = fabs( fOrigin - fMin ) < fMargin ? fabs( fOrigin - fMin ) : fMargin;
+            fMargin = fabs( fOrigin - fMax ) < fMargin ? fabs( fOrigin - fMax ) : fMargin;
+            continue;
+        }
+        double fT1 = ( fMin - fOrigin ) / vDirection.f[nAxis];
+        double fT2 = ( fMax - fOrigin ) / vDirection.f[nAxis];
+        double fNear = fT1 < fT2 ? fT1 : fT2;
+        double fFar = fT1 < fT2 ? fT2 : fT1;
+        fEnter = fNear > fEnter ? fNear : fEnter;
+        fExit = fFar < fExit ? fFar : fExit;
+    }
+    if( !bMissed )
+    {
+        fMargin = fabs( fExit - fEnter ) < fMargin ? fabs( fExit - fEnter ) : fMargin;
+    }
+    *pMargin = fMargin;
+    return !bMissed && fEnter <= fExit ? fEnter : -1.0;
+}
+
+// How far off where the ray enters is, relative to fScale, or 1 if it
+// should have missed or hit
+static double RayError( float fT, bool bHit, double fExact, double fScale )
+{
+    if( bHit != ( fExact >= 0.0 ) )
+        return 1.0;
+    return bHit ? fabs( fT - fExact ) / fScale : 0.0;
+}
+
+//-----------------------------------------------------------------------------
+//  IntersectRay
+//  Rays aimed at a point in the box hit it, from inside at 0. Rays pointed
+//  away from a face, or along it but outside, miss. Some of the rays run
+//  along the axes, so the infinities from dividing by 0 get checked
+//-----------------------------------------------------------------------------
+static uint TestRays( void )
+{
+    CWorstError Worst;
+    uint nCases = gs_nSamples / 64;
+    for( uint i = 0; i < nCases; ++i )
+    {
+        uint nAxis = i % 3;
+        bool bBelow = ( i & 4 ) != 0;
+        RAABB Box = RandomAABB( RandomPoint( 100.0f ) );
+        RVector4 vTarget = RandomPointIn( Box, 0.99f );
+
+        RVector4 vOrigin = RandomPoint( 150.0f );
+        RVector4 vDirection = vTarget - vOrigin;
+        if( i & 8 )
+        {   // Along an axis, from outside the box in line with the target
+            vOrigin = vTarget;
+            vOrigin.f[nAxis] = bBelow ? Box.vMin.f[nAxis] - RandomFloat( 0.01f, 50.0f ) : Box.vMax.f[nAxis] + RandomFloat( 0.01f, 50.0f );
+            vDirection = RVector4( 0.0f, 0.0f, 0.0f, 0.0f );
+            vDirection.f[nAxis] = bBelow ? 1.0f : -1.0f;
+        }
+        vDirection = vDirection * RandomFloat( 0.1f, 10.0f );
+
+        float fT = -1.0f;
+        double fMargin;
+        double fExact = RayAABB( vOrigin, vDirection, Box, &fMargin );
+        double fScale = ( ( Box.vMax - Box.vMin ).Magnitude() + ( Box.GetCenter() - vOrigin ).Magnitude() ) / vDirection.Magnitude();
+        if( fMargin > fScale * 1e-3 )
+        {
+            Worst.Add( RayError( fT, IntersectRay( Box, vOrigin, vDirection, &fT ), fExact, fScale ), (float)i );
+        }
+
+        // From the target itself
+        fT = -1.0f;
+        Worst.Add( IntersectRay( Box, vTarget, vDirection, &fT ) && fT == 0.0f ? 0.0 : 1.0, (float)i );
+
+        // From off a face, pointed further away, or along the face
+        vOrigin = RandomPointIn( Box, 1.0f );
+        vOrigin.f[nAxis] = bBelow ? Box.vMin.f[nAxis] - RandomFloat( 0.01f, 50.0f ) : Box.vMax.f[nAxis] + RandomFloat( 0.01f, 50.0f );
+        vDirection = RandomDirection();
+        vDirection.f[nAxis] = ( i & 8 ) ? 0.0f : ( bBelow ? -fabsf( vDirection.f[nAxis] ) : fabsf( vDirection.f[nAxis] ) );
+        if( vDirection.Magnitude() > 0.01f )
+        {
+            Worst.Add( IntersectRay( Box, vOrigin, vDirection, &fT ) ? 1.0 : 0.0, (float)i );
+        }
+    }
+    return Report( "IntersectRay AABB", Worst, gs_fRayBound, false );
+}
+
+//-----------------------------------------------------------------------------
+//  The batch kernels
+//  Run on every instruction set the CPU has, against the same answers as
+//  the single tests. Each also has to give what scalar gave, and count
+//  what passed, a wrong count showing up as case -1. The streams are an
+//  odd length, so the scalar tails get used too
+//-----------------------------------------------------------------------------
+static uint ReportISAs( const char* szName, const CWorstError* pWorst, double fBound )
+{
+    uint nFailures = 0;
+    eMathISA nBestISA = MathGetBestISA();
+    for( uint nISA = 0; nISA <= (uint)nBestISA; ++nISA )
+    {
+        if( MathSetISA( (eMathISA)nISA ) != (eMathISA)nISA )
+            continue;
+        char szISAName[64];
+        sprintf_s( szISAName, sizeof( szISAName ), "%s %s", szName, MathGetISAName( (eMathISA)nISA ) );
+        nFailures += Report( szISAName, pWorst[nISA], fBound, false );
+    }
+    MathSetISA( nBestISA );
+    return nFailures;
+}
+
+static uint TestBatchKernels( void )
+{
+    CWorstError pWorstCull[eNUMMATHISAS];
+    CWorstError pWorstOverlap[eNUMMATHISAS];
+    CWorstError pWorstRays[eNUMMATHISAS];
+    eMathISA nBestISA = MathGetBestISA();
+
+    uint nCount = gs_nSamples / 64 + 7;
+    RVec3Stream Points( nCount );
+    RVec3Stream Mins( nCount );
+    RVec3Stream Maxs( nCount );
+    float* pRadii = new float[nCount];
+    uint8* pExpected = new uint8[nCount];
+    uint8* pResults = new uint8[nCount];
+    uint8* pScalarResults = new uint8[nCount];
+
+    // Spheres against a frustum, none of them too close to call
+    TestFrustum Test;
+    RandomFrustum( &Test );
+    uint nExpected = 0;
+    for( uint i = 0; i < nCount; ++i )
+    {
+        RVector4 vCenter( 0.0f, 0.0f, 0.0f, 0.0f );
+        int nAnswer = -1;
+        while( nAnswer < 0 )
+        {
+            vCenter = RandomPointNear( Test );
+            pRadii[i] = RandomFloat( 0.001f, 0.05f ) * Test.fFar;
+            nAnswer = CullSphere( Test, vCenter, pRadii[i] );
+        }
+        Points.Set( i, RVector3( vCenter.x, vCenter.y, vCenter.z ) );
+        pExpected[i] = (uint8)nAnswer;
+        nExpected += pExpected[i];
+    }
+    for( uint nISA = 0; nISA <= (uint)nBestISA; ++nISA )
+    {
+        if( MathSetISA( (eMathISA)nISA ) != (eMathISA)nISA )
+            continue;
+        uint nVisible = StreamCullSpheres( Test.Frustum, Points, pRadii, pResults );
+        if( nISA == eMathISAScalar )
+        {
+            memcpy( pScalarResults, pResults, nCount );
+        }
+        pWorstCull[nISA].Add( nVisible == nExpected ? 0.0 : 1.0, -1.0f );
+        for( uint i = 0; i < nCount; ++i )
+        {
+            Expect( &pWorstCull[nISA], pResults[i] == pExpected[i], true, i );
+            Expect( &pWorstCull[nISA], pResults[i] == pScalarResults[i], true, i );
+        }
+    }
+
+    // Boxes on a grid, so plenty of them touch
+    RAABB Box( RVector4( (float)( rand() % 9 - 8 ), (float)( rand() % 9 - 8 ), (float)( rand() % 9 - 8 ), 0.0f ),
+               RVector4( (float)( rand() % 9 ), (float)( rand() % 9 ), (float)( rand() % 9 ), 0.0f ) );
+    nExpected = 0;
+    for( uint i = 0; i < nCount; ++i )
+    {
+        RVector3 vMin( (float)( rand() % 25 - 12 ), (float)( rand() % 25 - 12 ), (float)( rand() % 25 - 12 ) );
+        RVector3 vMax( vMin.x + rand() % 8, vMin.y + rand() % 8, vMin.z + rand() % 8 );
+        Mins.Set( i, vMin );
+        Maxs.Set( i, vMax );
+        bool bOverlaps = vMin.x <= Box.vMax.x && Box.vMin.x <= vMax.x
+                      && vMin.y <= Box.vMax.y && Box.vMin.y <= vMax.y
+                      && vMin.z <= Box.vMax.z && Box.vMin.z <= vMax.z;
+        pExpected[i] = bOverlaps ? 1 : 0;
+        nExpected += pExpected[i];
+    }
+    for( uint nISA = 0; nISA <= (uint)nBestISA; ++nISA )
+    {
+        if( MathSetISA( (eMathISA)nISA ) != (eMathISA)nISA )
+            continue;
+        uint nOverlapping = StreamOverlapAABBs( Box, Mins, Maxs, pResults );
+        if( nISA == eMathISAScalar )
+        {
+            memcpy( pScalarResults, pResults, nCount );
+        }
+        pWorstOverlap[nISA].Add( nOverlapping == nExpected ? 0.0 : 1.0, -1.0f );
+        for( uint i = 0; i < nCount; ++i )
+        {
+            Expect( &pWorstOverlap[nISA], pResults[i] == pExpected[i], true, i );
+            Expect( &pWorstOverlap[nISA], pResults[i] == pScalarResults[i], true, i );
+        }
+    }
+
+    // A few rays, some along the axes or in the planes between them, against
+    // boxes half of which are put in their way. The entry points are
+    // compared relative to the size of the scene
+    float* pExactT = new float[nCount];
+    float* pT = new float[nCount];
+    float* pScalarT = new float[nCount];
+    for( uint nRay = 0; nRay < 8; ++nRay )
+    {
+        RVector4 vOrigin = RandomPoint( 150.0f );
+        RVector4 vDirection = RandomDirection();
+        if( nRay % 4 < 2 )
+        {
+            vDirection.f[nRay % 3] = 0.0f;
+            vDirection.f[( nRay + 1 ) % 3] = nRay % 4 == 0 ? 0.0f : vDirection.f[( nRay + 1 ) % 3];
+            vDirection = Normalize( vDirection );
+        }
+
+        nExpected = 0;
+        for( uint i = 0; i < nCount; ++i )
+        {
+            RAABB Target;
+            double fExact = 0.0;
+            double fMargin = 0.0;
+            while( fMargin <= 1e-3 )
+            {
+                RVector4 vCenter = ( i & 1 ) ? RandomPoint( 100.0f ) : vOrigin + vDirection * RandomFloat( -50.0f, 200.0f ) + RandomPoint( 5.0f );
+                Target = RandomAABB( vCenter );
+                fExact = RayAABB( vOrigin, vDirection, Target, &fMargin );
+            }
+            Mins.Set( i, RVector3( Target.vMin.x, Target.vMin.y, Target.vMin.z ) );
+            Maxs.Set( i, RVector3( Target.vMax.x, Target.vMax.y, Target.vMax.z ) );
+            pExactT[i] = (float)fExact;
+            nExpected += fExact >= 0.0 ? 1 : 0;
+        }
+        for( uint nISA = 0; nISA <= (uint)nBestISA; ++nISA )
+        {
+            if( MathSetISA( (eMathISA)nISA ) != (eMathISA)nISA )
+                continue;
+            uint nHits = StreamIntersectRayAABBs( vOrigin, vDirection, Mins, Maxs, pT );
+            if( nISA == eMathISAScalar )
+            {
+                memcpy( pScalarT, pT, nCount * sizeof( float ) );
+            }
+            pWorstRays[nISA].Add( nHits == nExpected ? 0.0 : 1.0, -1.0f );
+            for( uint i = 0; i < nCount; ++i )
+            {
+                uint nCase = nRay * nCount + i;
+                pWorstRays[nISA].Add( RayError( pT[i], pT[i] >= 0.0f, pExactT[i], 100.0 ), (float)nCase );
+                pWorstRays[nISA].Add( RayError( pT[i], pT[i] >= 0.0f, pScalarT[i], 100.0 ), (float)nCase );
+            }
+        }
+    }
+    MathSetISA( nBestISA );
+
+    delete [] pRadii;
+    delete [] pExpected;
+    delete [] pResults;
+    delete [] pScalarResults;
+    delete [] pExactT;
+    delete [] pT;
+    delete [] pScalarT;
+
+    return ReportISAs( "StreamCullSpheres", pWorstCull, 0.0 )
+         + ReportISAs( "StreamOverlapAABBs", pWorstOverlap, 0.0 )
+         + ReportISAs( "StreamIntersectRayAABBs", pWorstRays, gs_fRayBound );
+}
+
+//-----------------------------------------------------------------------------
+//  Half floats
+//  Checked against conversions done the slow way in double: a half is its
+//  mantissa times a power of 2, and rounding goes to the nearest step, or
+//  the even one on a tie. Every half is converted to a float and back,
+//  then floats are swept across every exponent, including the denormals,
+//  infinities and NaNs, along with every tie between two halves and the
+//  floats either side of it. A NaN only has to stay a NaN with its sign
+//-----------------------------------------------------------------------------
+static uint32 FloatBits( float F )
+{
+    uint32 nBits;
+    memcpy( &nBits, &F, sizeof( nBits ) );
+    return nBits;
+}
+
+static float BitsFloat( uint32 nBits )
+{
+    float F;
+    memcpy( &F, &nBits, sizeof( F ) );
+    return F;
+}
+
+static bool IsNaN( float F )
+{
+    return ( FloatBits( F ) & 0x7FFFFFFF ) > 0x7F800000;
+}
+
+static bool IsNaN( RHalf H )
+{
+    return ( H & 0x7FFF ) > 0x7C00;
+}
+
+static bool FloatMatches( float F, float fExpected )
+{
+    if( IsNaN( fExpected ) )
+        return IsNaN( F ) && ( FloatBits( F ) >> 31 ) == ( FloatBits( fExpected ) >> 31 );
+    return FloatBits( F ) == FloatBits( fExpected );
+}
+
+static bool HalfMatches( RHalf H, RHalf nExpected )
+{
+    if( IsNaN( nExpected ) )
+        return IsNaN( H ) && ( H & 0x8000 ) == ( nExpected & 0x8000 );
+    return H == nExpected;
+}
+
+static float ReferenceHalfToFloat( RHalf H )
+{
+    uint32 nSign = (uint32)( H & 0x8000 ) << 16;
+    uint nExponent = ( H >> 10 ) & 0x1F;
+    uint nMantissa = H & 0x3FF;
+    if( nExponent == 0x1F )
+        return BitsFloat( nSign | 0x7F800000 | ( nMantissa << 13 ) );
+
+    double fValue = nExponent == 0 ? ldexp( (double)nMantissa, -24 ) : ldexp( (double)( nMantissa + 1024 ), (int)nExponent - 25 );
+    return nSign ? -(float)fValue : (float)fValue;
+}
+
+static RHalf ReferenceFloatToHalf( float F )
+{
+    RHalf nSign = (RHalf)( ( FloatBits( F ) >> 16 ) & 0x8000 );
+    if( IsNaN( F ) )
+        return nSign | 0x7E00;
+    double fAbs = fabs( (double)F );
+    if( fAbs == 0.0 )
+        return nSign;
+    if( fAbs > 65504.0 * 2.0 )
+        return nSign | 0x7C00;
+
+    // Normal halves have 11 significant bits, denormals are steps of 2^-24.
+    // A normal's exponent field is its step's exponent + 25, and a
+    // mantissa that rounds up to 2048 carries into it, up to infinity
+    int nExponent;
+    frexp( fAbs, &nExponent );
+    int nStepExponent = nExponent - 11 < -24 ? -24 : nExponent - 11;
+    double fSteps = ldexp( fAbs, -nStepExponent );
+    double fRounded = floor( fSteps );
+    double fFraction = fSteps - fRounded;
+    if( fFraction > 0.5 || ( fFraction == 0.5 && fmod( fRounded, 2.0 ) != 0.0 ) )
+    {
+        fRounded += 1.0;
+    }
+
+    uint nHalf = (uint)fRounded;
+    if( nStepExponent > -24 )
+    {
+        nHalf = ( (uint)( nStepExponent + 25 ) << 10 ) + nHalf - 1024;
+    }
+    return nSign | (RHalf)( nHalf < 0x7C00 ? nHalf : 0x7C00 );
+}
+
+//-----------------------------------------------------------------------------
+//  GetHalfTestFloats
+//  The sweep, every tie and the floats either side of them, both signs,
+//  and a few that are easy to get wrong. Returns how many
+//-----------------------------------------------------------------------------
+static uint GetHalfTestFloats( float* pFloats, uint nMaxFloats )
+{
+    static const float pSpecial[] =
+    {
+        0.0f, 1.0f, 65504.0f, 65519.996f, 65520.0f, 65536.0f, FLT_MAX,
+        6.1035156e-05f,     // 2^-14, the smallest normal half
+        6.0975552e-05f,     // The largest denormal half
+        5.9604645e-08f,     // 2^-24, the smallest denormal half
+        2.9802322e-08f,     // 2^-25, a tie with 0
+        4.4703484e-08f,     // 3 * 2^-26, rounds up to 2^-24
+        FLT_MIN, 1e-45f,
+    };
+
+    uint nFloats = 0;
+    for( uint i = 0; i < ARRAY_LENGTH( pSpecial ); ++i )
+    {
+        pFloats[nFloats++] = pSpecial[i];
+        pFloats[nFloats++] = -pSpecial[i];
+    }
+    pFloats[nFloats++] = BitsFloat( 0x7F800000 );   // Infinity
+    pFloats[nFloats++] = BitsFloat( 0xFF800000 );
+    pFloats[nFloats++] = BitsFloat( 0x7FC00000 );   // Quiet NaN
+    pFloats[nFloats++] = BitsFloat( 0xFF800001 );   // Signaling NaN
+
+    for( uint nHalf = 0; nHalf < 0x7C00; ++nHalf )
+    {
+        float fTie = (float)( ( (double)ReferenceHalfToFloat( (RHalf)nHalf ) + ReferenceHalfToFloat( (RHalf)( nHalf + 1 ) ) ) * 0.5 );
+        float pNear[3] = { fTie, BitsFloat( FloatBits( fTie ) - 1 ), BitsFloat( FloatBits( fTie ) + 1 ) };
+        for( uint i = 0; i < 3 && nFloats + 2 <= nMaxFloats; ++i )
+        {
+            pFloats[nFloats++] = pNear[i];
+            pFloats[nFloats++] = -pNear[i];
+        }
+    }
+
+    uint64 nStep = ( (uint64)1 << 32 ) / gs_nSamples;
+    for( uint64 nBits = 0x1234; nBits < ( (uint64)1 << 32 ) && nFloats < nMaxFloats; nBits += nStep )
+    {
+        pFloats[nFloats++] = BitsFloat( (uint32)nBits );
+    }
+    return nFloats;
+}
+
+static uint TestHalfs( void )
+{
+    CWorstError WorstToFloat;
+    CWorstError WorstToHalf;
+    CWorstError WorstHalf4;
+    for( uint nHalf = 0; nHalf < 0x10000; ++nHalf )
+    {
+        RHalf H = (RHalf)nHalf;
+        float fExact = ReferenceHalfToFloat( H );
+        WorstToFloat.Add( FloatMatches( HalfToFloat( H ), fExact ) ? 0.0 : 1.0, (float)nHalf );
+        WorstToHalf.Add( HalfMatches( FloatToHalf( fExact ), H ) ? 0.0 : 1.0, fExact );
+
+        RHalf4 Half4;
+        Half4.x = Half4.y = Half4.z = Half4.w = H;
+        WorstHalf4.Add( FloatMatches( Half4.ToVector4().z, fExact ) ? 0.0 : 1.0, (float)nHalf );
+    }
+
+    uint nMaxFloats = 6 * 0x7C00 + gs_nSamples + 64;
+    float* pFloats = new float[nMaxFloats];
+    uint nFloats = GetHalfTestFloats( pFloats, nMaxFloats );
+    for( uint i = 0; i < nFloats; ++i )
+    {
+        float F = pFloats[i];
+        RHalf nExpected = ReferenceFloatToHalf( F );
+        WorstToHalf.Add( HalfMatches( FloatToHalf( F ), nExpected ) ? 0.0 : 1.0, F );
+
+        RHalf4 Half4( F, -F, F, F );
+        WorstHalf4.Add( HalfMatches( Half4.x, nExpected ) ? 0.0 : 1.0, F );
+        WorstHalf4.Add( HalfMatches( Half4.y, ReferenceFloatToHalf( -F ) ) ? 0.0 : 1.0, -F );
+    }
+    delete [] pFloats;
+
+    return Report( "HalfToFloat", WorstToFloat, 0.0, false )
+         + Report( "FloatToHalf", WorstToHalf, 0.0, false )
+         + Report( "RHalf4", WorstHalf4, 0.0, false );
+}
+
+//-----------------------------------------------------------------------------
+//  The half stream kernels
+//  Every half, and the same floats as above, on every instruction set the
+//  CPU has. They have to give what HalfToFloat and FloatToHalf give, and
+//  what the scalar kernels gave
+//-----------------------------------------------------------------------------
+static uint TestHalfStreams( void )
+{
+    CWorstError pWorstToFloats[eNUMMATHISAS];
+    CWorstError pWorstToHalfs[eNUMMATHISAS];
+    eMathISA nBestISA = MathGetBestISA();
+
+    // Every half, with the first few again so the length is odd
+    uint nHalfs = 0x10000 + 7;
+    RHalf* pHalfs = new RHalf[nHalfs];
+    float* pToFloats = new float[nHalfs];
+    float* pScalarToFloats = new float[nHalfs];
+    for( uint i = 0; i < nHalfs; ++i )
+    {
+        pHalfs[i] = (RHalf)i;
+    }
+
+    uint nMaxFloats = 6 * 0x7C00 + gs_nSamples + 64;
+    float* pFloats = new float[nMaxFloats];
+    uint nFloats = GetHalfTestFloats( pFloats, nMaxFloats ) | 1;
+    RHalf* pToHalfs = new RHalf[nFloats];
+    RHalf* pScalarToHalfs = new RHalf[nFloats];
+
+    for( uint nISA = 0; nISA <= (uint)nBestISA; ++nISA )
+    {
+        if( MathSetISA( (eMathISA)nISA ) != (eMathISA)nISA )
+            continue;
+        StreamHalfsToFloats( pHalfs, pToFloats, nHalfs );
+        StreamFloatsToHalfs( pFloats, pToHalfs, nFloats );
+        if( nISA == eMathISAScalar )
+        {
+            memcpy( pScalarToFloats, pToFloats, nHalfs * sizeof( float ) );
+            memcpy( pScalarToHalfs, pToHalfs, nFloats * sizeof( RHalf ) );
+        }
+        for( uint i = 0; i < nHalfs; ++i )
+        {
+            bool bMatches = FloatMatches( pToFloats[i], HalfToFloat( pHalfs[i] ) ) && FloatMatches( pToFloats[i], pScalarToFloats[i] );
+            pWorstToFloats[nISA].Add( bMatches ? 0.0 : 1.0, (float)pHalfs[i] );
+        }
+        for( uint i = 0; i < nFloats; ++i )
+        {
+            bool bMatches = HalfMatches( pToHalfs[i], FloatToHalf( pFloats[i] ) ) && HalfMatches( pToHalfs[i], pScalarToHalfs[i] );
+            pWorstToHalfs[nISA].Add( bMatches ? 0.0 : 1.0, pFloats[i] );
+        }
+    }
+    MathSetISA( nBestISA );
+
+    delete [] pHalfs;
+    delete [] pToFloats;
+    delete [] pScalarToFloats;
+    delete [] pFloats;
+    delete [] pToHalfs;
+    delete [] pScalarToHalfs;
+
+    return ReportISAs( "StreamHalfsToFloats", pWorstToFloats, 0.0 )
+         + ReportISAs( "StreamFloatsToHalfs", pWorstToHalfs, 0.0 );
+}
+
+//-----------------------------------------------------------------------------
+//  Normalized integers
+//  Errors are in steps of the format. Packing has to give the step nearest
+//  the clamped value, which is never more than half a step off, and every
+//  packed value has to unpack to its step and pack back to itself. The
+//  bulk packers have to match packing one at a time, and a mismatch is an
+//  error of a whole step
+//-----------------------------------------------------------------------------
+static void AddNormError( CWorstError* pWorst, uint nStep, float F, float fMin, float fScale )
+{
+    double fClamped = F < fMin ? fMin : ( F > 1.0f ? 1.0 : (double)F );
+    pWorst->Add( fabs( (double)(int)nStep - fClamped * fScale ), F );
+}
+
+static uint TestNorms( void )
+{
+    static const float pSpecial[] = { -1e30f, -2.0f, -1.0f, -0.0f, 0.0f, 1.0f, 2.0f, 1e30f };
+
+    CWorstError Worst8;
+    CWorstError Worst16;
+    CWorstError Worst1010102;
+
+    // Packing, from a bit past -1 to a bit past 1, then the out of range
+    // values including infinity
+    uint nCount = gs_nSamples / 64 + 3;
+    RVector4* pVectors = new RVector4[nCount];
+    for( uint i = 0; i < nCount; ++i )
+    {
+        float F = ( (float)i / (float)nCount ) * 2.5f - 1.25f;
+        if( i < ARRAY_LENGTH( pSpecial ) )
+        {
+            F = pSpecial[i];
+        }
+        else if( i < ARRAY_LENGTH( pSpecial ) + 2 )
+        {
+            F = BitsFloat( i & 1 ? 0xFF800000 : 0x7F800000 );
+        }
+        pVectors[i] = RVector4( F, 1.0f - F, F * 0.5f, -F );
+    }
+
+    RUNorm8x4* pUNorm8 = new RUNorm8x4[nCount];
+    RSNorm16x4* pSNorm16 = new RSNorm16x4[nCount];
+    RUNorm1010102* pUNorm1010102 = new RUNorm1010102[nCount];
+    PackUNorm8x4( pVectors, pUNorm8, nCount );
+    PackSNorm16x4( pVectors, pSNorm16, nCount );
+    PackUNorm1010102( pVectors, pUNorm1010102, nCount );
+    for( uint i = 0; i < nCount; ++i )
+    {
+        const RVector4& V = pVectors[i];
+        RUNorm8x4 UNorm8( V );
+        RSNorm16x4 SNorm16( V );
+        RUNorm1010102 UNorm1010102( V );
+        for( uint nLane = 0; nLane < 4; ++nLane )
+        {
+            AddNormError( &Worst8, ( &UNorm8.x )[nLane], V.f[nLane], 0.0f, 255.0f );
+            AddNormError( &Worst16, ( &SNorm16.x )[nLane], V.f[nLane], -1.0f, 32767.0f );
+            uint nBits = nLane < 3 ? 10 * nLane : 30;
+            AddNormError( &Worst1010102, ( UNorm1010102.v >> nBits ) & ( nLane < 3 ? 0x3FF : 0x3 ), V.f[nLane], 0.0f, nLane < 3 ? 1023.0f : 3.0f );
+        }
+        Worst8.Add( pUNorm8[i].v == UNorm8.v ? 0.0 : 1.0, V.x );
+        Worst16.Add( memcmp( &pSNorm16[i], &SNorm16, sizeof( SNorm16 ) ) == 0 ? 0.0 : 1.0, V.x );
+        Worst1010102.Add( pUNorm1010102[i].v == UNorm1010102.v ? 0.0 : 1.0, V.x );
+    }
+    delete [] pVectors;
+    delete [] pUNorm8;
+    delete [] pSNorm16;
+    delete [] pUNorm1010102;
+
+    // Every packed value there is, unpacked and packed again
+    for( uint nValue = 0; nValue < 0x10000; ++nValue )
+    {
+        RUNorm8x4 UNorm8;
+        UNorm8.x = (uint8)nValue;
+        UNorm8.y = (uint8)~nValue;
+        UNorm8.z = (uint8)( nValue >> 8 );
+        UNorm8.w = (uint8)( nValue * 7 );
+        RVector4 V = UNorm8.ToVector4();
+        RUNorm8x4 Repacked( V );
+        for( uint nLane = 0; nLane < 4; ++nLane )
+        {
+            uint nStep = ( &UNorm8.x )[nLane];
+            Worst8.Add( fabs( V.f[nLane] * 255.0 - nStep ), (float)nStep );
+            Worst8.Add( fabs( (double)( &Repacked.x )[nLane] - nStep ), (float)nStep );
+        }
+
+        // -32768 is -1 too, so it packs back to -32767
+        RSNorm16x4 SNorm16;
+        SNorm16.x = (int16)nValue;
+        SNorm16.y = (int16)~nValue;
+        SNorm16.z = (int16)( nValue * 7 );
+        SNorm16.w = (int16)( nValue >> 4 );
+        V = SNorm16.ToVector4();
+        RSNorm16x4 Repacked16( V );
+        for( uint nLane = 0; nLane < 4; ++nLane )
+        {
+            int nStep = ( &SNorm16.x )[nLane] == -32768 ? -32767 : ( &SNorm16.x )[nLane];
+            Worst16.Add( fabs( V.f[nLane] * 32767.0 - nStep ), (float)nStep );
+            Worst16.Add( fabs( (double)( &Repacked16.x )[nLane] - nStep ), (float)nStep );
+        }
+
+        RUNorm1010102 UNorm1010102;
+        uint pSteps[4] = { nValue & 0x3FF, ( nValue >> 6 ) & 0x3FF, ( nValue * 7 ) & 0x3FF, nValue & 0x3 };
+        UNorm1010102.v = pSteps[0] | ( pSteps[1] << 10 ) | ( pSteps[2] << 20 ) | ( pSteps[3] << 30 );
+        V = UNorm1010102.ToVector4();
+        RUNorm1010102 Repacked1010102( V );
+        for( uint nLane = 0; nLane < 4; ++nLane )
+        {
+            uint nBits = nLane < 3 ? 10 * nLane : 30;
+            double fScale = nLane < 3 ? 1023.0 : 3.0;
+            uint nRepacked = ( Repacked1010102.v >> nBits ) & ( nLane < 3 ? 0x3FF : 0x3 );
+            Worst1010102.Add( fabs( V.f[nLane] * fScale - pSteps[nLane] ), (float)pSteps[nLane] );
+            Worst1010102.Add( fabs( (double)nRepacked - pSteps[nLane] ), (float)pSteps[nLane] );
+        }
+    }
+
+    return Report( "RUNorm8x4", Worst8, gs_fNormBound, false )
+         + Report( "RSNorm16x4", Worst16, gs_fNormBound, false )
+         + Report( "RUNorm1010102", Worst1010102, gs_fNormBound, false );
+}
+
+int main( int argc, char* argv[] )
+{
+    for( int nArg = 1; nArg < argc; ++nArg )
+    {
+        if( strcmp( argv[nArg], "-quick" ) == 0 )
+        {
+            gs_nSamples = 1 << 18;
+        }
+        else
+        {
+            printf( "Unknown command line option: %s\n", argv[nArg] );
+            return 2;
+        }
+    }
+
+    printf( "%-28s %-7s %12s %12s\n", "Function", "Build", "Worst error", "Bound" );
+    uint nFailures = 0;
+    nFailures += TestRecipSqrtEst();
+    nFailures += TestRecipEst();
+    nFailures += TestSinCos( "SinCos", SinCos, gs_fSinCosBound );
+    nFailures += TestSinCos( "SinCosEst", SinCosEst, gs_fSinCosEstBound );
+    nFailures += TestAtan2Est();
+
+    srand( 1 );
+    nFailures += TestPlanes();
+    nFailures += TestAABBsAndSpheres();
+    nFailures += TestOBBs();
+    nFailures += TestFrustums();
+    nFailures += TestRays();
+    nFailures += TestBatchKernels();
+    nFailures += TestHalfs();
+    nFailures += TestHalfStreams();
+    nFailures += TestNorms();
+
+    if( nFailures )
+    {
+        printf( "%u bounds exceeded\n", nFailures );
+        return 1;
+    }
+    printf( "All bounds hold\n" );
+    return 0;
+}